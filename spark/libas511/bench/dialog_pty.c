@@ -0,0 +1,477 @@
+/*
+  Copyright (C) 2002-2009 Peter Schnabel
+
+  Datei:   dialog_pty.c
+  Datum:   17.10.2026
+  Version: 0.0.1
+
+  Messprogramm für die Speicherverwaltung der Listen. Ein Kindprozess
+  spielt auf der Master Seite eines Pseudoterminals die SPS und beantwortet
+  S5_READ_SYSPAR, S5_READ_BST_ADDR_LIST und STATUS VAR. Gemessen werden
+  Malloc Aufrufe und Zeit je as511_read_module_addr_list und je STATUS VAR
+  Zyklus (create, insert_type, start, run, stop, destroy). Die Adressliste
+  einmal wie bisher (Systemparameter, Kopf und Liste je mit Malloc) und
+  einmal mit as511_read_module_addr_list, STATUS VAR einmal mit
+  td->listen_arena = 0 (jeder Knoten mit Malloc), einmal im Arena Speicher
+  und einmal zusätzlich mit as511_status_var_reserve. Dazu die Zeit für die
+  Liste allein, ohne die SPS.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+#define _GNU_SOURCE
+#include <setjmp.h>
+#include <unistd.h>
+#include <termios.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+// Fuer addr_list_bisher, das die Protokollfunktionen der Bibliothek selbst aufruft
+#define  _S5LIB_C_
+#include <as511_s5lib.h>
+
+// Länge der DB Adressliste in Bytes, 256 Bausteine
+#define DB_LISTE 512
+
+extern int MallocZaehler;
+extern unsigned long MallocAnzahl;
+
+static void usage( void )
+{
+  printf("Aufruf: dialog_pty [-n<anzahl>] [-v<variablen>] [-d]\n");
+  printf("-n<anzahl>    Anzahl Aufrufe bzw. Zyklen je Messung. Vorgabe 200.\n");
+  printf("-v<variablen> Anzahl Variablen je STATUS VAR. Vorgabe 32.\n");
+  printf("-d            Alle Zeichen auf stderr ausgeben.\n");
+}
+
+/*
+  Die SPS:
+*/
+static int plc_fd;
+
+static unsigned char plc_lese( void )
+{
+  unsigned char ch;
+
+  if( read(plc_fd, &ch, 1) != 1 )
+    _exit(0);
+  return ch;
+}
+
+// Datenbyte lesen, DLE kommt doppelt
+static unsigned char plc_lese_daten( void )
+{
+  unsigned char ch = plc_lese();
+
+  if( ch == DLE )
+    plc_lese();
+  return ch;
+}
+
+static void plc_schreibe( const unsigned char *p, int n )
+{
+  if( write(plc_fd, p, n) != n )
+    _exit(0);
+}
+
+// Daten mit doppeltem DLE, dann DLE ETX senden
+static void plc_schreibe_daten( const unsigned char *p, int n )
+{
+  static unsigned char b[2 * 65536 + 2];
+  int i, l = 0;
+
+  for( i = 0; i < n; i++ ) {
+    b[l++] = p[i];
+    if( p[i] == DLE )
+      b[l++] = DLE;
+  }
+  b[l++] = DLE;
+  b[l++] = ETX;
+  plc_schreibe(b, l);
+}
+
+static const unsigned char dle_ack[] = { DLE, ACK };
+static const unsigned char dle_ack_stx[] = { DLE, ACK, STX };
+static const unsigned char stx[] = { STX };
+
+static void plc_stopp( void )
+{
+  static const unsigned char stopp_ende[] = { DC2, DLE, ETX };
+
+  plc_schreibe(stx, 1);
+  plc_lese(); plc_lese();
+  plc_schreibe(stopp_ende, 3);
+  plc_lese(); plc_lese();
+}
+
+/* STATUS VAR: die Variablen lesen, dann RUN Anfragen beantworten bis STOP.
+   Jede Variable hat den Wert ihrer Nummer in der Liste.
+*/
+static void plc_status_var( void )
+{
+  static const unsigned char start_ende[] = { DLE, DLE, DLE, ETX };
+  unsigned char typ[1024], b[4 * 1024], ch;
+  int anzahl = 0, n, i;
+
+  for( i = 0; i < 6; i++ )
+    plc_lese_daten();
+  while( 1 ) {
+    ch = plc_lese();
+    if( ch != DLE )
+      continue;
+    ch = plc_lese();
+    if( ch == EOT )
+      break;
+    // DLE Typ Adresse HI LO
+    if( anzahl < (int)sizeof(typ) )
+      typ[anzahl++] = ch;
+    plc_lese(); plc_lese();
+  }
+  plc_schreibe(dle_ack_stx, 3);
+  plc_lese(); plc_lese();
+  plc_schreibe(start_ende, 4);
+  plc_lese(); plc_lese();
+
+  while( 1 ) {
+    while( plc_lese() != STX );
+    plc_schreibe(dle_ack, 2);
+    ch = plc_lese();
+    plc_lese(); plc_lese(); // DLE ETX
+    plc_schreibe(dle_ack, 2);
+
+    if( ch == S5_ONLINE_STOP ) {
+      plc_stopp();
+      return;
+    }
+
+    plc_schreibe(stx, 1);
+    plc_lese(); plc_lese();
+    n = 0;
+    b[n++] = 0x00;
+    b[n++] = 0xFF; // AG RUN
+    b[n++] = 0x00;
+    for( i = 0; i < anzahl; i++ ) {
+      b[n++] = 0; b[n++] = 0;   // Status
+      if( typ[i] == STATUS_VAR_ZAEHLER || typ[i] == STATUS_VAR_DATEN ) {
+        b[n++] = 0; b[n++] = 0;
+        b[n++] = HI(i); b[n++] = LO(i);
+      }
+      else {
+        b[n++] = 0; b[n++] = (unsigned char)i;
+      }
+    }
+    // Die drei Zeichen vor den Daten liest as511_status_var_run einzeln
+    plc_schreibe(b, 3);
+    plc_schreibe_daten(&b[3], n - 3);
+    plc_lese(); plc_lese();
+  }
+}
+
+static void plc( void )
+{
+  static const unsigned char start_ende[] = { 0x16, DLE, ETX };
+  unsigned char b[1 + DB_LISTE + sizeof(sp_t)];
+  sp_t sp;
+  unsigned char bef;
+  int i;
+
+  memset(&sp, 0x00, sizeof(sp));
+  sp.Laenge_DB_liste = DB_LISTE;
+
+  while( 1 ) {
+    // protokoll_start
+    while( plc_lese() != STX );
+    plc_schreibe(dle_ack, 2);
+    bef = plc_lese_daten();
+    plc_schreibe(stx, 1);
+    plc_lese(); plc_lese();
+    plc_schreibe(start_ende, 3);
+    plc_lese(); plc_lese();
+
+    switch( bef ) {
+      case S5_READ_SYSPAR:
+        plc_lese(); plc_lese(); // DLE EOT
+        plc_schreibe(dle_ack_stx, 3);
+        plc_lese(); plc_lese();
+        b[0] = 0;
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        swab(&sp, &b[1], sizeof(sp));
+#else
+        memcpy(&b[1], &sp, sizeof(sp));
+#endif
+        plc_schreibe_daten(b, 1 + sizeof(sp));
+        plc_lese(); plc_lese();
+        plc_stopp();
+        break;
+
+      case S5_READ_BST_ADDR_LIST:
+        plc_lese_daten();       // Bausteintyp
+        plc_lese(); plc_lese(); // DLE EOT
+        plc_schreibe(dle_ack_stx, 3);
+        plc_lese(); plc_lese();
+        b[0] = 0;
+        for( i = 0; i < DB_LISTE; i++ )
+          b[1 + i] = (unsigned char)i;
+        plc_schreibe_daten(b, 1 + DB_LISTE);
+        plc_lese(); plc_lese();
+        plc_stopp();
+        break;
+
+      case S5_STATUS_VAR:
+        plc_status_var();
+        break;
+    }
+  }
+}
+
+/*
+  Die Messungen:
+*/
+static double jetzt( void )
+{
+  struct timeval t;
+
+  gettimeofday(&t, NULL);
+  return 1e6 * t.tv_sec + t.tv_usec;
+}
+
+static void ausgabe( const char *name, unsigned long malloc_anzahl, int anzahl, double usec )
+{
+  printf("%-34s %8.1f Malloc %10.1f usec\n", name, (double)malloc_anzahl / anzahl, usec / anzahl);
+}
+
+/*
+  as511_read_module_addr_list wie vor der Arena Version, zum Vergleich: die
+  Systemparameter mit Malloc, Kopf und Liste mit je einem Malloc.
+  as511_read_module_addr_list_free gibt beides frei.
+*/
+static bal_t *addr_list_bisher( td_t *td, unsigned char bst_typ )
+{
+  bal_t *bal = NULL;
+  syspar_t *sp;
+  word_t l;
+
+  unsigned char ch;
+  unsigned int index = 0;
+
+  td->errnr = 0;
+
+  if( (sp = as511_read_system_parameter( td )) != NULL ) {
+    if((l = as511_get_bst_addr_size( td, sp, bst_typ )) > 0 ) {
+      if( sigsetjmp(td->env, 1) == 0 ) {
+        if( protokoll_start( td, S5_READ_BST_ADDR_LIST ) ) {
+          schreibe_daten_v2(td, bst_typ);
+          schreibe_byte_v2(td, DLE);
+          schreibe_byte_v2(td, EOT);
+          lese_byte_v2(td, &ch, DLE, 1);
+          lese_byte_v2(td, &ch, ACK, 1);
+          lese_byte_v2(td, &ch, STX, 1);
+          schreibe_byte_v2(td,DLE);
+          schreibe_byte_v2(td,ACK);
+
+          index = as511_read_data( td );
+
+          schreibe_byte_v2(td,DLE);
+          schreibe_byte_v2(td,ACK);
+
+          if (protokoll_stopp( td ) ) {
+            index--;
+            bal = Malloc( sizeof( bal_t ) );
+            bal->ptr = Malloc( l );
+
+            memcpy(bal->ptr, &td->mem[1], l );
+            bal->laenge = l;
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            swab(bal->ptr, bal->ptr, l );
+#endif
+            as511_read_system_parameter_free( td, sp );
+            return bal;
+          }
+        }
+      }
+    }
+  }
+  as511_read_system_parameter_free( td, sp );
+  return NULL;
+}
+
+static int addr_list( td_t *td, const char *name, bal_t *(*lesen)( td_t *, unsigned char ), int anzahl )
+{
+  unsigned long m = MallocAnzahl;
+  double t = jetzt();
+  bal_t *bal;
+  int i;
+
+  for( i = 0; i < anzahl; i++ ) {
+    if( (bal = lesen(td, DB)) == NULL ) {
+      printf("%s %d fehlgeschlagen: %04X\n", name, i, td->errnr);
+      return 1;
+    }
+    if( bal->laenge != DB_LISTE ) {
+      printf("%s %d: Länge %lu\n", name, i, bal->laenge);
+      as511_read_module_addr_list_free(td, bal);
+      return 1;
+    }
+    as511_read_module_addr_list_free(td, bal);
+  }
+  ausgabe(name, MallocAnzahl - m, anzahl, jetzt() - t);
+  return 0;
+}
+
+// Die Liste einer STATUS VAR anlegen, abwechselnd Datenworte und Merkerbytes
+static int liste( td_t *td, int variablen, int feld )
+{
+  int i;
+
+  if( as511_status_var_create(td) != 0 )
+    return 1;
+  if( feld && as511_status_var_reserve(td, variablen) != 0 )
+    return 1;
+  for( i = 0; i < variablen; i++ ) {
+    if( as511_status_var_insert_type(td, (i & 1) ? STATUS_VAR_MERKER : STATUS_VAR_DATEN,
+                                     (unsigned short)(0x2000 + 2 * i), NULL, NULL) == NULL )
+      return 1;
+  }
+  return 0;
+}
+
+static int status_var( td_t *td, const char *name, int arena, int feld, int anzahl, int variablen )
+{
+  unsigned long m;
+  double t;
+  svd_u *svd;
+  dl_t *dl;
+  int i, j;
+
+  td->listen_arena = arena;
+  // Der erste Zyklus legt die Bloecke der Arena an, gemessen wird danach
+  liste(td, variablen, feld);
+  as511_status_var_destroy(td, NULL);
+
+  m = MallocAnzahl;
+  t = jetzt();
+  for( i = 0; i < anzahl; i++ ) {
+    if( liste(td, variablen, feld) != 0 ) {
+      printf("%s: Liste %d nicht angelegt\n", name, i);
+      return 1;
+    }
+    if( !as511_status_var_start(td) ) {
+      printf("%s: as511_status_var_start %d fehlgeschlagen: %04X\n", name, i, td->errnr);
+      return 1;
+    }
+    as511_status_var_run(td);
+    if( td->errnr != 0 ) {
+      printf("%s: as511_status_var_run %d fehlgeschlagen: %04X\n", name, i, td->errnr);
+      return 1;
+    }
+    for( j = 0, dl = td->dlh->f; dl; dl = dl->n, j++ ) {
+      svd = DL_GET_DATA(svd_u, dl);
+      if( svd->t.type == STATUS_VAR_DATEN && svd->t6.w.d.wert != j ) {
+        printf("%s: Variable %d hat den Wert %d\n", name, j, svd->t6.w.d.wert);
+        return 1;
+      }
+    }
+    as511_status_var_stop(td);
+    as511_status_var_destroy(td, NULL);
+  }
+  ausgabe(name, MallocAnzahl - m, anzahl, jetzt() - t);
+
+  // Nur die Liste, ohne SPS
+  m = MallocAnzahl;
+  t = jetzt();
+  for( i = 0; i < 100 * anzahl; i++ ) {
+    liste(td, variablen, feld);
+    for( j = 0; j < variablen; j++ )
+      dlh_get(td->dlh, j);
+    as511_status_var_destroy(td, NULL);
+  }
+  printf("  nur Liste mit dlh_get            %8.1f Malloc %10.2f usec\n",
+         (double)(MallocAnzahl - m) / (100 * anzahl), (jetzt() - t) / (100 * anzahl));
+  return 0;
+}
+
+int main( int argc, char **argv )
+{
+  int master, rc, anzahl = 200, variablen = 32, debug = 0;
+  struct termios t;
+  pid_t pid;
+  td_t *td;
+
+  while( argc > 1 ) {
+    if( strncmp(argv[1], "-n", 2) == 0 ) {
+      anzahl = atoi(argv[1] + 2);
+    } else if( strncmp(argv[1], "-v", 2) == 0 ) {
+      variablen = atoi(argv[1] + 2);
+    } else if( strcmp(argv[1], "-d") == 0 ) {
+      debug = 1;
+    } else {
+      usage();
+      return 1;
+    }
+    argc--;
+    argv++;
+  }
+  if( anzahl < 1 || variablen < 1 || variablen > 1024 ) {
+    printf("variablen muss zwischen 1 und 1024 liegen\n");
+    return 1;
+  }
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if( master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ) {
+    printf("Kein Pseudoterminal\n");
+    return 1;
+  }
+  tcgetattr(master, &t);
+  cfmakeraw(&t);
+  tcsetattr(master, TCSANOW, &t);
+
+  if( (td = open_tty(ptsname(master))) == NULL ) {
+    printf("Kann %s nicht öffnen\n", ptsname(master));
+    return 1;
+  }
+  if( debug )
+    td->debug_level = DEBUG_LEVEL_ALL;
+
+  if( (pid = fork()) == 0 ) {
+    plc_fd = master;
+    plc();
+    _exit(0);
+  }
+
+  printf("%d Aufrufe, STATUS VAR mit %d Variablen\n", anzahl, variablen);
+  rc = addr_list(td, "Adressliste wie bisher", addr_list_bisher, anzahl);
+  if( rc == 0 )
+    rc = addr_list(td, "as511_read_module_addr_list", as511_read_module_addr_list, anzahl);
+  if( rc == 0 )
+    rc = status_var(td, "STATUS VAR mit Malloc", 0, 0, anzahl, variablen);
+  if( rc == 0 )
+    rc = status_var(td, "STATUS VAR im Arena Speicher", 1, 0, anzahl, variablen);
+  if( rc == 0 )
+    rc = status_var(td, "STATUS VAR mit Feld", 1, 1, anzahl, variablen);
+
+  kill(pid, SIGTERM);
+  waitpid(pid, NULL, 0);
+  close_tty(td);
+  close(master);
+  if( rc == 0 && MallocZaehler != 0 ) {
+    printf("%d mit Malloc belegte Bloecke nicht freigegeben\n", MallocZaehler);
+    rc = 1;
+  }
+  return rc;
+}
@@ -205,27 +205,12 @@ int as511_ctrl_output_stop( td_t *td )
 
 int as511_ctrl_output_destroy( td_t *td, int (*usrfk)(void*) )
 {
-  void *d;
-
-  if( td != NULL && td->dlh != NULL && td->dlh->dl_type == DL_TYPE_CTRL_OUTPUT ) {
-    while( td->dlh->f != NULL ) {
-      d = dlh_delete(td->dlh, td->dlh->l,DL_TYPE_CTRL_OUTPUT,usrfk,td->dlh->l->udata);
-      Free(d);
-    }
-    Free(td->dlh);
-    td->dlh = NULL;
-    return NO_ERROR; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_destroy( td, DL_TYPE_CTRL_OUTPUT, usrfk );
 }
 
 int as511_ctrl_output_create( td_t *td )
 {
-  if( td != NULL && td->dlh == NULL ) {
-    td->dlh = dlh_create( DL_TYPE_CTRL_OUTPUT );
-    return NO_ERROR; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_create( td, DL_TYPE_CTRL_OUTPUT );
 }
 
 void as511_ctrl_output_bl_free( td_t *td, copbl_t *bl )
@@ -61,6 +61,27 @@ struct MallocDebug
 };
 typedef struct MallocDebug MD;
 
+// Ein Block des Arena Speichers, die Daten folgen dem Kopf
+struct mem_block
+{
+  struct mem_block *n;  // Naechster Block
+  size_t groesse;       // Nutzbare Bytes hinter dem Kopf
+  size_t belegt;        // Davon belegt
+};
+
+/* Arena Speicher fuer Kopf, Knoten und Daten der Listen eines Handles.
+   Einzelne Bereiche werden nicht freigegeben, mem_arena_reset gibt am
+   Ende eines Dialoges (Status Var, Status Module ...) alles auf einmal
+   frei und behaelt die Bloecke fuer den naechsten Dialog.
+*/
+struct mem_arena
+{
+  struct mem_block *f;   // Erster Block
+  struct mem_block *a;   // Aktueller Block
+  unsigned long bloecke; // Mit Malloc angeforderte Bloecke
+};
+typedef struct mem_arena mem_arena_t;
+
 struct dbl_list_head
 {
   struct dbl_list *f;  // Erster Knoten der Liste
@@ -69,6 +90,17 @@ struct dbl_list_head
   int    dl_type;      // Typ der Daten, Status Var, Status Module ...
   int    dl_lock;      // Sperre für Einfügen und Löschen
   void   *data;        // Globale Listendaten, die nur einmal je Liste benötigt werden
+
+  int    anzahl;       // Anzahl der Knoten
+  mem_arena_t *arena;  // Speicher fuer Knoten und Daten, NULL = Malloc
+
+  // Mit dlh_reserve: Knoten und Daten in zwei Feldern hintereinander
+  struct dbl_list *feld;
+  unsigned char   *feld_daten;
+  size_t           feld_ds;      // Groesse der Daten je Knoten
+  int              feld_groesse; // Anzahl Knoten im Feld
+  int              feld_belegt;  // davon mit dlh_insert_last belegt
+  int              feld_index;   // 1, solange Knoten i == feld[i]
 };
 typedef struct dbl_list_head dlf_t;  // aus Kompatibilitätsgründen noch vorhanden
 typedef struct dbl_list_head dlh_t;
@@ -94,6 +126,17 @@ dlh_t *dlh_create ( int dl_type );
 void * dlh_delete ( dlh_t *dlh, dl_t *dl, int dl_type, int (*usrfk)(void*), void *ud);
 dl_t  *dl_create  ( void );
 
+// Listen im Arena Speicher
+dlh_t *dlh_create_arena( int dl_type, mem_arena_t *arena );
+int    dlh_reserve     ( dlh_t *dlh, int anzahl, size_t ds );
+dl_t  *dlh_get         ( dlh_t *dlh, int index );
+void   dl_data_free    ( dlh_t *dlh, void *data );
+
+mem_arena_t *mem_arena_create ( void );
+void        *mem_arena_alloc  ( mem_arena_t *arena, size_t size );
+void         mem_arena_reset  ( mem_arena_t *arena );
+void         mem_arena_destroy( mem_arena_t *arena );
+
 int dl_print_data( dl_t *dl );
 
 #endif
@@ -73,14 +73,13 @@ word_t as511_get_bst_addr_size( td_t *td, syspar_t *sp, byte_t bsttyp )
     21.08.2006
     Lesen der Systemparameter
 
-    Eingabe:  td  Zeiger auf Datenstruktur
-    Ausgabe:  Zeiger die Kopie der Systemparameter im PG
-              NULL bei Fehler
+    Eingabe:  td      Zeiger auf Datenstruktur
+              syspar  Speicher des Aufrufers fuer die Systemparameter
+    Ausgabe:  1 wenn OK, 0 bei Fehler
 */
-syspar_t * as511_read_system_parameter( td_t *td )
+int as511_read_system_parameter_buf( td_t *td, syspar_t *syspar )
 {
   unsigned char ch;
-  syspar_t *syspar = NULL;
 
   td->errnr = 0;
 
@@ -103,16 +102,31 @@ syspar_t * as511_read_system_parameter( td_t *td )
 #if __BYTE_ORDER == __LITTLE_ENDIAN
         swab(&td->mem[1],&td->mem[1],sizeof(sp_t) - 1);
 #endif
-        syspar = Malloc(sizeof(syspar_t));
         memcpy(&syspar->sp, &td->mem[1], sizeof(sp_t) );
         syspar->laenge = sizeof(sp_t);
-        return syspar;
+        return 1;
       }
     }
   }
   // Wenn das Programm bis hierher kommt, ist ein Fehler aufgetreten.
-  as511_read_system_parameter_free( td, syspar );
+  return 0;
+}
+
+/*
+    Lesen der Systemparameter
 
+    Eingabe:  td  Zeiger auf Datenstruktur
+    Ausgabe:  Zeiger die Kopie der Systemparameter im PG
+              NULL bei Fehler
+*/
+syspar_t * as511_read_system_parameter( td_t *td )
+{
+  syspar_t *syspar = Malloc(sizeof(syspar_t));
+
+  if( as511_read_system_parameter_buf( td, syspar ) )
+    return syspar;
+
+  as511_read_system_parameter_free( td, syspar );
   return NULL;
 }
 
@@ -23,6 +23,10 @@
 #ifndef _S5LIB_H_
 #define _S5LIB_H_
 
+// Größe der Puffer für gepuffertes Lesen und Schreiben in Byte
+#define RX_PUFFER_SIZE 256
+#define TX_PUFFER_SIZE 1100
+
 // Diese Datenstruktur ist für alle as511 Bausteinaufrufe zwingend
 // Die Struktur wird mit der Funktion open_tty inititalisiert und
 // mit close_tty geschlossen.
@@ -41,6 +45,19 @@ struct thread_daten
   struct dbl_list_head *dlh; // Kopf einer doppelt verketteten liste
   int            debug_level; // 0 ...
   FILE          *debug_handle;// Handle zur Ausgabe von Fehlermeldungen
+  int            puffer;  // 1 = gepuffert (Vorgabe von open_tty), 0 = jedes Zeichen einzeln
+  unsigned char  rx[RX_PUFFER_SIZE]; // Empfangspuffer
+  int            rx_anfang;// nächstes ungelesenes Zeichen in rx
+  int            rx_ende;  // hinter dem letzten empfangenen Zeichen in rx
+  unsigned char  tx[TX_PUFFER_SIZE]; // Sendepuffer, nimmt ein Telegramm auf
+  int            tx_laenge;// Anzahl der Zeichen in tx
+  int            tx_dle;   // letztes Zeichen in tx war das Steuerzeichen DLE
+  unsigned long  syscalls; // Anzahl poll(), read() und write(), für Messungen
+  long           speicher_bloecke; // mit as511_malloc belegte und nicht freigegebene Bloecke
+  size_t         speicher_bytes;   // Bytes in diesen Bloecken
+  size_t         speicher_max;     // hoechster Wert von speicher_bytes
+  struct mem_arena *arena;         // Speicher fuer die Liste dlh, siehe mem.c
+  int            listen_arena;     // 1 = Listen im Arena Speicher (Vorgabe von open_tty), 0 = Malloc je Knoten
 };
 typedef struct thread_daten td_t;
 
@@ -143,6 +160,7 @@ typedef struct thread_daten td_t;
 #define SPS_TIMEOUT        0x8002
 #define POLL_ERROR         0x8004
 #define UNKNOWN_MODULE     0x8008
+#define OUT_OF_MEMORY      0x8010
 
 #define CTRL_OUTP_BADLST   0x2001
 
@@ -214,6 +232,10 @@ typedef struct thread_daten td_t;
 // Größe des Zwischenpuffers in Byte für open_tty
 #define MEM_SIZE  65536
 
+// Mehr Bytes liest oder schreibt die SPS mit einem S5_READ_MEM bzw.
+// S5_WRITE_MEM nicht
+#define RAM_TELEGRAMM_MAX 512
+
 #define DEBUG_LEVEL_NONE      0
 #define DEBUG_LEVEL_SYSTEM    5
 #define DEBUG_LEVEL_AS511     10
@@ -261,6 +283,16 @@ struct sps_ram
 typedef struct sps_ram sps_ram_t;
 typedef struct sps_ram ram_t;
 
+// Ein Speicherbereich fuer as511_read_ram_multi
+struct ram_bereich
+{
+  unsigned short adr;    // Startadresse
+  unsigned short laenge; // Laenge in Byte
+  unsigned char *ptr;    // Nach dem Lesen: Zeiger auf die Daten, NULL bei Fehler
+  int            errnr;  // Fehlernummer, wenn ptr NULL ist
+};
+typedef struct ram_bereich rb_t;
+
 // BSTACK
 struct bstackformat
 {
@@ -450,6 +482,28 @@ int lese_byte_v2( td_t *td,
                   unsigned char test_ch,
                   int test_enable );
 int as511_read_data( td_t *td );
+
+/* Wie oben, aber ohne siglongjmp: Rueckgabe 0 oder die Fehlernummer,
+   die auch in td->errnr steht. Siehe s5lib.c
+*/
+int protokoll_start_r( td_t *td, unsigned char bef, int *antwort );
+int protokoll_stopp_r( td_t *td, int *antwort );
+int schreibe_byte_r( td_t *td, unsigned char ch );
+int schreibe_daten_r( td_t *td, unsigned char ch );
+int lese_byte_r( td_t *td,
+                 unsigned char *ch,
+                 unsigned char test_ch,
+                 int test_enable );
+int as511_read_data_r( td_t *td, unsigned int *index );
+
+/* Liste td->dlh fuer einen Dialog anlegen und wieder loeschen, im Arena
+   Speicher td->arena wenn td->listen_arena gesetzt ist. Siehe mem.c
+*/
+int td_dlh_create ( td_t *td, int dl_type );
+int td_dlh_destroy( td_t *td, int dl_type, int (*usrfk)(void*) );
+
+// Fehlernummer einer Funktion *_r an den Aufrufer weitergeben
+#define R_PRUEFEN(x) do { int r_ = (x); if( r_ != NO_ERROR ) return r_; } while( 0 )
 #endif
 
 ag_t *as511_get_ag_typ( td_t *td, syspar_t *sp );
@@ -463,6 +517,7 @@ void  as511_read_module_info_free( td_t * td, modinfo_t * mi );
 
 word_t     as511_get_bst_addr_size( td_t *td, syspar_t *sp, byte_t bsttyp );
 syspar_t  *as511_read_system_parameter( td_t *td );
+int        as511_read_system_parameter_buf( td_t *td, syspar_t *syspar );
 void as511_read_system_parameter_free( td_t *td, syspar_t *sp );
 
 raminfo_t *as511_read_ram_info( td_t *td );
@@ -476,6 +531,26 @@ sps_ram_t  *as511_read_ram ( td_t *td,
 sps_ram_t * as511_read_ram32( td_t *td,
                               unsigned long adr,
                               unsigned long laenge );
+sps_ram_t * as511_read_ram_multi( td_t *td,
+                                  rb_t *rb,
+                                  int anzahl,
+                                  unsigned short luecke );
+
+/* Speicher Lesen ohne siglongjmp. Rueckgabe 0 oder die Fehlernummer, die
+   auch in td->errnr steht. Bei as511_read_ram_r gehoert der Zielpuffer dem
+   Aufrufer, bei as511_read_ram_multi_r wird er mit as511_malloc belegt.
+   Mehrere Threads duerfen die Funktionen gleichzeitig aufrufen, jeder mit
+   seinem eigenen td.
+*/
+int as511_read_ram_r( td_t *td,
+                      unsigned short adr,
+                      unsigned short laenge,
+                      unsigned char *ziel );
+int as511_read_ram_multi_r( td_t *td,
+                            rb_t *rb,
+                            int anzahl,
+                            unsigned short luecke,
+                            sps_ram_t **ram );
 
 // Speicher Schreiben
 int as511_write_ram    ( td_t *td,
@@ -486,6 +561,10 @@ int as511_write_ram32  ( td_t *td,
                          unsigned long adr,
                          unsigned long laenge,
                          unsigned char *ptr );
+int as511_write_ram_r  ( td_t *td,
+                         unsigned short adr,
+                         unsigned short laenge,
+                         const unsigned char *quelle );
 
 void   as511_module_mem_free( td_t *td, bs_t *bst );
 
@@ -515,6 +594,7 @@ int as511_change_operating_mode( td_t *td, unsigned char mode );
 
 // Funktionen fuer STATUS VAR
 int as511_status_var_create( td_t *td );
+int as511_status_var_reserve( td_t *td, int anzahl );
 int as511_status_var_destroy( td_t *td, int (*usrfk)(void*) );
 dl_t *as511_status_var_insert_type( td_t *td, unsigned char type, unsigned short addr, int (*usrfk)(void*), void *udata );
 void as511_status_var_free( td_t *td, int (*usrfk)(void*) );
@@ -577,4 +657,12 @@ int    as511_step_module_stop     ( td_t *td );
 void  Free   ( void *p );
 void *Malloc ( size_t size );
 
+/* Speicher fuer ein Handle Anfordern/Freigeben. Belegte Bloecke und Bytes
+   werden in td->speicher_* gezaehlt, nicht global. as511_malloc gibt NULL
+   zurueck, wenn kein weiterer Speicher vorhanden ist.
+   Funktionen in wrappers.c
+*/
+void *as511_malloc( td_t *td, size_t size );
+void  as511_free  ( td_t *td, void *p );
+
 #endif // #ifdef _S5LIB_H_
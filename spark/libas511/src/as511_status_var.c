@@ -37,27 +37,32 @@
 
 int as511_status_var_destroy( td_t *td, int (*usrfk)(void*) )
 {
-  void *d;
-
-  if( td != NULL && td->dlh != NULL && td->dlh->dl_type == DL_TYPE_STATUS_VAR ) {
-    while( td->dlh->f != NULL ) {
-      d = dlh_delete(td->dlh, td->dlh->l,DL_TYPE_STATUS_VAR,usrfk,td->dlh->l->udata);
-      Free(d);
-    }
-    Free(td->dlh);
-    td->dlh = NULL;
-    return 0; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_destroy( td, DL_TYPE_STATUS_VAR, usrfk );
 }
 
 int as511_status_var_create( td_t *td )
 {
-  if( td != NULL && td->dlh == NULL ) {
-    td->dlh = dlh_create( DL_TYPE_STATUS_VAR );
-    return 0; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_create( td, DL_TYPE_STATUS_VAR );
+}
+
+/*
+  Funktion: int as511_status_var_reserve( td_t *td, int anzahl )
+
+  Eingabeparameter: td     = Datenstruktur für AS511 Protokoll, nach
+                             as511_status_var_create
+                    anzahl = Anzahl der folgenden as511_status_var_insert_type
+
+  Ausgabeparameter: 0 OK, 1 Fehler
+
+  Funktion:         Legt die Knoten und Daten fuer anzahl Variablen in je
+                    einem Feld an, statt jeden Knoten einzeln. Ohne Arena
+                    Speicher (td->listen_arena = 0) ist es ein Fehler.
+*/
+int as511_status_var_reserve( td_t *td, int anzahl )
+{
+  if( td == NULL || td->dlh == NULL || td->dlh->dl_type != DL_TYPE_STATUS_VAR )
+    return 1; // Fehler
+  return dlh_reserve( td->dlh, anzahl, sizeof(svd_u) );
 }
 
 /*
@@ -29,6 +29,84 @@
 #include <as511_s5lib.h>
 
 
+// Ausrichtung der Bereiche im Arena Speicher
+#define ARENA_AUSRICHTUNG 16
+#define ARENA_RUNDEN(x)   (((x) + ARENA_AUSRICHTUNG - 1) & ~(size_t)(ARENA_AUSRICHTUNG - 1))
+// Groesse des ersten Blocks, jeder weitere ist doppelt so gross
+#define ARENA_BLOCK       4096
+#define ARENA_KOPF        ARENA_RUNDEN(sizeof(struct mem_block))
+
+mem_arena_t *mem_arena_create( void )
+{
+  return Malloc(sizeof(mem_arena_t));
+}
+
+/*
+  Funktion: void *mem_arena_alloc( mem_arena_t *arena, size_t size )
+
+  Ausgabeparameter: Zeiger auf size Bytes, mit 0 gefuellt.
+
+  Funktion:         Nimmt den Speicher aus dem aktuellen Block der Arena.
+                    Ist er voll, wird der naechste Block genommen, und erst
+                    wenn es keinen gibt, ein neuer mit Malloc angefordert.
+*/
+void *mem_arena_alloc( mem_arena_t *arena, size_t size )
+{
+  struct mem_block *b;
+  size_t groesse;
+  void *p;
+
+  size = ARENA_RUNDEN(size ? size : 1);
+
+  while( arena->a == NULL || arena->a->belegt + size > arena->a->groesse ) {
+    if( arena->a != NULL && arena->a->n != NULL ) {
+      arena->a = arena->a->n;
+      continue;
+    }
+    groesse = arena->a ? 2 * arena->a->groesse : ARENA_BLOCK;
+    if( groesse < size )
+      groesse = size;
+    b = Malloc(ARENA_KOPF + groesse);
+    b->groesse = groesse;
+    arena->bloecke++;
+    if( arena->a == NULL )
+      arena->f = b;
+    else
+      arena->a->n = b;
+    arena->a = b;
+  }
+
+  p = (unsigned char *)arena->a + ARENA_KOPF + arena->a->belegt;
+  arena->a->belegt += size;
+  memset(p, 0x00, size);
+  return p;
+}
+
+// Alle Bereiche freigeben, die Bloecke bleiben fuer den naechsten Dialog
+void mem_arena_reset( mem_arena_t *arena )
+{
+  struct mem_block *b;
+
+  if( arena != NULL ) {
+    for( b = arena->f; b; b = b->n )
+      b->belegt = 0;
+    arena->a = arena->f;
+  }
+}
+
+void mem_arena_destroy( mem_arena_t *arena )
+{
+  struct mem_block *b, *n;
+
+  if( arena != NULL ) {
+    for( b = arena->f; b; b = n ) {
+      n = b->n;
+      Free(b);
+    }
+    Free(arena);
+  }
+}
+
 // Neue liste erzeugen dlh
 dlh_t *dlh_create ( int dl_type )
 {
@@ -41,6 +119,25 @@ dlh_t *dlh_create ( int dl_type )
   return dlh;
 }
 
+/*
+  Funktion: dlh_t *dlh_create_arena( int dl_type, mem_arena_t *arena )
+
+  Funktion:         Wie dlh_create, Kopf, Knoten und Daten der Liste kommen
+                    aber aus dem Arena Speicher. Knoten werden von
+                    dlh_delete nicht freigegeben, Daten nicht von
+                    dl_data_free. Beides geschieht mit mem_arena_reset, wenn
+                    die Liste nicht mehr gebraucht wird.
+*/
+dlh_t *dlh_create_arena( int dl_type, mem_arena_t *arena )
+{
+  dlh_t *dlh;
+  dlh = mem_arena_alloc(arena, sizeof(dlh_t));
+  dlh->arena = arena;
+
+  dlh->dl_type = dl_type;
+  return dlh;
+}
+
 // Neuen Knoten erzeugen (dl)
 dl_t *dl_create ( void )
 {
@@ -49,6 +146,79 @@ dl_t *dl_create ( void )
   return dl;
 }
 
+// Neuen Knoten fuer die Liste dlh erzeugen, aus dem Feld von dlh_reserve,
+// dem Arena Speicher oder mit Malloc
+static dl_t *dl_neu( dlh_t *dlh, int am_ende )
+{
+  dl_t *dl;
+
+  // Am Anfang eingefuegt, stimmt der Index im Feld nicht mehr
+  if( !am_ende )
+    dlh->feld_index = 0;
+  if( dlh->feld != NULL && dlh->feld_belegt < dlh->feld_groesse ) {
+    dl = &dlh->feld[dlh->feld_belegt++];
+    memset(dl, 0x00, sizeof(dl_t));
+    return dl;
+  }
+  if( dlh->arena != NULL )
+    return mem_arena_alloc(dlh->arena, sizeof(dl_t));
+  return dl_create();
+}
+
+/*
+  Funktion: int dlh_reserve( dlh_t *dlh, int anzahl, size_t ds )
+
+  Eingabeparameter: dlh       Leere Liste im Arena Speicher
+                    anzahl    Anzahl der Knoten
+                    ds        Grösse der Daten je Knoten
+
+  Ausgabeparameter: 0 OK, 1 Fehler
+
+  Funktion:         Legt die naechsten anzahl Knoten und ihre Daten in je
+                    einem Feld an. Die Liste bleibt doppelt verkettet, solange
+                    aber nur mit dlh_insert_last eingefuegt und nicht geloescht
+                    wird, liefert dlh_get den Knoten ohne die Liste zu
+                    durchlaufen und die Daten liegen hintereinander.
+*/
+int dlh_reserve( dlh_t *dlh, int anzahl, size_t ds )
+{
+  if( dlh == NULL || dlh->arena == NULL || dlh->f != NULL || dlh->feld != NULL || anzahl <= 0 )
+    return 1;
+
+  dlh->feld         = mem_arena_alloc(dlh->arena, anzahl * sizeof(dl_t));
+  dlh->feld_daten   = mem_arena_alloc(dlh->arena, anzahl * ARENA_RUNDEN(ds));
+  dlh->feld_ds      = ARENA_RUNDEN(ds);
+  dlh->feld_groesse = anzahl;
+  dlh->feld_belegt  = 0;
+  dlh->feld_index   = 1;
+  return 0;
+}
+
+/*
+  Funktion: dl_t *dlh_get( dlh_t *dlh, int index )
+
+  Ausgabeparameter: Knoten Nummer index (0 = dlh->f), NULL wenn es ihn nicht gibt
+*/
+dl_t *dlh_get( dlh_t *dlh, int index )
+{
+  dl_t *dl;
+
+  if( dlh == NULL || index < 0 || index >= dlh->anzahl )
+    return NULL;
+  if( dlh->feld_index && index < dlh->feld_belegt )
+    return &dlh->feld[index];
+  for( dl = dlh->f; dl && index > 0; dl = dl->n )
+    index--;
+  return dl;
+}
+
+// Daten freigeben, die dlh_delete zurueckgegeben hat
+void dl_data_free( dlh_t *dlh, void *data )
+{
+  if( dlh != NULL && dlh->arena == NULL )
+    Free(data);
+}
+
 /*
   Funktion: dl_t *dlh_insert_last( dlh_t *dlh )
 
@@ -67,10 +237,11 @@ dl_t *dlh_insert_last( dlh_t *dlh )
   dl_t *t = NULL;
 
   if( dlh != NULL ) {
+    dlh->anzahl++;
     if( dlh->l == NULL )
-      dlh->f = dlh->l = dl_create();
+      dlh->f = dlh->l = dl_neu(dlh, 1);
     else {
-      t = dl_create();
+      t = dl_neu(dlh, 1);
       dlh->l->n = t;
       t->v = dlh->l;
       dlh->l = t;
@@ -99,11 +270,12 @@ dl_t *dlh_insert_first( dlh_t *dlh )
   dl_t *t = NULL;
 
   if( dlh != NULL ) {
+    dlh->anzahl++;
     if( dlh->f == NULL )
-      dlh->f = dlh->l = dl_create();
+      dlh->f = dlh->l = dl_neu(dlh, 1);
     else {
       t = dlh->f;
-      dlh->f = dl_create();
+      dlh->f = dl_neu(dlh, 0);
       dlh->f->n = t;
       t->v = dlh->f;
     }
@@ -131,14 +303,23 @@ int   dl_insert_data( dlh_t *dlh, dl_t *dl, int dl_type, void *dl_data, size_t d
   if( dlh != NULL && dl != NULL ) {
     if( dl_type == dlh->dl_type ) {
 
-      // Suche dl in der Liste
-      for( dli = dlh->f; dli; dli = dli->n )
-        if( dli == dl )
-          break;
+      // Suche dl in der Liste, meistens wurde es gerade am Ende eingefuegt
+      if( dl == dlh->l || dl == dlh->f )
+        dli = dl;
+      else {
+        for( dli = dlh->f; dli; dli = dli->n )
+          if( dli == dl )
+            break;
+      }
 
       // Daten kopieren;
       if( dli != NULL && dl_data != NULL ) {
-        dl->data = Malloc(ds);
+        if( dlh->feld != NULL && dl >= dlh->feld && dl < &dlh->feld[dlh->feld_groesse] && ds <= dlh->feld_ds )
+          dl->data = &dlh->feld_daten[(dl - dlh->feld) * dlh->feld_ds];
+        else if( dlh->arena != NULL )
+          dl->data = mem_arena_alloc(dlh->arena, ds);
+        else
+          dl->data = Malloc(ds);
         dl->udata = udata;
         memcpy( dl->data, dl_data, ds );
       }
@@ -196,36 +377,78 @@ void * dlh_delete( dlh_t *dlh, dl_t *dl, int dl_type, int (*usrfk)(void*), void
     if ( (*usrfk)(ud) != 0 )
       return NULL;
 
+  dlh->anzahl--;
+  // Knoten im Arena Speicher gibt erst mem_arena_reset frei
+  if( dlh->arena != NULL ) {
+    if( dl != dlh->l )
+      dlh->feld_index = 0;
+    else if( dlh->feld_belegt > 0 && dl == &dlh->feld[dlh->feld_belegt - 1] )
+      dlh->feld_belegt--;
+  }
+
   if( dl->v == NULL && dl->n == NULL ) { // dl ist der letzte Knoten in der
-    Free( dl );                          // Liste
-    dlh->f = dlh->l = NULL;
+    dlh->f = dlh->l = NULL;              // Liste
   }
   else {
     if( dl->v == NULL && dl->n != NULL ) { // dl ist der erste Knoten in der Liste
-      dl = dl->n;
-      Free(dl->v);
-      dl->v = NULL;
-      dlh->f = dl;
+      dlh->f = dl->n;
+      dlh->f->v = NULL;
     }
     else {
       if( dl->v != NULL && dl->n == NULL ) { // dl ist der letzte Knoten in der Liste
-        dl = dl->v;
-        Free(dl->n);
-        dl->n = NULL;
-        dlh->l = dl;
+        dlh->l = dl->v;
+        dlh->l->n = NULL;
       }
       else { // dl ist nicht der letzte und nicht der erste Knoten in der Liste
         dln = dl->n;
         dlv = dl->v;
         dln->v = dlv;
         dlv->n = dln;
-        Free(dl);
       }
     }
   }
+  if( dlh->arena == NULL )
+    Free(dl);
   return d;
 }
 
+// Liste td->dlh fuer einen Dialog anlegen
+int td_dlh_create( td_t *td, int dl_type )
+{
+  if( td != NULL && td->dlh == NULL ) {
+    if( td->listen_arena ) {
+      if( td->arena == NULL )
+        td->arena = mem_arena_create();
+      td->dlh = dlh_create_arena( dl_type, td->arena );
+    }
+    else
+      td->dlh = dlh_create( dl_type );
+    return 0; // OK
+  }
+  return 1; // Fehler
+}
+
+// Liste td->dlh mit allen Knoten und Daten loeschen, vorher wird fuer jeden
+// Knoten usrfk mit seinen Benutzerdaten aufgerufen
+int td_dlh_destroy( td_t *td, int dl_type, int (*usrfk)(void*) )
+{
+  void *d;
+
+  if( td != NULL && td->dlh != NULL && td->dlh->dl_type == dl_type ) {
+    while( td->dlh->f != NULL ) {
+      d = dlh_delete(td->dlh, td->dlh->l,dl_type,usrfk,td->dlh->l->udata);
+      dl_data_free(td->dlh, d);
+    }
+    if( td->dlh->arena != NULL )
+      mem_arena_reset( td->dlh->arena );
+    else
+      Free(td->dlh);
+    td->dlh = NULL;
+    return 0; // OK
+  }
+  return 1; // Fehler
+}
+
 #if 0
 // Debug der Speicherverwaltung
 int dl_print_data( dl_t *dl )
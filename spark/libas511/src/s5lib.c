@@ -39,7 +39,72 @@
 #define DEBUG(x,y)  fprintf(td->debug_handle,(x),(y));
 
 /*
-  lese_byte_v2
+  Fehlerbehandlung der Ein- und Ausgabe
+
+  Die Funktionen *_r geben die Fehlernummer an den Aufrufer zurück
+  (0 = fehlerfrei) und setzen sie auch in td->errnr. Sie benutzen
+  weder siglongjmp noch globale Variablen, mehrere Threads können sie
+  darum gleichzeitig aufrufen, jeder mit seinem eigenen td.
+
+  Die Funktionen *_v2 und protokoll_start/protokoll_stopp rufen die
+  Funktionen *_r auf und springen bei einem Fehler wie bisher zu dem
+  Punkt, der mit sigsetjmp definiert wurde.
+*/
+
+/*
+  sende_puffer_r
+
+  Schreibt den Sendepuffer td->tx mit so wenigen write() wie möglich zu
+  dem Dateihandle td->fd.
+
+  Ausgabe: 0 oder SPS_TIMEOUT, POLL_ERROR
+
+  Fehlerbehandlung:
+    Der Sendepuffer wird geleert, damit der Rest eines abgebrochenen
+    Telegramms nicht später gesendet wird.
+*/
+static int sende_puffer_r( td_t *td )
+{
+  int rc, n, gesendet = 0;
+  struct pollfd pfd;
+
+  pfd.fd = td->fd;
+  pfd.events = POLLOUT;
+
+  while( gesendet < td->tx_laenge ) {
+    errno = 0; // Errno zurücksetzen
+
+    td->syscalls++;
+    if( (rc = poll(&pfd, 1, td->timeout)) > 0 ) {
+      td->syscalls++;
+      if( (n = write(td->fd, &td->tx[gesendet], td->tx_laenge - gesendet)) > 0 ) {
+        gesendet += n;
+        continue;
+      }
+      if( n < 0 && (errno == EINTR || errno == EAGAIN) )
+        continue;
+      rc = -1;
+    }
+
+    td->tx_laenge = 0;
+    td->tx_dle = 0;
+    if( rc == 0 ) {
+      if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
+        fprintf(td->debug_handle,"SPS Timeout: sende_puffer\n");
+      }
+      return td->errnr = SPS_TIMEOUT;
+    }
+    if( td->debug_level >= DEBUG_LEVEL_SYSTEM ) {
+      fprintf(td->debug_handle,"Fehler in poll in funktion sende_puffer\n");
+    }
+    return td->errnr = POLL_ERROR;
+  }
+  td->tx_laenge = 0;
+  return NO_ERROR;
+}
+
+/*
+  lese_byte_r
 
   Liest ein Zeichen von dem Dateihandle td->fd
 
@@ -47,25 +112,17 @@
     td:       Zeiger auf eine mit open_tty erzeugte Datenstruktur
     ch:       Zeiger auf das gelesene Zeichen
     test_ch:  Mit diesem Parameter ist es möglich, das gelesene Zeichen
-              zu Pruefen. Wird z.B. DLE erwatet, aber EOT gelesen, wird
-              die Funktion mit dem Fehlercode CHAR_UNKNOWN 0x8001 ueber
-              siglongjmp verlassen.
+              zu Pruefen. Wird z.B. DLE erwatet, aber EOT gelesen, gibt
+              die Funktion den Fehlercode CHAR_UNKNOWN 0x8001 zurück.
     test_enable:
               Damit wird der Test EIN > 0 oder AUS = 0 geschaltet.
 
-  Ausgabe:    Rueckgabewert von poll() wenn die Funktion fehlerfrei
-              ausgeführt wurde
+  Ausgabe:    0 oder CHAR_UNKNOWN, SPS_TIMEOUT, POLL_ERROR
 
-  Fehlerbehandlung:
-    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
-    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen zu dem Punkt,
-    der mit sigsetjmp definiert wurde.
-
-    poll wartet maximal td->timeout Millisekunden. Dann wird SPS_TIMEOUT
-    gesetzt und wie oben beschrieben an den Punkt, der mit sigsetjmp
-    definiert wurde, gesprungen.
+    poll wartet maximal td->timeout Millisekunden, dann wird SPS_TIMEOUT
+    zurückgegeben.
 */
-int lese_byte_v2( td_t *td, unsigned char *ch, unsigned char test_ch, int test_enable )
+int lese_byte_r( td_t *td, unsigned char *ch, unsigned char test_ch, int test_enable )
 {
   int rc;
   struct pollfd  pfd;
@@ -75,95 +132,184 @@ int lese_byte_v2( td_t *td, unsigned char *ch, unsigned char test_ch, int test_e
 
   errno = 0; // Errno zurücksetzen
 
-  if( (rc = poll(&pfd, 1, td->timeout)) > 0 ) {
-    read(td->fd,ch,1);
-
-    if( td->debug_level >= DEBUG_LEVEL_AS511_ALL ) {
-      DEBUG("\tAG -> PG %02X\n", *ch );
+  if( td->puffer ) {
+    // Erst das Telegramm senden, auf das die SPS antworten soll
+    if( td->tx_laenge > 0 ) {
+      td->tx_dle = 0;
+      if( (rc = sende_puffer_r( td )) != NO_ERROR )
+        return rc;
     }
 
-    if( test_enable && *ch != test_ch ) {
-      if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
-        fprintf(td->debug_handle,"Zeichen %02X anstatt %02X gelesen\n", *ch, test_ch );
+    // Ist der Empfangspuffer leer, alles lesen, was schon da ist
+    if( td->rx_anfang == td->rx_ende ) {
+      td->syscalls++;
+      if( (rc = poll(&pfd, 1, td->timeout)) > 0 ) {
+        int n;
+        td->syscalls++;
+        if( (n = read(td->fd, td->rx, RX_PUFFER_SIZE)) <= 0 ) {
+          rc = -1;
+        }
+        else {
+          td->rx_anfang = 0;
+          td->rx_ende = n;
+        }
       }
-      td->errnr = CHAR_UNKNOWN;
-      siglongjmp(td->env, CHAR_UNKNOWN );
+    }
+    else {
+      rc = 1;
+    }
+
+    if( rc > 0 ) {
+      *ch = td->rx[td->rx_anfang++];
     }
   }
   else {
-    if( rc == 0 ) {
-      if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
-        fprintf(td->debug_handle,"SPS Timeout: lese_byte_v2 %04X\n", SPS_TIMEOUT );
-      }
-      td->errnr = SPS_TIMEOUT;
-      siglongjmp(td->env, SPS_TIMEOUT );
+    td->syscalls++;
+    if( (rc = poll(&pfd, 1, td->timeout)) > 0 ) {
+      td->syscalls++;
+      if( read(td->fd,ch,1) != 1 )
+        rc = -1;
     }
-    else {
-      if( td->debug_level >= DEBUG_LEVEL_SYSTEM ) {
-        fprintf(td->debug_handle,"Fehler in poll in funktion lese_byte_v2\n");
-      }
-      siglongjmp(td->env, rc);
+  }
+
+  if( rc == 0 ) {
+    if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
+      fprintf(td->debug_handle,"SPS Timeout: lese_byte_v2 %04X\n", SPS_TIMEOUT );
     }
+    return td->errnr = SPS_TIMEOUT;
   }
-  return rc;
+  if( rc < 0 ) {
+    if( td->debug_level >= DEBUG_LEVEL_SYSTEM ) {
+      fprintf(td->debug_handle,"Fehler in poll in funktion lese_byte_v2\n");
+    }
+    return td->errnr = POLL_ERROR;
+  }
+
+  if( td->debug_level >= DEBUG_LEVEL_AS511_ALL ) {
+    DEBUG("\tAG -> PG %02X\n", *ch );
+  }
+
+  if( test_enable && *ch != test_ch ) {
+    if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
+      fprintf(td->debug_handle,"Zeichen %02X anstatt %02X gelesen\n", *ch, test_ch );
+    }
+    return td->errnr = CHAR_UNKNOWN;
+  }
+  return NO_ERROR;
 }
 
 /*
-  schreibe_byte_v2
+  lese_byte_v2
+
+  Wie lese_byte_r.
+
+  Ausgabe:    1 wenn die Funktion fehlerfrei ausgeführt wurde
+
+  Fehlerbehandlung:
+    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
+    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen mit der
+    Fehlernummer zu dem Punkt, der mit sigsetjmp definiert wurde.
+*/
+int lese_byte_v2( td_t *td, unsigned char *ch, unsigned char test_ch, int test_enable )
+{
+  int rc;
+
+  if( (rc = lese_byte_r(td, ch, test_ch, test_enable)) != NO_ERROR )
+    siglongjmp(td->env, rc);
+  return 1;
+}
+
+/*
+  schreibe_byte_r
 
   Schreibt ein Zeichen zu dem Dateihandle td->fd
 
   Eingabe:
     td:       Zeiger auf eine mit open_tty erzeugte Datenstruktur
     ch:       Das zu schreibende Zeichen
-  Ausgabe:    Rueckgabewert von poll() wenn die Funktion fehlerfrei
-              ausgeführt wurde
-
-  Fehlerbehandlung:
-    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
-    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen zu dem Punkt,
-    der mit sigsetjmp definiert wurde.
+  Ausgabe:    0 oder SPS_TIMEOUT, POLL_ERROR
 
-    poll wartet maximal td->timeout Millisekunden. Dann wird SPS_TIMEOUT
-    gesetzt und wie oben beschrieben an den Punkt, der mit sigsetjmp
-    definiert wurde, gesprungen.
+    poll wartet maximal td->timeout Millisekunden, dann wird SPS_TIMEOUT
+    zurückgegeben.
 */
-int schreibe_byte_v2( td_t *td, unsigned char ch )
+int schreibe_byte_r( td_t *td, unsigned char ch )
 {
   int rc;
   struct pollfd pfd;
 
+  if( td->puffer ) {
+    // Das Telegramm im Speicher zusammensetzen. Gesendet wird vor dem
+    // nächsten Lesen und nach DLE ACK, mit dem der PG seinen Teil eines
+    // Befehls immer abschliesst
+    if( td->tx_laenge >= TX_PUFFER_SIZE ) {
+      if( (rc = sende_puffer_r( td )) != NO_ERROR )
+        return rc;
+    }
+    td->tx[td->tx_laenge++] = ch;
+    if( td->debug_level >= DEBUG_LEVEL_AS511_ALL ) {
+      DEBUG("PG -> AG %02X\n", ch );
+    }
+    if( td->tx_dle && ch == ACK ) {
+      td->tx_dle = 0;
+      return sende_puffer_r( td );
+    }
+    td->tx_dle = (ch == DLE);
+    return NO_ERROR;
+  }
+
   pfd.fd = td->fd;
   pfd.events = POLLOUT;
 
   errno = 0; // Errno zurücksetzen
 
+  td->syscalls++;
   if( (rc = poll(&pfd, 1, td->timeout)) > 0 ) {
-    write(td->fd,&ch,1);
-    if( td->debug_level >= DEBUG_LEVEL_AS511_ALL ) {
+    td->syscalls++;
+    if( write(td->fd,&ch,1) != 1 )
+      rc = -1;
+    else if( td->debug_level >= DEBUG_LEVEL_AS511_ALL ) {
       DEBUG("PG -> AG %02X\n", ch );
     }
   }
-  else {
-    if( rc == 0 ) {
-      if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
-        fprintf(td->debug_handle,"SPS Timeout: schreibe_byte_v2\n");
-      }
-      td->errnr = SPS_TIMEOUT;
-      siglongjmp(td->env, SPS_TIMEOUT);
+
+  if( rc == 0 ) {
+    if( td->debug_level >= DEBUG_LEVEL_AS511 ) {
+      fprintf(td->debug_handle,"SPS Timeout: schreibe_byte_v2\n");
     }
-    else {
-      if( td->debug_level >= DEBUG_LEVEL_SYSTEM ) {
-        fprintf(td->debug_handle,"Fehler in poll in funktion schreibe_byte_v2\n");
-      }
-      siglongjmp(td->env, rc);
+    return td->errnr = SPS_TIMEOUT;
+  }
+  if( rc < 0 ) {
+    if( td->debug_level >= DEBUG_LEVEL_SYSTEM ) {
+      fprintf(td->debug_handle,"Fehler in poll in funktion schreibe_byte_v2\n");
     }
+    return td->errnr = POLL_ERROR;
   }
-  return rc;
+  return NO_ERROR;
 }
 
 /*
-  schreibe_daten_v2
+  schreibe_byte_v2
+
+  Wie schreibe_byte_r.
+
+  Ausgabe:    1 wenn die Funktion fehlerfrei ausgeführt wurde
+
+  Fehlerbehandlung:
+    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
+    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen mit der
+    Fehlernummer zu dem Punkt, der mit sigsetjmp definiert wurde.
+*/
+int schreibe_byte_v2( td_t *td, unsigned char ch )
+{
+  int rc;
+
+  if( (rc = schreibe_byte_r(td, ch)) != NO_ERROR )
+    siglongjmp(td->env, rc);
+  return 1;
+}
+
+/*
+  schreibe_daten_r
 
   Schreibt ein Zeichen zu dem Dateihandle td->fd. DLE ist ein Steuerzeichen im
   AS511 Protokoll. DLE wird doppelt geschrieben, damit die SPS DLE als Datenbyte
@@ -172,8 +318,28 @@ int schreibe_byte_v2( td_t *td, unsigned char ch )
   Eingabe:
     td:       Zeiger auf eine mit open_tty erzeugte Datenstruktur
     ch:       Das zu schreibende Zeichen
-  Ausgabe:    Rueckgabewert von poll() wenn die Funktion fehlerfrei
-              ausgeführt wurde
+  Ausgabe:    0 oder die Fehlernummer von schreibe_byte_r
+*/
+int schreibe_daten_r( td_t *td, unsigned char ch )
+{
+  int rc;
+
+  rc = schreibe_byte_r( td, ch );
+  if( rc == NO_ERROR && ch == 0x10 ) // DLE als daten doppelt schreiben
+    rc = schreibe_byte_r( td, ch );
+
+  // Ein Datenbyte ist kein Steuerzeichen, DLE ACK in den Daten beendet kein Telegramm
+  td->tx_dle = 0;
+
+  return rc;
+}
+
+/*
+  schreibe_daten_v2
+
+  Wie schreibe_daten_r.
+
+  Ausgabe:    1 wenn die Funktion fehlerfrei ausgeführt wurde
 
   Fehlerbehandlung:
     Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
@@ -185,11 +351,9 @@ int schreibe_daten_v2( td_t *td, unsigned char ch )
 {
   int rc;
 
-  rc = schreibe_byte_v2( td, ch );
-  if( rc == 1 && ch == 0x10 ) // DLE als daten doppelt schreiben
-    rc = schreibe_byte_v2( td, ch );
-
-  return rc;
+  if( (rc = schreibe_daten_r(td, ch)) != NO_ERROR )
+    siglongjmp(td->env, rc);
+  return 1;
 }
 
 /* ------------------------------------------------------
@@ -220,6 +384,14 @@ td_t *open_tty( char *name )
         td->debug_level = 0;
         td->debug_handle = stderr;
 
+        td->puffer    = 1;
+        td->rx_anfang = 0;
+        td->rx_ende   = 0;
+        td->tx_laenge = 0;
+        td->tx_dle    = 0;
+        td->syscalls  = 0;
+        td->listen_arena = 1;
+
         td->mem      = Malloc(MEM_SIZE);
         td->mem_size = MEM_SIZE;
 
@@ -268,92 +440,103 @@ int close_tty( td_t * td )
 {
   tcsetattr(td->fd,TCSAFLUSH,&td->term2); // Terminalattribute restaurieren
   close(td->fd);                // Terminal schliessen
+  mem_arena_destroy( td->arena );
   Free( td->mem );
   Free( td );
   return 1;
 }
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    Funktion protokoll_start
-
-    Eingabe: td     Zeiger auf Datenstruktur mit allen notwendigen parametern
-             bef    S5 Befehl Definiert in s5lib.h
+    Funktion protokoll_start_r
 
-    Ausgabe: 1 wenn die Funktion fehlerfrei ausgeführt wurde
+    Eingabe: td      Zeiger auf Datenstruktur mit allen notwendigen parametern
+             bef     S5 Befehl Definiert in s5lib.h
+             antwort Rueckgabewert der CPU
 
-    Fehlerbehandlung:
-    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
-    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen zu dem Punkt,
-    der mit sigsetjmp definiert wurde.
+    Ausgabe: 0 oder die Fehlernummer
 
     Beschreibung:
     Die Protokollfolge ist für alle S5 Befehle geleich.
     Danach unterscheiden sich der Ablauf im Protokollablauf
 */
-int protokoll_start( td_t *td, unsigned char bef )
+int protokoll_start_r( td_t *td, unsigned char bef, int *antwort )
 {
   unsigned char ch;
-  int rc;
 
-  schreibe_byte_v2(td, STX);
-  lese_byte_v2(td, &ch, DLE, 1);
-  lese_byte_v2(td, &ch, ACK, 1);
-  schreibe_daten_v2(td, bef);      // Befehlsnummer
-  lese_byte_v2(td, &ch, STX, 1);
-  schreibe_byte_v2(td, DLE);
-  schreibe_byte_v2(td, ACK);
-  lese_byte_v2(td, &ch, 0, 0);
-  rc = (int) ch;
+  R_PRUEFEN( schreibe_byte_r(td, STX) );
+  R_PRUEFEN( lese_byte_r(td, &ch, DLE, 1) );
+  R_PRUEFEN( lese_byte_r(td, &ch, ACK, 1) );
+  R_PRUEFEN( schreibe_daten_r(td, bef) );      // Befehlsnummer
+  R_PRUEFEN( lese_byte_r(td, &ch, STX, 1) );
+  R_PRUEFEN( schreibe_byte_r(td, DLE) );
+  R_PRUEFEN( schreibe_byte_r(td, ACK) );
+  R_PRUEFEN( lese_byte_r(td, &ch, 0, 0) );
+  *antwort = (int) ch;
   if( ch == CR ) {
-    lese_byte_v2(td, &ch, STX, 1);
+    R_PRUEFEN( lese_byte_r(td, &ch, STX, 1) );
   }
-  lese_byte_v2(td, &ch, DLE, 1);
-  lese_byte_v2(td, &ch, ETX, 1);
-  schreibe_byte_v2(td, DLE);
-  schreibe_byte_v2(td, ACK);
-  return rc;
+  R_PRUEFEN( lese_byte_r(td, &ch, DLE, 1) );
+  R_PRUEFEN( lese_byte_r(td, &ch, ETX, 1) );
+  R_PRUEFEN( schreibe_byte_r(td, DLE) );
+  R_PRUEFEN( schreibe_byte_r(td, ACK) );
+  return NO_ERROR;
 }
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    Funktion protokoll_stop
-
-    Eingabe: td   Zeiger auf Datenstruktur
-
-    Ausgabe: Rueckgabewert der CPU (rc)
+    Funktion protokoll_start
 
+    Eingabe: td     Zeiger auf Datenstruktur mit allen notwendigen parametern
+             bef    S5 Befehl Definiert in s5lib.h
 
+    Ausgabe: Rueckgabewert der CPU
 
     Fehlerbehandlung:
     Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
-    Die Funktionen schreibe_byte_v2 und lese_byte_v2 springen zu dem Punkt,
+    Sie springt mit der Fehlernummer von protokoll_start_r zu dem Punkt,
     der mit sigsetjmp definiert wurde.
+*/
+int protokoll_start( td_t *td, unsigned char bef )
+{
+  int rc, antwort = 0;
+
+  if( (rc = protokoll_start_r(td, bef, &antwort)) != NO_ERROR )
+    siglongjmp(td->env, rc);
+  return antwort;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    Funktion protokoll_stopp_r
+
+    Eingabe: td      Zeiger auf Datenstruktur
+             antwort Rueckgabewert der CPU
+
+    Ausgabe: 0 oder die Fehlernummer
 
     Die Protokollfolge ist für alle S5 Befehle geleich.
     Davor unterscheiden sich der Ablauf im Protokollablauf
 
     Fehlermeldungen werden auf der Standart Fehlerausgabe protokolliert
 */
-int protokoll_stopp( td_t *td )
+int protokoll_stopp_r( td_t *td, int *antwort )
 {
   unsigned char ch;
-  int rc = 0;
 
-  lese_byte_v2(td, &ch, STX, 1);
-  schreibe_byte_v2(td,DLE);
-  schreibe_byte_v2(td,ACK);
-  lese_byte_v2(td, &ch, 0, 0);
+  R_PRUEFEN( lese_byte_r(td, &ch, STX, 1) );
+  R_PRUEFEN( schreibe_byte_r(td,DLE) );
+  R_PRUEFEN( schreibe_byte_r(td,ACK) );
+  R_PRUEFEN( lese_byte_r(td, &ch, 0, 0) );
 
-  rc = (int) ch;
-  switch( rc ) {
+  *antwort = (int) ch;
+  switch( ch ) {
     // Wenn DLE ein Datenbyte ist, DLE Doppelt Lesen
     // Ansonsten gehört DLE zum Protokoll und wird
     // nicht weiter verarbeitet
     case DLE: // 0x10
-      lese_byte_v2(td, &ch, 0, 0);
+      R_PRUEFEN( lese_byte_r(td, &ch, 0, 0) );
       if( ch == ETX ) {
-        schreibe_byte_v2(td,DLE);
-        schreibe_byte_v2(td,ACK);
-        return rc;
+        R_PRUEFEN( schreibe_byte_r(td,DLE) );
+        R_PRUEFEN( schreibe_byte_r(td,ACK) );
+        return NO_ERROR;
       }
       break;
 
@@ -372,16 +555,36 @@ int protokoll_stopp( td_t *td )
                 "In Funktion protokoll_stopp:\n" \
                 "Unerwartetes Zeichen %02X vom AG\n", ch );
       }
-      siglongjmp(td->env, CHAR_UNKNOWN );
-      break;
+      return td->errnr = CHAR_UNKNOWN;
   }
 
-  lese_byte_v2(td, &ch, DLE, 1);
-  lese_byte_v2(td, &ch, 0, 0);
-  schreibe_byte_v2(td,DLE);
-  schreibe_byte_v2(td,ACK);
+  R_PRUEFEN( lese_byte_r(td, &ch, DLE, 1) );
+  R_PRUEFEN( lese_byte_r(td, &ch, 0, 0) );
+  R_PRUEFEN( schreibe_byte_r(td,DLE) );
+  R_PRUEFEN( schreibe_byte_r(td,ACK) );
 
-  return rc;
+  return NO_ERROR;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    Funktion protokoll_stopp
+
+    Eingabe: td   Zeiger auf Datenstruktur
+
+    Ausgabe: Rueckgabewert der CPU (rc)
+
+    Fehlerbehandlung:
+    Die Funktion kehrt nicht zum Aufrufer zurück, wenn ein Fehler auftritt.
+    Sie springt mit der Fehlernummer von protokoll_stopp_r zu dem Punkt,
+    der mit sigsetjmp definiert wurde.
+*/
+int protokoll_stopp( td_t *td )
+{
+  int rc, antwort = 0;
+
+  if( (rc = protokoll_stopp_r(td, &antwort)) != NO_ERROR )
+    siglongjmp(td->env, rc);
+  return antwort;
 }
 
 // Speicher fuer Bausteine freigeben, die mit
@@ -419,15 +622,22 @@ int as511_set_bst_data( bs_t *bst, byte_t btyp, byte_t bnr, word_t code_size, by
 }
 
 
-// Datenstrom aus der SPS Lesen
-int as511_read_data( td_t *td )
+/* Datenstrom aus der SPS Lesen, bis DLE ETX
+
+   Eingabe: index  Anzahl der nach td->mem gelesenen Zeichen
+   Ausgabe: 0 oder die Fehlernummer. Passt der Datenstrom nicht in td->mem,
+            wird er bis zum Ende gelesen, der Rest verworfen und
+            OUT_OF_MEMORY zurückgegeben.
+*/
+int as511_read_data_r( td_t *td, unsigned int *index )
 {
-  int index = 0;
   unsigned char ch = 0;
   int DLEret = 0;
+  int voll = 0;
 
+  *index = 0;
   while( 1 ) {
-    lese_byte_v2(td,&ch,0,0 );
+    R_PRUEFEN( lese_byte_r(td,&ch,0,0 ) );
         // War das zuletzt gelesene Zeichen DLE und
         // ist das aktuelle Zeichen ETX wird hier die
         // Schleife beendet.
@@ -441,8 +651,24 @@ int as511_read_data( td_t *td )
       continue;
 
         // Alles andere wird hier gespeichert.
-    td->mem[index++] = ch;
+    if( *index < td->mem_size )
+      td->mem[(*index)++] = ch;
+    else
+      voll = 1;
   }
+  if( voll )
+    return td->errnr = OUT_OF_MEMORY;
+  return NO_ERROR;
+}
+
+// Datenstrom aus der SPS Lesen
+int as511_read_data( td_t *td )
+{
+  unsigned int index = 0;
+  int rc;
+
+  if( (rc = as511_read_data_r(td, &index)) != NO_ERROR )
+    siglongjmp(td->env, rc);
   return index;
 }
 
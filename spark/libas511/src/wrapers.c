@@ -32,7 +32,12 @@
 
 #define MEM_TEST 0
 
+/* Anzahl der mit Malloc belegten Bloecke, fuer alle Threads. Die Liste md
+   mit MEM_TEST ist nur fuer Tests mit einem Thread gedacht.
+*/
 int MallocZaehler;
+// Anzahl aller Malloc Aufrufe, fuer Messungen
+unsigned long MallocAnzahl;
 
 
 MD md;
@@ -50,7 +55,8 @@ void *Malloc( size_t size )
   }
 
   memset(p,0x00,size);
-  MallocZaehler++;
+  __sync_fetch_and_add(&MallocZaehler, 1);
+  __sync_fetch_and_add(&MallocAnzahl, 1);
 #if defined MEM_TEST && MEM_TEST > 0
   if( ++md.debug ) {
     if( (mli = malloc(sizeof(ML))) != NULL ) {
@@ -90,6 +96,42 @@ void Free( void *p )
     }
   }
 #endif
-  MallocZaehler--;
+  __sync_fetch_and_sub(&MallocZaehler, 1);
   free(p);
 }
+
+// Vor jedem Block von as511_malloc steht seine Laenge
+union speicher_kopf
+{
+  size_t      laenge;
+  long double ausrichtung;
+};
+
+void *as511_malloc( td_t *td, size_t size )
+{
+  union speicher_kopf *k;
+
+  if( (k = malloc(sizeof(union speicher_kopf) + size)) == NULL )
+    return NULL;
+
+  memset(k,0x00,sizeof(union speicher_kopf) + size);
+  k->laenge = size;
+  td->speicher_bloecke++;
+  td->speicher_bytes += size;
+  if( td->speicher_bytes > td->speicher_max )
+    td->speicher_max = td->speicher_bytes;
+  return k + 1;
+}
+
+void as511_free( td_t *td, void *p )
+{
+  union speicher_kopf *k;
+
+  if( p == NULL )
+    return;
+
+  k = (union speicher_kopf *)p - 1;
+  td->speicher_bloecke--;
+  td->speicher_bytes -= k->laenge;
+  free(k);
+}
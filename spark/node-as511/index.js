@@ -1,12 +1,23 @@
 var as511bindings = require('bindings')('as511bindings');
 
+// by default only merge items that touch or overlap, a negative gap turns coalescing off
+const DEFAULT_COALESCE_GAP = 0;
+
 function as511(device) {
     this.device = device;
+
+    // each instance gets its own link, so several PLCs can be used from one process
+    this.context = as511bindings.createContext();
+
+    // readMany reads items this close together with one telegram
+    this.coalesceGap = DEFAULT_COALESCE_GAP;
+
+    this.subscribed = false;
 }
 
 as511.prototype.openSync = function() {
     try {
-        as511bindings.openSync(this.device);
+        as511bindings.openSync(this.context, this.device);
     }
     catch(e){
         throw new Error(e);
@@ -14,8 +25,10 @@ as511.prototype.openSync = function() {
 };
 
 as511.prototype.closeSync = function() {
+    // the subscription thread stops on its own, the link is closed as soon as its cycle is done
+    this.unsubscribe(function() {});
     try {
-        as511bindings.closeSync();
+        as511bindings.closeSync(this.context);
     }
     catch(e){
         throw new Error(e);
@@ -23,8 +36,9 @@ as511.prototype.closeSync = function() {
 };
 
 as511.prototype.readSync = function(addr, size) {
+    var value;
     try {
-        value = as511bindings.readSync(addr, size);
+        value = as511bindings.readSync(this.context, addr, size);
     }
     catch(e){
         throw new Error(e);
@@ -34,11 +48,141 @@ as511.prototype.readSync = function(addr, size) {
 
 as511.prototype.writeSync = function(addr, size, buf) {
     try {
-        as511bindings.writeSync(addr, size, buf);
+        as511bindings.writeSync(this.context, addr, size, buf);
     }
     catch(e){
         throw new Error(e);
     }
 };
 
+// run fn(callback) with the callback given, or return a promise of its result when there is none
+function callbackOrPromise(callback, fn) {
+    if (typeof callback === 'function') {
+        return fn(callback);
+    }
+    return new Promise(function(resolve, reject) {
+        fn(function(err, value) {
+            if (err) return reject(err);
+            return resolve(value);
+        });
+    });
+}
+
+// The asynchronous calls do the serial dialogue on a worker thread, so a slow or absent PLC does not
+// hold up the event loop. Calls on the same instance are run one after the other.
+
+// set the largest number of unused bytes between two items that readMany still reads together
+as511.prototype.setCoalesceGap = function(gap) {
+    this.coalesceGap = gap;
+};
+
+// read a list of { address, size } items in one worker. The callback gets an array with a buffer per
+// item, or null where that item failed, and an array with the matching error or null. Without a
+// callback the promise resolves to { values, errors }
+as511.prototype.readMany = function(items, callback) {
+    var self = this;
+    if (typeof callback !== 'function') {
+        return new Promise(function(resolve, reject) {
+            self.readMany(items, function(err, values, errors) {
+                if (err) return reject(err);
+                return resolve({ values: values, errors: errors });
+            });
+        });
+    }
+
+    var addrs = [], sizes = [];
+    for (var i = 0; i < items.length; i++) {
+        addrs.push(items[i].address);
+        sizes.push(items[i].size);
+    }
+    try {
+        as511bindings.readMany(self.context, addrs, sizes, self.coalesceGap, function(err, values, errors) {
+            if (err) return callback(err);
+            return callback(null, values, errors.map(function(error) {
+                return error === null ? null : new Error(error);
+            }));
+        });
+    }
+    catch(e){
+        process.nextTick(callback, new Error(e));
+    }
+    return undefined;
+};
+
+as511.prototype.read = function(addr, size, callback) {
+    var self = this;
+    return callbackOrPromise(callback, function(done) {
+        self.readMany([{ address: addr, size: size }], function(err, values, errors) {
+            if (err) return done(err);
+            if (errors[0]) return done(errors[0]);
+            return done(null, values[0]);
+        });
+    });
+};
+
+as511.prototype.write = function(addr, size, buf, callback) {
+    var self = this;
+    return callbackOrPromise(callback, function(done) {
+        try {
+            as511bindings.write(self.context, addr, size, buf, function(err) {
+                return done(err || null);
+            });
+        }
+        catch(e){
+            process.nextTick(done, new Error(e));
+        }
+    });
+};
+
+// watch a list of { address, size } items with the STATUS VAR function of the PLC, every periodMs.
+// Instead of a read telegram per item and cycle, the list is sent to the PLC once and each cycle
+// is one telegram. callback(err, changes) is called from the event loop for every cycle in which
+// an item changed, changes maps the index of each changed item to a buffer with its new bytes.
+// The first cycle, and the first good one after err was set, reports every item. Reads and writes
+// can still be made while subscribed, they interrupt the dialogue which is started again by the
+// next cycle.
+as511.prototype.subscribe = function(items, periodMs, callback) {
+    var self = this;
+
+    if (self.subscribed === true) {
+        return process.nextTick(callback, new Error('Already subscribed'));
+    }
+
+    var addrs = [], sizes = [];
+    for (var i = 0; i < items.length; i++) {
+        addrs.push(items[i].address);
+        sizes.push(items[i].size);
+    }
+    try {
+        as511bindings.subscribe(self.context, addrs, sizes, periodMs, function(err, indexes, values) {
+            var changes = {};
+            for (var j = 0; j < indexes.length; j++) {
+                changes[indexes[j]] = values[j];
+            }
+            callback(err || null, changes);
+        });
+        self.subscribed = true;
+    }
+    catch(e){
+        process.nextTick(callback, new Error(e));
+    }
+    return undefined;
+};
+
+as511.prototype.unsubscribe = function(callback) {
+    var self = this;
+    return callbackOrPromise(callback, function(done) {
+        if (self.subscribed !== true) {
+            return process.nextTick(done, null);
+        }
+        self.subscribed = false;
+
+        // done is called once the native thread has stopped and the PLC left the dialogue
+        if (!as511bindings.unsubscribe(self.context, function() { done(null); })) {
+            return process.nextTick(done, null);
+        }
+        return undefined;
+    });
+};
+
 module.exports = as511;
@@ -0,0 +1,230 @@
+/*
+  Copyright (C) 2002-2009 Peter Schnabel
+
+  Datei:   read_ram_pty.c
+  Datum:   17.10.2026
+  Version: 0.0.1
+
+  Messprogramm für as511_read_ram. Ein Kindprozess spielt auf der Master
+  Seite eines Pseudoterminals die SPS und beantwortet S5_READ_MEM. Der
+  Elternprozess liest über die Slave Seite mit as511_read_ram, einmal mit
+  td->puffer = 0 (jedes Zeichen mit eigenem poll() und read()/write()) und
+  einmal gepuffert, und gibt Systemaufrufe und Zeit je Aufruf aus.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+#define _GNU_SOURCE
+#include <setjmp.h>
+#include <unistd.h>
+#include <termios.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include <as511_s5lib.h>
+
+static void usage( void )
+{
+  printf("Aufruf: read_ram_pty [-n<anzahl>] [-l<laenge>] [-d]\n");
+  printf("-n<anzahl> Anzahl as511_read_ram je Durchlauf. Vorgabe 200.\n");
+  printf("-l<laenge> Anzahl Bytes je as511_read_ram. Vorgabe 64.\n");
+  printf("-d         Alle Zeichen auf stderr ausgeben.\n");
+}
+
+/*
+  Die SPS:
+*/
+static int plc_fd;
+
+static unsigned char plc_lese( void )
+{
+  unsigned char ch;
+
+  if( read(plc_fd, &ch, 1) != 1 )
+    _exit(0);
+  return ch;
+}
+
+// Datenbyte lesen, DLE kommt doppelt
+static unsigned char plc_lese_daten( void )
+{
+  unsigned char ch = plc_lese();
+
+  if( ch == DLE )
+    plc_lese();
+  return ch;
+}
+
+static void plc_schreibe( const unsigned char *p, int n )
+{
+  if( write(plc_fd, p, n) != n )
+    _exit(0);
+}
+
+static void plc( void )
+{
+  static const unsigned char dle_ack[] = { DLE, ACK };
+  static const unsigned char dle_ack_stx[] = { DLE, ACK, STX };
+  static const unsigned char start_ende[] = { 0x16, DLE, ETX };
+  static const unsigned char stopp_ende[] = { DC2, DLE, ETX };
+  static const unsigned char stx[] = { STX };
+  unsigned char b[2 * 65536 + 16];
+  unsigned int adr, ende, i;
+  int n;
+  unsigned char bef;
+
+  while( 1 ) {
+    // protokoll_start
+    while( plc_lese() != STX );
+    plc_schreibe(dle_ack, 2);
+    bef = plc_lese_daten();
+    plc_schreibe(stx, 1);
+    plc_lese(); plc_lese();
+    plc_schreibe(start_ende, 3);
+    plc_lese(); plc_lese();
+
+    if( bef != S5_READ_MEM )
+      continue;
+
+    adr   = plc_lese_daten() << 8;
+    adr  |= plc_lese_daten();
+    ende  = plc_lese_daten() << 8;
+    ende |= plc_lese_daten();
+    plc_lese(); plc_lese(); // DLE EOT
+    plc_schreibe(dle_ack_stx, 3);
+    plc_lese(); plc_lese();
+
+    // 5 Zeichen vor den Daten, dann der Speicherinhalt = niederwertiges Adressbyte
+    n = 0;
+    for( i = 0; i < 5; i++ )
+      b[n++] = 0;
+    for( i = adr; i <= ende; i++ ) {
+      b[n++] = i & 0xFF;
+      if( (i & 0xFF) == DLE )
+        b[n++] = DLE;
+    }
+    b[n++] = DLE;
+    b[n++] = ETX;
+    plc_schreibe(b, n);
+    plc_lese(); plc_lese();
+
+    // protokoll_stopp
+    plc_schreibe(stx, 1);
+    plc_lese(); plc_lese();
+    plc_schreibe(stopp_ende, 3);
+    plc_lese(); plc_lese();
+  }
+}
+
+/*
+  Die Messung:
+*/
+static int lauf( td_t *td, int puffer, int anzahl, int laenge )
+{
+  struct timeval t1, t2;
+  unsigned long syscalls;
+  double usec;
+  sps_ram_t *ram;
+  int i, j;
+
+  td->puffer = puffer;
+  syscalls = td->syscalls;
+  gettimeofday(&t1, NULL);
+  for( i = 0; i < anzahl; i++ ) {
+    if( (ram = as511_read_ram(td, (unsigned short)(i * laenge), (unsigned short)laenge)) == NULL ) {
+      printf("as511_read_ram %d fehlgeschlagen: %04X\n", i, td->errnr);
+      return 1;
+    }
+    for( j = 0; j < (int)ram->laenge; j++ ) {
+      if( ram->ptr[j] != ((i * laenge + j) & 0xFF) ) {
+        printf("as511_read_ram %d: falsche Daten an Byte %d\n", i, j);
+        as511_read_ram_free(td, ram);
+        return 1;
+      }
+    }
+    as511_read_ram_free(td, ram);
+  }
+  gettimeofday(&t2, NULL);
+  usec = 1e6 * (t2.tv_sec - t1.tv_sec) + t2.tv_usec - t1.tv_usec;
+
+  printf("%-14s %8.1f Systemaufrufe %10.1f usec je as511_read_ram\n",
+         puffer ? "gepuffert" : "ungepuffert",
+         (double)(td->syscalls - syscalls) / anzahl, usec / anzahl);
+  return 0;
+}
+
+int main( int argc, char **argv )
+{
+  int master, rc, anzahl = 200, laenge = 64, debug = 0;
+  struct termios t;
+  pid_t pid;
+  td_t *td;
+
+  while( argc > 1 ) {
+    if( strncmp(argv[1], "-n", 2) == 0 ) {
+      anzahl = atoi(argv[1] + 2);
+    } else if( strncmp(argv[1], "-l", 2) == 0 ) {
+      laenge = atoi(argv[1] + 2);
+    } else if( strcmp(argv[1], "-d") == 0 ) {
+      debug = 1;
+    } else {
+      usage();
+      return 1;
+    }
+    argc--;
+    argv++;
+  }
+  if( laenge < 1 || laenge > 512 ) {
+    printf("laenge muss zwischen 1 und 512 liegen\n");
+    return 1;
+  }
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if( master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ) {
+    printf("Kein Pseudoterminal\n");
+    return 1;
+  }
+  tcgetattr(master, &t);
+  cfmakeraw(&t);
+  tcsetattr(master, TCSANOW, &t);
+
+  if( (td = open_tty(ptsname(master))) == NULL ) {
+    printf("Kann %s nicht öffnen\n", ptsname(master));
+    return 1;
+  }
+  if( debug )
+    td->debug_level = DEBUG_LEVEL_ALL;
+
+  if( (pid = fork()) == 0 ) {
+    plc_fd = master;
+    plc();
+    _exit(0);
+  }
+
+  printf("%d mal as511_read_ram mit %d Bytes\n", anzahl, laenge);
+  rc = lauf(td, 0, anzahl, laenge);
+  if( rc == 0 )
+    rc = lauf(td, 1, anzahl, laenge);
+
+  kill(pid, SIGTERM);
+  waitpid(pid, NULL, 0);
+  close_tty(td);
+  close(master);
+  return rc;
+}
@@ -0,0 +1,422 @@
+/*
+  Copyright (C) 2002-2009 Peter Schnabel
+
+  Datei:   stress_pty.c
+  Datum:   17.10.2026
+  Version: 0.0.1
+
+  Belastungstest für die Funktionen ohne siglongjmp. Für jede Schnittstelle
+  wird ein Pseudoterminal geöffnet, ein Thread spielt auf der Master Seite
+  die SPS mit 64 KByte Speicher und beantwortet S5_READ_MEM und
+  S5_WRITE_MEM. Ein zweiter Thread je Schnittstelle schreibt und liest mit
+  as511_write_ram_r, as511_read_ram_r und as511_read_ram_multi_r zufällige
+  Bereiche und vergleicht sie mit seinem Abbild des SPS Speichers. Alle
+  Schnittstellen laufen gleichzeitig.
+
+  Die SPS beantwortet jede FEHLER_ALLE-te Anfrage nicht (SPS_TIMEOUT) oder
+  mit DLE NAK (CHAR_UNKNOWN). Jeder dieser Fehler muss genau einmal an den
+  Aufrufer zurückgegeben werden, danach wird die Anfrage wiederholt.
+  Geprüft wird ausserdem, dass am Ende kein mit as511_malloc belegter
+  Speicher mehr belegt ist.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+#define _GNU_SOURCE
+#include <setjmp.h>
+#include <unistd.h>
+#include <termios.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <as511_s5lib.h>
+
+// Jede wievielte Anfrage die SPS nicht oder falsch beantwortet
+#define FEHLER_ALLE 37
+// Überwachungszeit in ms, kürzer als TIMEOUT, damit die Timeouts den Test
+// nicht bremsen
+#define TEST_TIMEOUT 200
+// So oft wird eine fehlgeschlagene Anfrage wiederholt
+#define VERSUCHE 5
+
+extern int MallocZaehler;
+
+struct port
+{
+  int            nr;
+  int            master;    // Master Seite des Pseudoterminals, die SPS
+  td_t          *td;        // Slave Seite, das PG
+  int            anzahl;    // Anzahl Aufträge des PG
+  unsigned int   seed;
+  unsigned char  sps[65536];    // Speicher der SPS
+  unsigned char  abbild[65536]; // Speicher der SPS, wie ihn das PG erwartet
+  unsigned long  anfragen;  // von der SPS beantwortete protokoll_start
+  unsigned long  injiziert; // davon absichtlich falsch beantwortet
+  unsigned long  gemeldet;  // vom PG empfangene Fehler
+  int            ergebnis;  // 0 = OK
+  pthread_t      plc_thread;
+  pthread_t      pg_thread;
+};
+
+static void usage( void )
+{
+  printf("Aufruf: stress_pty [-p<schnittstellen>] [-n<anzahl>] [-d]\n");
+  printf("-p<schnittstellen> Anzahl gleichzeitiger Schnittstellen. Vorgabe 8.\n");
+  printf("-n<anzahl> Anzahl Aufträge je Schnittstelle. Vorgabe 300.\n");
+  printf("-d         Alle Zeichen auf stderr ausgeben.\n");
+}
+
+/*
+  Die SPS:
+*/
+static unsigned char plc_lese( struct port *p )
+{
+  unsigned char ch;
+
+  // Das PG hat die Slave Seite geschlossen, die SPS wird nicht mehr gebraucht
+  if( read(p->master, &ch, 1) != 1 )
+    pthread_exit(NULL);
+  return ch;
+}
+
+// Datenbyte lesen, DLE kommt doppelt
+static unsigned char plc_lese_daten( struct port *p )
+{
+  unsigned char ch = plc_lese(p);
+
+  if( ch == DLE )
+    plc_lese(p);
+  return ch;
+}
+
+static void plc_schreibe( struct port *p, const unsigned char *b, int n )
+{
+  if( write(p->master, b, n) != n )
+    pthread_exit(NULL);
+}
+
+static void *plc( void *arg )
+{
+  static const unsigned char dle_ack[] = { DLE, ACK };
+  static const unsigned char dle_nak[] = { DLE, NAK };
+  static const unsigned char dle_ack_stx[] = { DLE, ACK, STX };
+  static const unsigned char start_ende[] = { 0x16, DLE, ETX };
+  static const unsigned char stopp_ende[] = { DC2, DLE, ETX };
+  static const unsigned char stx[] = { STX };
+  struct port *p = arg;
+  unsigned char b[2 * RAM_TELEGRAMM_MAX + 16];
+  unsigned int adr, ende, i;
+  int n;
+  unsigned char bef, ch;
+
+  while( 1 ) {
+    // protokoll_start
+    while( plc_lese(p) != STX );
+    if( ++p->anfragen % FEHLER_ALLE == 0 ) {
+      if( ++p->injiziert % 2 )
+        continue;                   // keine Antwort, das PG läuft in SPS_TIMEOUT
+      plc_schreibe(p, dle_nak, 2);  // falsche Antwort, CHAR_UNKNOWN
+      continue;
+    }
+    plc_schreibe(p, dle_ack, 2);
+    bef = plc_lese_daten(p);
+    plc_schreibe(p, stx, 1);
+    plc_lese(p); plc_lese(p);
+    plc_schreibe(p, start_ende, 3);
+    plc_lese(p); plc_lese(p);
+
+    if( bef == S5_READ_MEM ) {
+      adr   = plc_lese_daten(p) << 8;
+      adr  |= plc_lese_daten(p);
+      ende  = plc_lese_daten(p) << 8;
+      ende |= plc_lese_daten(p);
+      plc_lese(p); plc_lese(p); // DLE EOT
+      plc_schreibe(p, dle_ack_stx, 3);
+      plc_lese(p); plc_lese(p);
+
+      // 5 Zeichen vor den Daten, dann der Speicherinhalt
+      n = 0;
+      for( i = 0; i < 5; i++ )
+        b[n++] = 0;
+      for( i = adr; i <= ende && n < (int)sizeof(b) - 4; i++ ) {
+        b[n++] = p->sps[i & 0xFFFF];
+        if( b[n - 1] == DLE )
+          b[n++] = DLE;
+      }
+      b[n++] = DLE;
+      b[n++] = ETX;
+      plc_schreibe(p, b, n);
+      plc_lese(p); plc_lese(p);
+    }
+    else if( bef == S5_WRITE_MEM ) {
+      adr   = plc_lese_daten(p) << 8;
+      adr  |= plc_lese_daten(p);
+      while( 1 ) {
+        ch = plc_lese(p);
+        if( ch == DLE && plc_lese(p) == EOT )
+          break;
+        p->sps[adr++ & 0xFFFF] = ch;
+      }
+      plc_schreibe(p, dle_ack, 2);
+    }
+    else {
+      continue;
+    }
+
+    // protokoll_stopp
+    plc_schreibe(p, stx, 1);
+    plc_lese(p); plc_lese(p);
+    plc_schreibe(p, stopp_ende, 3);
+    plc_lese(p); plc_lese(p);
+  }
+  return NULL;
+}
+
+/*
+  Das PG:
+*/
+
+// Ein Fehler der SPS muss SPS_TIMEOUT oder CHAR_UNKNOWN sein
+static int pruefe_fehler( struct port *p, const char *was, int rc )
+{
+  p->gemeldet++;
+  if( rc == SPS_TIMEOUT || rc == CHAR_UNKNOWN )
+    return 0;
+  printf("Schnittstelle %d: %s Fehler %04X\n", p->nr, was, rc);
+  return 1;
+}
+
+static int schreiben( struct port *p, unsigned short adr, unsigned short laenge )
+{
+  unsigned char daten[65536];
+  int i, rc, versuch;
+
+  for( i = 0; i < laenge; i++ )
+    daten[i] = (unsigned char) rand_r(&p->seed);
+
+  for( versuch = 0; versuch < VERSUCHE; versuch++ ) {
+    if( (rc = as511_write_ram_r(p->td, adr, laenge, daten)) == NO_ERROR ) {
+      memcpy(&p->abbild[adr], daten, laenge);
+      return 0;
+    }
+    if( pruefe_fehler(p, "as511_write_ram_r", rc) )
+      return 1;
+  }
+  printf("Schnittstelle %d: as511_write_ram_r gibt nicht auf\n", p->nr);
+  return 1;
+}
+
+static int lesen( struct port *p, unsigned short adr, unsigned short laenge )
+{
+  unsigned char daten[65536];
+  int rc, versuch;
+
+  for( versuch = 0; versuch < VERSUCHE; versuch++ ) {
+    if( (rc = as511_read_ram_r(p->td, adr, laenge, daten)) == NO_ERROR ) {
+      if( memcmp(daten, &p->abbild[adr], laenge) != 0 ) {
+        printf("Schnittstelle %d: as511_read_ram_r falsche Daten an %04X\n", p->nr, adr);
+        return 1;
+      }
+      return 0;
+    }
+    if( pruefe_fehler(p, "as511_read_ram_r", rc) )
+      return 1;
+  }
+  printf("Schnittstelle %d: as511_read_ram_r gibt nicht auf\n", p->nr);
+  return 1;
+}
+
+/* Vier Bereiche in einem 1 KByte Fenster, mit luecke so gross, dass sie
+   zusammengefasst werden. Ein Fehler bricht den einen Bereich ab, jeder
+   Aufruf meldet darum hoechstens einen Fehler der SPS.
+*/
+static int lesen_multi( struct port *p )
+{
+  rb_t rb[4];
+  sps_ram_t *ram;
+  unsigned int basis = rand_r(&p->seed) % (65536 - 1024 - 64);
+  int i, rc, versuch;
+
+  for( i = 0; i < 4; i++ ) {
+    rb[i].adr    = (unsigned short)(basis + rand_r(&p->seed) % 1024);
+    rb[i].laenge = (unsigned short)(1 + rand_r(&p->seed) % 64);
+  }
+
+  for( versuch = 0; versuch < VERSUCHE; versuch++ ) {
+    rc = as511_read_ram_multi_r(p->td, rb, 4, 1100, &ram);
+    if( ram == NULL ) {
+      printf("Schnittstelle %d: as511_read_ram_multi_r ohne Puffer, Fehler %04X\n", p->nr, rc);
+      return 1;
+    }
+    if( rc == NO_ERROR ) {
+      for( i = 0; i < 4; i++ ) {
+        if( rb[i].ptr == NULL || memcmp(rb[i].ptr, &p->abbild[rb[i].adr], rb[i].laenge) != 0 ) {
+          printf("Schnittstelle %d: as511_read_ram_multi_r falsche Daten an %04X\n", p->nr, rb[i].adr);
+          as511_read_ram_free(p->td, ram);
+          return 1;
+        }
+      }
+      as511_read_ram_free(p->td, ram);
+      return 0;
+    }
+    as511_read_ram_free(p->td, ram);
+    if( pruefe_fehler(p, "as511_read_ram_multi_r", rc) )
+      return 1;
+  }
+  printf("Schnittstelle %d: as511_read_ram_multi_r gibt nicht auf\n", p->nr);
+  return 1;
+}
+
+static void *pg( void *arg )
+{
+  struct port *p = arg;
+  unsigned int adr, laenge;
+  int i;
+
+  for( i = 0; i < p->anzahl && p->ergebnis == 0; i++ ) {
+    // Auch Bereiche über 512 Bytes, die mehrere Telegramme brauchen
+    adr    = rand_r(&p->seed) % 65536;
+    laenge = 1 + rand_r(&p->seed) % 700;
+    if( adr + laenge > 65536 )
+      laenge = 65536 - adr;
+
+    switch( rand_r(&p->seed) % 3 ) {
+      case 0:
+        p->ergebnis = schreiben(p, adr, laenge);
+        break;
+      case 1:
+        p->ergebnis = lesen(p, adr, laenge);
+        break;
+      case 2:
+        p->ergebnis = lesen_multi(p);
+        break;
+    }
+  }
+
+  if( p->ergebnis == 0 && p->td->speicher_bloecke != 0 ) {
+    printf("Schnittstelle %d: %ld Speicherbloecke nicht freigegeben\n", p->nr, p->td->speicher_bloecke);
+    p->ergebnis = 1;
+  }
+  return NULL;
+}
+
+static int port_oeffnen( struct port *p, int debug )
+{
+  struct termios t;
+  int i;
+
+  p->master = posix_openpt(O_RDWR | O_NOCTTY);
+  if( p->master < 0 || grantpt(p->master) != 0 || unlockpt(p->master) != 0 ) {
+    printf("Kein Pseudoterminal\n");
+    return 1;
+  }
+  tcgetattr(p->master, &t);
+  cfmakeraw(&t);
+  tcsetattr(p->master, TCSANOW, &t);
+
+  if( (p->td = open_tty(ptsname(p->master))) == NULL ) {
+    printf("Kann %s nicht öffnen\n", ptsname(p->master));
+    return 1;
+  }
+  p->td->timeout = TEST_TIMEOUT;
+  if( debug )
+    p->td->debug_level = DEBUG_LEVEL_ALL;
+
+  // Beide Seiten kennen den Speicher der SPS
+  for( i = 0; i < 65536; i++ )
+    p->sps[i] = p->abbild[i] = (unsigned char)(i ^ p->nr);
+  return 0;
+}
+
+int main( int argc, char **argv )
+{
+  int i, anzahl_ports = 8, anzahl = 300, debug = 0, rc = 0;
+  unsigned long injiziert = 0, gemeldet = 0, anfragen = 0;
+  struct port *ports;
+  struct timeval t1, t2;
+  double sec;
+
+  while( argc > 1 ) {
+    if( strncmp(argv[1], "-p", 2) == 0 ) {
+      anzahl_ports = atoi(argv[1] + 2);
+    } else if( strncmp(argv[1], "-n", 2) == 0 ) {
+      anzahl = atoi(argv[1] + 2);
+    } else if( strcmp(argv[1], "-d") == 0 ) {
+      debug = 1;
+    } else {
+      usage();
+      return 1;
+    }
+    argc--;
+    argv++;
+  }
+  if( anzahl_ports < 1 || anzahl < 1 ) {
+    usage();
+    return 1;
+  }
+
+  if( (ports = calloc(anzahl_ports, sizeof(struct port))) == NULL ) {
+    printf("Kein Speicher\n");
+    return 1;
+  }
+  for( i = 0; i < anzahl_ports; i++ ) {
+    ports[i].nr = i;
+    ports[i].anzahl = anzahl;
+    ports[i].seed = 1000 + i;
+    if( port_oeffnen(&ports[i], debug) )
+      return 1;
+  }
+
+  printf("%d Schnittstellen mit je %d Aufträgen\n", anzahl_ports, anzahl);
+  gettimeofday(&t1, NULL);
+  for( i = 0; i < anzahl_ports; i++ ) {
+    pthread_create(&ports[i].plc_thread, NULL, plc, &ports[i]);
+    pthread_create(&ports[i].pg_thread, NULL, pg, &ports[i]);
+  }
+  for( i = 0; i < anzahl_ports; i++ )
+    pthread_join(ports[i].pg_thread, NULL);
+  gettimeofday(&t2, NULL);
+  sec = (t2.tv_sec - t1.tv_sec) + (t2.tv_usec - t1.tv_usec) / 1e6;
+
+  for( i = 0; i < anzahl_ports; i++ ) {
+    // Schliessen der Slave Seite beendet den SPS Thread
+    close_tty(ports[i].td);
+    pthread_join(ports[i].plc_thread, NULL);
+    close(ports[i].master);
+
+    if( ports[i].ergebnis == 0 && ports[i].gemeldet != ports[i].injiziert ) {
+      printf("Schnittstelle %d: %lu Fehler injiziert, %lu gemeldet\n",
+             i, ports[i].injiziert, ports[i].gemeldet);
+      ports[i].ergebnis = 1;
+    }
+    rc |= ports[i].ergebnis;
+    anfragen  += ports[i].anfragen;
+    injiziert += ports[i].injiziert;
+    gemeldet  += ports[i].gemeldet;
+  }
+
+  if( MallocZaehler != 0 ) {
+    printf("%d mit Malloc belegte Bloecke nicht freigegeben\n", MallocZaehler);
+    rc = 1;
+  }
+
+  printf("%lu Telegramme in %.2f s, %lu Fehler injiziert, %lu gemeldet: %s\n",
+         anfragen, sec, injiziert, gemeldet, rc ? "FEHLER" : "OK");
+  free(ports);
+  return rc;
+}
@@ -62,8 +62,9 @@ bstack_t *as511_read_bstack( td_t * td )
 
         // Das Erste Zeichen ist ein Rückgabewert oder Datenmuell ???
         if( --index ) {
-          b = Malloc(sizeof(bstack_t));
-          b->ptr = Malloc(index);
+          // Der Stack liegt direkt hinter dem Kopf, ein Malloc fuer beides
+          b = Malloc(sizeof(bstack_t) + index);
+          b->ptr = (bstackfmt *)(b + 1);
           b->laenge = index / sizeof(bstackfmt);
           memcpy(b->ptr, &td->mem[1], index);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -89,7 +90,7 @@ bstack_t *as511_read_bstack( td_t * td )
 void  as511_read_bstack_free( td_t *td, bstack_t *b )
 {
   if( td && b ) {
-    if( b->ptr ) {
+    if( b->ptr && b->ptr != (bstackfmt *)(b + 1) ) {
       Free(b->ptr);
     }
     Free(b);
@@ -42,7 +42,7 @@
 bal_t  *as511_read_module_addr_list( td_t *td, unsigned char bst_typ )
 {
   bal_t *bal = NULL;
-  syspar_t *sp;
+  syspar_t sp;
   word_t l;
 
   unsigned char ch;
@@ -50,8 +50,8 @@ bal_t  *as511_read_module_addr_list( td_t *td, unsigned char bst_typ )
 
   td->errnr = 0;
 
-  if( (sp = as511_read_system_parameter( td )) != NULL ) {
-    if((l = as511_get_bst_addr_size( td, sp, bst_typ )) > 0 ) {
+  if( as511_read_system_parameter_buf( td, &sp ) ) {
+    if((l = as511_get_bst_addr_size( td, &sp, bst_typ )) > 0 ) {
       if( sigsetjmp(td->env, 1) == 0 ) {
         if( protokoll_start( td, S5_READ_BST_ADDR_LIST ) ) {
           schreibe_daten_v2(td, bst_typ);
@@ -70,22 +70,21 @@ bal_t  *as511_read_module_addr_list( td_t *td, unsigned char bst_typ )
 
           if (protokoll_stopp( td ) ) {
             index--;
-            bal = Malloc( sizeof( bal_t ) );
-            bal->ptr = Malloc( l );
+            // Die Liste liegt direkt hinter dem Kopf, ein Malloc fuer beides
+            bal = Malloc( sizeof( bal_t ) + l );
+            bal->ptr = (unsigned short *)(bal + 1);
 
             memcpy(bal->ptr, &td->mem[1], l );
             bal->laenge = l;
 #if __BYTE_ORDER == __LITTLE_ENDIAN
             swab(bal->ptr, bal->ptr, l );
 #endif
-            as511_read_system_parameter_free( td, sp );
             return bal;
           }
         }
       }
     }
   }
-  as511_read_system_parameter_free( td, sp );
   return NULL;
 }
 
@@ -93,7 +92,7 @@ bal_t  *as511_read_module_addr_list( td_t *td, unsigned char bst_typ )
 void  as511_read_module_addr_list_free( td_t *td, bal_t *bal )
 {
   if( td != NULL && bal != NULL ) {
-    if( bal->ptr != NULL ) {
+    if( bal->ptr != NULL && bal->ptr != (unsigned short *)(bal + 1) ) {
       Free(bal->ptr);
     }
     Free(bal);
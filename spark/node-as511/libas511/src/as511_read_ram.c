@@ -36,12 +36,73 @@
 #define  _S5LIB_C_
 #include <as511_s5lib.h>
 
-// Speicherinhalte vom AG ins PG übertragen
-sps_ram_t * as511_read_ram( td_t *td, unsigned short adr, unsigned short laenge )
+/* Ein S5_READ_MEM Telegramm mit hoechstens RAM_TELEGRAMM_MAX Bytes, die
+   Daten werden direkt nach ziel kopiert.
+   Ausgabe: 0 oder die Fehlernummer
+*/
+static int lese_telegramm_r( td_t *td, unsigned short adr, unsigned short laenge, unsigned char *ziel )
 {
-  sps_ram_t *tmp = NULL;
   unsigned char ch;
   unsigned int index = 0;
+  int antwort;
+
+  R_PRUEFEN( protokoll_start_r( td, S5_READ_MEM, &antwort ) );
+  if( !antwort )
+    return td->errnr = CHAR_UNKNOWN;
+
+  R_PRUEFEN( schreibe_daten_r(td, HI(adr)) );
+  R_PRUEFEN( schreibe_daten_r(td, LO(adr)) );
+  R_PRUEFEN( schreibe_daten_r(td, HI(adr+laenge-1)) );
+  R_PRUEFEN( schreibe_daten_r(td, LO(adr+laenge-1)) );
+  R_PRUEFEN( schreibe_byte_r(td, DLE) );
+  R_PRUEFEN( schreibe_byte_r(td, EOT) );
+  R_PRUEFEN( lese_byte_r(td, &ch, DLE, 1) );
+  R_PRUEFEN( lese_byte_r(td, &ch, ACK, 1) );
+  R_PRUEFEN( lese_byte_r(td, &ch, STX, 1) );
+  R_PRUEFEN( schreibe_byte_r(td,DLE) );
+  R_PRUEFEN( schreibe_byte_r(td,ACK) );
+  R_PRUEFEN( as511_read_data_r( td, &index ) );
+  R_PRUEFEN( schreibe_byte_r(td,DLE) );
+  R_PRUEFEN( schreibe_byte_r(td,ACK) );
+  R_PRUEFEN( protokoll_stopp_r( td, &antwort ) );
+
+  // Die Ersten 5 Zeichen sid offensichtlich Datenmuell ???
+  if( index < 5 + (unsigned int)laenge )
+    return td->errnr = CHAR_UNKNOWN;
+  memcpy(ziel, &td->mem[5], laenge);
+  return NO_ERROR;
+}
+
+/* Speicherinhalte vom AG ins PG übertragen, ohne siglongjmp und ohne
+   Speicher zu belegen. Mehr als RAM_TELEGRAMM_MAX Bytes werden mit
+   mehreren Telegrammen hintereinander gelesen.
+
+   Eingabe: ziel  Puffer des Aufrufers fuer laenge Bytes
+   Ausgabe: 0 oder die Fehlernummer, die auch in td->errnr steht
+*/
+int as511_read_ram_r( td_t *td, unsigned short adr, unsigned short laenge, unsigned char *ziel )
+{
+  unsigned int offset, n;
+  int rc;
+
+  if( td == NULL || (ziel == NULL && laenge > 0) )
+    return BAD_PARAMETER;
+
+  td->errnr = 0;
+  for( offset = 0; offset < laenge; offset += n ) {
+    n = laenge - offset;
+    if( n > RAM_TELEGRAMM_MAX )
+      n = RAM_TELEGRAMM_MAX;
+    if( (rc = lese_telegramm_r( td, (unsigned short)(adr + offset), (unsigned short)n, &ziel[offset] )) != NO_ERROR )
+      return td->errnr = rc;
+  }
+  return NO_ERROR;
+}
+
+// Speicherinhalte vom AG ins PG übertragen
+sps_ram_t * as511_read_ram( td_t *td, unsigned short adr, unsigned short laenge )
+{
+  sps_ram_t *tmp;
 
   td->errnr = 0;
 
@@ -50,36 +111,19 @@ sps_ram_t * as511_read_ram( td_t *td, unsigned short adr, unsigned short laenge
   if( laenge > 512 )
     laenge = 512;
 
-  if( sigsetjmp(td->env, 1) == 0 ) {
-    if( protokoll_start( td, S5_READ_MEM ) ) {
-      schreibe_daten_v2(td, HI(adr));
-      schreibe_daten_v2(td, LO(adr));
-      schreibe_daten_v2(td, HI(adr+laenge-1));
-      schreibe_daten_v2(td, LO(adr+laenge-1));
-      schreibe_byte_v2(td, DLE);
-      schreibe_byte_v2(td, EOT);
-      lese_byte_v2(td, &ch, DLE, 1);
-      lese_byte_v2(td, &ch, ACK, 1);
-      lese_byte_v2(td, &ch, STX, 1);
-      schreibe_byte_v2(td,DLE);
-      schreibe_byte_v2(td,ACK);
-      index = as511_read_data( td );
-      schreibe_byte_v2(td,DLE);       //  PG 0x10   DLE
-      schreibe_byte_v2(td,ACK);       //  PG 0x06   ACK
-
-      index -= 5; // Die Ersten 5 Zeichen sid offensichtlich Datenmuell ???
+  if( (tmp = as511_malloc(td, sizeof(sps_ram_t))) == NULL ||
+      (tmp->ptr = as511_malloc(td, laenge ? laenge : 1)) == NULL ) {
+    as511_read_ram_free( td, tmp );
+    td->errnr = OUT_OF_MEMORY;
+    return NULL;
+  }
+  tmp->laenge = laenge;
 
-      if (protokoll_stopp( td ) ) {
-        tmp = Malloc(sizeof(sps_ram_t));
-        tmp->ptr = Malloc(index);
-        tmp->laenge = index;
-        memcpy(tmp->ptr, &td->mem[5], index);
-        return tmp;
-      }
-    }
+  if( as511_read_ram_r( td, adr, laenge, tmp->ptr ) != NO_ERROR ) {
+    as511_read_ram_free( td, tmp );
+    return NULL;
   }
-  as511_read_ram_free( td, tmp );
-  return NULL;
+  return tmp;
 }
 
 // Speicherinhalte vom AG ins PG übertragen
@@ -118,11 +162,13 @@ sps_ram_t * as511_read_ram32( td_t *td, unsigned long adr, unsigned long laenge
       index -= 9; // Die Ersten 9 Zeichen sid offensichtlich Datenmuell ???
 
       if (protokoll_stopp( td ) ) {
-        tmp = Malloc(sizeof(sps_ram_t));
-        tmp->ptr = Malloc(index);
-        tmp->laenge = index;
-        memcpy(tmp->ptr, &td->mem[9], index);
-        return tmp;
+        if( (tmp = as511_malloc(td, sizeof(sps_ram_t))) != NULL &&
+            (tmp->ptr = as511_malloc(td, index ? index : 1)) != NULL ) {
+          tmp->laenge = index;
+          memcpy(tmp->ptr, &td->mem[9], index);
+          return tmp;
+        }
+        td->errnr = OUT_OF_MEMORY;
       }
     }
   }
@@ -134,8 +180,8 @@ void  as511_read_ram_free( td_t *td, sps_ram_t *sr )
 {
   if( td != NULL && sr != NULL ) {
     if( sr->ptr ) {
-      Free(sr->ptr);
+      as511_free(td, sr->ptr);
     }
-    Free(sr);
+    as511_free(td, sr);
   }
 }
@@ -0,0 +1,164 @@
+/*
+  Copyright (c) 2002-2009 Peter Schnabel
+
+  Datei:   as511_read_ram_multi.c
+  Datum:   17.10.2026
+  Version: 0.0.1
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+#include <setjmp.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <fcntl.h>
+#define __USE_XOPEN
+#include <unistd.h>
+#include <termios.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/poll.h>
+#include <errno.h>
+#define  _S5LIB_C_
+#include <as511_s5lib.h>
+
+// Ein Bereich, nach Adressen sortiert
+struct spanne
+{
+  unsigned long adr;
+  unsigned long ende;  // erstes Byte hinter dem Bereich
+  int           index; // Index in der Liste des Aufrufers
+};
+
+static int spanne_cmp( const void *a, const void *b )
+{
+  const struct spanne *x = a;
+  const struct spanne *y = b;
+
+  if( x->adr != y->adr )
+    return x->adr < y->adr ? -1 : 1;
+  if( x->ende != y->ende )
+    return x->ende < y->ende ? -1 : 1;
+  return 0;
+}
+
+/* Mehrere Speicherbereiche vom AG ins PG übertragen
+
+   Eingabe: rb      Liste der zu lesenden Bereiche
+            anzahl  Anzahl der Bereiche in rb
+            luecke  Bereiche, zwischen denen hoechstens luecke Bytes liegen,
+                    werden zusammen gelesen
+            ram     Ein Puffer mit allen zusammengefassten Bereichen,
+                    belegt mit as511_malloc, freigeben mit
+                    as511_read_ram_free.
+
+   Ausgabe: 0 oder die erste Fehlernummer, die auch in td->errnr steht.
+            rb[i].ptr zeigt in *ram, oder ist NULL wenn der Bereich nicht
+            gelesen werden konnte. Dann steht die Fehlernummer in
+            rb[i].errnr. *ram ist nur NULL, wenn kein Speicher belegt
+            werden konnte (OUT_OF_MEMORY) oder bei BAD_PARAMETER.
+
+   Bereiche, die laenger als 512 Bytes sind, werden mit mehreren Telegrammen
+   hintereinander gelesen. Jedes Telegramm braucht seinen eigenen
+   protokoll_start/protokoll_stopp, darum lohnt sich das Zusammenfassen.
+*/
+int as511_read_ram_multi_r( td_t *td, rb_t *rb, int anzahl, unsigned short luecke, sps_ram_t **ram )
+{
+  sps_ram_t *tmp;
+  struct spanne *sp;
+  unsigned long gesamt = 0, offset = 0, start, ende, adr, n;
+  int i, j, k, rc, fehler = 0;
+
+  if( ram != NULL )
+    *ram = NULL;
+  if( td == NULL || rb == NULL || anzahl <= 0 || ram == NULL )
+    return BAD_PARAMETER;
+
+  if( (sp = as511_malloc(td, anzahl * sizeof(struct spanne))) == NULL )
+    return td->errnr = OUT_OF_MEMORY;
+  for( i = 0; i < anzahl; i++ ) {
+    sp[i].adr   = rb[i].adr;
+    sp[i].ende  = (unsigned long)rb[i].adr + rb[i].laenge;
+    sp[i].index = i;
+    rb[i].ptr   = NULL;
+    rb[i].errnr = 0;
+  }
+  qsort(sp, anzahl, sizeof(struct spanne), spanne_cmp);
+
+  // Gesamtlaenge der zusammengefassten Bereiche
+  for( i = 0; i < anzahl; i = j ) {
+    ende = sp[i].ende;
+    for( j = i + 1; j < anzahl && sp[j].adr <= ende + luecke; j++ ) {
+      if( sp[j].ende > ende )
+        ende = sp[j].ende;
+    }
+    gesamt += ende - sp[i].adr;
+  }
+
+  if( (tmp = as511_malloc(td, sizeof(sps_ram_t))) == NULL ||
+      (tmp->ptr = as511_malloc(td, gesamt ? gesamt : 1)) == NULL ) {
+    as511_read_ram_free(td, tmp);
+    as511_free(td, sp);
+    return td->errnr = OUT_OF_MEMORY;
+  }
+  tmp->laenge = gesamt;
+
+  // Jeden zusammengefassten Bereich in Telegrammen zu hoechstens 512 Bytes lesen
+  for( i = 0; i < anzahl; i = j ) {
+    start = sp[i].adr;
+    ende  = sp[i].ende;
+    for( j = i + 1; j < anzahl && sp[j].adr <= ende + luecke; j++ ) {
+      if( sp[j].ende > ende )
+        ende = sp[j].ende;
+    }
+
+    rc = NO_ERROR;
+    for( adr = start; rc == NO_ERROR && adr < ende; adr += n ) {
+      n = ende - adr;
+      if( n > RAM_TELEGRAMM_MAX )
+        n = RAM_TELEGRAMM_MAX;
+      rc = as511_read_ram_r( td, (unsigned short)adr, (unsigned short)n, &tmp->ptr[offset + adr - start] );
+    }
+    if( rc != NO_ERROR && fehler == 0 )
+      fehler = rc;
+
+    for( k = i; k < j; k++ ) {
+      if( rc == NO_ERROR )
+        rb[sp[k].index].ptr = &tmp->ptr[offset + sp[k].adr - start];
+      else
+        rb[sp[k].index].errnr = rc;
+    }
+    offset += ende - start;
+  }
+
+  as511_free(td, sp);
+  *ram = tmp;
+  return td->errnr = fehler;
+}
+
+/* Wie as511_read_ram_multi_r
+
+   Ausgabe: Der Puffer mit allen zusammengefassten Bereichen, freigeben mit
+            as511_read_ram_free. Die erste Fehlernummer steht in td->errnr.
+*/
+sps_ram_t * as511_read_ram_multi( td_t *td, rb_t *rb, int anzahl, unsigned short luecke )
+{
+  sps_ram_t *tmp;
+
+  as511_read_ram_multi_r( td, rb, anzahl, luecke, &tmp );
+  return tmp;
+}
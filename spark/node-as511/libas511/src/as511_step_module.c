@@ -37,27 +37,12 @@
 
 int as511_step_module_destroy( td_t *td, int (*usrfk)(void*) )
 {
-  void *d;
-
-  if( td != NULL && td->dlh != NULL && td->dlh->dl_type == DL_TYPE_STEP_MODULE ) {
-    while( td->dlh->f != NULL ) {
-      d = dlh_delete(td->dlh, td->dlh->l,DL_TYPE_STEP_MODULE,usrfk,td->dlh->l->udata);
-      Free(d);
-    }
-    Free(td->dlh);
-    td->dlh = NULL;
-    return 0; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_destroy( td, DL_TYPE_STEP_MODULE, usrfk );
 }
 
 int as511_step_module_create( td_t *td )
 {
-  if( td != NULL && td->dlh == NULL ) {
-    td->dlh = dlh_create( DL_TYPE_STEP_MODULE );
-    return 0; // OK
-  }
-  return 1; // Fehler
+  return td_dlh_create( td, DL_TYPE_STEP_MODULE );
 }
 
 // Datenliste erstellen, die dem auszuführendem Programmcode entspricht.
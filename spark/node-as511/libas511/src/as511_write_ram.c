@@ -37,38 +37,58 @@
 #include <as511_s5lib.h>
 
 
-// Daten vom PG ins AG übertragen
-int as511_write_ram( td_t *td, unsigned short adr, unsigned short laenge, unsigned char *ptr )
+/* Daten vom PG ins AG übertragen, ohne siglongjmp. Mehr als
+   RAM_TELEGRAMM_MAX Bytes werden mit mehreren Telegrammen hintereinander
+   geschrieben.
+
+   Ausgabe: 0 oder die Fehlernummer, die auch in td->errnr steht
+*/
+int as511_write_ram_r( td_t *td, unsigned short adr, unsigned short laenge, const unsigned char *quelle )
 {
   unsigned char ch;
-  unsigned int index = 0;
+  unsigned int offset, index, n;
+  unsigned short a;
+  int antwort;
+
+  if( td == NULL || (quelle == NULL && laenge > 0) )
+    return BAD_PARAMETER;
 
   td->errnr = 0;
+  for( offset = 0; offset < laenge; offset += n ) {
+    n = laenge - offset;
+    if( n > RAM_TELEGRAMM_MAX )
+      n = RAM_TELEGRAMM_MAX;
+    a = (unsigned short)(adr + offset);
 
+    R_PRUEFEN( protokoll_start_r( td, S5_WRITE_MEM, &antwort ) );
+    if( !antwort )
+      return td->errnr = CHAR_UNKNOWN;
+    // Startadresse angeben
+    R_PRUEFEN( schreibe_daten_r(td, HI(a)) );
+    R_PRUEFEN( schreibe_daten_r(td, LO(a)) );
+    // und dann die Daten
+    for( index = 0; index < n; index++ ) {
+      R_PRUEFEN( schreibe_daten_r(td, quelle[offset + index]) );
+    }
+    R_PRUEFEN( schreibe_byte_r(td, DLE) );
+    R_PRUEFEN( schreibe_byte_r(td, EOT) );
+    R_PRUEFEN( lese_byte_r(td, &ch, DLE, 1) );
+    R_PRUEFEN( lese_byte_r(td, &ch, ACK, 1) );
+    R_PRUEFEN( protokoll_stopp_r( td, &antwort ) );
+  }
+  return NO_ERROR;
+}
+
+// Daten vom PG ins AG übertragen
+int as511_write_ram( td_t *td, unsigned short adr, unsigned short laenge, unsigned char *ptr )
+{
   /* Zur Zeit werden Maximal 512 byte geschrieben.
   Später wird es dieses Limit nicht mehr geben.
   */
   if( laenge > 512 )
     laenge = 512;
 
-  if( sigsetjmp(td->env, 1) == 0 ) {
-    if( protokoll_start( td, S5_WRITE_MEM ) ) {
-      // Startadresse angeben
-      schreibe_daten_v2(td, HI(adr));
-      schreibe_daten_v2(td, LO(adr));
-      // und dann die Daten
-      for( index = 0; index < laenge; index++ ) {
-        schreibe_daten_v2(td, ptr[index]);
-      }
-      schreibe_byte_v2(td, DLE);
-      schreibe_byte_v2(td, EOT);
-      lese_byte_v2(td, &ch, DLE, 1);
-      lese_byte_v2(td, &ch, ACK, 1);
-      protokoll_stopp( td );
-      return 1;
-    }
-  }
-  return 0;
+  return as511_write_ram_r( td, adr, laenge, ptr ) == NO_ERROR;
 }
 
 
@@ -1,29 +1,51 @@
 #include <nan.h>
 
+#include <vector>
+
 #include <setjmp.h>
 extern "C" {
     #include <as511_s5lib.h>
     #include <as511_ustack.h>
 }
 
-td_t *td = NULL;
+#include "context_object.h"
+
+namespace nodeAs511 {
+
+using v8::FunctionCallbackInfo;
+using v8::Local;
+using v8::Value;
+using Nan::AsyncQueueWorker;
+using Nan::AsyncWorker;
+using Nan::Callback;
+using Nan::Null;
+
+void Method_CreateContext(const FunctionCallbackInfo<Value>& args) {
+  ContextObject::NewInstance(args);
+}
 
 NAN_METHOD(Method_OpenSync) {
 
-    if (info.Length() < 1) {
+    if (info.Length() < 2) {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
 
-    if (!info[0]->IsString()) {
+    if (!info[0]->IsObject() || !info[1]->IsString()) {
         Nan::ThrowTypeError("Wrong arguments");
         return;
     }
 
-    v8::String::Utf8Value arg0(info[0]->ToString());
-    std::string device = std::string(*arg0);
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    if (context->getTd() != NULL) {
+        Nan::ThrowTypeError("Already Open");
+        return;
+    }
 
-    td = open_tty((char*)device.c_str());
+    v8::String::Utf8Value arg1(info[1]->ToString());
+    std::string device = std::string(*arg1);
+
+    td_t *td = open_tty((char*)device.c_str());
     if (!td) {
         std::string err = "Failed to open ";
         err.append(device);
@@ -34,81 +56,778 @@ NAN_METHOD(Method_OpenSync) {
     // Uncomment to enable full debug from libas511
     //td->debug_level = DEBUG_LEVEL_ALL;
 
+    context->lock();
+    context->setTd(td);
+    context->unlock();
     info.GetReturnValue().Set(true);
 }
 
 NAN_METHOD(Method_CloseSync) {
 
+    if ((info.Length() < 1) || !info[0]->IsObject()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+    // waits for a read or write still running on a worker thread
+    context->lock();
+    td_t *td = context->getTd();
     if (td == NULL) {
+        context->unlock();
         Nan::ThrowTypeError("Not Open");
         return;
     }
 
     close_tty(td);
-    td = NULL;
+    context->setTd(NULL);
+    context->unlock();
 
     info.GetReturnValue().Set(true);
 }
 
 NAN_METHOD(Method_ReadSync) {
+    if (info.Length() < 3) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    context->lock();
+    td_t *td = context->getTd();
     if (td == NULL) {
+        context->unlock();
         Nan::ThrowTypeError("Not Open");
         return;
     }
 
-    if (info.Length() < 2) {
+    word_t size = (word_t)info[2]->NumberValue();
+    v8::Local<v8::Object> buf = Nan::NewBuffer(size).ToLocalChecked();
+    int errnr = as511_read_ram_r(td, (word_t)info[1]->NumberValue(), size,
+                                 (unsigned char*) node::Buffer::Data(buf));
+    context->unlock();
+
+    if (errnr != 0) {
+        Nan::ThrowTypeError("Failed reading ram");
+        return;
+    }
+    info.GetReturnValue().Set(buf);
+}
+
+NAN_METHOD(Method_WriteSync) {
+    if (info.Length() < 4) {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
 
-    if (!info[0]->IsNumber() || !info[1]->IsNumber()) {
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber()) {
         Nan::ThrowTypeError("Wrong arguments");
         return;
     }
 
-    ram_t *ram;
-    ram = as511_read_ram(td, (word_t)info[0]->NumberValue(), (word_t)info[1]->NumberValue() );
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    context->lock();
+    td_t *td = context->getTd();
+    if (td == NULL) {
+        context->unlock();
+        Nan::ThrowTypeError("Not Open");
+        return;
+    }
 
-    if( ram == NULL ) {
-        as511_read_ram_free( td, ram );
-        Nan::ThrowTypeError("Failed reading ram");
+    unsigned char *bufferPtr = (unsigned char*) node::Buffer::Data(info[3]->ToObject());
+    as511_write_ram_r(td, (word_t)info[1]->NumberValue(), (word_t)info[2]->NumberValue(), bufferPtr);
+    context->unlock();
+
+    info.GetReturnValue().Set(true);
+}
+
+// error text for a failed transfer, from the error number libas511 left in the link
+static void transferError(char *errorMsg, const char *what, int errnr) {
+    if (errnr == SPS_TIMEOUT) {
+        sprintf(errorMsg, "Failed %s ram: timeout", what);
+    } else if (errnr == CHAR_UNKNOWN) {
+        sprintf(errorMsg, "Failed %s ram: unexpected character", what);
+    } else {
+        sprintf(errorMsg, "Failed %s ram. Error code = %i", what, errnr);
+    }
+}
+
+class ReadManyWorker : public AsyncWorker {
+
+    public:
+        ReadManyWorker(Callback *callback, ContextObject* context, Local<v8::Object> contextHandle,
+                       const std::vector<word_t>& addrs, const std::vector<word_t>& sizes, int gap)
+        : AsyncWorker(callback), localContext(context), addrs(addrs), sizes(sizes), gap(gap),
+          data(addrs.size()), errnrs(addrs.size(), 0), notOpen(false) {
+            // keep the context from being collected while the worker runs
+            SaveToPersistent("context", contextHandle);
+        }
+
+        ~ReadManyWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+            localContext->lock();
+            td_t *td = localContext->getTd();
+            if (td == NULL) {
+                notOpen = true;
+                localContext->unlock();
+                return;
+            }
+
+            // all items in one go, so a poll cycle only queues one worker
+            if ((gap >= 0) && !addrs.empty()) {
+                // neighbouring items are read with one telegram, each with its own handshake
+                std::vector<rb_t> rb(addrs.size());
+                for (size_t i = 0; i < addrs.size(); i++) {
+                    rb[i].adr = addrs[i];
+                    rb[i].laenge = sizes[i];
+                }
+                ram_t *ram = NULL;
+                as511_read_ram_multi_r(td, &rb[0], (int)rb.size(), (unsigned short)gap, &ram);
+                for (size_t i = 0; i < addrs.size(); i++) {
+                    if (ram == NULL) {
+                        errnrs[i] = (td->errnr != 0) ? td->errnr : -1;
+                    } else if (rb[i].ptr != NULL) {
+                        data[i].assign(rb[i].ptr, rb[i].ptr + rb[i].laenge);
+                    } else if (rb[i].errnr != SPS_TIMEOUT) {
+                        // a bad item fails the whole range it was merged into, so find out
+                        // on its own whether it is this one. After a timeout the PLC is not
+                        // answering and there is no point in asking again
+                        readItem(td, i);
+                    } else {
+                        errnrs[i] = rb[i].errnr;
+                    }
+                }
+                as511_read_ram_free(td, ram);
+            } else {
+                for (size_t i = 0; i < addrs.size(); i++) {
+                    readItem(td, i);
+                }
+            }
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+            if (notOpen) {
+                Local<Value> argv[] = {
+                    Nan::Error("Not Open"),
+                    Null(),
+                    Null()
+                };
+                callback->Call(3, argv);
+                return;
+            }
+
+            // one buffer or null per item, and the matching error message or null
+            Local<v8::Array> values = Nan::New<v8::Array>(addrs.size());
+            Local<v8::Array> errors = Nan::New<v8::Array>(addrs.size());
+            for (size_t i = 0; i < addrs.size(); i++) {
+                if (errnrs[i] != 0) {
+                    char errorMsg[100];
+                    transferError(errorMsg, "reading", errnrs[i]);
+                    Nan::Set(values, i, Null());
+                    Nan::Set(errors, i, Nan::New(errorMsg).ToLocalChecked());
+                } else {
+                    Local<v8::Object> buf = Nan::NewBuffer(data[i].size()).ToLocalChecked();
+                    if (!data[i].empty()) {
+                        memcpy(node::Buffer::Data(buf), &data[i][0], data[i].size());
+                    }
+                    Nan::Set(values, i, buf);
+                    Nan::Set(errors, i, Null());
+                }
+            }
+
+            Local<Value> argv[] = {
+                Null(),
+                values,
+                errors
+            };
+            callback->Call(3, argv);
+        }
+
+    private:
+        void readItem(td_t *td, size_t i) {
+            data[i].resize(sizes[i]);
+            errnrs[i] = as511_read_ram_r(td, addrs[i], sizes[i], data[i].empty() ? NULL : &data[i][0]);
+            if (errnrs[i] != 0) {
+                data[i].clear();
+            }
+        }
+
+        ContextObject* localContext;
+        std::vector<word_t> addrs;
+        std::vector<word_t> sizes;
+        int gap;
+        std::vector< std::vector<unsigned char> > data;
+        std::vector<int> errnrs;
+        bool notOpen;
+};
+
+class WriteWorker : public AsyncWorker {
+
+    public:
+        WriteWorker(Callback *callback, ContextObject* context, Local<v8::Object> contextHandle,
+                    word_t addr, word_t size, const unsigned char *bufferPtr)
+        : AsyncWorker(callback), localContext(context), addr(addr),
+          data(bufferPtr, bufferPtr + size) {
+            SaveToPersistent("context", contextHandle);
+        }
+
+        ~WriteWorker() {}
+
+        // Executed inside the worker-thread.
+        void Execute () {
+            localContext->lock();
+            td_t *td = localContext->getTd();
+            if (td == NULL) {
+                localContext->unlock();
+                SetErrorMessage("Not Open");
+                return;
+            }
+
+            // the data was copied on the event loop, the caller may reuse its buffer
+            int errnr = as511_write_ram_r(td, addr, (word_t)data.size(), data.empty() ? NULL : &data[0]);
+            localContext->unlock();
+
+            if (errnr != 0) {
+                char errorMsg[100];
+                transferError(errorMsg, "writing", errnr);
+                SetErrorMessage(errorMsg);
+            }
+        }
+
+        // Executed on the event loop when Execute did not set an error
+        void HandleOKCallback () {
+            Local<Value> argv[] = {
+                Null(),
+                Null()
+            };
+            callback->Call(2, argv);
+        }
+
+    private:
+        ContextObject* localContext;
+        word_t addr;
+        std::vector<unsigned char> data;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ReadMany()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- array of addresses
+*              info[2] -- array of sizes, one per address
+*              info[3] -- largest gap in bytes between items read together,
+*                         negative to read every item on its own
+*              info[4] -- ASync Callback (err, buffers, errors)
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ReadMany) {
+    if (info.Length() != 5) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+
+    if (!info[0]->IsObject() || !info[1]->IsArray() || !info[2]->IsArray() || !info[3]->IsNumber() ||
+        !info[4]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong arguments");
         return;
     }
 
-    v8::Local<v8::Object> buf = Nan::NewBuffer(ram->laenge).ToLocalChecked();
-    memcpy(node::Buffer::Data(buf), ram->ptr, ram->laenge);
+    Local<v8::Array> addrArray = info[1].As<v8::Array>();
+    Local<v8::Array> sizeArray = info[2].As<v8::Array>();
+    if (addrArray->Length() != sizeArray->Length()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
 
-    as511_read_ram_free( td, ram );
-    info.GetReturnValue().Set(buf);
+    std::vector<word_t> addrs(addrArray->Length());
+    std::vector<word_t> sizes(sizeArray->Length());
+    for (uint32_t i = 0; i < addrArray->Length(); i++) {
+        Local<Value> addr = Nan::Get(addrArray, i).ToLocalChecked();
+        Local<Value> size = Nan::Get(sizeArray, i).ToLocalChecked();
+        if (!addr->IsNumber() || !size->IsNumber()) {
+            Nan::ThrowTypeError("Wrong arguments");
+            return;
+        }
+        addrs[i] = (word_t)addr->NumberValue();
+        sizes[i] = (word_t)size->NumberValue();
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    Callback *callback = new Callback(info[4].As<v8::Function>());
+    int gap = (int)info[3]->NumberValue();
+    if (gap > 0xFFFF) {
+        gap = 0xFFFF;
+    }
+
+    AsyncQueueWorker(new ReadManyWorker(callback, context, info[0]->ToObject(), addrs, sizes, gap));
 }
 
-NAN_METHOD(Method_WriteSync) {
-    if (td == NULL) {
-        Nan::ThrowTypeError("Not Open");
+/******************************************************************************
+*
+*  Function: 			Method_Write()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- address
+*              info[2] -- size
+*              info[3] -- buffer with at least size bytes
+*              info[4] -- ASync Callback (err)
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_Write) {
+    if (info.Length() != 5) {
+        Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
 
-    if (info.Length() < 3) {
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() ||
+        !node::Buffer::HasInstance(info[3]) || !info[4]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
+
+    word_t size = (word_t)info[2]->NumberValue();
+    if (node::Buffer::Length(info[3]) < size) {
+        Nan::ThrowTypeError("Buffer too small");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    Callback *callback = new Callback(info[4].As<v8::Function>());
+    const unsigned char *bufferPtr = (const unsigned char*) node::Buffer::Data(info[3]);
+
+    AsyncQueueWorker(new WriteWorker(callback, context, info[0]->ToObject(),
+                                     (word_t)info[1]->NumberValue(), size, bufferPtr));
+}
+
+// one variable of the STATUS VAR list and where its value goes
+struct StatusVarEntry {
+    unsigned char type;
+    word_t addr;
+    size_t item;
+    size_t offset;
+};
+
+// items of one cycle that changed, handed from the subscription thread to the main event loop
+struct SubscriptionBatch {
+    int errnr;
+    std::vector<size_t> indexes;
+    std::vector< std::vector<unsigned char> > values;
+};
+
+/******************************************************************************
+*
+*  Class: 			Subscription
+*
+*  Watches a fixed set of items with the STATUS VAR function of the PLC on its
+*  own thread. The variable list is sent once when the dialogue is opened, after
+*  that each cycle is a single telegram that brings back every value. Items are
+*  split into data words, an odd last byte is watched as a flag byte. Only the
+*  items whose bytes changed since they were last delivered are handed to the
+*  main event loop through a uv_async handle, one batch per cycle. The first
+*  cycle, and the first one after a failed cycle, delivers every item.
+*
+*  The dialogue stays open between cycles. Reads and writes from the event loop
+*  end it when they take the link, the next cycle opens it again.
+*
+******************************************************************************/
+class Subscription {
+
+    public:
+        Subscription(ContextObject* context, Local<v8::Object> contextHandle, Local<v8::Function> callback,
+                     const std::vector<word_t>& addrs, const std::vector<word_t>& sizes, uint64_t periodMs)
+        : resource("nodeAs511:Subscription") {
+            localContext = context;
+            // keep the context alive for as long as the thread may use it
+            localContextHandle.Reset(contextHandle);
+            dataCallback.Reset(callback);
+            for (size_t i = 0; i < addrs.size(); i++) {
+                for (size_t offset = 0; offset < sizes[i]; offset += 2) {
+                    StatusVarEntry entry;
+                    entry.type = ((sizes[i] - offset) >= 2) ? STATUS_VAR_DATEN : STATUS_VAR_MERKER;
+                    entry.addr = (word_t)(addrs[i] + offset);
+                    entry.item = i;
+                    entry.offset = offset;
+                    entries.push_back(entry);
+                }
+                values.push_back(std::vector<unsigned char>(sizes[i], 0));
+            }
+            lastValues = values;
+            periodNs = periodMs * 1000000;
+            firstCycle = true;
+            stopping = false;
+            finished = false;
+            stopRequested = false;
+        }
+
+        ~Subscription() {
+            uv_cond_destroy(&cond);
+            uv_mutex_destroy(&mutex);
+            localContextHandle.Reset();
+        }
+
+        // start the monitoring thread, called from the main event loop
+        int Start() {
+            uv_mutex_init(&mutex);
+            uv_cond_init(&cond);
+            uv_async_init(uv_default_loop(), &async, Deliver);
+            async.data = this;
+            int res = uv_thread_create(&thread, Run, this);
+            if (res != 0) {
+                uv_close((uv_handle_t*)&async, Closed);
+            }
+            return res;
+        }
+
+        // ask the thread to stop, the callback runs once it has been joined
+        bool Stop(Local<v8::Function> callback) {
+            if (stopRequested) {
+                return false;
+            }
+            stopRequested = true;
+            stopCallback.Reset(callback);
+            uv_mutex_lock(&mutex);
+            stopping = true;
+            uv_cond_signal(&cond);
+            uv_mutex_unlock(&mutex);
+            return true;
+        }
+
+    private:
+        static void Run(void* arg) {
+            Subscription* self = (Subscription*)arg;
+
+            uint64_t next = uv_hrtime();
+            uv_mutex_lock(&self->mutex);
+            while (!self->stopping) {
+                uv_mutex_unlock(&self->mutex);
+                self->Poll();
+                uv_mutex_lock(&self->mutex);
+
+                // keep to the period, but never try to catch up on cycles that overran
+                uint64_t now = uv_hrtime();
+                next += self->periodNs;
+                if (next < now) {
+                    next = now;
+                }
+                while (!self->stopping && (now < next)) {
+                    uv_cond_timedwait(&self->cond, &self->mutex, next - now);
+                    now = uv_hrtime();
+                }
+            }
+            self->finished = true;
+            uv_mutex_unlock(&self->mutex);
+
+            // leave the PLC out of the dialogue
+            self->localContext->lock();
+            self->localContext->unlock();
+
+            uv_async_send(&self->async);
+        }
+
+        // send the variable list, with the lock held
+        int Open(td_t *td) {
+            if (td->dlh != NULL) {
+                localContext->closeStatusVar(false);
+            }
+            as511_status_var_create(td);
+            // nodes for all entries in one block, without it each insert allocates its own
+            as511_status_var_reserve(td, (int)entries.size());
+            for (size_t e = 0; e < entries.size(); e++) {
+                if (as511_status_var_insert_type(td, entries[e].type, entries[e].addr, NULL, NULL) == NULL) {
+                    localContext->closeStatusVar(false);
+                    return BAD_PARAMETER;
+                }
+            }
+            if (!as511_status_var_start(td)) {
+                int errnr = (td->errnr != 0) ? td->errnr : -1;
+                localContext->closeStatusVar(false);
+                return errnr;
+            }
+            localContext->setStatusVarOpen(true);
+            return 0;
+        }
+
+        // one cycle, runs on the subscription thread
+        void Poll() {
+            SubscriptionBatch* batch = new SubscriptionBatch();
+            batch->errnr = 0;
+
+            localContext->lockStatusVar();
+            td_t *td = localContext->getTd();
+            if (td == NULL) {
+                batch->errnr = -1;
+            } else {
+                if (!localContext->isStatusVarOpen()) {
+                    batch->errnr = Open(td);
+                }
+                if (batch->errnr == 0) {
+                    as511_status_var_run(td);
+                    batch->errnr = td->errnr;
+                }
+                if (batch->errnr == 0) {
+                    // the values are in the list in the order the entries were inserted
+                    size_t e = 0;
+                    for (dl_t *dl = td->dlh->f; (dl != NULL) && (e < entries.size()); dl = dl->n, e++) {
+                        svd_u *svd = DL_GET_DATA(svd_u, dl);
+                        unsigned char *value = &values[entries[e].item][entries[e].offset];
+                        if (entries[e].type == STATUS_VAR_DATEN) {
+                            value[0] = (unsigned char)(svd->t6.w.d.wert >> 8);
+                            value[1] = (unsigned char)(svd->t6.w.d.wert & 0xFF);
+                        } else {
+                            value[0] = svd->t4.w;
+                        }
+                    }
+                } else if (localContext->isStatusVarOpen()) {
+                    // the dialogue is in an unknown state, start over next cycle
+                    localContext->closeStatusVar(false);
+                }
+            }
+            localContext->unlock();
+
+            if (batch->errnr == 0) {
+                for (size_t i = 0; i < values.size(); i++) {
+                    if (firstCycle || (values[i] != lastValues[i])) {
+                        lastValues[i] = values[i];
+                        batch->indexes.push_back(i);
+                        batch->values.push_back(values[i]);
+                    }
+                }
+            }
+            firstCycle = (batch->errnr != 0);
+
+            // nothing changed and nothing failed, so don't wake the event loop
+            if (batch->indexes.empty() && (batch->errnr == 0)) {
+                delete batch;
+                return;
+            }
+
+            uv_mutex_lock(&mutex);
+            pending.push_back(batch);
+            uv_mutex_unlock(&mutex);
+            uv_async_send(&async);
+        }
+
+        // runs inside the main event loop, so it is safe to use V8
+        static void Deliver(uv_async_t* handle) {
+            Nan::HandleScope scope;
+            Subscription* self = (Subscription*)handle->data;
+
+            std::vector<SubscriptionBatch*> batches;
+            uv_mutex_lock(&self->mutex);
+            batches.swap(self->pending);
+            bool finished = self->finished;
+            uv_mutex_unlock(&self->mutex);
+
+            for (size_t b = 0; b < batches.size(); b++) {
+                SubscriptionBatch* batch = batches[b];
+                // nothing more is delivered once unsubscribe has been called
+                if (!self->stopRequested) {
+                    Local<Value> err = Null();
+                    if (batch->errnr != 0) {
+                        char errorMsg[100];
+                        transferError(errorMsg, "monitoring", batch->errnr);
+                        err = Nan::Error(errorMsg);
+                    }
+                    Local<v8::Array> indexes = Nan::New<v8::Array>(batch->indexes.size());
+                    Local<v8::Array> values = Nan::New<v8::Array>(batch->values.size());
+                    for (size_t i = 0; i < batch->indexes.size(); i++) {
+                        Local<v8::Object> buf = Nan::NewBuffer(batch->values[i].size()).ToLocalChecked();
+                        if (!batch->values[i].empty()) {
+                            memcpy(node::Buffer::Data(buf), &batch->values[i][0], batch->values[i].size());
+                        }
+                        Nan::Set(indexes, i, Nan::New<v8::Number>((double)batch->indexes[i]));
+                        Nan::Set(values, i, buf);
+                    }
+                    Local<Value> argv[] = {
+                        err,
+                        indexes,
+                        values
+                    };
+                    self->dataCallback.Call(3, argv, &self->resource);
+                }
+                delete batch;
+            }
+
+            if (finished) {
+                uv_thread_join(&self->thread);
+                self->localContext->setSubscription(NULL);
+                if (!self->stopCallback.IsEmpty()) {
+                    Local<Value> argv[] = {
+                        Null()
+                    };
+                    self->stopCallback.Call(1, argv, &self->resource);
+                }
+                uv_close((uv_handle_t*)&self->async, Closed);
+            }
+        }
+
+        static void Closed(uv_handle_t* handle) {
+            delete (Subscription*)handle->data;
+        }
+
+        ContextObject* localContext;
+        Nan::Persistent<v8::Object> localContextHandle;
+        Callback dataCallback;
+        Callback stopCallback;
+        Nan::AsyncResource resource;
+
+        // only used by the subscription thread once started
+        std::vector<StatusVarEntry> entries;
+        std::vector< std::vector<unsigned char> > values;
+        std::vector< std::vector<unsigned char> > lastValues;
+        uint64_t periodNs;
+        bool firstCycle;
+
+        // only used by the main event loop
+        bool stopRequested;
+
+        // shared, guarded by mutex
+        uv_mutex_t mutex;
+        uv_cond_t cond;
+        bool stopping;
+        bool finished;
+        std::vector<SubscriptionBatch*> pending;
+
+        uv_thread_t thread;
+        uv_async_t async;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_Subscribe()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- array of addresses
+*              info[2] -- array of sizes, one per address
+*              info[3] -- number  period in milliseconds
+*              info[4] -- Callback, called from the event loop once per cycle
+*                         that changed something with (err, indexes, buffers):
+*                         the indexes of the items that changed and a buffer
+*                         with the new bytes of each
+*
+*  Starts a thread watching the items until Method_Unsubscribe is called.
+*  Only one subscription can run on a context.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_Subscribe) {
+    if (info.Length() != 5) {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
 
-    if (!info[0]->IsNumber() || !info[1]->IsNumber()) {
+    if (!info[0]->IsObject() || !info[1]->IsArray() || !info[2]->IsArray() || !info[3]->IsNumber() ||
+        !info[4]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
+
+    Local<v8::Array> addrArray = info[1].As<v8::Array>();
+    Local<v8::Array> sizeArray = info[2].As<v8::Array>();
+    if ((addrArray->Length() != sizeArray->Length()) || (addrArray->Length() == 0)) {
         Nan::ThrowTypeError("Wrong arguments");
         return;
     }
 
-    unsigned char *bufferPtr = (unsigned char*) node::Buffer::Data(info[2]->ToObject());
-    as511_write_ram(td, (word_t)info[0]->NumberValue(), (word_t)info[1]->NumberValue(), bufferPtr);
+    std::vector<word_t> addrs(addrArray->Length());
+    std::vector<word_t> sizes(sizeArray->Length());
+    for (uint32_t i = 0; i < addrArray->Length(); i++) {
+        Local<Value> addr = Nan::Get(addrArray, i).ToLocalChecked();
+        Local<Value> size = Nan::Get(sizeArray, i).ToLocalChecked();
+        if (!addr->IsNumber() || !size->IsNumber()) {
+            Nan::ThrowTypeError("Wrong arguments");
+            return;
+        }
+        addrs[i] = (word_t)addr->NumberValue();
+        sizes[i] = (word_t)size->NumberValue();
+    }
 
-    info.GetReturnValue().Set(true);
+    double period = info[3]->NumberValue();
+    if (!(period >= 1)) {
+        Nan::ThrowRangeError("Period must be at least 1ms");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    if (context->getSubscription() != NULL) {
+        Nan::ThrowError("Already subscribed");
+        return;
+    }
+
+    Subscription* subscription = new Subscription(context, info[0]->ToObject(), info[4].As<v8::Function>(),
+                                                  addrs, sizes, (uint64_t)period);
+    if (subscription->Start() != 0) {
+        Nan::ThrowError("Could not start the subscription thread");
+        return;
+    }
+    context->setSubscription(subscription);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_Unsubscribe()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- ASync Callback, called once the thread has stopped
+*
+*  Returns: true when a subscription is being stopped, false (and the callback
+*           will not be called) when there is none.
+*
+******************************************************************************/
+NAN_METHOD(Method_Unsubscribe) {
+    if (info.Length() != 2) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+
+    if (!info[0]->IsObject() || !info[1]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong arguments");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    Subscription* subscription = context->getSubscription();
+
+    bool stopping = (subscription != NULL) && subscription->Stop(info[1].As<v8::Function>());
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(stopping));
 }
 
 void init(v8::Local<v8::Object> target) {
+
+    ContextObject::Init(target->GetIsolate());
+
+    NODE_SET_METHOD(target, "createContext", Method_CreateContext);
     target->Set(Nan::New("openSync").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_OpenSync)->GetFunction());
     target->Set(Nan::New("closeSync").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_CloseSync)->GetFunction());
     target->Set(Nan::New("readSync").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ReadSync)->GetFunction());
     target->Set(Nan::New("writeSync").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_WriteSync)->GetFunction());
+    target->Set(Nan::New("readMany").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ReadMany)->GetFunction());
+    target->Set(Nan::New("write").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Write)->GetFunction());
+    target->Set(Nan::New("subscribe").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Subscribe)->GetFunction());
+    target->Set(Nan::New("unsubscribe").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Unsubscribe)->GetFunction());
 }
 
 NODE_MODULE(binding, init);
+
+}  // namespace nodeAs511
@@ -0,0 +1,97 @@
+#include <node.h>
+
+#include "context_object.h"
+
+namespace nodeAs511 {
+
+using v8::Context;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::Persistent;
+using v8::String;
+using v8::Value;
+
+Persistent<Function> ContextObject::constructor;
+
+ContextObject::ContextObject(void) {
+    td = NULL;
+    statusVarOpen = false;
+    subscription = NULL;
+    uv_mutex_init(&mutex);
+}
+
+ContextObject::~ContextObject() {
+    // don't leave the serial port open if the context is garbage collected while still open
+    if (td != NULL) {
+        closeStatusVar(statusVarOpen);
+        close_tty(td);
+        td = NULL;
+    }
+    uv_mutex_destroy(&mutex);
+}
+
+void ContextObject::lock() {
+    uv_mutex_lock(&mutex);
+    if (statusVarOpen) {
+        closeStatusVar(true);
+    }
+}
+
+void ContextObject::closeStatusVar(bool stopDialogue) {
+    if ((td != NULL) && (td->dlh != NULL)) {
+        if (stopDialogue) {
+            as511_status_var_stop(td);
+        }
+        as511_status_var_destroy(td, NULL);
+    }
+    statusVarOpen = false;
+}
+
+void ContextObject::Init(Isolate* isolate) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(String::NewFromUtf8(isolate, "ContextObject"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  constructor.Reset(isolate, tpl->GetFunction());
+}
+
+void ContextObject::New(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.IsConstructCall()) {
+    // Invoked as constructor: `new ContextObject(...)`
+    ContextObject* obj = new ContextObject();
+    obj->Wrap(args.This());
+    args.GetReturnValue().Set(args.This());
+  } else {
+    // Invoked as plain function `ContextObject(...)`, turn into construct call.
+    const int argc = 1;
+    Local<Value> argv[argc] = { args[0] };
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Function> cons = Local<Function>::New(isolate, constructor);
+    Local<Object> instance =
+        cons->NewInstance(context, argc, argv).ToLocalChecked();
+    args.GetReturnValue().Set(instance);
+  }
+}
+
+void ContextObject::NewInstance(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  const unsigned argc = 1;
+  Local<Value> argv[argc] = { args[0] };
+  Local<Function> cons = Local<Function>::New(isolate, constructor);
+  Local<Context> context = isolate->GetCurrentContext();
+  Local<Object> instance =
+      cons->NewInstance(context, argc, argv).ToLocalChecked();
+
+  args.GetReturnValue().Set(instance);
+}
+
+
+} // namespace nodeAs511
@@ -0,0 +1,61 @@
+#ifndef CONTEXT_OBJECT_H
+#define CONTEXT_OBJECT_H
+
+#include <node.h>
+#include <node_object_wrap.h>
+#include <uv.h>
+
+#include <setjmp.h>
+extern "C" {
+    #include <as511_s5lib.h>
+}
+
+namespace nodeAs511 {
+
+class Subscription;
+
+class ContextObject : public node::ObjectWrap {
+ public:
+  static void Init(v8::Isolate* isolate);
+  static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  inline td_t* getTd() { return td; }
+  inline void setTd(td_t* tdIn) { td = tdIn; }
+
+  // libas511 is not re-entrant on a link, so the worker threads and the
+  // sync calls take turns on it. lock() also ends a STATUS VAR dialogue the
+  // subscription left open, as no other telegram can be sent during one
+  void lock();
+  inline void unlock() { uv_mutex_unlock(&mutex); }
+
+  // the subscription thread keeps its STATUS VAR dialogue open between
+  // cycles, it takes the link with lockStatusVar() to carry on with it
+  inline void lockStatusVar() { uv_mutex_lock(&mutex); }
+  inline bool isStatusVarOpen() { return statusVarOpen; }
+  inline void setStatusVarOpen(bool open) { statusVarOpen = open; }
+  // with the lock held: drop the variable list, after telling the PLC the
+  // dialogue ends if it is still in a state to listen
+  void closeStatusVar(bool stopDialogue);
+
+  inline Subscription* getSubscription() { return subscription; }
+  inline void setSubscription(Subscription* sub) { subscription = sub; }
+
+ private:
+  explicit ContextObject();
+  ~ContextObject();
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static v8::Persistent<v8::Function> constructor;
+
+  // open AS511 link, one per serial port
+  td_t *td;
+  uv_mutex_t mutex;
+  bool statusVarOpen;
+  // STATUS VAR running on its own thread, or NULL
+  Subscription* subscription;
+
+};
+
+}  // namespace nodeAs511
+
+#endif
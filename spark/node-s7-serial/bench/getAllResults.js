@@ -0,0 +1,147 @@
+/*jshint esversion: 6 */
+
+// Compares the per item getResult() decoding against the bulk getAllResults() decoding, both on
+// the same requests of up to 10 items, and shows readAllItems, which goes through the read plan
+// and readItems, for reference. Needs a PLC attached, e.g.
+//   TTY_DEV=/dev/ttyUSB0 PROTOCOL=PPI ITEMS=VW0,VW2,VW4,M0.1 POLLS=200 node bench/getAllResults.js
+
+var nodaveBindings = require('bindings')('nodaveBindings');
+var nodeS7Serial = require('../index.js');
+var constants = nodeS7Serial.constants;
+
+const async = require('async');
+
+var ttyDev = process.env.TTY_DEV || '/dev/ttyUSB0';
+var protocolMode = process.env.PROTOCOL || 'PPI';
+var baudRate = process.env.BAUD_RATE || (protocolMode === 'MPI' ? '38400' : '9600');
+var parity = process.env.PARITY || (protocolMode === 'MPI' ? 'ODD' : 'EVEN');
+var items = (process.env.ITEMS || 'VW0,VW2,VW4,VW6,VW8,VW10,VW12,VW14,VW16,VW18').split(',');
+var polls = parseInt(process.env.POLLS || '100');
+
+function hrtimeToMs(hrtime) {
+    return (hrtime[0] * 1000) + (hrtime[1] / 1e6);
+}
+
+function readPerItem(client, done) {
+    // the original readAllItems loop, one getResult call per item
+    var jsTime = [0, 0];
+    var start = 0;
+    async.whilst (
+        function () { return start < client.readRequestArray.length; },
+        function (cb) {
+            var count = Math.min(10, client.readRequestArray.length - start);
+            nodaveBindings.prepareReadRequest(client.context);
+            for (var i = 0; i < count; i++) {
+                var r = client.readRequestArray[start + i];
+                nodaveBindings.addVarToRequest(client.context, r.readType, r.memoryArea, r.blockIndex, r.startAddress, (r.readType === constants.READ_WORD) ? 2 : ((r.readType === constants.READ_DWORD) ? 4 : 1));
+            }
+            nodaveBindings.execReadRequest(client.context, function(err) {
+                if (err) return done(err);
+                var t = process.hrtime();
+                for (var j = 0; j < count; j++) {
+                    var r = client.readRequestArray[start + j];
+                    nodaveBindings.getResult(client.context, j, r.readType, r.format, r.memoryArea);
+                }
+                nodaveBindings.freeResults(client.context);
+                var d = process.hrtime(t);
+                jsTime = [jsTime[0] + d[0], jsTime[1] + d[1]];
+                start += count;
+                cb(null);
+            });
+        },
+        function () { done(null, hrtimeToMs(jsTime)); }
+    );
+}
+
+function readBulk(client, done) {
+    // the same requests as readPerItem, decoded and freed in the worker thread by getAllResults
+    var jsTime = [0, 0];
+    var start = 0;
+    async.whilst (
+        function () { return start < client.readRequestArray.length; },
+        function (cb) {
+            var count = Math.min(10, client.readRequestArray.length - start);
+            // result index, byte offset, bit offset, data type, data format, memory area
+            var descriptors = new Int32Array(count * 6);
+            nodaveBindings.prepareReadRequest(client.context);
+            for (var i = 0; i < count; i++) {
+                var r = client.readRequestArray[start + i];
+                nodaveBindings.addVarToRequest(client.context, r.readType, r.memoryArea, r.blockIndex, r.startAddress, (r.readType === constants.READ_WORD) ? 2 : ((r.readType === constants.READ_DWORD) ? 4 : 1));
+                descriptors.set([i, 0, -1, r.readType, r.format, r.memoryArea], i * 6);
+            }
+            nodaveBindings.getAllResults(client.context, descriptors, function(err, values, status) {
+                if (err) return done(err);
+                // all that is left on the js thread is taking the values out
+                var t = process.hrtime();
+                var results = {};
+                for (var j = 0; j < count; j++) {
+                    var r = client.readRequestArray[start + j];
+                    results[r.address] = (status[j] === 0) ? values[j] : null;
+                }
+                var d = process.hrtime(t);
+                jsTime = [jsTime[0] + d[0], jsTime[1] + d[1]];
+                start += count;
+                cb(null);
+            });
+        },
+        function () { done(null, hrtimeToMs(jsTime)); }
+    );
+}
+
+function readPlan(client, done) {
+    // readAllItems packs the items into as few exchanges as the PDU allows, time the whole call
+    var t = process.hrtime();
+    client.readAllItems(function(err) {
+        done(err, hrtimeToMs(process.hrtime(t)));
+    });
+}
+
+function run(name, client, readFunc, done) {
+    var cpuStart = process.cpuUsage();
+    var wallStart = process.hrtime();
+    var jsMs = 0;
+    var n = 0;
+    async.whilst (
+        function () { return n < polls; },
+        function (cb) {
+            readFunc(client, function(err, ms) {
+                if (err) return cb(err);
+                jsMs += ms;
+                n++;
+                cb(null);
+            });
+        },
+        function (err) {
+            if (err) return done(err);
+            var cpu = process.cpuUsage(cpuStart);
+            console.log(name + ': ' + polls + ' polls of ' + items.length + ' items, ' +
+                        'wall ' + (hrtimeToMs(process.hrtime(wallStart)) / polls).toFixed(3) + ' ms/poll, ' +
+                        'cpu ' + ((cpu.user + cpu.system) / 1000 / polls).toFixed(3) + ' ms/poll');
+            if (readFunc !== readPlan) {
+                console.log(name + ': result handling on js thread ' + (jsMs / polls).toFixed(3) + ' ms/poll');
+            }
+            done(null);
+        }
+    );
+}
+
+var client = new nodeS7Serial.constructor(protocolMode, ttyDev, baudRate, parity, 'MPI v1', '187K', 0, 2);
+client.initiateConnection(function(err) {
+    if (err) {
+        console.log(err);
+        return;
+    }
+    items.forEach(function(item) {
+        client.addItems(item, constants.FORMAT_SIGNED);
+    });
+    run('getResult', client, readPerItem, function(err) {
+        if (err) console.log(err);
+        run('getAllResults', client, readBulk, function(err) {
+            if (err) console.log(err);
+            run('readAllItems', client, readPlan, function(err) {
+                if (err) console.log(err);
+                client.dropConnection(function() {});
+            });
+        });
+    });
+});
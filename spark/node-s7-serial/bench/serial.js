@@ -0,0 +1,124 @@
+/*jshint esversion: 6 */
+
+// Serial throughput of node-s7-serial: polls the items with readAllItems and reports reads/s,
+// latency percentiles, the PPI retry counters and failed polls.
+// Without TTY_DEV it starts libnodave/serialsim (make -C libnodave serialsim) and talks to that, e.g.
+//   PROTOCOL=PPI SIM_FLAGS="-e2 -p10" POLLS=200 node bench/serial.js
+//   PROTOCOL=MPI SIM_FLAGS="-b0" node bench/serial.js
+// or to a real PLC:
+//   TTY_DEV=/dev/ttyUSB0 PROTOCOL=PPI node bench/serial.js
+
+var nodeS7Serial = require('../index.js');
+var constants = nodeS7Serial.constants;
+
+const async = require('async');
+const childProcess = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+var protocolMode = process.env.PROTOCOL || 'PPI';
+var baudRate = process.env.BAUD_RATE || (protocolMode === 'MPI' ? '38400' : '9600');
+var parity = process.env.PARITY || (protocolMode === 'MPI' ? 'ODD' : 'EVEN');
+var items = (process.env.ITEMS || 'VW0,VW2,VW4,VW6,VW8,VW10,VW12,VW14,VW16,VW18').split(',');
+var polls = parseInt(process.env.POLLS || '100');
+var ttyDev = process.env.TTY_DEV;
+var simulator = null;
+
+function hrtimeToUs(hrtime) {
+    return (hrtime[0] * 1e6) + (hrtime[1] / 1e3);
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.max(0, Math.ceil(sorted.length * p / 100) - 1)];
+}
+
+function startSimulator(done) {
+    // serialsim makes a link to its pseudo terminal, wait for it to show up
+    ttyDev = '/tmp/serialsim.' + process.pid;
+    var args = ['-L' + ttyDev].concat((process.env.SIM_FLAGS || '').split(' ').filter(function(arg) { return arg.length > 0; }));
+    if (protocolMode === 'MPI') args.unshift('-m');
+    simulator = childProcess.spawn(path.join(__dirname, '..', 'libnodave', 'serialsim'), args, { stdio: 'inherit' });
+    simulator.on('error', function(err) {
+        done(err);
+        done = function() {};
+    });
+    var tries = 0;
+    async.until(
+        function () { return fs.existsSync(ttyDev) || (tries > 50); },
+        function (cb) { tries++; setTimeout(cb, 100); },
+        function () {
+            done(fs.existsSync(ttyDev) ? null : new Error('serialsim did not start'));
+            done = function() {};
+        }
+    );
+}
+
+function run(client, done) {
+    var latencies = [];
+    var failures = 0;
+    var n = 0;
+    var ppiStart = client.getPPIStats();
+    var wallStart = process.hrtime();
+    async.whilst (
+        function () { return n < polls; },
+        function (cb) {
+            var t = process.hrtime();
+            client.readAllItems(function(err) {
+                if (err) {
+                    failures++;
+                } else {
+                    latencies.push(hrtimeToUs(process.hrtime(t)));
+                }
+                n++;
+                cb(null);
+            });
+        },
+        function () {
+            var wallUs = hrtimeToUs(process.hrtime(wallStart));
+            console.log(protocolMode + ' at ' + baudRate + ' baud, ' + polls + ' polls of ' + items.length + ' items: ' +
+                        (1e6 * polls / wallUs).toFixed(1) + ' reads/s');
+            if (latencies.length > 0) {
+                latencies.sort(function(a, b) { return a - b; });
+                console.log('latency us: p50 ' + percentile(latencies, 50).toFixed(0) + ' p90 ' + percentile(latencies, 90).toFixed(0) +
+                            ' p99 ' + percentile(latencies, 99).toFixed(0) + ' max ' + latencies[latencies.length - 1].toFixed(0));
+            }
+            var ppi = client.getPPIStats();
+            if ((ppi !== null) && (ppiStart !== null)) {
+                console.log('retries: 2nd ' + (ppi.secondTries - ppiStart.secondTries) + ' 3rd ' + (ppi.thirdTries - ppiStart.thirdTries) +
+                            ' poll ' + (ppi.pollRetries - ppiStart.pollRetries) + ', turnaround ' + ppi.turnaroundDelay + ' us');
+            }
+            console.log('failed polls: ' + failures + ' of ' + polls);
+            done(null);
+        }
+    );
+}
+
+function finish() {
+    if (simulator !== null) simulator.kill('SIGINT');
+}
+
+function bench(err) {
+    if (err) {
+        console.log(err.message);
+        return finish();
+    }
+    var client = new nodeS7Serial.constructor(protocolMode, ttyDev, baudRate, parity, 'MPI v1', '187K', 0, 2);
+    client.initiateConnection(function(err) {
+        if (err) {
+            console.log(err);
+            return finish();
+        }
+        items.forEach(function(item) {
+            client.addItems(item, constants.FORMAT_SIGNED);
+        });
+        run(client, function() {
+            client.dropConnection(finish);
+        });
+    });
+}
+
+if (ttyDev) {
+    bench(null);
+} else {
+    startSimulator(bench);
+}
@@ -10,7 +10,8 @@
           ],
         'sources': [
       	"libnodave/nodave.c",
-        "libnodave/setport.c"
+        "libnodave/setport.c",
+        "libnodave/openSocket.c"
         ]
     }, {
         "target_name": "nodaveBindings",
@@ -0,0 +1,49 @@
+/*jshint esversion: 6 */
+
+var nodaveBindings = require('bindings')('nodaveBindings');
+var constants = require('./constants.js');
+
+// A block read with readBlock is a Buffer holding the bytes as the PLC does, big-endian. Single values
+// are read from it in place, whole arrays of words and double words are converted in one native pass.
+
+
+// a DataView over the block, its getters default to big-endian so they read PLC values as they are
+function view(block) {
+    return new DataView(block.buffer, block.byteOffset, block.length);
+}
+
+
+// the value of one tag at offset bytes into the block, as readAllItems would return it
+function getValue(block, offset, readType, format, bit) {
+    if (readType === constants.READ_BIT) {
+        var value = (block.readUInt8(offset) >> (bit || 0)) & 0x01;
+        return (format === constants.FORMAT_BOOL) ? (value > 0) : value;
+    } else if (readType === constants.READ_BYTE) {
+        return (format === constants.FORMAT_SIGNED) ? block.readInt8(offset) : block.readUInt8(offset);
+    } else if (readType === constants.READ_WORD) {
+        return (format === constants.FORMAT_SIGNED) ? block.readInt16BE(offset) : block.readUInt16BE(offset);
+    }
+    if (format === constants.FORMAT_FLOAT) {
+        return block.readFloatBE(offset);
+    }
+    return (format === constants.FORMAT_SIGNED) ? block.readInt32BE(offset) : block.readUInt32BE(offset);
+}
+
+
+// count consecutive values from offset bytes into the block as a typed array. Bytes need no conversion
+// so they are a view sharing the block's memory, words and double words are a converted copy
+function decodeArray(block, offset, count, readType, format) {
+    if ((readType === constants.READ_BIT) || (readType === constants.READ_BYTE)) {
+        if ((offset < 0) || (count < 0) || (offset + count > block.length)) {
+            throw new RangeError('Values out of the block');
+        }
+        var ArrayType = (format === constants.FORMAT_SIGNED) ? Int8Array : Uint8Array;
+        return new ArrayType(block.buffer, block.byteOffset + offset, count);
+    }
+    return nodaveBindings.decodeArray(block, offset, count, readType, format);
+}
+
+
+module.exports.view = view;
+module.exports.getValue = getValue;
+module.exports.decodeArray = decodeArray;
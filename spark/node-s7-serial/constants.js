@@ -55,6 +55,16 @@ module.exports.FORMAT_SIGNED   = 1;
 module.exports.FORMAT_FLOAT    = 2;
 module.exports.FORMAT_BOOL     = 3;
 
+// command priority classes (should match as defined in command_queue.h)
+module.exports.PRIORITY_CONTROL = 0; // connect, disconnect and writes
+module.exports.PRIORITY_READ    = 1; // on-demand reads
+module.exports.PRIORITY_POLL    = 2; // cyclic polling
+
+// how far reconnect had to go back (1 and 2 should match as defined in binding.cpp)
+module.exports.RECONNECT_CONNECTION = 1; // only the PLC connection was set up again
+module.exports.RECONNECT_ADAPTER    = 2; // the adapter was initialized again too
+module.exports.RECONNECT_FULL       = 3; // port, adapter and connection from scratch
+
 
 // MPI versions (should match as defined in nodavesimple.h)
 module.exports.mpiModeTranslate = {
@@ -74,3 +84,24 @@ module.exports.mpiSpeedTranslate = {
     '45K': 5,
     '93K': 6,
 };
+
+// PPI turnaround modes (should match as defined in nodavesimple.h)
+module.exports.ppiTurnaroundTranslate = {
+    'fixed': 0,     // always wait 20ms (or turnaroundDelay) before polling for the response
+    'frame': 1,     // wait the line idle time and station delay at the baud rate, 93 bit times
+    'adaptive': 2   // as 'frame', backing off while retries are seen
+};
+
+// protocol modes for PLCs behind an MPI/PPI to ethernet gateway (should match as defined in nodavesimple.h)
+module.exports.netLinkProtocolTranslate = {
+    'IBH MPI': 223,     // MPI through an IBH/MHJ NetLink
+    'IBH PPI': 224,     // PPI through an IBH/MHJ NetLink
+    'NetLink Pro': 230  // MPI through a Deltalogic NetLink Pro
+};
+
+// the port each gateway listens on
+module.exports.netLinkPortDefault = {
+    'IBH MPI': 1099,
+    'IBH PPI': 1099,
+    'NetLink Pro': 7777
+};
@@ -2,33 +2,61 @@
 
 var nodaveBindings = require('bindings')('nodaveBindings');
 var constants = require('./constants.js');
+var planner = require('./planner.js');
 
 const async = require('async');
 
-const NUMBER_OF_REQUESTS_IN_MULTIREAD = 10;
-
-function NodeS7Serial(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress) {
+function NodeS7Serial(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress, options) {
     var self = this;
 
     self.connected = false;
+    self.subscribed = false;
     self.readRequestArray = [];
     self.resultsObject = {};
+    self.readPlan = null;
+    self.maxPDULength = planner.DEFAULT_MAX_PDU_LENGTH;
+    self.coalesceGap = planner.DEFAULT_COALESCE_GAP;
 
     self.protocolMode = protocolMode;
     self.localAddress = localAddress;
     self.plcAddress = plcAddress;
     self.serialDevice = device;
     self.serialBaudRate = baudRate; // keep baud rate as a string (for PPI default is 9600, for MPI 38400)
-    self.serialParity = parity.charAt(0); // shorten parity string to first char e.g. 'e' 'o' or 'n' (for PPI default is even, for MPI odd)
+    self.serialParity = (parity || '').charAt(0); // shorten parity string to first char e.g. 'e' 'o' or 'n' (for PPI default is even, for MPI odd)
+    self.parallelJobs = 1;
+    // how long reconnects took, by how far they had to go back
+    self.reconnectStats = {
+        reconnects: 0,
+        failed: 0,
+        levels: [0, 0, 0], // connection only, adapter as well, full
+        lastUs: 0,
+        maxUs: 0,
+        totalUs: 0
+    };
 
-    // mpi only settings
-    if (self.protocolMode === 'MPI') {
-        self.mpiMode = constants.mpiModeTranslate[mpiMode] !== null ? constants.mpiModeTranslate[mpiMode] : constants.mpiModeTranslate['MPI v1'];
-        self.mpiSpeed = constants.mpiSpeedTranslate[mpiSpeed] !== null ? constants.mpiSpeedTranslate[mpiSpeed] : constants.mpiSpeedTranslate['187K'];
+    // ppi only settings
+    options = options || {};
+    self.ppiTurnaround = constants.ppiTurnaroundTranslate.hasOwnProperty(options.turnaround) ? constants.ppiTurnaroundTranslate[options.turnaround] : constants.ppiTurnaroundTranslate.fixed;
+    self.ppiTurnaroundDelay = options.hasOwnProperty('turnaroundDelay') ? options.turnaroundDelay : -1; // microseconds, fixed mode only (-1 for 20ms)
+
+    // iso tcp only settings, device is then the PLC's host name or IP address
+    self.tcpPort = options.port || 102;
+    self.tcpRack = options.rack || 0;
+    self.tcpSlot = options.hasOwnProperty('slot') ? options.slot : 2;
+    self.tcpParallelJobs = options.hasOwnProperty('parallelJobs') ? options.parallelJobs : 8; // 1 for stop and wait
+
+    // gateway only settings, device is then the gateway's host name or IP address
+    self.netLinkProtocol = constants.netLinkProtocolTranslate[protocolMode];
+    self.netLinkPort = options.port || constants.netLinkPortDefault[protocolMode];
+
+    // mpi only settings, also the bus speed behind a gateway
+    if ((self.protocolMode === 'MPI') || (self.netLinkProtocol !== undefined)) {
+        self.mpiMode = constants.mpiModeTranslate.hasOwnProperty(mpiMode) ? constants.mpiModeTranslate[mpiMode] : constants.mpiModeTranslate['MPI v1'];
+        self.mpiSpeed = constants.mpiSpeedTranslate.hasOwnProperty(mpiSpeed) ? constants.mpiSpeedTranslate[mpiSpeed] : constants.mpiSpeedTranslate['187K'];
     }
 
-    // create context and keep a reference to it
-    self.context = nodaveBindings.createContext();
+    // create context and keep a reference to it, its I/O thread queues up to queueLength commands
+    self.context = nodaveBindings.createContext(options.queueLength);
 }
 
 // helper functions
@@ -58,6 +86,33 @@ function convertReadTypeToLength(readType) {
 }
 
 
+function convertDecodedValue(readRequest, value, status) {
+    // a non zero status means there was no value for this item
+    if (status !== 0) {
+        return null;
+    }
+    if (readRequest.format === constants.FORMAT_BOOL) {
+        return value > 0;
+    }
+    return value;
+}
+
+
+// S7-200 PPI connections, direct or through a gateway, address the S7-200 memory areas, all others the S7-300 ones
+function usesPPIAreas(self) {
+    return (self.protocolMode === 'PPI') || (self.protocolMode === 'IBH PPI');
+}
+
+
+function connectionEstablished(self) {
+    // the read plan depends on the PDU length negotiated with the PLC
+    self.maxPDULength = nodaveBindings.getMaxPDULength(self.context);
+    // and how many of its requests may be in flight at once
+    self.parallelJobs = nodaveBindings.getParallelJobs(self.context);
+    self.readPlan = null;
+}
+
+
 // api functions
 
 NodeS7Serial.prototype.initiateConnection = function(callback) {
@@ -71,15 +126,37 @@ NodeS7Serial.prototype.initiateConnection = function(callback) {
                     return callback(err);
                 } else {
                     self.connected = true;
+                    connectionEstablished(self);
+                    return callback(null);
+                }
+            });
+        } else if (self.netLinkProtocol !== undefined) {
+            nodaveBindings.connectNetLink(self.context, self.serialDevice, self.netLinkPort, self.netLinkProtocol, self.mpiSpeed, self.localAddress, self.plcAddress, self.tcpRack, self.tcpSlot, function(err) {
+                if (err) {
+                    return callback(err);
+                } else {
+                    self.connected = true;
+                    connectionEstablished(self);
+                    return callback(null);
+                }
+            });
+        } else if (self.protocolMode === 'TCP') {
+            nodaveBindings.connectTCP(self.context, self.serialDevice, self.tcpPort, self.tcpRack, self.tcpSlot, self.tcpParallelJobs, function(err) {
+                if (err) {
+                    return callback(err);
+                } else {
+                    self.connected = true;
+                    connectionEstablished(self);
                     return callback(null);
                 }
             });
         } else {
-            nodaveBindings.connectPPI(self.context, self.serialDevice, self.serialBaudRate, self.serialParity, self.localAddress, self.plcAddress, function(err) {
+            nodaveBindings.connectPPI(self.context, self.serialDevice, self.serialBaudRate, self.serialParity, self.localAddress, self.plcAddress, self.ppiTurnaround, self.ppiTurnaroundDelay, function(err) {
                 if (err) {
                     return callback(err);
                 } else {
                     self.connected = true;
+                    connectionEstablished(self);
                     return callback(null);
                 }
             });
@@ -90,11 +167,86 @@ NodeS7Serial.prototype.initiateConnection = function(callback) {
 
 };
 
+NodeS7Serial.prototype.reconnect = function(callback) {
+    var self = this;
+    var startedAt = process.hrtime();
+
+    // the time from asking until reads can go ahead again, waiting for the line included
+    function reconnected(err, level) {
+        var elapsed = process.hrtime(startedAt);
+        var us = (elapsed[0] * 1e6) + Math.round(elapsed[1] / 1e3);
+        var stats = self.reconnectStats;
+        stats.reconnects++;
+        stats.lastUs = us;
+        stats.maxUs = Math.max(stats.maxUs, us);
+        stats.totalUs += us;
+        if (err) {
+            stats.failed++;
+            return callback(err, level);
+        }
+        stats.levels[level - 1]++;
+        return callback(null, level);
+    }
+
+    // tty (or socket) and adapter are set up from scratch, the read list is kept
+    function reconnectFully() {
+        self.connected = false;
+        nodaveBindings.disconnect(self.context, function() {
+            self.initiateConnection(function(err) {
+                return reconnected(err, constants.RECONNECT_FULL);
+            });
+        });
+    }
+
+    try {
+        if (self.connected !== true) {
+            return reconnectFully();
+        }
+        // first only the PLC connection on the port and adapter that are still open, with the
+        // parameters negotiated last time, the binding goes on to the adapter itself
+        nodaveBindings.reconnect(self.context, function(err, level) {
+            if (err) {
+                return reconnectFully();
+            }
+            connectionEstablished(self);
+            return reconnected(null, level);
+        });
+    } catch (err) {
+        return callback(err);
+    }
+};
+
+NodeS7Serial.prototype.getReconnectStats = function() {
+    var self = this;
+
+    // how often reconnect was called, how far it had to go back and how long reads were held up
+    var stats = self.reconnectStats;
+    return {
+        reconnects: stats.reconnects,
+        failed: stats.failed,
+        connectionOnly: stats.levels[constants.RECONNECT_CONNECTION - 1],
+        adapter: stats.levels[constants.RECONNECT_ADAPTER - 1],
+        full: stats.levels[constants.RECONNECT_FULL - 1],
+        lastUs: stats.lastUs,
+        maxUs: stats.maxUs,
+        totalUs: stats.totalUs,
+        averageUs: (stats.reconnects > 0) ? (stats.totalUs / stats.reconnects) : 0
+    };
+};
+
 NodeS7Serial.prototype.dropConnection = function(callback) {
     var self = this;
 
+    // the subscription thread has to be gone before the connection is
+    if (self.subscribed === true) {
+        return self.unsubscribe(function() {
+            self.dropConnection(callback);
+        });
+    }
+
     // clear read list
     self.readRequestArray = [];
+    self.readPlan = null;
 
     //if we successfuly connected
     if (self.connected === true) {
@@ -203,7 +355,7 @@ NodeS7Serial.prototype.addItems = function(address, format) {
             readType = constants.READ_BIT;
 
             // extract the memory area code
-            if (self.protocolMode === 'MPI') {
+            if (!usesPPIAreas(self)) {
                 memoryArea = constants.mpiAreaTranslate[splitAddress[0].substr(0, 1)];
             } else {
                 memoryArea = constants.ppiAreaTranslate[splitAddress[0].substr(0, 1)];
@@ -240,7 +392,7 @@ NodeS7Serial.prototype.addItems = function(address, format) {
             lengthCodeIndex = 2;
         } else {
             // extract the one byte memory area code
-            if (self.protocolMode === 'MPI') {
+            if (!usesPPIAreas(self)) {
                 memoryArea = constants.mpiAreaTranslate[splitAddress[0].substr(0, 1)];
             } else {
                 memoryArea = constants.ppiAreaTranslate[splitAddress[0].substr(0, 1)];
@@ -280,69 +432,134 @@ NodeS7Serial.prototype.addItems = function(address, format) {
         readType: readType,
         memoryArea: memoryArea,
         blockIndex: blockIndex,
-        startAddress: startAddress
+        startAddress: startAddress,
+        length: convertReadTypeToLength(readType)
     };
 
     self.readRequestArray.push(newRequest);
+    self.readPlan = null;
+};
+
+NodeS7Serial.prototype.getPPIStats = function() {
+    var self = this;
+
+    // retry counters and last turnaround delay, only kept for PPI connections
+    if ((self.connected !== true) || (self.protocolMode !== 'PPI')) {
+        return null;
+    }
+    return nodaveBindings.getPPIStats(self.context);
+};
+
+NodeS7Serial.prototype.getQueueStats = function() {
+    var self = this;
+
+    // depth of the I/O thread command queue and how long commands waited in it
+    var stats = nodaveBindings.getQueueStats(self.context);
+    stats.waitAverageUs = (stats.executed > 0) ? (stats.waitTotalUs / stats.executed) : 0;
+    // and per priority class, how long its exchanges waited from being issued until they got the serial line
+    stats.classes.forEach(function(classStats) {
+        classStats.waitAverageUs = (classStats.exchanges > 0) ? (classStats.waitTotalUs / classStats.exchanges) : 0;
+    });
+    return stats;
+};
+
+// upper bound of the histogram bucket the p-th percentile of the exchanges fell into
+function latencyPercentile(stats, p) {
+    var rank = Math.ceil(stats.exchanges * p / 100);
+    var count = 0;
+    for (var i = 0; i < stats.latency.length; i++) {
+        count += stats.latency[i];
+        if ((count >= rank) && (count > 0)) {
+            // beyond the last bound, the maximum seen is all we know
+            return (i < stats.latencyBucketUs.length) ? Math.min(stats.latencyBucketUs[i], stats.latencyMaxUs) : stats.latencyMaxUs;
+        }
+    }
+    return 0;
+}
+
+NodeS7Serial.prototype.getStats = function() {
+    var self = this;
+
+    // link health of the connection as of its last exchange: latency histogram, errors, retries and traffic
+    var stats = nodaveBindings.getStats(self.context);
+    stats.latencyAverageUs = (stats.exchanges > 0) ? (stats.latencyTotalUs / stats.exchanges) : 0;
+    stats.latencyP50Us = latencyPercentile(stats, 50);
+    stats.latencyP99Us = latencyPercentile(stats, 99);
+    stats.errorRate = (stats.exchanges > 0) ? (stats.errors / stats.exchanges) : 0;
+    return stats;
+};
+
+NodeS7Serial.prototype.setCoalesceGap = function(gap) {
+    var self = this;
+
+    // number of unused bytes we are prepared to read to merge two items into one, negative disables merging
+    self.coalesceGap = gap;
+    self.readPlan = null;
+};
+
+NodeS7Serial.prototype.getReadPlan = function() {
+    var self = this;
+
+    // work out how the read list is merged and split into exchanges, only when the list, gap or PDU length changed
+    if (self.readPlan === null) {
+        self.readPlan = planner.buildReadPlan(self.readRequestArray, self.maxPDULength, self.coalesceGap);
+    }
+    return self.readPlan;
 };
 
-NodeS7Serial.prototype.readAllItems = function(callback) {
+NodeS7Serial.prototype.readAllItems = function(callback, priority) {
     var self = this;
 
+    // a timer driven poll passes PRIORITY_POLL so that on-demand reads and writes go ahead of its exchanges
+    if (priority !== constants.PRIORITY_POLL) {
+        priority = constants.PRIORITY_READ;
+    }
+
     try {
 
-        var startingReadIndex = 0;
-        var currentReadIndex = 0;
-        var readRequest;
+        var readPlan = self.getReadPlan();
+        var planIndex = 0;
 
         // clear the results object
         self.resultsObject = {};
 
+        // over iso tcp with more than one job negotiated, hand the whole plan over in one go so its requests are
+        // pipelined rather than each waiting for the answer to the one before
+        if ((self.parallelJobs > 1) && (readPlan.requests.length > 1)) {
+            var flat = readPlan.flat;
+            nodaveBindings.readExchanges(self.context, flat.items, flat.exchanges, flat.descriptors, priority, function(err, values, status) {
+                if (err) {
+                    return callback(err);
+                }
+                for (var valueIndex = 0; valueIndex < flat.readIndexes.length; valueIndex++) {
+                    var readRequest = self.readRequestArray[flat.readIndexes[valueIndex]];
+                    self.resultsObject[readRequest.address] = convertDecodedValue(readRequest, values[valueIndex], status[valueIndex]);
+                }
+                return callback(null, self.resultsObject);
+            });
+            return;
+        }
+
         async.whilst (
-            function () { return startingReadIndex < self.readRequestArray.length; },
+            function () { return planIndex < readPlan.requests.length; },
             function (cb) {
 
-                nodaveBindings.prepareReadRequest(self.context);
-
-                var requestCount = 0;
-                currentReadIndex = startingReadIndex;
-                while ((requestCount < NUMBER_OF_REQUESTS_IN_MULTIREAD) &&
-                       (currentReadIndex < self.readRequestArray.length)) {
-                    readRequest = self.readRequestArray[currentReadIndex];
-                    var length = convertReadTypeToLength(readRequest.readType);
-                    nodaveBindings.addVarToRequest(self.context,
-                                                    readRequest.readType,
-                                                     readRequest.memoryArea,
-                                                      readRequest.blockIndex,
-                                                       readRequest.startAddress,
-                                                        length);
-                    requestCount = requestCount + 1;
-                    currentReadIndex = currentReadIndex + 1;
-                }
-
-                // peform the actual reads (asyncronous)
-                nodaveBindings.execReadRequest(self.context, function(err, data) {
+                // build the request from the (merged) items the plan packed into this exchange, peform the actual
+                // reads and slice every value out of the results, all in the worker thread (asyncronous)
+                var planRequest = readPlan.requests[planIndex];
+                nodaveBindings.readItems(self.context, planRequest.items, planRequest.descriptors, priority, function(err, values, status) {
                     if (err) {
                         return callback(err);
                     }
 
-                    // now need to get the results back out
-                    var responseIndex = 0;
-                    currentReadIndex = startingReadIndex;
-                    // loop through the same self.readRequestArray elements we just added to the read request (syncronously)
-                    while (responseIndex < requestCount) {
-                        readRequest = self.readRequestArray[currentReadIndex];
-                        var result = nodaveBindings.getResult(self.context, responseIndex, readRequest.readType, readRequest.format, readRequest.memoryArea);
+                    // the values come back in the order of the read requests this exchange answers
+                    for (var responseIndex = 0; responseIndex < planRequest.readIndexes.length; responseIndex++) {
+                        var readRequest = self.readRequestArray[planRequest.readIndexes[responseIndex]];
                         // add to the results object with the key of the address string (result could be a bool, integer or float)
-                        self.resultsObject[readRequest.address] = result;
-                        responseIndex = responseIndex + 1;
-                        currentReadIndex = currentReadIndex + 1;
+                        self.resultsObject[readRequest.address] = convertDecodedValue(readRequest, values[responseIndex], status[responseIndex]);
                     }
 
-                    // free the memory used for the results
-                    nodaveBindings.freeResults(self.context);
-
-                    startingReadIndex = currentReadIndex;
+                    planIndex = planIndex + 1;
                     cb(null);
                 });
             },
@@ -354,34 +571,181 @@ NodeS7Serial.prototype.readAllItems = function(callback) {
     }
 };
 
-NodeS7Serial.prototype.writeItems = function(variable, data, callback) {
-    let self = this;
+NodeS7Serial.prototype.readBlock = function(area, blockIndex, start, length, callback, priority) {
+    var self = this;
 
-    //NOTE: Only one element can be written at once.
+    // as for readAllItems, a timer driven poll passes PRIORITY_POLL
+    if (priority !== constants.PRIORITY_POLL) {
+        priority = constants.PRIORITY_READ;
+    }
 
-    try{
-        let writeRequest = getWriteParam(variable, self);
-        nodaveBindings.prepareWriteRequest(self.context);
+    // the area is a memory area constant or its letters as in an address, e.g. 'DB' or 'V'
+    if (typeof area === 'string') {
+        var areaTranslate = usesPPIAreas(self) ? constants.ppiAreaTranslate : constants.mpiAreaTranslate;
+        if (!areaTranslate.hasOwnProperty(area)) {
+            return callback(new Error('Invalid memory area ' + area));
+        }
+        area = areaTranslate[area];
+    }
+
+    try {
+        // the bytes are read in PDU sized exchanges in the worker thread, straight into a single Buffer.
+        // Take the values out of it with block.getValue, or whole arrays with block.decodeArray
+        nodaveBindings.readBlock(self.context, area, blockIndex, start, length, priority, function(err, data) {
+            if (err) {
+                return callback(err);
+            }
+            return callback(null, data);
+        });
+    } catch (err) {
+        return callback(err);
+    }
+};
+
+NodeS7Serial.prototype.subscribe = function(periodMs, options, callback) {
+    var self = this;
 
-        let length = convertReadTypeToLength(writeRequest.readType);
-        const buff = Buffer.allocUnsafe(length);
+    // options is optional: { deadband: default deadband, deadbands: { address: deadband } }
+    if (typeof options === 'function') {
+        callback = options;
+        options = {};
+    }
+    options = options || {};
+    var defaultDeadband = options.deadband || 0;
+    var deadbands = options.deadbands || {};
 
-        if (length == 2){
-            buff.writeInt16BE(data,0);
-        } else if (length == 4){
-            buff.writeInt32BE(data,0);
+    try {
+        if (self.connected !== true) {
+            return callback(new Error('Not connected'));
         }
-        else{
-            buff.writeInt8(data,0);
+        if (self.subscribed === true) {
+            return callback(new Error('Already subscribed'));
         }
-        nodaveBindings.addWriteVarToRequest(self.context, writeRequest.readType, writeRequest.memoryArea, writeRequest.blockIndex, writeRequest.startAddress, length, buff);
 
-        nodaveBindings.execWriteRequest(self.context, (err)=>{
-            if (err) {
-                return callback(err);
+        // the whole read plan laid out flat, the values of each exchange following on from the previous one
+        var flat = self.getReadPlan().flat;
+        var valueCount = flat.readIndexes.length;
+        var valueDeadbands = new Float64Array(valueCount);
+        var valueToRequest = new Array(valueCount);
+        for (var valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+            var readRequest = self.readRequestArray[flat.readIndexes[valueIndex]];
+            valueDeadbands[valueIndex] = deadbands.hasOwnProperty(readRequest.address) ? deadbands[readRequest.address] : defaultDeadband;
+            valueToRequest[valueIndex] = readRequest;
+        }
+
+        // the native thread only calls back with the values that changed since they were last delivered
+        nodaveBindings.subscribe(self.context, flat.items, flat.exchanges, flat.descriptors, valueDeadbands, periodMs, function(err, indexes, values, status) {
+            var changes = {};
+            for (var i = 0; i < indexes.length; i++) {
+                var readRequest = valueToRequest[indexes[i]];
+                changes[readRequest.address] = convertDecodedValue(readRequest, values[i], status[i]);
             }
-            return callback(null);
+            callback(err, changes);
         });
+        self.subscribed = true;
+
+    } catch (err) {
+        return callback(err);
+    }
+};
+
+NodeS7Serial.prototype.unsubscribe = function(callback) {
+    var self = this;
+
+    if (self.subscribed !== true) {
+        return callback(null);
+    }
+    self.subscribed = false;
+
+    // the callback is called once the native thread has stopped
+    if (!nodaveBindings.unsubscribe(self.context, function() { callback(null); })) {
+        return callback(null);
+    }
+};
+
+function encodeWriteValue(writeRequest, data) {
+    const buff = Buffer.allocUnsafe(writeRequest.length);
+
+    if (writeRequest.length == 2){
+        buff.writeInt16BE(data,0);
+    } else if (writeRequest.length == 4){
+        buff.writeInt32BE(data,0);
+    }
+    else{
+        buff.writeInt8(data,0);
+    }
+    return buff;
+}
+
+NodeS7Serial.prototype.writeItems = function(variables, data, callback) {
+    let self = this;
+
+    // either a single variable and value, or arrays of both as with nodes7. Multiple items are packed
+    // into as few write requests as the PDU length allows, the callback then gets an error (or null) per item
+    const single = !Array.isArray(variables);
+    if (single) {
+        variables = [variables];
+        data = [data];
+    }
+
+    try{
+        let itemErrors = new Array(variables.length).fill(null);
+        let writeRequests = [];
+        let writeIndexes = [];
+        let buffers = [];
+        variables.forEach((variable, index) => {
+            let writeRequest = getWriteParam(variable, self);
+            if (writeRequest === -1) {
+                itemErrors[index] = new Error(`Invalid address ${variable.address}`);
+                return;
+            }
+            writeRequests.push(writeRequest);
+            writeIndexes.push(index);
+            buffers.push(encodeWriteValue(writeRequest, data[index]));
+        });
+
+        let writePlan = planner.packWriteRequests(writeRequests, self.maxPDULength);
+        let planIndex = 0;
+
+        async.whilst (
+            function () { return planIndex < writePlan.requests.length; },
+            function (cb) {
+
+                // the request is built in the worker thread, so it can't get mixed up with a subscription's
+                let planRequest = writePlan.requests[planIndex];
+                let items = new Int32Array(planRequest.count * 5);
+                for (let n = 0; n < planRequest.count; n++) {
+                    let writeRequest = writeRequests[planRequest.startIndex + n];
+                    items.set([writeRequest.readType, writeRequest.memoryArea, writeRequest.blockIndex, writeRequest.startAddress, writeRequest.length], n * 5);
+                }
+                let buff = Buffer.concat(buffers.slice(planRequest.startIndex, planRequest.startIndex + planRequest.count));
+
+                nodaveBindings.writeItems(self.context, items, buff, (err, status) => {
+                    if (err) {
+                        // the PLC didn't answer, so don't wait for it again for the rest of the items
+                        for (let n = planRequest.startIndex; n < writeRequests.length; n++) {
+                            itemErrors[writeIndexes[n]] = err;
+                        }
+                        planIndex = writePlan.requests.length;
+                        return cb(null);
+                    }
+                    for (let n = 0; n < planRequest.count; n++) {
+                        if (status[n] !== 0) {
+                            itemErrors[writeIndexes[planRequest.startIndex + n]] = new Error(`Error Executing Write Request. Return code = ${status[n]}\n`);
+                        }
+                    }
+                    planIndex = planIndex + 1;
+                    return cb(null);
+                });
+            },
+            function () {
+                let firstError = itemErrors.find(itemError => itemError !== null) || null;
+                if (single) {
+                    return callback(firstError);
+                }
+                return callback(firstError, itemErrors);
+            }
+        );
 
     } catch (err){
         return callback(err);
@@ -473,7 +837,7 @@ function getWriteParam(variable, self) {
             readType = constants.READ_BIT;
 
             // extract the memory area code
-            if (self.protocolMode === 'MPI') {
+            if (!usesPPIAreas(self)) {
                 memoryArea = constants.mpiAreaTranslate[splitAddress[0].substr(0, 1)];
             } else {
                 memoryArea = constants.ppiAreaTranslate[splitAddress[0].substr(0, 1)];
@@ -510,7 +874,7 @@ function getWriteParam(variable, self) {
             lengthCodeIndex = 2;
         } else {
             // extract the one byte memory area code
-            if (self.protocolMode === 'MPI') {
+            if (!usesPPIAreas(self)) {
                 memoryArea = constants.mpiAreaTranslate[splitAddress[0].substr(0, 1)];
             } else {
                 memoryArea = constants.ppiAreaTranslate[splitAddress[0].substr(0, 1)];
@@ -550,7 +914,8 @@ function getWriteParam(variable, self) {
         readType: readType,
         memoryArea: memoryArea,
         blockIndex: blockIndex,
-        startAddress: startAddress
+        startAddress: startAddress,
+        length: convertReadTypeToLength(readType)
     };
 
     return newRequest;
@@ -558,3 +923,4 @@ function getWriteParam(variable, self) {
 
 module.exports.constructor = NodeS7Serial;
 module.exports.constants = constants;
+module.exports.block = require('./block.js');
@@ -87,10 +87,12 @@ void setTimeOut(daveInterface * di, int tmo) {
 int DECL2 stdwrite(daveInterface * di, char * buffer, int length) {
     if (daveDebug & daveDebugByte)
 	_daveDump("I send", (uc*)buffer, length);
-    return write(di->fd.wfd, buffer,length);
+    int res=write(di->fd.wfd, buffer,length);
+    if (res>0) di->txBytes+=res;
+    return res;
 }
 
-int DECL2 stdread(daveInterface * di, char * buffer, int length) {
+static int _daveSelectRead(daveInterface * di, char * buffer, int length) {
     fd_set FDS;
     struct timeval t;
     int i;
@@ -99,9 +101,35 @@ int DECL2 stdread(daveInterface * di, char * buffer, int length) {
     FD_ZERO(&FDS);
     FD_SET(di->fd.rfd, &FDS);
     i=0;
+    di->rxSyscalls++;
     if(select(di->fd.rfd + 1, &FDS, NULL, NULL, &t)>0) {
         i=read(di->fd.rfd, buffer, length);
+	if (i>0) di->rxBytes+=i;
     }
+    return i;
+}
+
+/*
+    Serial protocols read their frames a byte at a time. On a buffered interface,
+    hand those bytes out of rxBuffer and only go to the device (reading whatever
+    it has available) once everything read before has been consumed.
+*/
+int DECL2 stdread(daveInterface * di, char * buffer, int length) {
+    int i;
+    di->rxReadCalls++;
+    if (!di->rxBuffered) return _daveSelectRead(di, buffer, length);
+    if (di->rxHead>=di->rxTail) {
+	di->rxHead=0;
+	di->rxTail=0;
+	if (length>=daveRxBufferSize) return _daveSelectRead(di, buffer, length);
+	i=_daveSelectRead(di, (char*)di->rxBuffer, daveRxBufferSize);
+	if (i<=0) return i;
+	di->rxTail=i;
+    }
+    i=di->rxTail-di->rxHead;
+    if (i>length) i=length;
+    memcpy(buffer, di->rxBuffer+di->rxHead, i);
+    di->rxHead+=i;
 //    if (daveDebug & daveDebugByte)
 //	_daveDump("got",buffer,i);
     return i;
@@ -160,6 +188,10 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 	di->getResponse=_daveGetResponseISO_TCP;
 	di->ifread=stdread;
 	di->ifwrite=stdwrite;
+	di->rxBuffered=0;
+	di->turnaroundMode=daveTurnaroundFixed;
+	di->turnaroundDelay=20000;	/* 20 ms, what PPI always waited before */
+	di->turnaroundBaud=9600;
 	di->initAdapter=_daveReturnOkDummy;
 	di->connectPLC=_daveReturnOkDummy2;
 	di->disconnectPLC=_daveReturnOkDummy2;
@@ -168,6 +200,7 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 	switch (protocol) {
 	    case daveProtoMPI:
 		di->initAdapter=_daveInitAdapterMPI1;
+		di->rxBuffered=1;
 		di->connectPLC=_daveConnectPLCMPI1;
 		di->disconnectPLC=_daveDisconnectPLCMPI;
 		di->disconnectAdapter=_daveDisconnectAdapterMPI;
@@ -180,6 +213,7 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 	    case daveProtoMPI2:
 	    case daveProtoMPI4:
 		di->initAdapter=_daveInitAdapterMPI2;
+		di->rxBuffered=1;
 		di->connectPLC=_daveConnectPLCMPI2;
 		di->disconnectPLC=_daveDisconnectPLCMPI;
 		di->disconnectAdapter=_daveDisconnectAdapterMPI;
@@ -192,6 +226,7 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 
 	    case daveProtoMPI3:
 		di->initAdapter=_daveInitAdapterMPI3;
+		di->rxBuffered=1;
 		di->connectPLC=_daveConnectPLCMPI3;
 		di->disconnectPLC=_daveDisconnectPLCMPI3;
 		di->disconnectAdapter=_daveDisconnectAdapterMPI3;
@@ -212,6 +247,7 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 	    case daveProtoPPI:
 		di->getResponse=_daveGetResponsePPI;
 		di->exchange=_daveExchangePPI;
+		di->rxBuffered=1;
 		di->connectPLC=_daveConnectPLCPPI;
 		di->timeout=150000; /* 0.15 seconds */
 		break;
@@ -241,6 +277,7 @@ daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int
 		break;
 	    case daveProtoAS511:
 		di->connectPLC=_daveConnectPLCAS511;
+		di->rxBuffered=1;
 		di->disconnectPLC=_daveDisconnectPLCAS511;
 		di->exchange=_daveFakeExchangeAS511;
 		di->sendMessage=_daveFakeExchangeAS511;
@@ -323,6 +360,97 @@ int DECL2 daveGetTimeout(daveInterface * di) {
     return di->timeout;
 }
 
+void DECL2 daveSetRxBuffered(daveInterface * di, int buffered) {
+#ifdef DEBUG_CALLS
+    LOG3("daveSetRxBuffered(di:%p, buffered:%d)\n", di, buffered);
+#endif
+    _daveFlushRx(di);
+    di->rxBuffered=buffered;
+}
+
+void DECL2 daveGetRxStats(daveInterface * di, unsigned long * readCalls, unsigned long * syscalls) {
+    if (readCalls) *readCalls=di->rxReadCalls;
+    if (syscalls) *syscalls=di->rxSyscalls;
+}
+
+/*
+    Select how PPI times the poll for a response after the PLC acknowledged a request.
+    baud is the line speed the computed delays are based on, fixedDelay (microseconds)
+    the delay of daveTurnaroundFixed. Negative values keep the current settings.
+*/
+void DECL2 daveSetPPITurnaround(daveInterface * di, int mode, int baud, int fixedDelay) {
+#ifdef DEBUG_CALLS
+    LOG5("daveSetPPITurnaround(di:%p, mode:%d, baud:%d, fixedDelay:%d)\n", di, mode, baud, fixedDelay);
+#endif
+    di->turnaroundMode=mode;
+    if (baud>0) di->turnaroundBaud=baud;
+    if (fixedDelay>=0) di->turnaroundDelay=fixedDelay;
+    di->turnaroundBackoff=0;
+    di->turnaroundClean=0;
+}
+
+int DECL2 daveGetPPITurnaround(daveInterface * di) {
+    return di->lastTurnaround;
+}
+
+void DECL2 daveGetPPIRetries(daveInterface * di, int * secondTries, int * thirdTries, int * pollRetries) {
+    if (secondTries) *secondTries=di->secondTries;
+    if (thirdTries) *thirdTries=di->thirdTries;
+    if (pollRetries) *pollRetries=di->pollRetries;
+}
+
+/*
+    Link health: _daveExchange and the pipelined and event driven calls time every
+    exchange and count it here, the transport code counts bytes, retries and
+    checksum errors on the interface.
+*/
+static unsigned long long _daveMicroseconds(void) {
+#ifdef LINUX
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+#endif
+#ifdef BCCWIN
+    return 1000ULL * GetTickCount();
+#endif
+    return 0;
+}
+
+void DECL2 _daveRecordExchange(daveConnection * dc, int res, unsigned long usec) {
+    daveConnectionStats * s=&(dc->stats);
+    int i=0;
+    while ((i<daveLatencyBuckets-1) && (usec>=(128UL<<i))) i++;
+    s->latency[i]++;
+    s->exchanges++;
+    s->latencyTotal+=usec;
+    if (usec>s->latencyMax) s->latencyMax=usec;
+    if (res==daveResOK) {
+	s->pdusReceived++;
+    } else {
+	s->errors++;
+	if (res==daveResTimeout) s->timeouts++;
+    }
+}
+
+void DECL2 daveGetConnectionStats(daveConnection * dc, daveConnectionStats * stats) {
+    *stats=dc->stats;
+}
+
+void DECL2 daveResetConnectionStats(daveConnection * dc) {
+#ifdef DEBUG_CALLS
+    LOG2("daveResetConnectionStats(dc:%p)\n", dc);
+#endif
+    memset(&(dc->stats), 0, sizeof(dc->stats));
+}
+
+/*
+    Throw away bytes read ahead but not yet consumed.
+*/
+void DECL2 _daveFlushRx(daveInterface * di) {
+    di->rxHead=0;
+    di->rxTail=0;
+}
+
 char * DECL2 daveGetName(daveInterface * di) {
 #ifdef DEBUG_CALLS
     LOG2("daveGetName(di:%p)\n",di);
@@ -1332,78 +1460,152 @@ int DECL2 daveReadBits(daveConnection * dc,int area, int DBnum, int start,int le
 }
 
 /*
-    Execute a predefined read request. Store results into the resultSet structure.
+    Fill results from the data part of a read response. The payloads are left where
+    they are, bytes points into the received PDU.
 */
-int DECL2 daveExecReadRequest(daveConnection * dc, PDU *p, daveResultSet* rl){
-    PDU p2;
+static void _daveParseReadResults(PDU * p2, daveResult * results, int count) {
     uc * q;
-    daveResult * cr, *c2;
-    int res, i, len, rlen;
-#ifdef DEBUG_CALLS
-    LOG4("daveExecReadRequest(dc:%p, PDU:%p, rl:%p\n", dc, p, rl);
-    FLUSH;
-#endif
+    daveResult * c2;
+    int i, len, rlen;
+    i=0;
+    c2=results;
+    q=p2->data;
+    rlen=p2->dlen;
+    while (i<count) {
+/*	printf("result %d: %d  %d %d %d\n",i, *q,q[1],q[2],q[3]); */
+	if ((*q==255)&&(rlen>4)) {
+	    len=q[2]*0x100+q[3];
+	    if (q[1]==4) {
+		len>>=3;	/* len is in bits, adjust */
+	    } else if (q[1]==9) {
+		/* len is already in bytes, ok */
+	    } else if (q[1]==3) {
+		/* len is in bits, but there is a byte per result bit, ok */
+	    } else {
+		if (daveDebug & daveDebugPDU)
+		    LOG2("fixme: what to do with data type %d?\n",q[1]);
+	    }
+	} else {
+	    len=0;
+	}
+/*	printf("Store result %d length:%d\n", i, len); */
+	c2->length=len;
+	c2->bytes=(len>0) ? q+4 : NULL;
+	c2->error=daveUnknownError;
+
+	if (q[0]==0xFF) {
+	    c2->error=daveResOK;
+	} else
+	    c2->error=q[0];
+
+/*	printf("Error %d\n", c2->error); */
+	q+=len+4;
+	rlen-=len;
+	if ((len % 2)==1) {
+	    q++;
+	    rlen--;
+	}
+	c2++;
+	i++;
+    }
+}
+
+static int _daveReadRequest(daveConnection * dc, PDU *p, PDU *p2){
+    int res;
     dc->AnswLen=0;	// 03/12/05
     dc->resultPointer=NULL;
     dc->_resultPointer=NULL;
     res=_daveExchange(dc, p);
     if (res!=daveResOK) return res;
-    res=_daveSetupReceivedPDU(dc, &p2);
+    res=_daveSetupReceivedPDU(dc, p2);
     if (res!=daveResOK) return res;
-    res=_daveTestReadResult(&p2);
+    return _daveTestReadResult(p2);
+}
+
+/*
+    Execute a predefined read request. Store results into the resultSet structure.
+    The results belong to the application until daveFreeResults, so they are parsed
+    in the connection's arena and copied out with a single allocation: the results
+    array with the payloads behind it.
+*/
+int DECL2 daveExecReadRequest(daveConnection * dc, PDU *p, daveResultSet* rl){
+    PDU p2;
+    daveResult * cr;
+    uc * bytes;
+    int res, i, len;
+#ifdef DEBUG_CALLS
+    LOG4("daveExecReadRequest(dc:%p, PDU:%p, rl:%p\n", dc, p, rl);
+    FLUSH;
+#endif
+    res=_daveReadRequest(dc, p, &p2);
     if(res!=daveResOK) return res;
-    i=0;
     if (rl!=NULL) {
-	cr=(daveResult*)calloc(p2.param[1], sizeof(daveResult));
+	if (p2.param[1]>daveMaxArenaResults) return daveResCannotEvaluatePDU;
+	_daveParseReadResults(&p2, dc->arena.results, p2.param[1]);
+	len=0;
+	for (i=0; i<p2.param[1]; i++) len+=dc->arena.results[i].length;
+	cr=(daveResult*)malloc(p2.param[1]*sizeof(daveResult)+len);
+	if (cr==NULL) return daveResCannotEvaluatePDU;
 	rl->numResults=p2.param[1];
 	rl->results=cr;
-	c2=cr;
-	q=p2.data;
-	rlen=p2.dlen;
-	while (i<p2.param[1]) {
-/*	    printf("result %d: %d  %d %d %d\n",i, *q,q[1],q[2],q[3]); */
-	    if ((*q==255)&&(rlen>4)) {
-		len=q[2]*0x100+q[3];
-		if (q[1]==4) {
-		    len>>=3;	/* len is in bits, adjust */
-		} else if (q[1]==9) {
-		    /* len is already in bytes, ok */
-		} else if (q[1]==3) {
-		    /* len is in bits, but there is a byte per result bit, ok */
-		} else {
-		    if (daveDebug & daveDebugPDU)
-			LOG2("fixme: what to do with data type %d?\n",q[1]);
-		}
-	    } else {
-		len=0;
+	rl->arena=NULL;
+	bytes=(uc*)(cr+rl->numResults);
+	for (i=0; i<rl->numResults; i++) {
+	    cr[i]=dc->arena.results[i];
+	    if (cr[i].length>0) {
+		memcpy(bytes, cr[i].bytes, cr[i].length);
+		cr[i].bytes=bytes;
+		bytes+=cr[i].length;
 	    }
-/*	    printf("Store result %d length:%d\n", i, len); */
-	    c2->length=len;
-	    if(len>0){
-		 c2->bytes=(uc*)malloc(len);
-		 memcpy(c2->bytes, q+4, len);
-	    }
-	    c2->error=daveUnknownError;
-
-	    if (q[0]==0xFF) {
-		c2->error=daveResOK;
-	    } else
-		c2->error=q[0];
-
-/*	    printf("Error %d\n", c2->error); */
-	    q+=len+4;
-	    rlen-=len;
-	    if ((len % 2)==1) {
-	        q++;
-	        rlen--;
-	    }
-	    c2++;
-	    i++;
 	}
     }
     return res;
 }
 
+/*
+    Execute a predefined read request without allocating: the results are kept in
+    the connection's arena and their payloads are not copied out of msgIn.
+    daveFreeResults may still be called, it has nothing to do.
+*/
+int DECL2 daveExecReadRequestArena(daveConnection * dc, PDU *p, daveResultSet* rl){
+    PDU p2;
+    int res;
+#ifdef DEBUG_CALLS
+    LOG4("daveExecReadRequestArena(dc:%p, PDU:%p, rl:%p\n", dc, p, rl);
+    FLUSH;
+#endif
+    res=_daveReadRequest(dc, p, &p2);
+    if(res!=daveResOK) return res;
+    if (rl!=NULL) {
+	if (p2.param[1]>daveMaxArenaResults) return daveResCannotEvaluatePDU;
+	rl->numResults=p2.param[1];
+	rl->results=dc->arena.results;
+	rl->arena=&(dc->arena);
+	_daveParseReadResults(&p2, rl->results, rl->numResults);
+    }
+    return res;
+}
+
+/*
+    Move the payloads of arena results from msgIn into the arena, so they survive
+    other exchanges on the connection (up to the next daveExecReadRequestArena).
+*/
+int DECL2 daveKeepResults(daveConnection * dc, daveResultSet * rl){
+    daveResult * r;
+    int i, pos;
+    if ((rl==NULL) || (rl->arena!=&(dc->arena))) return daveEmptyResultSetError;
+    pos=0;
+    for (i=0; i<rl->numResults; i++) {
+	r=&(rl->results[i]);
+	if (r->length>0) {
+	    memmove(dc->arena.bytes+pos, r->bytes, r->length);
+	    r->bytes=dc->arena.bytes+pos;
+	    pos+=r->length;
+	}
+    }
+    return 0;
+}
+
 /*
     Execute a predefined write request.
 */
@@ -1421,11 +1623,16 @@ int DECL2 daveExecWriteRequest(daveConnection * dc, PDU *p, daveResultSet* rl){
     res=_daveSetupReceivedPDU(dc, &p2);
     if(res!=daveResOK) return res;
     res=_daveTestWriteResult(&p2);
-    if(res!=daveResOK) return res;
+    if(res==daveResUnexpectedFunc) return res;
+/*
+    The return value is still the result of the first item, but the result set is now
+    filled in whenever the PLC answered, so a failed item doesn't hide the others.
+*/
     if (rl!=NULL) {
         cr=(daveResult*)calloc(p2.param[1], sizeof(daveResult));
         rl->numResults=p2.param[1];
         rl->results=cr;
+        rl->arena=NULL;
         c2=cr;
         q=p2.data;
         i=0;
@@ -1481,8 +1688,6 @@ int DECL2 daveUseResult(daveConnection * dc, daveResultSet * rl, int n){
 }
 
 void DECL2 daveFreeResults(daveResultSet * rl){
-    daveResult * r;
-    int i;
 #ifdef DEBUG_CALLS
     LOG2("daveFreeResults(%p)",rl);
 #endif
@@ -1492,12 +1697,16 @@ void DECL2 daveFreeResults(daveResultSet * rl){
 #endif
         return;	// make it NULL safe
 }
-/*    printf("result set: %p\n",rl); */
-    for (i=0; i<rl->numResults; i++) {
-        r=&(rl->results[i]);
-/*	printf("result: %p bytes at:%p\n",r,r->bytes); */
-	if (r->bytes!=NULL) free(r->bytes);
+    if (rl->arena!=NULL) {	/* the arena belongs to the connection, nothing to free */
+	rl->numResults=0;
+	rl->results=NULL;
+	rl->arena=NULL;
+	return;
     }
+/*
+    The payloads of a read are in the same block as the results, see daveExecReadRequest,
+    and write results have none.
+*/
 #ifdef DEBUG_CALLS
         LOG2(" free'd %d results\n",rl->numResults);
 #endif
@@ -1527,6 +1736,8 @@ daveConnection * DECL2 daveNewConnection(daveInterface * di, int MPI, int rack,
 	dc->connectionNumber=di->nextConnection;	// 1/10/05 trying Andrew's patch
 
 	dc->PDUnumber=0xFFFE;			// just a start value; // test!
+	dc->maxParallelJobs=1;			/* stop and wait unless asked for more */
+	dc->parallelJobs=1;
 	dc->messageNumber=0;
 	dc->communicationType=davePGCommunication;
 
@@ -2244,6 +2455,7 @@ rep:
 	    if (state==3) {
 	        if ((daveDebug & daveDebugSpecialChars)!=0)
 		    LOG4("readMPI: packet size %d, got BCC: %x. I calc: %x\n",res,*(b+res-1),bcc);
+		if (*(b+res-1)!=bcc) di->checksumErrors++;	/* only counted, the packet is used anyway */
 		if ((daveDebug & daveDebugRawRead)!=0)
 		    _daveDump("answer",b,res);
 		return res;
@@ -3314,12 +3526,14 @@ int DECL2 _daveDisconnectPLCMPI(daveConnection * dc)
     build the PDU for a PDU length negotiation
 */
 int DECL2 _daveNegPDUlengthRequest(daveConnection * dc, PDU *p) {
-    uc pa[]=	{0xF0, 0 ,0, 1, 0, 1,
+    uc pa[]=	{0xF0, 0 ,
+    dc->maxParallelJobs / 0x100, dc->maxParallelJobs % 0x100,	/* jobs we may have outstanding */
+    dc->maxParallelJobs / 0x100, dc->maxParallelJobs % 0x100,	/* jobs the PLC may have outstanding */
     dc->maxPDUlength / 0x100, //3,
     dc->maxPDUlength % 0x100, //0xC0,
     };
     int res;
-    int CpuPduLimit;
+    int CpuPduLimit, jobs;
     PDU p2;
     p->header=dc->msgOut+dc->PDUstartO;
     _daveInitPDUheader(p,1);
@@ -3333,6 +3547,10 @@ int DECL2 _daveNegPDUlengthRequest(daveConnection * dc, PDU *p) {
     if(res!=daveResOK) return res;
     CpuPduLimit=daveGetU16from(p2.param+6);
     if (dc->maxPDUlength > CpuPduLimit) dc->maxPDUlength = CpuPduLimit; // use lower number as limit
+    jobs=daveGetU16from(p2.param+2);
+    if (jobs>daveGetU16from(p2.param+4)) jobs=daveGetU16from(p2.param+4);
+    if (jobs>dc->maxParallelJobs) jobs=dc->maxParallelJobs;
+    dc->parallelJobs=(jobs<1) ? 1 : jobs;
     if (daveDebug & daveDebugConnect) {
 	LOG3("\n*** Partner offered PDU length: %d used limit %d\n\n",CpuPduLimit,dc->maxPDUlength);
     }
@@ -3525,22 +3743,10 @@ int DECL2 _daveConnectPLCMPI1(daveConnection * dc) {
 */
 #ifdef HAVE_SELECT
 int DECL2 _daveReadOne(daveInterface * di, uc *b) {
-	fd_set FDS;
-	struct timeval t;
-	FD_ZERO(&FDS);
-	FD_SET(di->fd.rfd, &FDS);
-
-	t.tv_sec = di->timeout / 1000000;
-	t.tv_usec = di->timeout % 1000000;
-/*	if (daveDebug & daveDebugByte)
-	    LOG2("timeout %d\n",di->timeout); */
-	if (select(di->fd.rfd + 1, &FDS, NULL, NULL, &t) <= 0)
-	{
-	    if (daveDebug & daveDebugByte) LOG1("timeout in readOne.\n");
-	    return (0);
-	} else {
-	    return read(di->fd.rfd, b, 1);
-	}
+	int res;
+	res=stdread(di, (char*)b, 1);
+	if ((res<=0) && (daveDebug & daveDebugByte)) LOG1("timeout in readOne.\n");
+	return res;
 };
 #endif
 
@@ -3573,7 +3779,9 @@ int DECL2 _daveTimedRecv(daveInterface * di, uc *b, int len){
         if (daveDebug & daveDebugByte) LOG1("timeout in TCP read.\n");
 	    return 0;
     } else {
-	return recv((SOCKET)(di->fd.rfd), b, len, 0);
+	int res=recv((SOCKET)(di->fd.rfd), b, len, 0);
+	if (res>0) di->rxBytes+=res;
+	return res;
     }
 #endif
 
@@ -3582,7 +3790,9 @@ int DECL2 _daveTimedRecv(daveInterface * di, uc *b, int len){
         if (daveDebug & daveDebugByte) LOG1("timeout in TCP read.\n");
 	    return 0;
     } else {
-	return read(di->fd.rfd, b, len);
+	int res=read(di->fd.rfd, b, len);
+	if (res>0) di->rxBytes+=res;
+	return res;
     }
 #endif
 }
@@ -3636,6 +3846,7 @@ again:
 //	    _daveDump("IBHfollow", IBHfollow, 15);
 
 	    res2=send((unsigned int)(di->fd.wfd), IBHfollow, 15, 0);
+	    if (res2>0) di->txBytes+=res2;
 
 //	    LOG2("send: res2:%d\n",res2);
 
@@ -3717,9 +3928,11 @@ int DECL2 _daveSendISOPacket(daveConnection * dc, int size) {
 	_daveDump("send packet: ",dc->msgOut+dc->partPos,size);
 #ifdef HAVE_SELECT
     daveWriteFile(dc->iface->fd.wfd, dc->msgOut+dc->partPos, size, i);
+    if ((int)i>0) dc->iface->txBytes+=i;
 #endif
 #ifdef BCCWIN
     res = send((SOCKET)(dc->iface->fd.wfd), dc->msgOut+dc->partPos, size, 0);
+    if (res>0) dc->iface->txBytes+=res;
     if (res==SOCKET_ERROR )
 	if (daveDebug & daveDebugPrintErrors) LOG2("_daveSendISOPacket WSAGetLastError: %d \n",WSAGetLastError());
 
@@ -3742,17 +3955,10 @@ int DECL2 _daveGetResponseISO_TCP(daveConnection * dc) {
     return 0;
 }
 /*
-    Executes the dialog around one message:
+    Send a PDU built in msgOut, split into ISO packets of at most TPDUsize bytes.
 */
-int DECL2 _daveExchangeTCP(daveConnection * dc, PDU * p) {
-    int res, totLen, sLen;
-
-    if (daveDebug & daveDebugExchange) {
-        LOG2("%s enter _daveExchangeTCP\n", dc->iface->name);
-    }
-
-//    _daveSendISOPacket(dc,3+p->hlen+p->plen+p->dlen);
-
+static void _daveSendPDUTCP(daveConnection * dc, PDU * p) {
+    int totLen, sLen;
     dc->partPos=0;
     totLen=p->hlen+p->plen+p->dlen;
     while(totLen) {
@@ -3769,6 +3975,21 @@ int DECL2 _daveExchangeTCP(daveConnection * dc, PDU * p) {
 	totLen-=sLen;
 	dc->partPos+=sLen;
     }
+}
+
+/*
+    Executes the dialog around one message:
+*/
+int DECL2 _daveExchangeTCP(daveConnection * dc, PDU * p) {
+    int res;
+
+    if (daveDebug & daveDebugExchange) {
+        LOG2("%s enter _daveExchangeTCP\n", dc->iface->name);
+    }
+
+//    _daveSendISOPacket(dc,3+p->hlen+p->plen+p->dlen);
+
+    _daveSendPDUTCP(dc, p);
 
     res=_daveReadISOPacket(dc->iface,dc->msgIn);
     if(res==7) {
@@ -3784,6 +4005,147 @@ int DECL2 _daveExchangeTCP(daveConnection * dc, PDU * p) {
     return 0;
 }
 
+/*
+    Pipelined ISO over TCP. _daveExchangeTCP sends a PDU and waits for its answer
+    before anything else can go out. Instead, up to daveGetMaxParallelJobs requests
+    may be sent with daveSendRequestTCP before their answers are collected with
+    daveReceiveResponseTCP. The PLC may answer in any order, the PDU reference
+    returned by both tells which request an answer belongs to. A request is copied
+    to the socket when it is sent, so msgOut is free for building the next one.
+*/
+/*
+    Keep the send time of a pipelined request in a slot of its own. Answers can
+    overtake each other, so the references in flight need not be consecutive. If
+    more requests are sent than there are slots, the oldest one loses its time.
+*/
+static void _daveRememberSent(daveConnection * dc, int ref) {
+    int i, slot=0;
+    for (i=0; i<daveMaxParallelJobs; i++) {
+	if (dc->sentAt[i]==0) {
+	    slot=i;
+	    break;
+	}
+	if (dc->sentAt[i]<dc->sentAt[slot]) slot=i;
+    }
+    dc->sentAt[slot]=_daveMicroseconds();
+    dc->sentRef[slot]=ref;
+}
+
+/*
+    When the request an answer belongs to was sent, the slot is free again. With
+    ref<0, for an answer that could not be read, the request waited for longest.
+    Returns 0 if no request is known.
+*/
+static unsigned long long _daveTakeSent(daveConnection * dc, int ref) {
+    int i, slot=-1;
+    unsigned long long sent;
+    for (i=0; i<daveMaxParallelJobs; i++) {
+	if (dc->sentAt[i]==0) continue;
+	if (ref>=0) {
+	    if (dc->sentRef[i]==ref) {
+		slot=i;
+		break;
+	    }
+	} else if ((slot<0) || (dc->sentAt[i]<dc->sentAt[slot])) {
+	    slot=i;
+	}
+    }
+    if (slot<0) return 0;
+    sent=dc->sentAt[slot];
+    dc->sentAt[slot]=0;
+    return sent;
+}
+
+int DECL2 daveSendRequestTCP(daveConnection * dc, PDU * p, int * ref) {
+    unsigned long long txBytes;
+    if ((dc->iface->protocol!=daveProtoISOTCP) && (dc->iface->protocol!=daveProtoISOTCP243))
+	return daveResNotYetImplemented;
+    if ((p->header[4]==0)&&(p->header[5]==0)) {
+        dc->PDUnumber++;
+        p->header[5]=dc->PDUnumber % 256;
+        p->header[4]=dc->PDUnumber / 256;
+    }
+    if (ref!=NULL) *ref=256*p->header[4]+p->header[5];
+    _daveRememberSent(dc, 256*p->header[4]+p->header[5]);
+    txBytes=dc->iface->txBytes;
+    dc->stats.pdusSent++;
+    _daveSendPDUTCP(dc, p);
+    dc->stats.bytesSent+=dc->iface->txBytes-txBytes;
+    return daveResOK;
+}
+
+/*
+    Read the next answer into msgIn and tell which request it belongs to.
+*/
+int DECL2 daveReceiveResponseTCP(daveConnection * dc, int * ref) {
+    int res;
+    uc * h;
+    unsigned long long rxBytes, started, sent, now;
+    if ((dc->iface->protocol!=daveProtoISOTCP) && (dc->iface->protocol!=daveProtoISOTCP243))
+	return daveResNotYetImplemented;
+    started=_daveMicroseconds();
+    rxBytes=dc->iface->rxBytes;
+    res=_daveGetResponseISO_TCP(dc);
+    dc->stats.bytesReceived+=dc->iface->rxBytes-rxBytes;
+    now=_daveMicroseconds();
+    if (res!=0) {
+	/*
+	    No telling which request this was. Time it as the one waited for longest,
+	    or from the start of this call if none is outstanding.
+	*/
+	sent=_daveTakeSent(dc, -1);
+	_daveRecordExchange(dc, res, (unsigned long)(now-(sent ? sent : started)));
+	return res;
+    }
+    h=dc->msgIn+dc->PDUstartI;
+    if (ref!=NULL) *ref=256*h[4]+h[5];
+    sent=_daveTakeSent(dc, 256*h[4]+h[5]);
+    _daveRecordExchange(dc, res, (unsigned long)(now-(sent ? sent : started)));
+    return daveResOK;
+}
+
+/*
+    Evaluate the read response last received with daveReceiveResponseTCP the way
+    daveExecReadRequestArena does: the results are kept in the connection's arena.
+*/
+int DECL2 daveGetReadResponseArena(daveConnection * dc, daveResultSet * rl) {
+    PDU p2;
+    int res;
+    dc->AnswLen=0;
+    dc->resultPointer=NULL;
+    dc->_resultPointer=NULL;
+    res=_daveSetupReceivedPDU(dc, &p2);
+    if (res!=daveResOK) return res;
+    res=_daveTestReadResult(&p2);
+    if (res!=daveResOK) return res;
+    if (rl!=NULL) {
+	if (p2.param[1]>daveMaxArenaResults) return daveResCannotEvaluatePDU;
+	rl->numResults=p2.param[1];
+	rl->results=dc->arena.results;
+	rl->arena=&(dc->arena);
+	_daveParseReadResults(&p2, rl->results, rl->numResults);
+    }
+    return res;
+}
+
+/*
+    The number of requests we ask the PLC to accept in parallel, set before
+    daveConnectPLC. Only used by ISO over TCP.
+*/
+void DECL2 daveSetMaxParallelJobs(daveConnection * dc, int jobs) {
+    if (jobs<1) jobs=1;
+    if (jobs>daveMaxParallelJobs) jobs=daveMaxParallelJobs;
+    dc->maxParallelJobs=jobs;
+}
+
+/*
+    The number of requests that may be in flight after the PDU length negotiation,
+    the lower of what we asked for and what the PLC offered.
+*/
+int DECL2 daveGetMaxParallelJobs(daveConnection * dc) {
+    return dc->parallelJobs;
+}
+
 int DECL2 _daveConnectPLCTCP(daveConnection * dc) {
     int res, success, retries, i, px;
     uc b4[]={
@@ -3991,7 +4353,9 @@ int DECL2 _daveGetResponsePPI(daveConnection *dc) {
     b=dc->msgIn;
     alt=1;
     while ((expectingLength)||(res<expectedLen)) {
-	i = dc->iface->ifread(dc->iface, dc->msgIn+res, 1);
+	/* byte by byte until the length is known, then the rest of the frame at once */
+	i = dc->iface->ifread(dc->iface, dc->msgIn+res, expectingLength ? 1 : expectedLen-res);
+	if (i < 0) i = 0;
 	res += i;
 	if ((daveDebug & daveDebugByte)!=0) {
 	    LOG3("i:%d res:%d\n",i,res);
@@ -4001,6 +4365,7 @@ int DECL2 _daveGetResponsePPI(daveConnection *dc) {
 		    return daveResTimeout;
 	} else {
 	    if ( (expectingLength) && (res==1) && (b[0] == 0xE5)) {
+		dc->iface->pollRetries++;
 		if(alt) {
 		    _daveSendRequestData(dc,alt);
 		    res=0;
@@ -4039,17 +4404,56 @@ int DECL2 _daveGetResponsePPI(daveConnection *dc) {
 	if ((daveDebug & daveDebugByte)!=0) {
     	    LOG1("checksum error\n");
 	}
+	dc->iface->checksumErrors++;
         return 2048;
     }
     return 0;
 }
 
+/*
+    PPI turnaround: the S7-200 must not be polled for the response too soon after it
+    acknowledged the request (seen with USB to serial adapters). The request is on the
+    PLC's side by then, so the computed delay is only the time until it may answer: the
+    line idle time (33 bit times) plus the maximum station delay (60 bit times). That is
+    9.7 ms at 9600 baud, 4.8 ms at 19200 and 0.5 ms at 187.5k.
+*/
+#define davePPIBackoffMin 1000
+#define davePPIBackoffMax 50000
+#define davePPICleanExchanges 16
+#define davePPIIdleBits 33
+#define davePPIStationDelayBits 60
+
+static int _davePPITurnaround(daveInterface * di) {
+    long bits;
+    if (di->turnaroundMode==daveTurnaroundFixed) return di->turnaroundDelay;
+    bits=davePPIIdleBits+davePPIStationDelayBits;
+    return (int)((bits*1000000L)/di->turnaroundBaud) + di->turnaroundBackoff;
+}
+
+/*
+    Adaptive mode: double the back-off on every exchange that needed a retry and
+    halve it again after a run of clean ones.
+*/
+static void _davePPIAdapt(daveInterface * di, int retried) {
+    if (di->turnaroundMode!=daveTurnaroundAdaptive) return;
+    if (retried) {
+	di->turnaroundBackoff=di->turnaroundBackoff ? 2*di->turnaroundBackoff : davePPIBackoffMin;
+	if (di->turnaroundBackoff>davePPIBackoffMax) di->turnaroundBackoff=davePPIBackoffMax;
+	di->turnaroundClean=0;
+    } else if (di->turnaroundBackoff && (++di->turnaroundClean>=davePPICleanExchanges)) {
+	di->turnaroundBackoff/=2;
+	if (di->turnaroundBackoff<davePPIBackoffMin) di->turnaroundBackoff=0;
+	di->turnaroundClean=0;
+    }
+}
+
 int DECL2 _daveExchangePPI(daveConnection * dc,PDU * p1) {
-    int i,res=0,len;
+    int i,res=0,len,retries;
     dc->msgOut[0]=dc->MPIAdr;	/* address ? */
     dc->msgOut[1]=dc->iface->localMPI;
     dc->msgOut[2]=108;
     len=3+p1->hlen+p1->plen+p1->dlen;	/* The 3 fix bytes + all parts of PDU */
+    retries=dc->iface->secondTries+dc->iface->thirdTries+dc->iface->pollRetries;
     _daveSendLength(dc->iface, len);
     _daveSendIt(dc->iface, dc->msgOut, len);
     i = dc->iface->ifread(dc->iface, dc->msgIn+res, 1);
@@ -4059,17 +4463,20 @@ int DECL2 _daveExchangePPI(daveConnection * dc,PDU * p1) {
     }
     if (i == 0) {
 	seconds++;
+	dc->iface->secondTries++;
 	_daveSendLength(dc->iface, len);
 	_daveSendIt(dc->iface, dc->msgOut, len);
 	i = dc->iface->ifread(dc->iface, dc->msgIn+res, 1);
 	if (i == 0) {
 	    thirds++;
+	    dc->iface->thirdTries++;
 	    _daveSendLength(dc->iface, len);
 	    _daveSendIt(dc->iface, dc->msgOut, len);
 	    i = dc->iface->ifread(dc->iface, dc->msgIn+res, 1);
 	    if (i == 0) {
 		LOG1("timeout in _daveExchangePPI!\n");
 		FLUSH;
+		_davePPIAdapt(dc->iface, 1);
     		return daveResTimeout;
 	    }
 	}
@@ -4077,10 +4484,15 @@ int DECL2 _daveExchangePPI(daveConnection * dc,PDU * p1) {
 
     // DW ADDED delay to prevent s7-200 getting a rx packet too soon after sending a tx ones
     // this fixes the frequent timeouts observed in PPI mode when using a USB to Serial adapter
-    usleep(20000);
+    // (a fixed 20ms only in daveTurnaroundFixed mode, see _davePPITurnaround)
+    dc->iface->lastTurnaround=_davePPITurnaround(dc->iface);
+    if (dc->iface->lastTurnaround>0) usleep(dc->iface->lastTurnaround);
 
     _daveSendRequestData(dc,0);
-    return _daveGetResponsePPI(dc);
+    res=_daveGetResponsePPI(dc);
+    _davePPIAdapt(dc->iface, (res!=0) ||
+	(dc->iface->secondTries+dc->iface->thirdTries+dc->iface->pollRetries!=retries));
+    return res;
 }
 
 int DECL2 _daveConnectPLCPPI(daveConnection * dc) {
@@ -4108,7 +4520,9 @@ int DECL2 daveDisconnectAdapter(daveInterface * di) {
 }
 
 int DECL2 _daveExchange(daveConnection * dc, PDU *p) {
-    int res;
+    daveInterface * di=dc->iface;
+    int res, resends, pollRetries, checksumErrors;
+    unsigned long long txBytes, rxBytes, t;
     if ((p->header[4]==0)&&(p->header[5]==0)) { /* do not number already numbered PDUs 12/10/04 */
         dc->PDUnumber++;
         if (daveDebug & daveDebugExchange) {
@@ -4117,7 +4531,21 @@ int DECL2 _daveExchange(daveConnection * dc, PDU *p) {
         p->header[5]=dc->PDUnumber % 256;	// test!
         p->header[4]=dc->PDUnumber / 256;	// test!
     }
-    res=dc->iface->exchange(dc, p);
+    /* the interface may be shared, what changes on it during the exchange belongs to dc */
+    resends=di->secondTries+di->thirdTries;
+    pollRetries=di->pollRetries;
+    checksumErrors=di->checksumErrors;
+    txBytes=di->txBytes;
+    rxBytes=di->rxBytes;
+    dc->stats.pdusSent++;
+    t=_daveMicroseconds();
+    res=di->exchange(dc, p);
+    _daveRecordExchange(dc, res, (unsigned long)(_daveMicroseconds()-t));
+    dc->stats.resends+=di->secondTries+di->thirdTries-resends;
+    dc->stats.pollRetries+=di->pollRetries-pollRetries;
+    dc->stats.checksumErrors+=di->checksumErrors-checksumErrors;
+    dc->stats.bytesSent+=di->txBytes-txBytes;
+    dc->stats.bytesReceived+=di->rxBytes-rxBytes;
     if (((daveDebug & daveDebugExchange)!=0) ||((daveDebug & daveDebugErrorReporting)!=0)) {
 	LOG2("result of exchange: %d\n",res);
     }
@@ -4746,6 +5174,7 @@ int DECL2 _daveWriteIBH(daveInterface * di, uc * buffer, int len) { //cs: let it
 //    res=send((SOCKET)(di->fd.wfd), buffer, ((len+1)/2)*2, 0);
     res=send((SOCKET)(di->fd.wfd), buffer, len, 0);
 #endif
+    if (res>0) di->txBytes+=res;
     return res;
 }
 
@@ -5601,6 +6030,9 @@ int DECL2 daveDeleteProgramBlock(daveConnection*dc, int blockType, int number) {
 	'_','D','E','L','E' //Command Delete
 	};
 
+	if (dc->iface->protocol==daveProtoAS511) {
+		daveInvalidateS5Blocks(dc, daveDB, daveAllDBs);	// whatever it does, blocks may move
+	}
 	paDelete[13] = blockType;
 	sprintf((char*)(paDelete+14),"%05d",number);
 	paDelete[19] = 'B'; //This is overriden by sprintf via 0x00 as String seperator!
@@ -5777,7 +6209,7 @@ int DECL2 daveReadS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset, i
     uc b1[daveMaxRawLen];
 //    if (_daveIsS5BlockArea(area)==0) {
     if (area==daveDB) {
-        res=_daveReadS5BlockAddress(dc,area,BlockN,&ai);//TODO make address cache
+        res=_daveGetS5BlockAddress(dc,area,BlockN,&ai);
         if (res<0) {
             LOG2("%s *** Error in ReadS5Bytes.BlockAddr request.\n", dc->iface->name);
             return res-50;
@@ -5813,14 +6245,17 @@ int DECL2 daveReadS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset, i
     res=_daveExchangeAS511(dc,b1,4,2*count+7,0x04);
     if (res<0) {
         LOG2("%s *** Error in ReadS5Bytes.Exchange sequence.\n", dc->iface->name);
+	if (area==daveDB) daveInvalidateS5Blocks(dc,area,BlockN);
 	return res-10;
     }
     if (dc->AnswLen<count+7) {
         LOG3("%s *** Too few chars (%d) in ReadS5Bytes data.\n", dc->iface->name,dc->AnswLen);
+	if (area==daveDB) daveInvalidateS5Blocks(dc,area,BlockN);
 	return -5;
     }
     if ((dc->msgIn[0]!=0)||(dc->msgIn[1]!=0)||(dc->msgIn[2]!=0)||(dc->msgIn[3]!=0)||(dc->msgIn[4]!=0)) {
         LOG2("%s *** Wrong ReadS5Bytes data signature.\n", dc->iface->name);
+	if (area==daveDB) daveInvalidateS5Blocks(dc,area,BlockN);
 	return -6;
     }
     dc->resultPointer=dc->msgIn+5;
@@ -6121,6 +6556,136 @@ int DECL2 _daveReadS5BlockAddress(daveConnection * dc, uc area, uc BlockN, daveS
     return 0;
 }
 
+/*
+    The address cache of connectPLC, see the comment there. Entries are kept in the list
+    dc->cache->first, one per block that was used, and are read from the PLC again once
+    they are older than the TTL, after daveInvalidateS5Blocks or when an access through
+    them failed.
+*/
+static daveS5AreaInfo * _daveFindS5Block(daveS5cache * cache, uc area, uc BlockN)
+{
+    daveS5AreaInfo * ai;
+    for (ai=cache->first; ai!=NULL; ai=ai->next)
+	if ((ai->area==area)&&(ai->DBnumber==BlockN)) return ai;
+    return NULL;
+}
+
+static int _daveIsS5Cacheable(daveS5cache * cache, uc BlockN)
+{
+    return !cache->allNonCacheable && !(cache->nonCacheable[BlockN/8] & (1<<(BlockN%8)));
+}
+
+/*
+    Address and length of a block, from the cache if there is a valid entry, else from
+    the PLC. A block that is read from the PLC is added to the cache unless it is set
+    non-cacheable:
+*/
+int DECL2 _daveGetS5BlockAddress(daveConnection * dc, uc area, uc BlockN, daveS5AreaInfo * ai)
+{
+    int res;
+    unsigned long long now;
+    daveS5AreaInfo * entry;
+    daveS5cache * cache=dc->cache;
+
+    if ((cache==NULL)||!_daveIsS5Cacheable(cache,BlockN))
+	return _daveReadS5BlockAddress(dc,area,BlockN,ai);
+    now=_daveMicroseconds();
+    entry=_daveFindS5Block(cache,area,BlockN);
+    if ((entry!=NULL)&&((cache->ttl==0)||(now-entry->fetched<cache->ttl))) {
+	*ai=*entry;
+	return 0;
+    }
+    res=_daveReadS5BlockAddress(dc,area,BlockN,ai);
+    if (res<0) return res;
+    if (entry==NULL) {
+	entry=(daveS5AreaInfo*)calloc(1,sizeof(daveS5AreaInfo));
+	if (entry==NULL) return 0;
+	entry->area=area;
+	entry->DBnumber=BlockN;
+	entry->next=cache->first;
+	cache->first=entry;
+    }
+    entry->address=ai->address;
+    entry->len=ai->len;
+    entry->fetched=now;
+    if (daveDebug & daveDebugConnect)
+	LOG4("%s cached address %04x of block %d\n", dc->iface->name, entry->address, BlockN);
+    return 0;
+}
+
+/*
+    Fetches the addresses of all the blocks in numbers in one go, meant to be called right
+    after connectPLC with every DB the application is going to use. Reads and writes then
+    go straight to the data instead of asking for the block address first. AS511 has no
+    request for several addresses with their lengths, so it is still one exchange per block,
+    but all of them are done before the first read. Returns the result of the first block
+    that could not be resolved, the others are resolved anyway:
+*/
+int DECL2 daveResolveS5Blocks(daveConnection * dc, uc area, int * numbers, int count)
+{
+    int i, res, first=0;
+    daveS5AreaInfo ai;
+    if (dc->cache==NULL) return -1;
+    for (i=0; i<count; i++) {
+	daveInvalidateS5Blocks(dc,area,numbers[i]);
+	res=_daveGetS5BlockAddress(dc,area,(uc)numbers[i],&ai);
+	if ((res<0)&&(first==0)) first=res-50;
+    }
+    return first;
+}
+
+/*
+    Forgets the cached address of a block, or of all blocks of the area with daveAllDBs.
+    Call it after a block was written, deleted or the PLC memory was compressed, by this
+    program or by a programming device, as all of these move blocks:
+*/
+void DECL2 daveInvalidateS5Blocks(daveConnection * dc, uc area, int number)
+{
+    daveS5AreaInfo ** link, * ai;
+    if (dc->cache==NULL) return;
+    link=&dc->cache->first;
+    while ((ai=*link)!=NULL) {
+	if ((ai->area==area)&&((number==daveAllDBs)||(ai->DBnumber==number))) {
+	    *link=ai->next;
+	    free(ai);
+	} else {
+	    link=&ai->next;
+	}
+    }
+}
+
+static void _daveFreeS5Blocks(daveS5cache * cache)
+{
+    daveS5AreaInfo * ai;
+    while ((ai=cache->first)!=NULL) {
+	cache->first=ai->next;
+	free(ai);
+    }
+}
+
+/*
+    Data blocks of programs that create them dynamically, see connectPLC:
+*/
+void DECL2 daveSetNonCacheable(daveConnection * dc, int number)
+{
+    if (dc->cache==NULL) return;
+    if (number==daveAllDBs) {
+	dc->cache->allNonCacheable=1;
+    } else {
+	dc->cache->nonCacheable[(number&0xFF)/8]|=1<<(number%8);
+    }
+    daveInvalidateS5Blocks(dc,daveDB,number);
+}
+
+/*
+    How long a cached block address is used before it is read from the PLC again, 0 (the
+    default) keeps it until it is invalidated:
+*/
+void DECL2 daveSetS5CacheTTL(daveConnection * dc, unsigned long usec)
+{
+    if (dc->cache!=NULL) dc->cache->ttl=usec;
+}
+
 int DECL2 _daveIsS5BlockArea(uc area)
 {
     if (
@@ -6191,14 +6756,22 @@ int DECL2 _daveFakeExchangeAS511(daveConnection * dc, PDU *p){
     too. But that would use 256 entries that must exist while the program might not use data
     blocks at all. So we don't. We add data block addresses to the PLC address cache when they
     are used for the first time.
+    To have them all in the cache before the first read, pass the data blocks to
+	daveResolveS5Blocks(dc, daveDB, DBnumbers, count);
     There are S5 programs that create data blocks dynamically. Hence cached addresses get invalid.
     If you have a PLC with such a program use
 	daveSetNonCacheable(dc, DBnumber);
     If you suspect somebody could pull the plug, connect a programming device, modify data blocks
     and reconnect your application program, use
-	daveSetNonCacheable(dc, allDBs);
+	daveSetNonCacheable(dc, daveAllDBs);
     In this case, the actual address will be fetched before each read or write from/to the related
-    data blocks (which will slow down your application).
+    data blocks (which will slow down your application). Less costly are
+	daveSetS5CacheTTL(dc, usec);
+    after which cached addresses are fetched again once they are older than usec, and
+	daveInvalidateS5Blocks(dc, daveDB, DBnumber or daveAllDBs);
+    when you know blocks were written, deleted or the memory was compressed. An address also
+    leaves the cache when a read or write through it fails.
+    The settings are kept when connectPLC is called again, the addresses are not.
 */
 
 int DECL2 _daveConnectPLCAS511(daveConnection * dc){
@@ -6206,7 +6779,12 @@ int DECL2 _daveConnectPLCAS511(daveConnection * dc){
     uc b1[maxSysinfoLen]; //20 words + some Dups
 //    dc->maxPDUlength=1000;
     dc->maxPDUlength=240;
-    dc->cache=(daveS5cache*)calloc(1,sizeof(daveS5cache));
+    if (dc->cache==NULL) {
+	dc->cache=(daveS5cache*)calloc(1,sizeof(daveS5cache));
+	if (dc->cache==NULL) return daveResNoBuffer;
+    } else {
+	_daveFreeS5Blocks(dc->cache);
+    }
 
     res=_daveExchangeAS511(dc,b1,0,maxSysinfoLen,0x18);
     if (res<0) {
@@ -6224,7 +6802,6 @@ int DECL2 _daveConnectPLCAS511(daveConnection * dc){
     dc->cache->timers=daveGetU16from(dc->msgIn+11);	// start of timer memory;
     dc->cache->counters=daveGetU16from(dc->msgIn+13);	// start of counter memory
     dc->cache->systemData=daveGetU16from(dc->msgIn+15);	// start of system data
-    dc->cache->first=NULL;
     LOG2("start of inputs in memory %04x\n",dc->cache->PAE);
     LOG2("start of outputs in memory %04x\n",dc->cache->PAA);
     LOG2("start of flags in memory %04x\n",dc->cache->flags);
@@ -6235,6 +6812,7 @@ int DECL2 _daveConnectPLCAS511(daveConnection * dc){
 }
 
 int DECL2 _daveDisconnectPLCAS511(daveConnection * dc){
+    if (dc->cache!=NULL) _daveFreeS5Blocks(dc->cache);
     free(dc->cache);
     dc->cache=0;
     return 0;
@@ -6253,7 +6831,7 @@ int DECL2 daveWriteS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset,
 //    if (_daveIsS5DBlockArea(area)==0) {
     if (area==daveDB) {
 //	LOG1("_daveIsS5DBlockArea\n");
-        res=_daveReadS5BlockAddress(dc,area,BlockN,&ai);
+        res=_daveGetS5BlockAddress(dc,area,BlockN,&ai);
         if (res<0) {
             LOG2("%s *** Error in WriteS5Bytes.BlockAddr request.\n", dc->iface->name);
             return res-50;
@@ -6273,7 +6851,7 @@ int DECL2 daveWriteS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset,
 		return -1;
 	}
     }
-    if ((count>daveMaxRawLen)||(offset+count>ai.len)) {
+    if ((count>daveMaxRawLen)||((area==daveDB)&&(offset+count>ai.len))) {
         LOG2("%s writeS5Bytes *** Requested data is out-of-range.\n", dc->iface->name);
         return -1;
     }
@@ -6287,6 +6865,7 @@ int DECL2 daveWriteS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset,
     res=_daveExchangeAS511(dc,b1,2+count,0,0x03);
     if (res<0) {
         LOG2("%s *** Error in WriteS5Bytes.Exchange sequense.\n", dc->iface->name);
+	if (area==daveDB) daveInvalidateS5Blocks(dc,area,BlockN);
 	return res-10;
     }
     return 0;
@@ -161,6 +161,13 @@ typedef struct dost {
 #define daveSpeed45k    5
 #define daveSpeed93k    6
 
+/*
+    How long PPI waits after a request was acknowledged before polling for the response:
+*/
+#define daveTurnaroundFixed	0	/* a fixed delay, 20 ms unless set otherwise */
+#define daveTurnaroundFrame	1	/* line idle time and station delay at the baud rate */
+#define daveTurnaroundAdaptive	2	/* as daveTurnaroundFrame, backing off while retries are seen */
+
 /*
     Some S7 communication function codes (yet unused ones may be incorrect).
 */
@@ -287,6 +294,7 @@ EXPORTSPEC void DECL2 daveStringCopy(char * intString, char * extString); // arg
     for PC systems, where one k less or more doesn't matter.
 */
 #define daveMaxRawLen 2048
+#define daveRxBufferSize 512	/* bytes a serial interface reads ahead in one system call */
 /*
     Some definitions for debugging:
 */
@@ -402,6 +410,24 @@ struct _daveInterface {
     _readFunc ifread;
     _writeFunc ifwrite;
     int seqNumber;
+    int rxBuffered;	/* stdread reads ahead into rxBuffer, set for serial protocols */
+    int rxHead;		/* next byte in rxBuffer to hand out */
+    int rxTail;		/* end of the bytes read into rxBuffer */
+    unsigned long rxReadCalls;	/* number of reads done by the protocol code */
+    unsigned long rxSyscalls;	/* number of select()+read() actually done for them */
+    uc rxBuffer[daveRxBufferSize];
+    int turnaroundMode;		/* PPI turnaround mode, one of the daveTurnaround... constants */
+    int turnaroundDelay;	/* delay in microseconds used by daveTurnaroundFixed */
+    int turnaroundBaud;		/* line speed the computed delays are based on */
+    int turnaroundBackoff;	/* microseconds daveTurnaroundAdaptive currently adds */
+    int turnaroundClean;	/* exchanges without retries since the back-off last changed */
+    int lastTurnaround;		/* delay used in the last PPI exchange */
+    int secondTries;		/* PPI requests that had to be sent a second time */
+    int thirdTries;		/* PPI requests that had to be sent a third time */
+    int pollRetries;		/* PPI polls answered with E5, the response was not ready */
+    int checksumErrors;		/* PPI and MPI answers with a bad checksum or BCC */
+    unsigned long long txBytes;	/* written to and read from the device, */
+    unsigned long long rxBytes;	/* framing included */
 };
 
 EXPORTSPEC daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int localMPI, int protocol, int speed);
@@ -449,6 +475,7 @@ typedef struct _daveS5AreaInfo  {
     int DBnumber;
     int address;
     int len;
+    unsigned long long fetched;	/* when the address was read from the PLC, usec */
     struct _daveS5AreaInfo * next;
 } daveS5AreaInfo;
 
@@ -459,9 +486,14 @@ typedef struct _daveS5cache {
     int timers;	// start of timer memory
     int counters;// start of counter memory
     int systemData;// start of system data
-    daveS5AreaInfo * first;
+    daveS5AreaInfo * first;	// block addresses, see _daveGetS5BlockAddress
+    unsigned long ttl;	// usec a block address is trusted, 0 for ever
+    int allNonCacheable;	// daveSetNonCacheable(dc, daveAllDBs) was called
+    uc nonCacheable[32];	// bit set for each DB that is fetched before every access
 } daveS5cache;
 
+#define daveAllDBs 256	/* all data blocks in daveSetNonCacheable and daveInvalidateS5Blocks */
+
 
 typedef struct _daveRoutingData {
 	int connectionType;
@@ -473,6 +505,42 @@ typedef struct _daveRoutingData {
 	uc  PLCadr[4];		// currently, IP is maximum. Maybe there could be MAC adresses for Industrial Ethernet?
 } daveRoutingData;
 
+/*
+    Multiple variable support:
+*/
+typedef struct {
+    int error;
+    int length;
+    uc * bytes;
+} daveResult;
+
+typedef struct _daveResultArena daveResultArena;
+
+typedef struct {
+    int numResults;
+    daveResult * results;
+    daveResultArena * arena;	/* set when the results live in a connection's arena, see daveExecReadRequestArena */
+} daveResultSet;
+
+#define daveMaxArenaResults 128
+
+/*
+    Per connection storage reused by every daveExecReadRequestArena, so polling
+    does not allocate. The payloads stay in msgIn unless daveKeepResults moves them here.
+*/
+struct _daveResultArena {
+    daveResult results[daveMaxArenaResults];
+    uc bytes[daveMaxRawLen];
+};
+
+#include "nodavestats.h"
+
+/*
+    The most requests daveSetMaxParallelJobs asks for, and so the most that can be
+    in flight on a pipelined ISO over TCP connection.
+*/
+#define daveMaxParallelJobs 64
+
 /*
     This holds data for a PLC connection;
 */
@@ -504,6 +572,12 @@ struct _daveConnection {
     int routing;		// nonzero means routing enabled
     int communicationType;		// (1=PG Communication,2=OP Communication,3=Step7Basic Communication)
     daveRoutingData routingData;
+    daveResultArena arena;	/* results of daveExecReadRequestArena */
+    int maxParallelJobs;	/* jobs asked for in the PDU length negotiation */
+    int parallelJobs;		/* jobs that may be outstanding, as negotiated */
+    daveConnectionStats stats;	/* see daveGetConnectionStats */
+    unsigned long long sentAt[daveMaxParallelJobs];	/* when pipelined requests went out, 0 for a free slot */
+    int sentRef[daveMaxParallelJobs];	/* the PDU reference of the request in each slot */
 }; 
 
 EXPORTSPEC void DECL2 daveSetRoutingDestination(daveConnection * dc, int subnet1,int subnet3,int adrsize, uc* plcadr);
@@ -884,17 +958,6 @@ EXPORTSPEC int DECL2 daveForce200(daveConnection * dc, int area, int start, int
 /*
     Multiple variable support:
 */
-typedef struct {
-    int error;
-    int length;
-    uc * bytes;
-} daveResult;
-
-typedef struct {
-    int numResults;
-    daveResult * results;
-} daveResultSet;
-
 
 /* use this to initialize a multivariable read: */
 EXPORTSPEC void DECL2 davePrepareReadRequest(daveConnection * dc, PDU *p);
@@ -906,6 +969,24 @@ EXPORTSPEC int DECL2 daveExecReadRequest(daveConnection * dc, PDU *p, daveResult
 EXPORTSPEC int DECL2 daveUseResult(daveConnection * dc, daveResultSet * rl, int n);
 /* Frees the memory occupied by the result structure */
 EXPORTSPEC void DECL2 daveFreeResults(daveResultSet * rl);
+/* Executes the complete request, keeping the results in the connection's arena. They
+   are valid until the next exchange on the connection, or until the next
+   daveExecReadRequestArena after daveKeepResults: */
+EXPORTSPEC int DECL2 daveExecReadRequestArena(daveConnection * dc, PDU *p, daveResultSet * rl);
+/* Copies arena results out of msgIn so further exchanges do not overwrite them: */
+EXPORTSPEC int DECL2 daveKeepResults(daveConnection * dc, daveResultSet * rl);
+/* Pipelined ISO over TCP: send up to daveGetMaxParallelJobs requests before
+   collecting their answers, which are matched to the requests by PDU reference: */
+EXPORTSPEC int DECL2 daveSendRequestTCP(daveConnection * dc, PDU *p, int * ref);
+EXPORTSPEC int DECL2 daveReceiveResponseTCP(daveConnection * dc, int * ref);
+/* Evaluates the read response last received, as daveExecReadRequestArena does: */
+EXPORTSPEC int DECL2 daveGetReadResponseArena(daveConnection * dc, daveResultSet * rl);
+/* Jobs to ask for before connecting, and the number negotiated with the PLC: */
+EXPORTSPEC void DECL2 daveSetMaxParallelJobs(daveConnection * dc, int jobs);
+EXPORTSPEC int DECL2 daveGetMaxParallelJobs(daveConnection * dc);
+/* Link health of a connection since it was set up or last reset: */
+EXPORTSPEC void DECL2 daveGetConnectionStats(daveConnection * dc, daveConnectionStats * stats);
+EXPORTSPEC void DECL2 daveResetConnectionStats(daveConnection * dc);
 /* Adds a new bit variable to a prepared request: */
 EXPORTSPEC void DECL2 daveAddBitVarToReadRequest(PDU *p, int area, int DBnum, int start, int byteCount);
 
@@ -1044,6 +1125,13 @@ EXPORTSPEC int DECL2 _daveGetResponsePPI_IBH(daveConnection *dc);
 **/
 EXPORTSPEC void DECL2 daveSetTimeout(daveInterface * di, int tmo);
 EXPORTSPEC int DECL2 daveGetTimeout(daveInterface * di);
+EXPORTSPEC void DECL2 daveSetRxBuffered(daveInterface * di, int buffered);
+EXPORTSPEC void DECL2 daveGetRxStats(daveInterface * di, unsigned long * readCalls, unsigned long * syscalls);
+EXPORTSPEC void DECL2 _daveFlushRx(daveInterface * di);
+EXPORTSPEC void DECL2 daveSetPPITurnaround(daveInterface * di, int mode, int baud, int fixedDelay);
+EXPORTSPEC int DECL2 daveGetPPITurnaround(daveInterface * di);
+EXPORTSPEC void DECL2 daveGetPPIRetries(daveInterface * di, int * secondTries, int * thirdTries, int * pollRetries);
+EXPORTSPEC void DECL2 _daveRecordExchange(daveConnection * dc, int res, unsigned long usec);
 EXPORTSPEC char * DECL2 daveGetName(daveInterface * di);
 
 EXPORTSPEC int DECL2 daveGetMPIAdr(daveConnection * dc);
@@ -1101,6 +1189,11 @@ EXPORTSPEC int DECL2 _daveIsS5ImageArea(uc area);
 EXPORTSPEC int DECL2 _daveIsS5DBBlockArea(uc area);
 EXPORTSPEC int DECL2 daveReadS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset, int count);
 EXPORTSPEC int DECL2 daveWriteS5Bytes(daveConnection * dc, uc area, uc BlockN, int offset, int count, void * buf);
+EXPORTSPEC int DECL2 _daveGetS5BlockAddress(daveConnection * dc, uc area, uc BlockN, daveS5AreaInfo * ai);
+EXPORTSPEC int DECL2 daveResolveS5Blocks(daveConnection * dc, uc area, int * numbers, int count);
+EXPORTSPEC void DECL2 daveInvalidateS5Blocks(daveConnection * dc, uc area, int number);
+EXPORTSPEC void DECL2 daveSetNonCacheable(daveConnection * dc, int number);
+EXPORTSPEC void DECL2 daveSetS5CacheTTL(daveConnection * dc, unsigned long usec);
 EXPORTSPEC int DECL2 daveStopS5(daveConnection * dc);
 EXPORTSPEC int DECL2 daveStartS5(daveConnection * dc);
 EXPORTSPEC int DECL2 daveGetS5ProgramBlock(daveConnection * dc, int blockType, int number, char* buffer, int * length);
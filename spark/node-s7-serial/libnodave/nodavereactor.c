@@ -0,0 +1,530 @@
+/*
+ Part of Libnodave, a free communication libray for Siemens S7 300/400.
+
+ An event driven exchange engine for ISO over TCP and IBH NetLink MPI.
+
+ _daveExchangeTCP and _daveExchangeIBH send a PDU and then block in select()
+ and read() until the answer is in, so every connection polled at the same
+ time needs a thread of its own. Here the same dialogs are kept as a state per
+ connection: the bytes that arrived so far, how much of the request is still
+ to be written and, for IBH, where we are in the follow up of a long answer.
+ A single thread calling daveReactorRun waits in epoll for all the sockets and
+ moves each exchange on as far as the bytes that arrived allow.
+
+ Libnodave is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ Libnodave is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "log2.h"
+#include "nodavereactor.h"
+
+extern int daveDebug;
+extern uc IBHfollow[];
+
+#define ISOTCPminPacketLength 16
+#define ISOheaderLength 7		/* TPKT and COTP data header */
+#define IBHfollowLength 15
+#define IBHmaxPackets 7			/* as in _daveGetResponseMPI_IBH */
+#define IBHpacketResponse 55		/* __daveAnalyze found the answer */
+#define reactorMaxEvents 64
+
+/* where a connection is in its exchange */
+#define stateIdle 0
+#define stateSending 1			/* some of the request is still to be written */
+#define stateReceiving 2
+#define stateFollowAck 3		/* IBH: discard the acknowledge of a follow up request */
+#define stateFollowData 4		/* IBH: the next part of a long answer */
+
+typedef struct _daveReactorConn {
+    daveConnection * dc;
+    int fd;
+    int state;
+    int events;			/* what epoll watches for */
+    unsigned long long deadline;
+    unsigned long long started;	/* when the exchange was submitted, for the connection's stats */
+    daveExchangeDone done;
+    void * user;
+    int packets;		/* IBH packets analyzed in this exchange */
+    int assembled;		/* bytes of the answer in msgIn */
+    uc rx[2*daveMaxRawLen];	/* bytes read, not yet a complete packet */
+    int rxLen;
+    uc tx[2*daveMaxRawLen];	/* bytes to write */
+    int txLen;
+    int txPos;
+    int removed;		/* taken out from inside daveReactorRun, freed when it returns */
+    struct _daveReactorConn * next;
+} daveReactorConn;
+
+struct _daveReactor {
+    int epfd;
+    int pending;
+    int completed;
+    int running;		/* inside daveReactorRun, connections removed now are only marked */
+    daveReactorConn * conns;
+};
+
+static unsigned long long _daveNow(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+}
+
+static int _daveIsIBH(daveConnection * dc) {
+    return dc->iface->protocol==daveProtoMPI_IBH;
+}
+
+static daveReactorConn * _daveFindConn(daveReactor * r, daveConnection * dc) {
+    daveReactorConn * c;
+    for (c=r->conns; c!=NULL; c=c->next) {
+	if ((c->dc==dc) && !c->removed) return c;
+    }
+    return NULL;
+}
+
+static int _daveWatch(daveReactor * r, daveReactorConn * c, int events) {
+    struct epoll_event ev;
+    if (events==c->events) return 0;
+    ev.events=events;
+    ev.data.ptr=c;
+    c->events=events;
+    return epoll_ctl(r->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void _daveComplete(daveReactor * r, daveReactorConn * c, int res) {
+    if (c->state==stateIdle) return;
+    c->state=stateIdle;
+    c->assembled=0;
+    c->txLen=c->txPos=0;
+    _daveWatch(r, c, EPOLLIN);
+    r->pending--;
+    r->completed++;
+    _daveRecordExchange(c->dc, res, (unsigned long)(_daveNow()-c->started));
+    if (daveDebug & daveDebugExchange) {
+	LOG3("%s reactor exchange done: %d\n", c->dc->iface->name, res);
+    }
+    /* last, the callback may submit the next exchange */
+    c->done(c->dc, res, c->user);
+}
+
+/*
+    Write what the socket takes, watch for it to take more if there is any left.
+*/
+static int _daveFlush(daveReactor * r, daveReactorConn * c) {
+    int res;
+    while (c->txPos<c->txLen) {
+	/* a PLC that went away must not take the whole process with SIGPIPE */
+	res=send(c->fd, c->tx+c->txPos, c->txLen-c->txPos, MSG_NOSIGNAL);
+	if (res<0) {
+	    if ((errno==EAGAIN) || (errno==EWOULDBLOCK)) break;
+	    if (errno==EINTR) continue;
+	    return daveResTimeout;
+	}
+	c->txPos+=res;
+	c->dc->stats.bytesSent+=res;
+    }
+    if (c->txPos<c->txLen) {
+	_daveWatch(r, c, EPOLLIN | EPOLLOUT);
+    } else {
+	c->txLen=c->txPos=0;
+	if (c->state==stateSending) c->state=stateReceiving;
+	_daveWatch(r, c, EPOLLIN);
+    }
+    return 0;
+}
+
+static int _daveQueue(daveReactorConn * c, uc * b, int len) {
+    if (c->txLen+len>(int)sizeof(c->tx)) return daveResInvalidLength;
+    memcpy(c->tx+c->txLen, b, len);
+    c->txLen+=len;
+    return 0;
+}
+
+/*
+    The request as _daveExchangeTCP sends it: TPKT and COTP header ahead of each
+    piece of at most TPDUsize bytes.
+*/
+static int _daveQueueISO(daveConnection * dc, daveReactorConn * c, PDU * p) {
+    uc h[ISOheaderLength];
+    int totLen, sLen, pos, res;
+    totLen=p->hlen+p->plen+p->dlen;
+    pos=0;
+    while (totLen) {
+	if (totLen>dc->TPDUsize) {
+	    sLen=dc->TPDUsize;
+	    h[6]=0x00;
+	} else {
+	    sLen=totLen;
+	    h[6]=0x80;
+	}
+	h[0]=3;
+	h[1]=0;
+	h[2]=(sLen+ISOheaderLength) / 0x100;
+	h[3]=(sLen+ISOheaderLength) % 0x100;
+	h[4]=0x02;
+	h[5]=0xf0;
+	res=_daveQueue(c, h, ISOheaderLength);
+	if (res==0) res=_daveQueue(c, dc->msgOut+dc->PDUstartO+pos, sLen);
+	if (res!=0) return res;
+	totLen-=sLen;
+	pos+=sLen;
+    }
+    return 0;
+}
+
+/*
+    Ask the NetLink for the next part of a long answer, as _daveReadIBHPacket does.
+*/
+static int _daveQueueIBHFollow(daveReactorConn * c) {
+    uc f[IBHfollowLength];
+    uc * b=c->dc->msgIn;
+    memcpy(f, IBHfollow, IBHfollowLength);
+    f[0]=b[1];
+    f[1]=b[0];
+    f[8]=b[8];
+    f[9]=b[9];
+    f[10]=b[10];
+    f[11]=b[11];
+    return _daveQueue(c, f, IBHfollowLength);
+}
+
+static void _daveISOPacket(daveReactor * r, daveReactorConn * c, uc * b, int len) {
+    uc * msgIn=c->dc->msgIn;
+    if (c->state==stateIdle) return;	/* nobody asked, drop it */
+    if (c->assembled==0) {
+	memcpy(msgIn, b, len);
+	c->assembled=len;
+    } else {
+	/* a follow on piece, only its data is appended */
+	if (c->assembled+len-ISOheaderLength>daveMaxRawLen) {
+	    _daveComplete(r, c, daveResInvalidLength);
+	    return;
+	}
+	memcpy(msgIn+c->assembled, b+ISOheaderLength, len-ISOheaderLength);
+	c->assembled+=len-ISOheaderLength;
+    }
+    if ((b[5]==0xf0) && ((b[6] & 0x80)==0)) return;	/* more follows */
+    if (c->assembled==7) {
+	if (daveDebug & daveDebugByte)
+	    LOG1("CPU sends funny 7 byte packets.\n");
+	c->assembled=0;
+	return;
+    }
+    _daveComplete(r, c, (c->assembled<=ISOTCPminPacketLength) ? daveResShortPacket : daveResOK);
+}
+
+static void _daveIBHPacket(daveReactor * r, daveReactorConn * c, uc * b, int len) {
+    uc * msgIn=c->dc->msgIn;
+    int pt;
+    if (c->state==stateIdle) return;
+    if (c->state==stateFollowAck) {
+	c->state=stateFollowData;
+	return;
+    }
+    if (c->state==stateFollowData) {
+	if ((len<17) || (c->assembled+len-17>daveMaxRawLen)) {
+	    _daveComplete(r, c, daveResShortPacket);
+	    return;
+	}
+	memcpy(msgIn+c->assembled, b+17, len-17);
+	msgIn[16]=b[16];
+	c->assembled+=len-17;
+	msgIn[15]=0xf1;
+	c->state=stateReceiving;
+    } else {
+	memcpy(msgIn, b, len);
+	c->assembled=len;
+	b=msgIn;
+    }
+    if ((len>15) && (b[15]==0xf0)) {
+	/* a long answer, fetch the next part */
+	if (_daveQueueIBHFollow(c)==0) {
+	    c->state=stateFollowAck;
+	    if (_daveFlush(r, c)!=0) _daveComplete(r, c, daveResTimeout);
+	    return;
+	}
+    }
+    c->packets++;
+    pt=0;
+    if (c->assembled>4) pt=__daveAnalyze(c->dc);
+    if (daveDebug & daveDebugExchange)
+	LOG2("reactor IBH packet type:%d\n", pt);
+    c->assembled=0;
+    if (pt==IBHpacketResponse) {
+	_daveComplete(r, c, daveResOK);
+    } else if (c->packets>=IBHmaxPackets) {
+	_daveComplete(r, c, daveResTimeout);
+    }
+}
+
+/*
+    Take every complete packet off the front of the receive buffer.
+*/
+static int _daveDrain(daveReactor * r, daveReactorConn * c) {
+    int len, pos=0;
+    for (;;) {
+	if (_daveIsIBH(c->dc)) {
+	    if (c->rxLen-pos<3) break;
+	    len=c->rx[pos+2]+8;
+	} else {
+	    if (c->rxLen-pos<4) break;
+	    len=c->rx[pos+2]*0x100+c->rx[pos+3];
+	    if ((len<ISOheaderLength) || (len>daveMaxRawLen)) return daveResShortPacket;
+	}
+	if (c->rxLen-pos<len) break;
+	/* the blocking calls give each packet the full timeout */
+	c->deadline=_daveNow()+c->dc->iface->timeout;
+	if (_daveIsIBH(c->dc)) {
+	    _daveIBHPacket(r, c, c->rx+pos, len);
+	} else {
+	    _daveISOPacket(r, c, c->rx+pos, len);
+	}
+	/* the done callback took the connection out, the rest of its bytes are nobody's */
+	if (c->removed) return 0;
+	pos+=len;
+    }
+    if (pos>0) {
+	memmove(c->rx, c->rx+pos, c->rxLen-pos);
+	c->rxLen-=pos;
+    }
+    return 0;
+}
+
+static void _daveReadable(daveReactor * r, daveReactorConn * c) {
+    int res;
+    for (;;) {
+	res=read(c->fd, c->rx+c->rxLen, sizeof(c->rx)-c->rxLen);
+	if (res>0) {
+	    c->rxLen+=res;
+	    c->dc->stats.bytesReceived+=res;
+	    if (_daveDrain(r, c)!=0) {
+		/* lost track of the packets, nothing on this connection can be trusted */
+		c->rxLen=0;
+		_daveComplete(r, c, daveResShortPacket);
+		return;
+	    }
+	    if (c->removed) return;
+	    continue;
+	}
+	if ((res<0) && (errno==EINTR)) continue;
+	if ((res<0) && ((errno==EAGAIN) || (errno==EWOULDBLOCK))) return;
+	/* closed by the other side or failed, the blocking calls would wait for the timeout */
+	_daveWatch(r, c, 0);
+	_daveComplete(r, c, daveResTimeout);
+	return;
+    }
+}
+
+daveReactor * DECL2 daveNewReactor(void) {
+    daveReactor * r=(daveReactor *) calloc(1, sizeof(daveReactor));
+    if (r==NULL) return NULL;
+    r->epfd=epoll_create1(0);
+    if (r->epfd<0) {
+	free(r);
+	return NULL;
+    }
+    return r;
+}
+
+void DECL2 daveFreeReactor(daveReactor * r) {
+    daveReactorConn * c;
+    while (r->conns!=NULL) {
+	c=r->conns;
+	r->conns=c->next;
+	free(c);
+    }
+    close(r->epfd);
+    free(r);
+}
+
+int DECL2 daveReactorAdd(daveReactor * r, daveConnection * dc) {
+    struct epoll_event ev;
+    daveReactorConn * c;
+    int fl;
+    if ((dc->iface->protocol!=daveProtoISOTCP) && (dc->iface->protocol!=daveProtoISOTCP243) && !_daveIsIBH(dc))
+	return daveResNotYetImplemented;
+    if (_daveFindConn(r, dc)!=NULL) return daveResInvalidParam;
+    c=(daveReactorConn *) calloc(1, sizeof(daveReactorConn));
+    if (c==NULL) return daveResNoBuffer;
+    c->dc=dc;
+    c->fd=dc->iface->fd.rfd;
+    c->state=stateIdle;
+    c->events=EPOLLIN;
+
+    fl=fcntl(c->fd, F_GETFL, 0);
+    fcntl(c->fd, F_SETFL, fl | O_NONBLOCK);
+    ev.events=c->events;
+    ev.data.ptr=c;
+    if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, c->fd, &ev)!=0) {
+	fcntl(c->fd, F_SETFL, fl);
+	free(c);
+	return -errno;
+    }
+    c->next=r->conns;
+    r->conns=c;
+    return 0;
+}
+
+int DECL2 daveReactorRemove(daveReactor * r, daveConnection * dc) {
+    daveReactorConn ** pc, * c;
+    int fl;
+    for (pc=&(r->conns); (*pc!=NULL) && (((*pc)->dc!=dc) || (*pc)->removed); pc=&((*pc)->next));
+    c=*pc;
+    if (c==NULL) return daveResInvalidParam;
+    if (c->state!=stateIdle) r->pending--;
+    c->state=stateIdle;
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    fl=fcntl(c->fd, F_GETFL, 0);
+    fcntl(c->fd, F_SETFL, fl & ~O_NONBLOCK);
+    if (r->running) {
+	/*
+	    A done callback may remove any connection, daveReactorRun may still hold
+	    a pointer to this one in its events or as the next to time out. Keep it
+	    in the list until daveReactorRun is through.
+	*/
+	c->removed=1;
+	return 0;
+    }
+    *pc=c->next;
+    free(c);
+    return 0;
+}
+
+/*
+    Free the connections removed while daveReactorRun was running.
+*/
+static void _daveSweep(daveReactor * r) {
+    daveReactorConn ** pc, * c;
+    pc=&(r->conns);
+    while (*pc!=NULL) {
+	c=*pc;
+	if (c->removed) {
+	    *pc=c->next;
+	    free(c);
+	} else {
+	    pc=&(c->next);
+	}
+    }
+}
+
+int DECL2 daveReactorSubmit(daveReactor * r, daveConnection * dc, PDU * p, daveExchangeDone done, void * user) {
+    daveReactorConn * c=_daveFindConn(r, dc);
+    int res;
+    if ((c==NULL) || (c->state!=stateIdle) || (done==NULL)) return daveResInvalidParam;
+
+    /* number the PDU as _daveExchange does */
+    if ((p->header[4]==0) && (p->header[5]==0)) {
+	dc->PDUnumber++;
+	p->header[5]=dc->PDUnumber % 256;
+	p->header[4]=dc->PDUnumber / 256;
+    }
+    c->txLen=c->txPos=0;
+    if (_daveIsIBH(dc)) {
+	_davePackPDU(dc, p);
+	res=_daveQueue(c, dc->msgOut, dc->msgOut[2]+8);
+	dc->AnswLen=0;
+    } else {
+	res=_daveQueueISO(dc, c, p);
+    }
+    if (res!=0) return res;
+
+    c->done=done;
+    c->user=user;
+    c->packets=0;
+    c->assembled=0;
+    c->started=_daveNow();
+    c->deadline=c->started+dc->iface->timeout;
+    dc->stats.pdusSent++;
+    c->state=stateSending;
+    r->pending++;
+    res=_daveFlush(r, c);
+    if (res!=0) {
+	c->state=stateIdle;
+	r->pending--;
+    }
+    return res;
+}
+
+int DECL2 daveReactorRun(daveReactor * r, int timeout) {
+    struct epoll_event events[reactorMaxEvents];
+    daveReactorConn * c, * next;
+    unsigned long long now, first=0;
+    int n, i, wait;
+
+    /* wake up in time for the first exchange to run out of time */
+    for (c=r->conns; c!=NULL; c=c->next) {
+	if ((c->state!=stateIdle) && ((first==0) || (c->deadline<first))) first=c->deadline;
+    }
+    wait=timeout;
+    if (first!=0) {
+	now=_daveNow();
+	i=(first>now) ? (int)((first-now+999)/1000) : 0;
+	if ((wait<0) || (i<wait)) wait=i;
+    }
+
+    r->completed=0;
+    n=epoll_wait(r->epfd, events, reactorMaxEvents, wait);
+    if (n<0) return (errno==EINTR) ? 0 : -errno;
+    /* from here on the done callbacks run, see daveReactorRemove */
+    r->running=1;
+    for (i=0; i<n; i++) {
+	c=(daveReactorConn *) events[i].data.ptr;
+	if (c->removed) continue;
+	if (events[i].events & EPOLLOUT) {
+	    if (_daveFlush(r, c)!=0) _daveComplete(r, c, daveResTimeout);
+	}
+	if (c->removed) continue;
+	if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+	    _daveReadable(r, c);
+	}
+    }
+
+    now=_daveNow();
+    for (c=r->conns; c!=NULL; c=next) {
+	next=c->next;
+	if (!c->removed && (c->state!=stateIdle) && (c->deadline<=now)) {
+	    /*
+		_daveGetResponseMPI_IBH counts a read that timed out as one of its
+		packets and keeps waiting until it has seen IBHmaxPackets.
+	    */
+	    if (_daveIsIBH(c->dc) && (c->state==stateReceiving) && (++c->packets<IBHmaxPackets)) {
+		c->deadline=now+c->dc->iface->timeout;
+		continue;
+	    }
+	    if (daveDebug & daveDebugPrintErrors)
+		LOG2("%s reactor exchange timed out\n", c->dc->iface->name);
+	    _daveComplete(r, c, daveResTimeout);
+	}
+    }
+    r->running=0;
+    _daveSweep(r);
+    return r->completed;
+}
+
+int DECL2 daveReactorPending(daveReactor * r) {
+    return r->pending;
+}
+
+/*
+    Changes:
+    10/17/2026  first version
+    10/17/2026  connections removed from a done callback are freed after daveReactorRun
+*/
@@ -0,0 +1,76 @@
+/*
+ Part of Libnodave, a free communication libray for Siemens S7 300/400.
+
+ An event driven exchange engine: one thread drives the exchanges of many
+ ISO over TCP and IBH NetLink MPI connections through epoll, instead of one
+ thread blocked in select() per connection. Linux only.
+
+ Libnodave is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ Libnodave is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef __nodavereactor
+#define __nodavereactor
+
+#include "nodave.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _daveReactor daveReactor;
+
+/*
+    Called from daveReactorRun when an exchange is over. With res==daveResOK the
+    answer is in dc->msgIn, just as after daveExchange, and can be evaluated with
+    _daveSetupReceivedPDU or daveGetReadResponseArena. A new exchange may be
+    submitted for dc from inside the callback, and any connection may be taken
+    out with daveReactorRemove and freed. The reactor itself must not be freed
+    from inside the callback.
+*/
+typedef void (DECL2 * daveExchangeDone) (daveConnection * dc, int res, void * user);
+
+EXPORTSPEC daveReactor * DECL2 daveNewReactor(void);
+EXPORTSPEC void DECL2 daveFreeReactor(daveReactor * r);
+/*
+    Hand a connection established with daveConnectPLC over to the reactor. Its
+    socket is switched to non-blocking mode, so it must not be used with the
+    blocking calls again until daveReactorRemove.
+*/
+EXPORTSPEC int DECL2 daveReactorAdd(daveReactor * r, daveConnection * dc);
+EXPORTSPEC int DECL2 daveReactorRemove(daveReactor * r, daveConnection * dc);
+/*
+    Start sending the PDU built in dc->msgOut. One exchange per connection at a
+    time, done is called when the answer is in or the interface timeout passed.
+*/
+EXPORTSPEC int DECL2 daveReactorSubmit(daveReactor * r, daveConnection * dc, PDU * p, daveExchangeDone done, void * user);
+/*
+    Wait up to timeout milliseconds for the sockets, advance every exchange that
+    can make progress and time out the ones that ran out of time. Returns the
+    number of exchanges completed, or a negative errno.
+*/
+EXPORTSPEC int DECL2 daveReactorRun(daveReactor * r, int timeout);
+/* The number of exchanges submitted and not yet completed: */
+EXPORTSPEC int DECL2 daveReactorPending(daveReactor * r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/*
+    Changes:
+    10/17/2026  first version
+    10/17/2026  connections may be removed from a done callback
+*/
@@ -107,6 +107,13 @@ typedef struct {
 #define daveSpeed45k    5
 #define daveSpeed93k    6
 
+/*
+    How long PPI waits after a request was acknowledged before polling for the response:
+*/
+#define daveTurnaroundFixed	0	/* a fixed delay, 20 ms unless set otherwise */
+#define daveTurnaroundFrame	1	/* line idle time and station delay at the baud rate */
+#define daveTurnaroundAdaptive	2	/* as daveTurnaroundFrame, backing off while retries are seen */
+
 /*
     Some MPI function codes (yet unused ones may be incorrect).
 */
@@ -179,6 +186,7 @@ typedef struct {
 #define daveEmptyResultSetError -127 
 #define daveResUnexpectedFunc -128 
 #define daveResUnknownDataUnitSize -129
+#define daveResNoBuffer -130
 
 #define daveResShortPacket -1024 
 #define daveResTimeout -1025 
@@ -271,6 +279,14 @@ struct _daveInterface {
 
 EXPORTSPEC daveInterface * DECL2 daveNewInterface(_daveOSserialType nfd, char * nname, int localMPI, int protocol, int speed);
 
+#include "nodavestats.h"
+
+/*
+    The most requests daveSetMaxParallelJobs asks for, and so the most that can be
+    in flight on a pipelined ISO over TCP connection.
+*/
+#define daveMaxParallelJobs 64
+
 /* 
     This holds data for a PLC connection;
 */
@@ -547,9 +563,12 @@ typedef struct {
     uc * bytes;
 } daveResult;
 
+typedef struct _daveResultArena daveResultArena;
+
 typedef struct {
     int numResults;
     daveResult * results;
+    daveResultArena * arena;	/* set when the results live in a connection's arena, see daveExecReadRequestArena */
 } daveResultSet;
 
 
@@ -563,6 +582,24 @@ EXPORTSPEC int DECL2 daveExecReadRequest(daveConnection * dc, PDU *p, daveResult
 EXPORTSPEC int DECL2 daveUseResult(daveConnection * dc, daveResultSet * rl, int n);
 /* Frees the memory occupied by the result structure */
 EXPORTSPEC void DECL2 daveFreeResults(daveResultSet * rl);
+/* Executes the complete request, keeping the results in the connection's arena. They
+   are valid until the next exchange on the connection, or until the next
+   daveExecReadRequestArena after daveKeepResults: */
+EXPORTSPEC int DECL2 daveExecReadRequestArena(daveConnection * dc, PDU *p, daveResultSet * rl);
+/* Copies arena results out of msgIn so further exchanges do not overwrite them: */
+EXPORTSPEC int DECL2 daveKeepResults(daveConnection * dc, daveResultSet * rl);
+/* Pipelined ISO over TCP: send up to daveGetMaxParallelJobs requests before
+   collecting their answers, which are matched to the requests by PDU reference: */
+EXPORTSPEC int DECL2 daveSendRequestTCP(daveConnection * dc, PDU *p, int * ref);
+EXPORTSPEC int DECL2 daveReceiveResponseTCP(daveConnection * dc, int * ref);
+/* Evaluates the read response last received, as daveExecReadRequestArena does: */
+EXPORTSPEC int DECL2 daveGetReadResponseArena(daveConnection * dc, daveResultSet * rl);
+/* Jobs to ask for before connecting, and the number negotiated with the PLC: */
+EXPORTSPEC void DECL2 daveSetMaxParallelJobs(daveConnection * dc, int jobs);
+EXPORTSPEC int DECL2 daveGetMaxParallelJobs(daveConnection * dc);
+/* Link health of a connection since it was set up or last reset: */
+EXPORTSPEC void DECL2 daveGetConnectionStats(daveConnection * dc, daveConnectionStats * stats);
+EXPORTSPEC void DECL2 daveResetConnectionStats(daveConnection * dc);
 /* Adds a new bit variable to a prepared request: */
 EXPORTSPEC void DECL2 daveAddBitVarToReadRequest(PDU *p, int area, int DBnum, int start, int byteCount);
 
@@ -595,6 +632,11 @@ EXPORTSPEC int DECL2 daveListReachablePartners(daveInterface * di,char * buf);
 **/
 EXPORTSPEC void DECL2 daveSetTimeout(daveInterface * di, int tmo);
 EXPORTSPEC int DECL2 daveGetTimeout(daveInterface * di);
+EXPORTSPEC void DECL2 daveSetRxBuffered(daveInterface * di, int buffered);
+EXPORTSPEC void DECL2 daveGetRxStats(daveInterface * di, unsigned long * readCalls, unsigned long * syscalls);
+EXPORTSPEC void DECL2 daveSetPPITurnaround(daveInterface * di, int mode, int baud, int fixedDelay);
+EXPORTSPEC int DECL2 daveGetPPITurnaround(daveInterface * di);
+EXPORTSPEC void DECL2 daveGetPPIRetries(daveInterface * di, int * secondTries, int * thirdTries, int * pollRetries);
 
 EXPORTSPEC char * DECL2 daveGetName(daveInterface * di);
 
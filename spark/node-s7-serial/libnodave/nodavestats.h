@@ -0,0 +1,52 @@
+/*
+ Part of Libnodave, a free communication libray for Siemens S7 300/400.
+
+ The link statistics of a connection, shared by nodave.h and nodavesimple.h so
+ daveGetConnectionStats fills the same layout whichever of them a program uses.
+
+ Libnodave is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ Libnodave is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef __nodavestats
+#define __nodavestats
+
+/*
+    Link health of a connection, kept by the library on every exchange. Latency is
+    counted in log2 buckets: bucket i holds the exchanges that took less than
+    128<<i microseconds, the last one all that took longer.
+*/
+#define daveLatencyBuckets 16
+
+typedef struct {
+    unsigned long exchanges;	/* exchanges timed, the sum of the latency buckets */
+    unsigned long errors;	/* exchanges that did not end with daveResOK */
+    unsigned long timeouts;	/* exchanges that ended with daveResTimeout */
+    unsigned long resends;	/* PPI requests sent a second or third time */
+    unsigned long pollRetries;	/* PPI polls answered with E5, the response was not ready */
+    unsigned long checksumErrors;	/* answers with a bad checksum or BCC */
+    unsigned long pdusSent;
+    unsigned long pdusReceived;
+    unsigned long long bytesSent;	/* on the wire, including the transport's framing */
+    unsigned long long bytesReceived;
+    unsigned long long latencyTotal;	/* microseconds */
+    unsigned long latencyMax;
+    unsigned long latency[daveLatencyBuckets];
+} daveConnectionStats;
+
+#endif
+
+/*
+    Changes:
+    10/17/2026  taken out of nodave.h and nodavesimple.h
+*/
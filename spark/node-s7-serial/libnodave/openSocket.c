@@ -39,6 +39,7 @@
 
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <netinet/tcp.h>	// for TCP_NODELAY and the keepalive tuning
 
 #include "log2.h"
 #include "nodave.h"
@@ -46,6 +47,21 @@
 
 extern int daveDebug;
 
+/*
+    Keepalive tuning: probe an idle connection after DAVE_KEEPALIVE_IDLE seconds, then every
+    DAVE_KEEPALIVE_INTERVAL seconds, and give up after DAVE_KEEPALIVE_COUNT unanswered probes.
+    A gateway that went away is then noticed within about a minute instead of two hours.
+*/
+#ifndef DAVE_KEEPALIVE_IDLE
+#define DAVE_KEEPALIVE_IDLE 30
+#endif
+#ifndef DAVE_KEEPALIVE_INTERVAL
+#define DAVE_KEEPALIVE_INTERVAL 10
+#endif
+#ifndef DAVE_KEEPALIVE_COUNT
+#define DAVE_KEEPALIVE_COUNT 3
+#endif
+
 int openSocket(const int port, const char * peer) {
     int fd,res,opt;
     struct sockaddr_in addr;
@@ -97,10 +113,28 @@ int openSocket(const int port, const char * peer) {
 */	
 	errno=0;
 	opt=1;
-	res=setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, 4);
+	res=setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
 	if (daveDebug & daveDebugOpen) {	
 	    LOG3(ThisModule "setsockopt %s %d\n", strerror(errno),res);	
 	}    
+#ifdef TCP_KEEPIDLE
+	opt=DAVE_KEEPALIVE_IDLE;
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &opt, sizeof(opt));
+	opt=DAVE_KEEPALIVE_INTERVAL;
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &opt, sizeof(opt));
+	opt=DAVE_KEEPALIVE_COUNT;
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &opt, sizeof(opt));
+#endif
+/*
+	Requests are small and every one waits for its answer, so Nagle would only
+	hold back the next request until the ack of the last one comes in.
+*/
+	errno=0;
+	opt=1;
+	res=setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+	if (daveDebug & daveDebugOpen) {	
+	    LOG3(ThisModule "setsockopt TCP_NODELAY %s %d\n", strerror(errno),res);	
+	}    
     }	
     FLUSH;
     return fd;
@@ -120,5 +154,6 @@ int closeSocket(int h) {
     03/06/2005  added Hugo Meiland's includes for FreeBSD.
 Version 0.8.4.5    
     07/10/09  	Added closeSocket()
+    10/17/26  	Set TCP_NODELAY and shorter keepalive times on the socket.
     
 */
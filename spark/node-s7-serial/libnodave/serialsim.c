@@ -0,0 +1,652 @@
+/*
+ Part of Libnodave, a free communication libray for Siemens S7 300/400.
+ This program simulates a PLC on a serial line: an S7-200 talking PPI or an
+ S7-300 behind an MPI adapter (the protocol of daveProtoMPI).
+
+ It opens a pseudo terminal and answers on its master side, the programs
+ under test open the slave side like any serial port. The memory areas are
+ plain byte arrays of configurable size that can be read and written. To make
+ the numbers look like a real line, every byte in and out costs the time it
+ takes at the given baud rate and answers are only ready after a scan time.
+ Faults can be injected at random, with a seed so that runs repeat:
+  -e  PPI: the request is not acknowledged with E5, the master has to send it
+      again. MPI: the adapter does not acknowledge a data frame with DLE.
+  -p  PPI: a poll for the answer gets E5, as if the PLC was not ready yet.
+  -t  the answer to a request never comes, the master runs into its timeout.
+
+ Libnodave is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ Libnodave is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "nodave.h"
+
+#define simPPI 0
+#define simMPI 1
+
+#define MAX_OUT 4		/* MPI frames waiting to be sent */
+
+static int protocol=simPPI;
+static int plcAddress=2;
+static int baud=-1;		/* -1: default of the protocol, 0: no pacing */
+static int scanTime=2000;	/* usec until an answer is ready */
+static int maxPDU=240;
+static int e5Fault=0, pollFault=0, silentFault=0;	/* in percent */
+static unsigned int seed=1;
+static volatile int stop=0;
+
+/*
+    The memory areas:
+*/
+static int inputSize=256, outputSize=256, flagSize=4096, dbSize=8192, dbCount=10;
+static uc * inputs, * outputs, * flags, * dbs;
+
+/*
+    Counters, printed on exit:
+*/
+static unsigned long requests, reads, writes, items, itemErrors;
+static unsigned long droppedAcks, notReady, silences, badFrames;
+
+static unsigned long long now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+}
+
+static int chance(int percent) {
+    return (percent>0) && ((int)(rand_r(&seed) % 100) < percent);
+}
+
+/*
+    The time the bytes take on the line: 11 bits each (start, 8 data, parity, stop).
+*/
+static void line(int bytes) {
+    if (baud>0) usleep((useconds_t)((11ULL*1000000ULL*bytes)/baud));
+}
+
+static void simWrite(int fd, uc * b, int len) {
+    int res;
+    line(len);
+    while (len>0) {
+	res=write(fd, b, len);
+	if (res<=0) return;
+	b+=res;
+	len-=res;
+    }
+}
+
+/*
+    The PLC, shared by both protocols:
+*/
+static uc * areaMemory(int area, int db, int * size) {
+    switch (area) {
+	case daveInputs: *size=inputSize; return inputs;
+	case daveOutputs: *size=outputSize; return outputs;
+	case daveFlags: *size=flagSize; return flags;
+	case daveDB:
+	    if ((db<1) || (db>dbCount)) return NULL;
+	    *size=dbSize;
+	    return dbs+(db-1)*dbSize;
+    }
+    return NULL;
+}
+
+/*
+    Check an item's address. Returns the memory and sets byte address and length,
+    or returns NULL and sets the S7 item error code.
+*/
+static uc * itemMemory(uc * item, int * start, int * len, int * bit, uc * error) {
+    int size, addr;
+    uc * mem=areaMemory(item[8], 256*item[6]+item[7], &size);
+    if (mem==NULL) {
+	*error=0x0A;	/* object does not exist */
+	return NULL;
+    }
+    addr=(item[9]<<16)|(item[10]<<8)|item[11];
+    *bit=(item[3]==1);	/* transport size of the bit functions */
+    *start=addr>>3;
+    *len=*bit ? 1 : 256*item[4]+item[5];
+    if ((*len<1) || (*start+*len>size)) {
+	*error=0x05;	/* address out of range */
+	return NULL;
+    }
+    if (*bit) *start=addr;	/* keep the bit number */
+    return mem;
+}
+
+static int plcRead(uc * param, uc * data) {
+    int i, start, len, bit, dlen=0;
+    uc error, * mem, * item;
+    reads++;
+    for (i=0; i<param[1]; i++) {
+	item=param+2+12*i;
+	items++;
+	mem=itemMemory(item, &start, &len, &bit, &error);
+	if (mem==NULL) {
+	    itemErrors++;
+	    data[dlen++]=error;
+	    data[dlen++]=0;
+	    data[dlen++]=0;
+	    data[dlen++]=0;
+	    continue;
+	}
+	data[dlen++]=0xFF;
+	data[dlen++]=bit ? 3 : 4;
+	data[dlen++]=bit ? 0 : (len*8)/256;
+	data[dlen++]=bit ? 1 : (len*8)%256;
+	if (bit) {
+	    data[dlen++]=(mem[start>>3]>>(start&7)) & 1;
+	} else {
+	    memcpy(data+dlen, mem+start, len);
+	    dlen+=len;
+	}
+	if ((dlen%2) && (i<param[1]-1)) data[dlen++]=0;
+    }
+    return dlen;
+}
+
+static int plcWrite(uc * param, uc * values, uc * data) {
+    int i, start, len, bit, pos=0;
+    uc error, * mem, * item;
+    writes++;
+    for (i=0; i<param[1]; i++) {
+	item=param+2+12*i;
+	items++;
+	mem=itemMemory(item, &start, &len, &bit, &error);
+	if (mem==NULL) {
+	    itemErrors++;
+	    data[i]=error;
+	} else {
+	    if (bit) {
+		if (values[pos+4] & 1) mem[start>>3]|=1<<(start&7); else mem[start>>3]&=~(1<<(start&7));
+	    } else {
+		memcpy(mem+start, values+pos+4, len);
+	    }
+	    data[i]=0xFF;
+	}
+	/* data header and value, padded to a word unless it is the last one */
+	pos+=4+(bit ? 1 : len);
+	if (pos%2) pos++;
+    }
+    return param[1];
+}
+
+/*
+    Answer one request PDU, returns the length of the answer.
+*/
+static int plcPDU(uc * req, uc * resp) {
+    uc * param=req+10;
+    int plen=256*req[6]+req[7];
+    int rplen, dlen=0;
+
+    requests++;
+    resp[0]=0x32; resp[1]=3; resp[2]=0; resp[3]=0;
+    resp[4]=req[4]; resp[5]=req[5];
+    resp[10]=0; resp[11]=0;
+    switch (param[0]) {
+	case daveFuncRead:
+	    rplen=2;
+	    resp[12]=daveFuncRead;
+	    resp[13]=param[1];
+	    dlen=plcRead(param, resp+12+rplen);
+	    break;
+	case daveFuncWrite:
+	    rplen=2;
+	    resp[12]=daveFuncWrite;
+	    resp[13]=param[1];
+	    dlen=plcWrite(param, param+plen, resp+12+rplen);
+	    break;
+	case 0xF0:
+	    /* PDU length negotiation: one job at a time, our PDU length */
+	    rplen=plen;
+	    memcpy(resp+12, param, plen);
+	    resp[14]=0; resp[15]=1;
+	    resp[16]=0; resp[17]=1;
+	    if (256*param[6]+param[7]<maxPDU) {
+		resp[18]=param[6]; resp[19]=param[7];
+	    } else {
+		resp[18]=maxPDU/256; resp[19]=maxPDU%256;
+	    }
+	    break;
+	default:
+	    /* anything else is not implemented here */
+	    rplen=2;
+	    resp[10]=0x81; resp[11]=0x04;
+	    resp[12]=param[0];
+	    resp[13]=0;
+    }
+    resp[6]=rplen/256; resp[7]=rplen%256;
+    resp[8]=dlen/256; resp[9]=dlen%256;
+    return 12+rplen+dlen;
+}
+
+/*
+    PPI: the S7-200 is a slave. It acknowledges a request frame with E5 and sends
+    the answer when the master polls for it with an SD1 frame.
+*/
+static uc ppiIn[daveMaxRawLen];
+static int ppiLen;
+static uc ppiResp[daveMaxRawLen];
+static int ppiRespLen;
+static unsigned long long ppiReady;
+
+static int ppiSum(uc * b, int len) {
+    int i, sum=0;
+    for (i=0; i<len; i++) sum+=b[i];
+    return sum & 0xff;
+}
+
+static void ppiFrame(int fd) {
+    uc e5=0xE5, frame[daveMaxRawLen];
+    int len;
+    if (ppiIn[0]==0x68) {
+	len=ppiIn[1];
+	if ((ppiIn[2]!=len) || (ppiIn[3]!=0x68) || (ppiIn[len+5]!=SYN) || (ppiSum(ppiIn+4, len)!=ppiIn[len+4])) {
+	    badFrames++;
+	    return;
+	}
+	if ((ppiIn[4]&0x7f)!=plcAddress) return;
+	if (chance(e5Fault)) {
+	    droppedAcks++;
+	    return;
+	}
+	ppiRespLen=plcPDU(ppiIn+7, ppiResp);
+	ppiReady=now()+scanTime;
+	simWrite(fd, &e5, 1);
+    } else {
+	/* request data: 10 DA SA FC FCS 16 */
+	if ((ppiIn[5]!=SYN) || (ppiSum(ppiIn+1, 3)!=ppiIn[4])) {
+	    badFrames++;
+	    return;
+	}
+	if ((ppiIn[1]&0x7f)!=plcAddress) return;
+	if ((ppiRespLen==0) || (now()<ppiReady)) {
+	    if (ppiRespLen) notReady++;
+	    simWrite(fd, &e5, 1);
+	    return;
+	}
+	if (chance(pollFault)) {
+	    notReady++;
+	    simWrite(fd, &e5, 1);
+	    return;
+	}
+	if (chance(silentFault)) {
+	    silences++;
+	    ppiRespLen=0;
+	    return;
+	}
+	frame[0]=0x68;
+	frame[1]=frame[2]=ppiRespLen+3;
+	frame[3]=0x68;
+	frame[4]=ppiIn[2];
+	frame[5]=plcAddress;
+	frame[6]=0x08;
+	memcpy(frame+7, ppiResp, ppiRespLen);
+	frame[7+ppiRespLen]=ppiSum(frame+4, ppiRespLen+3);
+	frame[8+ppiRespLen]=SYN;
+	simWrite(fd, frame, ppiRespLen+9);
+	ppiRespLen=0;
+    }
+}
+
+static void ppiByte(int fd, uc c) {
+    if (ppiLen==0) {
+	/* wait for the start of a frame, E5 and garbage are dropped */
+	if ((c!=0x68) && (c!=DLE)) return;
+    }
+    if (ppiLen>=(int)sizeof(ppiIn)) {
+	badFrames++;
+	ppiLen=0;
+	return;
+    }
+    ppiIn[ppiLen++]=c;
+    if (ppiIn[0]==DLE) {
+	if (ppiLen<6) return;
+    } else {
+	if ((ppiLen<4) || (ppiLen<ppiIn[1]+6)) return;
+    }
+    ppiFrame(fd);
+    ppiLen=0;
+}
+
+/*
+    MPI: the adapter and the PLC behind it. Either side starts a frame with STX,
+    the other one answers DLE, then the frame is sent with doubled DLEs and
+    DLE ETX BCC at the end and is acknowledged with DLE again.
+*/
+#define mpiIdle 0
+#define mpiFrame 1
+
+typedef struct {
+    uc b[daveMaxRawLen];
+    int len;
+    unsigned long long ready;
+} mpiOut;
+
+static int mpiState=mpiIdle;
+static uc mpiIn[daveMaxRawLen];
+static int mpiLen, mpiDLE, mpiETX;
+static uc mpiBCC;
+static mpiOut mpiQueue[MAX_OUT];
+static int mpiQueued;
+static int mpiSending;		/* 1: sent STX, 2: sent the frame, waiting for DLE */
+static int mpiRetransmit;	/* we dropped the DLE, the master will repeat the frame */
+static uc mpiHostConnection, mpiMessageNumber=1;
+
+static void mpiSingle(int fd, uc c) {
+    simWrite(fd, &c, 1);
+}
+
+static void mpiQueueFrame(uc * b, int len, int delay) {
+    if (mpiQueued>=MAX_OUT) return;
+    memcpy(mpiQueue[mpiQueued].b, b, len);
+    mpiQueue[mpiQueued].len=len;
+    mpiQueue[mpiQueued].ready=now()+delay;
+    mpiQueued++;
+}
+
+/*
+    Start on the next frame, when it is ready and we are not in a dialog:
+*/
+static void mpiKick(int fd) {
+    if (mpiSending || (mpiState!=mpiIdle) || (mpiQueued==0)) return;
+    if (now()<mpiQueue[0].ready) return;
+    mpiSending=1;
+    mpiSingle(fd, STX);
+}
+
+static void mpiSendFrame(int fd, uc * b, int size) {
+    uc target[2*daveMaxRawLen];
+    int i, targetSize=0;
+    uc bcc=DLE^ETX;
+    for (i=0; i<size; i++) {
+	target[targetSize++]=b[i];
+	if (b[i]==DLE) target[targetSize++]=DLE; else bcc^=b[i];
+    }
+    target[targetSize++]=DLE;
+    target[targetSize++]=ETX;
+    target[targetSize++]=bcc;
+    simWrite(fd, target, targetSize);
+}
+
+static void mpiPrefix(uc * b, uc type) {
+    b[0]=0x04;
+    b[1]=0x80 | plcAddress;
+    b[2]=0x80;
+    b[3]=0x0C;
+    b[4]=mpiHostConnection;
+    b[5]=0x14;
+    b[6]=type;
+}
+
+static void mpiMessage(int fd) {
+    uc out[daveMaxRawLen];
+    static const uc version[]={0x01,0x0D,0x20,'V','0','0','.','8','3'};
+    static const uc connected[]={0xD0,0x04,0x00,0x80,0x00,0x02,0x00,0x02,0x01,0x00,0x01,0x00};
+    uc * b=mpiIn;
+
+    if (b[0]==0x01) {
+	/* adapter commands: 01 0D 02 identify, 01 03 02 set up the bus, 01 04 02 disconnect */
+	memcpy(out, version, sizeof(version));
+	out[1]=b[1];
+	mpiQueueFrame(out, sizeof(version), 0);
+	return;
+    }
+    if ((b[0]!=0x04) || (mpiLen<7)) return;
+    if ((b[1]&0x1f)!=plcAddress) return;	/* nobody there */
+    switch (b[6]) {
+	case 0xE0:	/* connect request */
+	    mpiHostConnection=b[5];
+	    mpiPrefix(out, 0xD0);
+	    memcpy(out+6, connected, sizeof(connected));
+	    mpiQueueFrame(out, 6+sizeof(connected), 0);
+	    break;
+	case 0x05:	/* connection confirm */
+	    mpiPrefix(out, 0x05);
+	    out[7]=0x01;
+	    mpiQueueFrame(out, 8, 0);
+	    break;
+	case 0xF1:	/* a PDU: acknowledge it, answer after the scan */
+	    mpiPrefix(out, 0xB0);
+	    out[7]=0x01;
+	    out[8]=b[7];
+	    mpiQueueFrame(out, 9, 0);
+	    if (chance(silentFault)) {
+		silences++;
+		plcPDU(b+8, out+8);
+		break;
+	    }
+	    mpiPrefix(out, 0xF1);
+	    out[7]=mpiMessageNumber++;
+	    if (mpiMessageNumber==0) mpiMessageNumber=1;
+	    mpiQueueFrame(out, 8+plcPDU(b+8, out+8), scanTime);
+	    break;
+	case 0x80:	/* disconnect */
+	    mpiPrefix(out, 0x80);
+	    mpiQueueFrame(out, 7, 0);
+	    break;
+	default:	/* 0xB0, the master's acknowledge */
+	    break;
+    }
+}
+
+static void mpiByte(int fd, uc c) {
+    if (mpiState==mpiIdle) {
+	if (c==STX) {
+	    mpiSingle(fd, DLE);
+	    mpiState=mpiFrame;
+	    mpiLen=mpiDLE=mpiETX=0;
+	    mpiBCC=0;
+	} else if (c==DLE) {
+	    if (mpiSending==1) {
+		mpiSendFrame(fd, mpiQueue[0].b, mpiQueue[0].len);
+		mpiSending=2;
+	    } else if (mpiSending==2) {
+		mpiQueued--;
+		memmove(mpiQueue, mpiQueue+1, mpiQueued*sizeof(mpiOut));
+		mpiSending=0;
+	    }
+	} else if (mpiRetransmit) {
+	    /* the master repeats the frame we did not acknowledge, without STX */
+	    mpiRetransmit=0;
+	    mpiState=mpiFrame;
+	    mpiLen=mpiDLE=mpiETX=0;
+	    mpiBCC=0;
+	    mpiByte(fd, c);
+	}
+	return;
+    }
+    if (mpiETX) {
+	mpiState=mpiIdle;
+	if ((mpiBCC^DLE^ETX)!=c) {
+	    badFrames++;
+	    return;
+	}
+	if ((mpiLen>7) && (mpiIn[0]==0x04) && (mpiIn[6]==0xF1) && chance(e5Fault)) {
+	    droppedAcks++;
+	    mpiRetransmit=1;
+	    return;
+	}
+	mpiSingle(fd, DLE);
+	mpiMessage(fd);
+	return;
+    }
+    if (mpiDLE) {
+	mpiDLE=0;
+	if (c==ETX) {
+	    mpiETX=1;
+	    return;
+	}
+	if (c!=DLE) {
+	    badFrames++;
+	    mpiState=mpiIdle;
+	    return;
+	}
+    } else if (c==DLE) {
+	mpiDLE=1;
+	return;
+    } else if ((c==STX) && (mpiLen==0)) {
+	return;		/* STX again, already answered */
+    }
+    if (mpiLen>=(int)sizeof(mpiIn)) {
+	badFrames++;
+	mpiState=mpiIdle;
+	return;
+    }
+    mpiIn[mpiLen++]=c;
+    if (c!=DLE) mpiBCC^=c;	/* a doubled DLE contributes nothing, as in _daveSendWithCRC */
+}
+
+static void onSignal(int sig) {
+    stop=1;
+}
+
+static void usage(void) {
+    printf("Usage: serialsim [-m] [-a<address>] [-b<baud>] [-w<usec>] [-e<percent>] [-p<percent>] [-t<percent>] [-r<seed>]\n");
+    printf("       [-I<bytes>] [-Q<bytes>] [-M<bytes>] [-D<count>] [-V<bytes>] [-P<pdu length>] [-L<link>]\n");
+    printf("-m simulate an MPI adapter and an S7-300 instead of an S7-200 talking PPI.\n");
+    printf("-a<address> address of the PLC. Default is 2.\n");
+    printf("-b<baud> line speed to pace the bytes with, 0 for no pacing. Default is 9600 for PPI, 38400 for MPI.\n");
+    printf("-w<usec> scan time, until an answer is ready. Default is 2000.\n");
+    printf("-e<percent> requests not acknowledged (E5 for PPI, DLE for MPI).\n");
+    printf("-p<percent> PPI polls answered with E5, not ready yet.\n");
+    printf("-t<percent> requests never answered.\n");
+    printf("-r<seed> seed for the faults. Default is 1.\n");
+    printf("-I -Q -M<bytes> size of inputs, outputs and flags. Default is 256, 256, 4096.\n");
+    printf("-D<count> -V<bytes> number of data blocks (DB1 is V memory) and size of each. Default is 10 of 8192.\n");
+    printf("-P<pdu length> largest PDU to offer. Default is 240.\n");
+    printf("-L<link> make a symbolic link to the pseudo terminal, e.g. -L/tmp/plc.\n");
+    printf("Example: serialsim -L/tmp/plc -e2 -p10\n");
+}
+
+int main(int argc, char **argv) {
+    int master, slave, i, n, wait;
+    char * link=NULL;
+    struct termios tio;
+    struct pollfd pfd;
+    uc b[256];
+
+    while (argc>1) {
+	if (strcmp(argv[1],"-m")==0) protocol=simMPI;
+	else if (strncmp(argv[1],"-a",2)==0) plcAddress=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-b",2)==0) baud=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-w",2)==0) scanTime=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-e",2)==0) e5Fault=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-p",2)==0) pollFault=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-t",2)==0) silentFault=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-r",2)==0) seed=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-I",2)==0) inputSize=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-Q",2)==0) outputSize=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-M",2)==0) flagSize=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-D",2)==0) dbCount=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-V",2)==0) dbSize=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-P",2)==0) maxPDU=atol(argv[1]+2);
+	else if (strncmp(argv[1],"-L",2)==0) link=argv[1]+2;
+	else {
+	    usage();
+	    return -1;
+	}
+	argc--;
+	argv++;
+    }
+    if (baud<0) baud=(protocol==simMPI) ? 38400 : 9600;
+    if ((maxPDU<32) || (maxPDU>960)) maxPDU=240;
+
+    /* a recognizable pattern to read: each byte holds its address */
+    inputs=(uc *) malloc(inputSize+1);
+    outputs=(uc *) malloc(outputSize+1);
+    flags=(uc *) malloc(flagSize+1);
+    dbs=(uc *) malloc(dbCount*dbSize+1);
+    if ((inputs==NULL) || (outputs==NULL) || (flags==NULL) || (dbs==NULL)) {
+	printf("Not enough memory.\n");
+	return -1;
+    }
+    for (i=0; i<inputSize; i++) inputs[i]=i;
+    for (i=0; i<outputSize; i++) outputs[i]=i;
+    for (i=0; i<flagSize; i++) flags[i]=i;
+    for (i=0; i<dbCount*dbSize; i++) dbs[i]=i%dbSize;
+
+    master=posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master<0) || (grantpt(master)!=0) || (unlockpt(master)!=0)) {
+	printf("Couldn't open a pseudo terminal.\n");
+	return -1;
+    }
+    /*
+	Keep the slave side open: raw from the start, and the master does not see
+	end of file each time a program closes its port.
+    */
+    slave=open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave>=0) {
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+    }
+    if (link!=NULL) {
+	unlink(link);
+	if (symlink(ptsname(master), link)!=0) {
+	    printf("Couldn't link %s to %s.\n", link, ptsname(master));
+	    return -1;
+	}
+    }
+    printf("serialsim: %s PLC %d on %s, %d baud, scan %d usec, faults E5/DLE %d%% poll %d%% silent %d%%\n",
+	(protocol==simMPI) ? "MPI" : "PPI", plcAddress, ptsname(master), baud, scanTime, e5Fault, pollFault, silentFault);
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    pfd.fd=master;
+    pfd.events=POLLIN;
+    while (!stop) {
+	wait=1000;
+	if ((protocol==simMPI) && mpiQueued && !mpiSending) {
+	    unsigned long long t=now();
+	    wait=(mpiQueue[0].ready>t) ? (int)((mpiQueue[0].ready-t+999)/1000) : 0;
+	}
+	n=poll(&pfd, 1, wait);
+	if ((n>0) && (pfd.revents & POLLIN)) {
+	    n=read(master, b, sizeof(b));
+	    if (n<=0) {
+		usleep(10000);
+		continue;
+	    }
+	    line(n);
+	    for (i=0; i<n; i++) {
+		if (protocol==simMPI) mpiByte(master, b[i]); else ppiByte(master, b[i]);
+	    }
+	}
+	if (protocol==simMPI) mpiKick(master);
+    }
+
+    fprintf(stderr, "serialsim: %lu requests, %lu reads, %lu writes, %lu items, %lu item errors\n",
+	requests, reads, writes, items, itemErrors);
+    fprintf(stderr, "serialsim: injected %lu unacknowledged, %lu not ready, %lu unanswered, %lu bad frames\n",
+	droppedAcks, notReady, silences, badFrames);
+    if (link!=NULL) unlink(link);
+    if (slave>=0) close(slave);
+    close(master);
+    return 0;
+}
+
+/*
+    Changes:
+    10/17/2026  first version
+*/
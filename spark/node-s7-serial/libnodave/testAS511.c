@@ -332,11 +332,16 @@ int main(int argc, char **argv) {
 	    printf("error %d=%s\n", res, daveStrerror(res));
 
 	if (doReadDB>=0) {
+	res=daveResolveS5Blocks(dc, daveDB, &doReadDB, 1);
+	if (res!=0)
+	    printf("error resolving DB%d %d=%s\n", doReadDB, res, daveStrerror(res));
 	res=daveReadBytes(dc, daveDB, doReadDB, 0, dbReadLen,NULL);
 	if (res==0) {
 	    _daveDump("bytes from DB:",dc->resultPointer,dbReadLen);
 	} else 
 	    printf("error %d=%s\n", res, daveStrerror(res));
+	res=daveReadBytes(dc, daveDB, doReadDB, 0, dbReadLen,NULL);
+	printf("second read from DB%d with the cached address: %d=%s\n", doReadDB, res, daveStrerror(res));
 	}
 	if(doNewfunctions) {
 //	    saveDebug=daveGetDebug();
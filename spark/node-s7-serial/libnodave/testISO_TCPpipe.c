@@ -0,0 +1,365 @@
+/*
+ Benchmark for pipelined ISO over TCP in Libnodave, a free communication libray for Siemens S7.
+
+ A child process stands in for an S7-300/400 on the other end of a socket pair. It
+ accepts the ISO connect and PDU length negotiation, offering the number of parallel
+ jobs given with -j, and answers read requests after a simulated latency (network
+ round trip plus PLC cycle), optionally with some random jitter so answers overtake
+ each other. The parent reads through the normal ISO over TCP transport, once stop
+ and wait with daveExecReadRequestArena and once keeping up to the negotiated number
+ of requests in flight with daveSendRequestTCP and daveReceiveResponseTCP, and checks
+ every answer was matched to the right request.
+
+ This is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "nodave.h"
+
+#define MAX_JOBS 64
+#define TPKT_HEADER 4
+#define COTP_DT_HEADER 3
+
+void usage(void)
+{
+    printf("Usage: testISO_TCPpipe [-n<count>] [-i<items>] [-l<length>] [-j<jobs>] [-w<usec>] [-v<usec>] [-d]\n");
+    printf("-n<count> number of read requests per run. Default is 500.\n");
+    printf("-i<items> number of variables in each read request. Default is 4.\n");
+    printf("-l<length> number of bytes of each variable. Default is 16.\n");
+    printf("-j<jobs> parallel jobs to ask for and the PLC stand-in offers. Default is 8.\n");
+    printf("-w<usec> time the PLC stand-in takes to answer a request. Default is 2000.\n");
+    printf("-v<usec> random extra time added to each answer, lets answers overtake each other. Default is 0.\n");
+    printf("-d will produce a lot of debug messages.\n");
+}
+
+static unsigned long long now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+}
+
+/*
+    The PLC stand-in:
+*/
+typedef struct {
+    unsigned long long due;
+    int len;
+    uc b[daveMaxRawLen];
+} plcAnswer;
+
+static int plcRead(int fd, uc * b, int len) {
+    int res, got=0;
+    while (got<len) {
+	res=read(fd, b+got, len-got);
+	if (res<=0) return -1;
+	got+=res;
+    }
+    return got;
+}
+
+/*
+    Answer the PDU in req, the answer PDU goes to resp. Returns its length.
+*/
+static int plcBuildResponse(uc * req, uc * resp, int offeredJobs) {
+    uc * param=req+10;
+    int plen=256*req[6]+req[7];
+    int i, n, len, dlen=0, rplen, jobs;
+    uc * data;
+
+    resp[0]=0x32; resp[1]=3; resp[2]=0; resp[3]=0;
+    resp[4]=req[4]; resp[5]=req[5];
+    resp[10]=0; resp[11]=0;
+    data=resp+12;
+    if (param[0]==daveFuncRead) {
+	rplen=2;
+	data[0]=daveFuncRead;
+	data[1]=param[1];
+	data+=rplen;
+	for (i=0; i<param[1]; i++) {
+	    uc * item=param+2+12*i;
+	    len=256*item[4]+item[5];
+	    data[dlen++]=0xFF;
+	    data[dlen++]=4;
+	    data[dlen++]=(len*8)/256;
+	    data[dlen++]=(len*8)%256;
+	    /* echo the low byte of the bit address, so the reader can check the match */
+	    for (n=0; n<len; n++) data[dlen++]=(uc)(item[11]+n);
+	    if ((len%2) && (i<param[1]-1)) data[dlen++]=0;
+	}
+    } else {
+	/* PDU length negotiation: offer 480 bytes and our number of jobs */
+	rplen=plen;
+	memcpy(data, param, plen);
+	if ((param[0]==0xF0) && (plen>=8)) {
+	    jobs=daveGetU16from(param+2);
+	    if (jobs>offeredJobs) jobs=offeredJobs;
+	    data[2]=data[4]=jobs/256;
+	    data[3]=data[5]=jobs%256;
+	    data[6]=480/256; data[7]=480%256;
+	}
+    }
+    resp[6]=rplen/256; resp[7]=rplen%256;
+    resp[8]=dlen/256; resp[9]=dlen%256;
+    return 12+rplen+dlen;
+}
+
+static void plcStandIn(int fd, int offeredJobs, int latency, int jitter) {
+    uc b[daveMaxRawLen];
+    uc cc[]={ 0x03,0x00,0x00,0x16,
+	0x11,0xD0,0x00,0x01,0x00,0x01,0x00,
+	0xC0,0x01,0x0A,		/* TPDU size 1024 */
+	0xC1,0x02,0x01,0x00,
+	0xC2,0x02,0x01,0x02 };
+    plcAnswer * answers=calloc(MAX_JOBS, sizeof(plcAnswer));
+    int pending=0, i, first, len, res;
+    unsigned long long t;
+    fd_set fds;
+    struct timeval tv;
+
+    for (;;) {
+	/* send what is due, the earliest first */
+	t=now();
+	for (;;) {
+	    first=-1;
+	    for (i=0; i<pending; i++) {
+		if ((answers[i].due<=t) && ((first<0) || (answers[i].due<answers[first].due))) first=i;
+	    }
+	    if (first<0) break;
+	    write(fd, answers[first].b, answers[first].len);
+	    answers[first]=answers[--pending];
+	}
+
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	tv.tv_sec=1;
+	tv.tv_usec=0;
+	for (i=0; i<pending; i++) {
+	    if ((first<0) || (answers[i].due<answers[first].due)) first=i;
+	}
+	if (first>=0) {
+	    tv.tv_sec=0;
+	    tv.tv_usec=(answers[first].due>t) ? (answers[first].due-t) : 0;
+	}
+	res=select(fd+1, &fds, NULL, NULL, &tv);
+	if (res<0) return;
+	if (res==0) continue;
+
+	if (plcRead(fd, b, TPKT_HEADER)!=TPKT_HEADER) return;
+	len=256*b[2]+b[3];
+	if (plcRead(fd, b+TPKT_HEADER, len-TPKT_HEADER)!=len-TPKT_HEADER) return;
+	if (b[5]==0xE0) {
+	    /* connect request */
+	    write(fd, cc, sizeof(cc));
+	} else if ((b[5]==0xF0) && (pending<MAX_JOBS)) {
+	    /* data, the PDU follows the COTP header */
+	    plcAnswer * a=&answers[pending++];
+	    a->len=TPKT_HEADER+COTP_DT_HEADER+plcBuildResponse(b+TPKT_HEADER+COTP_DT_HEADER, a->b+TPKT_HEADER+COTP_DT_HEADER, offeredJobs);
+	    a->b[0]=3; a->b[1]=0;
+	    a->b[2]=a->len/256; a->b[3]=a->len%256;
+	    a->b[4]=2; a->b[5]=0xF0; a->b[6]=0x80;
+	    a->due=now()+latency+((jitter>0) ? (rand()%jitter) : 0);
+	}
+    }
+}
+
+/*
+    The benchmark:
+*/
+static void buildRequest(daveConnection * dc, PDU * p, int n, int items, int length) {
+    int j;
+    davePrepareReadRequest(dc, p);
+    for (j=0; j<items; j++) daveAddVarToReadRequest(p, daveFlags, 0, (n*items+j)*length, length);
+}
+
+/*
+    The first byte of the first variable of request n, as the stand-in echoes it.
+*/
+static uc expected(int n, int items, int length) {
+    return (uc)((n*items*length*8) & 0xFF);
+}
+
+static void report(char * name, int count, int items, int length, unsigned long long usec) {
+    printf("%-16s %10.1f usec per request %10.1f requests/s %10.1f KB/s\n", name,
+	(double)usec/count, 1e6*count/usec, 1e6*count*items*length/usec/1024);
+}
+
+static int runStopAndWait(daveConnection * dc, int count, int items, int length) {
+    PDU p;
+    daveResultSet rs;
+    unsigned long long t;
+    int i, res;
+
+    t=now();
+    for (i=0; i<count; i++) {
+	buildRequest(dc, &p, i, items, length);
+	res=daveExecReadRequestArena(dc, &p, &rs);
+	if (res!=0) {
+	    printf("read request %d failed: %s\n", i, daveStrerror(res));
+	    return res;
+	}
+	if (rs.results[0].bytes[0]!=expected(i, items, length)) {
+	    printf("read request %d got the wrong answer\n", i);
+	    return -1;
+	}
+    }
+    report("stop and wait", count, items, length, now()-t);
+    return 0;
+}
+
+static int runPipelined(daveConnection * dc, int count, int items, int length, int latency) {
+    PDU p;
+    daveResultSet rs;
+    daveConnectionStats stats;
+    unsigned long long t;
+    unsigned long early;
+    int refs[MAX_JOBS], requests[MAX_JOBS];
+    int jobs, sent=0, done=0, inFlight=0, ref, i, res, strays=0;
+    char name[32];
+
+    jobs=daveGetMaxParallelJobs(dc);
+    if (jobs>MAX_JOBS) jobs=MAX_JOBS;
+    daveResetConnectionStats(dc);
+    t=now();
+    while (done<count) {
+	/* fill the window */
+	while ((inFlight<jobs) && (sent<count)) {
+	    buildRequest(dc, &p, sent, items, length);
+	    res=daveSendRequestTCP(dc, &p, &ref);
+	    if (res!=0) {
+		printf("sending read request %d failed: %s\n", sent, daveStrerror(res));
+		return res;
+	    }
+	    refs[inFlight]=ref;
+	    requests[inFlight]=sent;
+	    inFlight++;
+	    sent++;
+	}
+
+	/* and take whichever answer comes next */
+	res=daveReceiveResponseTCP(dc, &ref);
+	if (res!=0) {
+	    printf("reading an answer failed: %s\n", daveStrerror(res));
+	    return res;
+	}
+	for (i=0; (i<inFlight) && (refs[i]!=ref); i++);
+	if (i==inFlight) {
+	    strays++;
+	    continue;
+	}
+	res=daveGetReadResponseArena(dc, &rs);
+	if (res!=0) {
+	    printf("read request %d failed: %s\n", requests[i], daveStrerror(res));
+	    return res;
+	}
+	if (rs.results[0].bytes[0]!=expected(requests[i], items, length)) {
+	    printf("read request %d got the wrong answer\n", requests[i]);
+	    return -1;
+	}
+	inFlight--;
+	refs[i]=refs[inFlight];
+	requests[i]=requests[inFlight];
+	done++;
+    }
+    sprintf(name, "pipelined (%d)", jobs);
+    report(name, count, items, length, now()-t);
+    if (strays>0) printf("%d answers matched no request\n", strays);
+
+    /* every request was timed from its own send, none can have been answered before the stand-in's latency */
+    daveGetConnectionStats(dc, &stats);
+    early=0;
+    for (i=0; (i<daveLatencyBuckets-1) && ((128L<<i)<=latency); i++) early+=stats.latency[i];
+    printf("%-16s %10.1f usec average %10lu usec longest\n", "latency",
+	(double)stats.latencyTotal/stats.exchanges, stats.latencyMax);
+    if (early>0) {
+	printf("%lu answers timed shorter than the stand-in's latency\n", early);
+	return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int sv[2], res, count=500, items=4, length=16, jobs=8, latency=2000, jitter=0;
+    pid_t pid;
+    daveInterface * di;
+    daveConnection * dc;
+    _daveOSserialType fds;
+
+    while (argc>1) {
+	if (strncmp(argv[1],"-n",2)==0) {
+	    count=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-i",2)==0) {
+	    items=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-l",2)==0) {
+	    length=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-j",2)==0) {
+	    jobs=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-w",2)==0) {
+	    latency=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-v",2)==0) {
+	    jitter=atol(argv[1]+2);
+	} else if (strcmp(argv[1],"-d")==0) {
+	    daveSetDebug(daveDebugAll);
+	} else {
+	    usage();
+	    return -1;
+	}
+	argc--;
+	argv++;
+    }
+    if ((jobs<1) || (jobs>MAX_JOBS)) {
+	printf("Jobs must be 1 to %d.\n", MAX_JOBS);
+	return -1;
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv)!=0) {
+	printf("Couldn't create a socket pair.\n");
+	return -1;
+    }
+
+    pid=fork();
+    if (pid==0) {
+	close(sv[0]);
+	plcStandIn(sv[1], jobs, latency, jitter);
+	_exit(0);
+    }
+    close(sv[1]);
+
+    fds.rfd=sv[0];
+    fds.wfd=sv[0];
+    di=daveNewInterface(fds, "IF1", 0, daveProtoISOTCP, daveSpeed187k);
+    dc=daveNewConnection(di, 2, 0, 2);
+    daveSetMaxParallelJobs(dc, jobs);
+    res=daveConnectPLC(dc);
+    if (res==0) {
+	printf("%d read requests of %d variables of %d bytes, %d usec latency, PDU length %d, %d parallel jobs\n",
+	    count, items, length, latency, daveGetMaxPDULen(dc), daveGetMaxParallelJobs(dc));
+	res=runStopAndWait(dc, count, items, length);
+	if (res==0) res=runPipelined(dc, count, items, length, latency);
+    } else {
+	printf("Couldn't connect to the PLC stand-in: %s\n", daveStrerror(res));
+    }
+
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    close(sv[0]);
+    return res;
+}
@@ -0,0 +1,251 @@
+/*
+ Benchmark for the serial receive path of Libnodave, a free communication libray for Siemens S7.
+
+ A child process stands in for an S7-200 on the master side of a pseudo terminal and
+ answers PPI read requests. The parent talks to it through the slave side with the
+ normal PPI transport and counts the reads the protocol code asks for and the
+ select()+read() system calls needed to serve them, once with the interface read
+ ahead buffer switched off and once with it on. The PPI turnaround mode can be
+ chosen to compare the fixed delay with the computed ones, the retry counters are
+ shown to check a shorter delay does not cost retries.
+
+ This is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "nodave.h"
+#include "setport.h"
+
+#define PLC_ADDRESS 2
+#define LOCAL_ADDRESS 0
+
+int useArena=0;
+
+void usage(void)
+{
+    printf("Usage: testPPIpty [-n<count>] [-i<items>] [-l<length>] [-t<mode>] [-b<baud>] [-a] [-d]\n");
+    printf("-n<count> number of read requests per run. Default is 200.\n");
+    printf("-i<items> number of variables in each read request. Default is 4.\n");
+    printf("-l<length> number of bytes of each variable. Default is 4.\n");
+    printf("-t<mode> PPI turnaround: fixed, frame or adaptive. Default is fixed.\n");
+    printf("-b<baud> line speed the computed turnaround is based on. Default is 9600.\n");
+    printf("-a will read with daveExecReadRequestArena instead of daveExecReadRequest.\n");
+    printf("-d will produce a lot of debug messages.\n");
+}
+
+/*
+    The PLC stand-in:
+*/
+static int plcRead(int fd, uc * b, int len) {
+    int res, got=0;
+    while (got<len) {
+	res=read(fd, b+got, len-got);
+	if (res<=0) return -1;
+	got+=res;
+    }
+    return got;
+}
+
+static int plcBuildResponse(uc * req, uc * resp) {
+    uc * param=req+10;
+    int plen=256*req[6]+req[7];
+    int i, n, len, bits, dlen=0, rplen;
+    uc * data;
+
+    resp[0]=0x32; resp[1]=3; resp[2]=0; resp[3]=0;
+    resp[4]=req[4]; resp[5]=req[5];
+    resp[10]=0; resp[11]=0;
+    data=resp+12;
+    if (param[0]==daveFuncRead) {
+	rplen=2;
+	data[0]=daveFuncRead;
+	data[1]=param[1];
+	data+=rplen;
+	for (i=0; i<param[1]; i++) {
+	    uc * item=param+2+12*i;
+	    len=256*item[4]+item[5];
+	    bits=(item[3]==1);	/* transport size of daveAddBitVarToReadRequest */
+	    data[dlen++]=0xFF;
+	    data[dlen++]=bits ? 3 : 4;
+	    data[dlen++]=bits ? 0 : (len*8)/256;
+	    data[dlen++]=bits ? 1 : (len*8)%256;
+	    if (bits) len=1;
+	    for (n=0; n<len; n++) data[dlen++]=(uc)(item[11]+n);
+	    if ((len%2) && (i<param[1]-1)) data[dlen++]=0;
+	}
+    } else {
+	/* PDU length negotiation or anything else: echo the parameters, offer 240 */
+	rplen=plen;
+	memcpy(data, param, plen);
+	if ((param[0]==0xF0) && (plen>=8)) {
+	    data[6]=0; data[7]=240;
+	}
+    }
+    resp[6]=rplen/256; resp[7]=rplen%256;
+    resp[8]=dlen/256; resp[9]=dlen%256;
+    return 12+rplen+dlen;
+}
+
+static void plcStandIn(int fd) {
+    uc b[daveMaxRawLen], resp[daveMaxRawLen], frame[daveMaxRawLen];
+    uc e5=0xE5;
+    int respLen=0, i, sum, len;
+
+    while (plcRead(fd, b, 1)==1) {
+	if (b[0]==0x68) {
+	    /* SD2 frame with a request PDU: acknowledge, answer on the next poll */
+	    if (plcRead(fd, b+1, 3)!=3) return;
+	    len=b[1];
+	    if (plcRead(fd, b+4, len+2)!=len+2) return;
+	    respLen=plcBuildResponse(b+7, resp);
+	    write(fd, &e5, 1);
+	} else if (b[0]==0x10) {
+	    /* request data poll */
+	    if (plcRead(fd, b+1, 5)!=5) return;
+	    if (respLen==0) {
+		write(fd, &e5, 1);
+		continue;
+	    }
+	    frame[0]=0x68;
+	    frame[1]=frame[2]=respLen+3;
+	    frame[3]=0x68;
+	    frame[4]=LOCAL_ADDRESS;
+	    frame[5]=PLC_ADDRESS;
+	    frame[6]=0x08;
+	    memcpy(frame+7, resp, respLen);
+	    sum=0;
+	    for (i=4; i<7+respLen; i++) sum+=frame[i];
+	    frame[7+respLen]=sum&0xff;
+	    frame[8+respLen]=0x16;
+	    write(fd, frame, respLen+9);
+	    respLen=0;
+	}
+    }
+}
+
+/*
+    The benchmark:
+*/
+static int run(daveConnection * dc, int buffered, int count, int items, int length) {
+    PDU p;
+    daveResultSet rs;
+    struct timeval t1, t2;
+    unsigned long reads0, calls0, reads1, calls1;
+    double usec;
+    int i, j, res, secondTries, thirdTries, pollRetries;
+
+    daveSetRxBuffered(dc->iface, buffered);
+    daveGetRxStats(dc->iface, &reads0, &calls0);
+    gettimeofday(&t1, NULL);
+    for (i=0; i<count; i++) {
+	davePrepareReadRequest(dc, &p);
+	for (j=0; j<items; j++) daveAddVarToReadRequest(&p, daveFlags, 0, j*length, length);
+	res=useArena ? daveExecReadRequestArena(dc, &p, &rs) : daveExecReadRequest(dc, &p, &rs);
+	if (res!=0) {
+	    printf("read request %d failed: %s\n", i, daveStrerror(res));
+	    return res;
+	}
+	daveFreeResults(&rs);
+    }
+    gettimeofday(&t2, NULL);
+    daveGetRxStats(dc->iface, &reads1, &calls1);
+    usec = 1e6 * (t2.tv_sec - t1.tv_sec) + t2.tv_usec - t1.tv_usec;
+    daveGetPPIRetries(dc->iface, &secondTries, &thirdTries, &pollRetries);
+    printf("%-10s %8.1f reads %8.1f syscalls %10.1f usec per daveExecReadRequest\n",
+	buffered ? "buffered" : "unbuffered",
+	(double)(reads1-reads0)/count, (double)(calls1-calls0)/count, usec/count);
+    printf("           turnaround %d usec, retries: 2nd %d 3rd %d poll %d\n",
+	daveGetPPITurnaround(dc->iface), secondTries, thirdTries, pollRetries);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int master, res, count=200, items=4, length=4, mode=daveTurnaroundFixed, baud=9600;
+    pid_t pid;
+    daveInterface * di;
+    daveConnection * dc;
+    _daveOSserialType fds;
+
+    while (argc>1) {
+	if (strncmp(argv[1],"-n",2)==0) {
+	    count=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-i",2)==0) {
+	    items=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-l",2)==0) {
+	    length=atol(argv[1]+2);
+	} else if (strcmp(argv[1],"-tfixed")==0) {
+	    mode=daveTurnaroundFixed;
+	} else if (strcmp(argv[1],"-tframe")==0) {
+	    mode=daveTurnaroundFrame;
+	} else if (strcmp(argv[1],"-tadaptive")==0) {
+	    mode=daveTurnaroundAdaptive;
+	} else if (strncmp(argv[1],"-b",2)==0) {
+	    baud=atol(argv[1]+2);
+	} else if (strcmp(argv[1],"-a")==0) {
+	    useArena=1;
+	} else if (strcmp(argv[1],"-d")==0) {
+	    daveSetDebug(daveDebugAll);
+	} else {
+	    usage();
+	    return -1;
+	}
+	argc--;
+	argv++;
+    }
+
+    master=posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master<0) || (grantpt(master)!=0) || (unlockpt(master)!=0)) {
+	printf("Couldn't open a pseudo terminal.\n");
+	return -1;
+    }
+    fds.rfd=setPort(ptsname(master), "9600", 'E');
+    fds.wfd=fds.rfd;
+    if (fds.rfd<0) {
+	printf("Couldn't open %s\n", ptsname(master));
+	return -1;
+    }
+
+    pid=fork();
+    if (pid==0) {
+	close(fds.rfd);
+	plcStandIn(master);
+	_exit(0);
+    }
+
+    di=daveNewInterface(fds, "IF1", LOCAL_ADDRESS, daveProtoPPI, daveSpeed187k);
+    daveSetPPITurnaround(di, mode, baud, -1);
+    dc=daveNewConnection(di, PLC_ADDRESS, 0, 0);
+    res=daveConnectPLC(dc);
+    if (res==0) {
+	printf("%d read requests of %d variables of %d bytes, PDU length %d\n", count, items, length, dc->maxPDUlength);
+	res=run(dc, 0, count, items, length);
+	if (res==0) res=run(dc, 1, count, items, length);
+    } else {
+	printf("Couldn't connect to the PLC stand-in: %s\n", daveStrerror(res));
+    }
+
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    closePort(fds.rfd);
+    close(master);
+    return res;
+}
@@ -0,0 +1,250 @@
+/*
+ Test and demo program for Libnodave, a free communication libray for Siemens S7.
+
+ Load test for the event driven exchange engine in nodavereactor.c: opens many
+ ISO over TCP or IBH NetLink connections, first polls each of them from a
+ thread of its own with the blocking calls, then all of them from a single
+ thread through the reactor.
+
+ Run it against the simulators, e.g. "isotest4 1102" and
+ "testReactorLoad -c100 -p1102 127.0.0.1" or "ibhsim5 1099" and
+ "testReactorLoad -i -c100 -p1099 127.0.0.1". ibhsim5 does not cope with
+ many connections at a time, start several of them on consecutive ports and
+ use -s.
+
+ This is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "nodave.h"
+#include "nodavereactor.h"
+#include "openSocket.h"
+
+#define MAX_CONNECTIONS 1000
+
+void usage(void)
+{
+    printf("Usage: testReactorLoad [-i] [-c<connections>] [-n<count>] [-l<length>] [-p<port>] [-s<servers>] [-m<mpi>] [-d] IP-Address\n");
+    printf("-i use IBH NetLink MPI instead of ISO over TCP.\n");
+    printf("-c<connections> number of connections to open. Default is 50.\n");
+    printf("-n<count> read requests per connection and run. Default is 200.\n");
+    printf("-l<length> bytes to read with each request. Default is 16.\n");
+    printf("-p<port> TCP port. Default is 102, or 1099 with -i.\n");
+    printf("-s<servers> spread the connections over this many simulators listening on port, port+1...\n");
+    printf("-m<mpi> MPI address of the PLC behind the NetLink. Default is 2.\n");
+    printf("-d will produce a lot of debug messages.\n");
+    printf("Example: testReactorLoad -c100 -p1102 127.0.0.1\n");
+}
+
+static unsigned long long now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+}
+
+static void report(char * name, int connections, int count, unsigned long long usec) {
+    printf("%-22s %10.1f exchanges/s %10.1f usec per exchange per connection\n", name,
+	1e6*connections*count/usec, (double)usec/count);
+}
+
+typedef struct {
+    daveConnection * dc;
+    int remaining;
+    int errors;
+    int length;
+    pthread_t thread;
+} loadConnection;
+
+/*
+    One thread per connection, as the blocking calls need it:
+*/
+static void * blockingPoll(void * arg) {
+    loadConnection * lc=(loadConnection *) arg;
+    while (lc->remaining>0) {
+	if (daveReadBytes(lc->dc, daveFlags, 0, 0, lc->length, NULL)!=0) lc->errors++;
+	lc->remaining--;
+    }
+    return NULL;
+}
+
+static int runThreads(loadConnection * lc, int connections, int count) {
+    int i, errors=0;
+    unsigned long long t=now();
+    for (i=0; i<connections; i++) {
+	lc[i].remaining=count;
+	lc[i].errors=0;
+	if (pthread_create(&lc[i].thread, NULL, blockingPoll, &lc[i])!=0) {
+	    printf("Couldn't start thread %d.\n", i);
+	    return -1;
+	}
+    }
+    for (i=0; i<connections; i++) {
+	pthread_join(lc[i].thread, NULL);
+	errors+=lc[i].errors;
+    }
+    report("thread per connection", connections, count, now()-t);
+    if (errors) printf("%d exchanges failed\n", errors);
+    return 0;
+}
+
+/*
+    All connections from this thread:
+*/
+static daveReactor * reactor;
+
+static void submitRead(loadConnection * lc);
+
+static void DECL2 readDone(daveConnection * dc, int res, void * user) {
+    loadConnection * lc=(loadConnection *) user;
+    PDU p2;
+    if (res==daveResOK) {
+	res=_daveSetupReceivedPDU(dc, &p2);
+	if (res==daveResOK) res=_daveTestReadResult(&p2);
+    }
+    if (res!=daveResOK) lc->errors++;
+    lc->remaining--;
+    if (lc->remaining>0) submitRead(lc);
+}
+
+static void submitRead(loadConnection * lc) {
+    PDU p;
+    davePrepareReadRequest(lc->dc, &p);
+    daveAddVarToReadRequest(&p, daveFlags, 0, 0, lc->length);
+    if (daveReactorSubmit(reactor, lc->dc, &p, readDone, lc)!=0) {
+	lc->errors+=lc->remaining;
+	lc->remaining=0;
+    }
+}
+
+static int runReactor(loadConnection * lc, int connections, int count) {
+    int i, res, errors=0;
+    unsigned long long t;
+    for (i=0; i<connections; i++) {
+	res=daveReactorAdd(reactor, lc[i].dc);
+	if (res!=0) {
+	    printf("Couldn't add connection %d to the reactor: %d\n", i, res);
+	    return -1;
+	}
+    }
+    t=now();
+    for (i=0; i<connections; i++) {
+	lc[i].remaining=count;
+	lc[i].errors=0;
+	submitRead(&lc[i]);
+    }
+    while (daveReactorPending(reactor)>0) {
+	res=daveReactorRun(reactor, 1000);
+	if (res<0) {
+	    printf("daveReactorRun failed: %d\n", res);
+	    return -1;
+	}
+    }
+    report("reactor, one thread", connections, count, now()-t);
+    for (i=0; i<connections; i++) {
+	errors+=lc[i].errors;
+	daveReactorRemove(reactor, lc[i].dc);
+    }
+    if (errors) printf("%d exchanges failed\n", errors);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int i, ibh=0, connections=50, count=200, length=16, port=0, mpi=2, servers=1, opened=0, res=0;
+    _daveOSserialType fds;
+    daveInterface * di;
+    loadConnection * lc;
+
+    while (argc>1 && argv[1][0]=='-') {
+	if (strcmp(argv[1],"-i")==0) {
+	    ibh=1;
+	} else if (strncmp(argv[1],"-c",2)==0) {
+	    connections=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-n",2)==0) {
+	    count=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-l",2)==0) {
+	    length=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-p",2)==0) {
+	    port=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-s",2)==0) {
+	    servers=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-m",2)==0) {
+	    mpi=atol(argv[1]+2);
+	} else if (strcmp(argv[1],"-d")==0) {
+	    daveSetDebug(daveDebugAll);
+	} else {
+	    usage();
+	    return -1;
+	}
+	argc--;
+	argv++;
+    }
+    if (argc<2) {
+	usage();
+	return -1;
+    }
+    if ((connections<1) || (connections>MAX_CONNECTIONS)) {
+	printf("Connections must be 1 to %d.\n", MAX_CONNECTIONS);
+	return -1;
+    }
+    if (port==0) port=ibh ? 1099 : 102;
+    if (servers<1) servers=1;
+
+    lc=(loadConnection *) calloc(connections, sizeof(loadConnection));
+    for (i=0; i<connections; i++) {
+	fds.rfd=openSocket(port+i%servers, argv[1]);
+	fds.wfd=fds.rfd;
+	if (fds.rfd<=0) break;
+	di=daveNewInterface(fds, "IF1", 0, ibh ? daveProtoMPI_IBH : daveProtoISOTCP, daveSpeed187k);
+	if (ibh && (daveInitAdapter(di)!=0)) {
+	    printf("Couldn't connect to Adapter %d.\n", i);
+	    break;
+	}
+	lc[i].dc=ibh ? daveNewConnection(di, mpi, 0, 0) : daveNewConnection(di, 2, 0, 2);
+	lc[i].length=length;
+	if (daveConnectPLC(lc[i].dc)!=0) {
+	    printf("Couldn't connect to PLC %d.\n", i);
+	    break;
+	}
+	/* daveConnectPLC sets its own, a loaded simulator may take longer */
+	daveSetTimeout(di, 5000000);
+	opened++;
+    }
+    if (opened<connections) {
+	res=-2;
+    } else {
+	printf("%d %s connections, %d read requests of %d bytes each\n",
+	    connections, ibh ? "IBH NetLink" : "ISO over TCP", count, length);
+	reactor=daveNewReactor();
+	res=runThreads(lc, connections, count);
+	if (res==0) res=runReactor(lc, connections, count);
+	daveFreeReactor(reactor);
+    }
+    for (i=0; i<opened; i++) {
+	daveDisconnectPLC(lc[i].dc);
+	if (ibh) daveDisconnectAdapter(lc[i].dc->iface);
+	closeSocket(lc[i].dc->iface->fd.rfd);
+    }
+    free(lc);
+    return res;
+}
+
+/*
+    Changes:
+    10/17/2026  first version
+*/
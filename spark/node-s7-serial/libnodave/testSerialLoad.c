@@ -0,0 +1,193 @@
+/*
+ Test and demo program for Libnodave, a free communication libray for Siemens S7.
+
+ Throughput benchmark for the serial protocols: reads the same variables over
+ and over through PPI or MPI and reports reads per second, the latency
+ percentiles of the single daveExecReadRequest calls, the PPI retry counters,
+ the number of failed reads and the link statistics the library keeps for the
+ connection. Meant to run against serialsim, e.g.
+
+   serialsim -L/tmp/plc -e1 -p5 &
+   testSerialLoad -n1000 /tmp/plc
+
+ but works on a real PLC as well. It only reads.
+
+ This is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Libnodave; see the file COPYING.  If not, write to
+ the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "nodave.h"
+#include "setport.h"
+
+void usage(void)
+{
+    printf("Usage: testSerialLoad [-m] [-b<baud>] [-n<count>] [-i<items>] [-l<length>] [-a<mpi>] [-t<mode>] [-d] serial port\n");
+    printf("-m use MPI (adapter protocol MPI v1) instead of PPI.\n");
+    printf("-b<baud> line speed. Default is 9600 for PPI, 38400 for MPI.\n");
+    printf("-n<count> number of read requests. Default is 500.\n");
+    printf("-i<items> number of variables in each read request. Default is 4.\n");
+    printf("-l<length> number of bytes of each variable. Default is 4.\n");
+    printf("-a<mpi> address of the PLC. Default is 2.\n");
+    printf("-t<mode> PPI turnaround: fixed, frame or adaptive. Default is adaptive.\n");
+    printf("-d will produce a lot of debug messages.\n");
+    printf("Example: testSerialLoad -n1000 /tmp/plc\n");
+}
+
+static unsigned long long now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return 1000000ULL * t.tv_sec + t.tv_usec;
+}
+
+static int compareLatency(const void * a, const void * b) {
+    unsigned long x=*(const unsigned long *)a, y=*(const unsigned long *)b;
+    return (x<y) ? -1 : (x>y);
+}
+
+static unsigned long percentile(unsigned long * sorted, int n, int p) {
+    int i=(n*p+99)/100-1;
+    if (i<0) i=0;
+    return sorted[i];
+}
+
+int main(int argc, char **argv) {
+    int i, j, res, mpi=0, count=500, items=4, length=4, plcAddress=2, mode=daveTurnaroundAdaptive;
+    int failures=0, done=0, secondTries, thirdTries, pollRetries;
+    char * baud=NULL;
+    unsigned long * latency;
+    unsigned long long t0, t1, total;
+    _daveOSserialType fds;
+    daveInterface * di;
+    daveConnection * dc;
+    daveResultSet rs;
+    daveConnectionStats stats;
+    PDU p;
+
+    while (argc>1 && argv[1][0]=='-') {
+	if (strcmp(argv[1],"-m")==0) {
+	    mpi=1;
+	} else if (strncmp(argv[1],"-b",2)==0) {
+	    baud=argv[1]+2;
+	} else if (strncmp(argv[1],"-n",2)==0) {
+	    count=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-i",2)==0) {
+	    items=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-l",2)==0) {
+	    length=atol(argv[1]+2);
+	} else if (strncmp(argv[1],"-a",2)==0) {
+	    plcAddress=atol(argv[1]+2);
+	} else if (strcmp(argv[1],"-tfixed")==0) {
+	    mode=daveTurnaroundFixed;
+	} else if (strcmp(argv[1],"-tframe")==0) {
+	    mode=daveTurnaroundFrame;
+	} else if (strcmp(argv[1],"-tadaptive")==0) {
+	    mode=daveTurnaroundAdaptive;
+	} else if (strcmp(argv[1],"-d")==0) {
+	    daveSetDebug(daveDebugAll);
+	} else {
+	    usage();
+	    return -1;
+	}
+	argc--;
+	argv++;
+    }
+    if ((argc<2) || (count<1)) {
+	usage();
+	return -1;
+    }
+    if (baud==NULL) baud=mpi ? "38400" : "9600";
+
+    fds.rfd=setPort(argv[1], baud, mpi ? 'O' : 'E');
+    fds.wfd=fds.rfd;
+    if (fds.rfd<=0) {
+	printf("Couldn't open serial port %s\n", argv[1]);
+	return -1;
+    }
+    di=daveNewInterface(fds, "IF1", 0, mpi ? daveProtoMPI : daveProtoPPI, daveSpeed187k);
+    daveSetTimeout(di, 1000000);
+    if (!mpi) daveSetPPITurnaround(di, mode, atol(baud), -1);
+    res=daveInitAdapter(di);
+    if (res!=0) {
+	printf("Couldn't initialize the adapter: %d\n", res);
+	closePort(fds.rfd);
+	return -2;
+    }
+    dc=daveNewConnection(di, plcAddress, 0, 0);
+    res=daveConnectPLC(dc);
+    if (res!=0) {
+	printf("Couldn't connect to the PLC: %s\n", daveStrerror(res));
+	daveDisconnectAdapter(di);
+	closePort(fds.rfd);
+	return -3;
+    }
+    printf("%s at %s baud, %d read requests of %d variables of %d bytes, PDU length %d\n",
+	mpi ? "MPI" : "PPI", baud, count, items, length, daveGetMaxPDULen(dc));
+
+    latency=(unsigned long *) malloc(count*sizeof(unsigned long));
+    total=now();
+    for (i=0; i<count; i++) {
+	davePrepareReadRequest(dc, &p);
+	for (j=0; j<items; j++) daveAddVarToReadRequest(&p, daveFlags, 0, j*length, length);
+	t0=now();
+	res=daveExecReadRequest(dc, &p, &rs);
+	t1=now();
+	if (res==0) {
+	    for (j=0; (j<items) && (res==0); j++) res=daveUseResult(dc, &rs, j);
+	    daveFreeResults(&rs);
+	}
+	if (res!=0) {
+	    failures++;
+	    if (failures<=10) printf("read request %d failed: %s\n", i, daveStrerror(res));
+	    continue;
+	}
+	latency[done++]=(unsigned long)(t1-t0);
+    }
+    total=now()-total;
+
+    printf("%10.1f reads/s %10.1f KB/s\n", 1e6*count/total, 1e6*done*items*length/total/1024);
+    if (done>0) {
+	qsort(latency, done, sizeof(unsigned long), compareLatency);
+	printf("latency usec: p50 %lu p90 %lu p99 %lu max %lu\n",
+	    percentile(latency, done, 50), percentile(latency, done, 90),
+	    percentile(latency, done, 99), latency[done-1]);
+    }
+    if (!mpi) {
+	daveGetPPIRetries(di, &secondTries, &thirdTries, &pollRetries);
+	printf("retries: 2nd %d 3rd %d poll %d, turnaround %d usec\n",
+	    secondTries, thirdTries, pollRetries, daveGetPPITurnaround(di));
+    }
+    printf("failed reads: %d of %d\n", failures, count);
+    daveGetConnectionStats(dc, &stats);
+    printf("link: %lu exchanges, %lu timeouts, %lu checksum errors, %llu bytes sent, %llu received, latency average %llu max %lu usec\n",
+	stats.exchanges, stats.timeouts, stats.checksumErrors, stats.bytesSent, stats.bytesReceived,
+	stats.exchanges ? stats.latencyTotal/stats.exchanges : 0, stats.latencyMax);
+    printf("latency histogram:");
+    for (i=0; i<daveLatencyBuckets; i++) if (stats.latency[i]) printf(" <%lu:%lu", 128UL<<i, stats.latency[i]);
+    printf("\n");
+
+    free(latency);
+    daveDisconnectPLC(dc);
+    daveDisconnectAdapter(di);
+    closePort(fds.rfd);
+    return 0;
+}
+
+/*
+    Changes:
+    10/17/2026  first version
+*/
@@ -0,0 +1,304 @@
+/*jshint esversion: 6 */
+
+var constants = require('./constants.js');
+
+// read request PDU layout, as built by davePrepareReadRequest and daveAddToReadRequest
+const READ_REQUEST_HEADER_LENGTH = 12;  // 10 byte PDU header + function code and item count
+const READ_REQUEST_ITEM_LENGTH = 12;    // 0x12 0x0a 0x10, transport size, length, DB number, area, start address
+
+// read response PDU layout, as parsed by daveExecReadRequest
+const READ_RESPONSE_HEADER_LENGTH = 14; // 12 byte PDU header (with error code) + function code and item count
+const READ_RESPONSE_ITEM_LENGTH = 4;    // return code, transport size and length ahead of each items data
+
+// write request PDU layout, as built by davePrepareWriteRequest and daveAddToWriteRequest
+const WRITE_REQUEST_HEADER_LENGTH = 12; // 10 byte PDU header + function code and item count
+const WRITE_REQUEST_ITEM_LENGTH = 16;   // 12 byte item address + return code, transport size and length ahead of its data
+
+// write response PDU layout, as parsed by daveExecWriteRequest
+const WRITE_RESPONSE_HEADER_LENGTH = 14; // 12 byte PDU header (with error code) + function code and item count
+const WRITE_RESPONSE_ITEM_LENGTH = 1;    // one return code per item
+
+// the protocol will not take more items than this in a single request, whatever the PDU size
+const MAX_ITEMS_IN_MULTIREAD = 20;
+const MAX_ITEMS_IN_MULTIWRITE = 20;
+
+// smallest PDU length we will ever be offered (MPI over serial is limited to 240)
+const DEFAULT_MAX_PDU_LENGTH = 240;
+
+// by default only merge items that touch or overlap, a negative gap turns coalescing off
+const DEFAULT_COALESCE_GAP = 0;
+
+
+function responseDataLength(readRequest) {
+    // number of data bytes the PLC returns for an item, the length is a count of elements
+    // for timers and counters. S7-200 counters come back as 3 bytes and timers as 5 bytes each
+    var dataLength;
+    if (readRequest.memoryArea === constants.S7_200_AREA_C) {
+        dataLength = readRequest.length * 3;
+    } else if (readRequest.memoryArea === constants.S7_200_AREA_T) {
+        dataLength = readRequest.length * 5;
+    } else if ((readRequest.memoryArea === constants.S7_300_AREA_C) || (readRequest.memoryArea === constants.S7_300_AREA_T)) {
+        dataLength = readRequest.length * 2;
+    } else {
+        dataLength = readRequest.length;
+    }
+    // odd length items are padded to a word boundary
+    return dataLength + (dataLength % 2);
+}
+
+
+function isCoalescable(readRequest) {
+    // timers and counters are read as elements rather than bytes, so they always get their own item
+    return !((readRequest.memoryArea === constants.S7_200_AREA_C) || (readRequest.memoryArea === constants.S7_200_AREA_T) ||
+             (readRequest.memoryArea === constants.S7_300_AREA_C) || (readRequest.memoryArea === constants.S7_300_AREA_T));
+}
+
+
+// merge read requests of the same area and DB into contiguous byte ranges, where the gap between them is
+// at most gapTolerance bytes. Bits are served from their containing byte. Returns the items to actually
+// read plus, for each read request, where its value is found in those items
+function coalesceReadRequests(readRequestArray, gapTolerance, maxPDULength) {
+    maxPDULength = maxPDULength || DEFAULT_MAX_PDU_LENGTH;
+
+    var readItems = [];
+    var slices = new Array(readRequestArray.length);
+    var ranges = [];
+    var i;
+
+    // a range must still fit in the response of an exchange on its own
+    var maxRangeLength = maxPDULength - READ_RESPONSE_HEADER_LENGTH - READ_RESPONSE_ITEM_LENGTH;
+    maxRangeLength -= maxRangeLength % 2;
+
+    for (i = 0; i < readRequestArray.length; i++) {
+        var readRequest = readRequestArray[i];
+        if ((gapTolerance < 0) || !isCoalescable(readRequest)) {
+            // read as is
+            slices[i] = { itemIndex: readItems.length, byteOffset: 0, bitOffset: -1 };
+            readItems.push({
+                readType: readRequest.readType,
+                memoryArea: readRequest.memoryArea,
+                blockIndex: readRequest.blockIndex,
+                startAddress: readRequest.startAddress,
+                length: readRequest.length
+            });
+        } else if (readRequest.readType === constants.READ_BIT) {
+            // bit addresses are in bits, serve them from their containing byte
+            ranges.push({ index: i, memoryArea: readRequest.memoryArea, blockIndex: readRequest.blockIndex,
+                          start: Math.floor(readRequest.startAddress / 8), end: Math.floor(readRequest.startAddress / 8) + 1,
+                          bitOffset: readRequest.startAddress % 8 });
+        } else {
+            ranges.push({ index: i, memoryArea: readRequest.memoryArea, blockIndex: readRequest.blockIndex,
+                          start: readRequest.startAddress, end: readRequest.startAddress + readRequest.length,
+                          bitOffset: -1 });
+        }
+    }
+
+    // sort by area, DB and address so neighbours end up next to each other
+    ranges.sort(function(a, b) {
+        return (a.memoryArea - b.memoryArea) || (a.blockIndex - b.blockIndex) || (a.start - b.start) || (a.end - b.end);
+    });
+
+    var current = null;
+    for (i = 0; i < ranges.length; i++) {
+        var range = ranges[i];
+        if ((current === null) ||
+            (current.memoryArea !== range.memoryArea) ||
+            (current.blockIndex !== range.blockIndex) ||
+            (range.start > current.startAddress + current.length + gapTolerance) ||
+            (Math.max(range.end, current.startAddress + current.length) - current.startAddress > maxRangeLength)) {
+            current = {
+                readType: constants.READ_BYTE,
+                memoryArea: range.memoryArea,
+                blockIndex: range.blockIndex,
+                startAddress: range.start,
+                length: range.end - range.start
+            };
+            readItems.push(current);
+        } else {
+            current.length = Math.max(range.end, current.startAddress + current.length) - current.startAddress;
+        }
+        slices[range.index] = { itemIndex: readItems.length - 1, byteOffset: range.start - current.startAddress, bitOffset: range.bitOffset };
+    }
+
+    return {
+        readItems: readItems,
+        slices: slices
+    };
+}
+
+
+// split the read request list into as few exchanges as the negotiated PDU length allows, keeping
+// both the request and the expected response of each exchange within maxPDULength
+function packReadRequests(readRequestArray, maxPDULength) {
+    maxPDULength = maxPDULength || DEFAULT_MAX_PDU_LENGTH;
+
+    var plan = {
+        maxPDULength: maxPDULength,
+        roundTrips: 0,
+        requests: []
+    };
+
+    var current = null;
+    for (var i = 0; i < readRequestArray.length; i++) {
+        var itemRequestLength = READ_REQUEST_ITEM_LENGTH;
+        var itemResponseLength = READ_RESPONSE_ITEM_LENGTH + responseDataLength(readRequestArray[i]);
+
+        // start a new exchange when this item would overflow the current one
+        if ((current === null) ||
+            (current.count >= MAX_ITEMS_IN_MULTIREAD) ||
+            (current.requestLength + itemRequestLength > maxPDULength) ||
+            (current.responseLength + itemResponseLength > maxPDULength)) {
+            current = {
+                startIndex: i,
+                count: 0,
+                requestLength: READ_REQUEST_HEADER_LENGTH,
+                responseLength: READ_RESPONSE_HEADER_LENGTH
+            };
+            plan.requests.push(current);
+        }
+
+        current.count += 1;
+        current.requestLength += itemRequestLength;
+        current.responseLength += itemResponseLength;
+    }
+
+    plan.roundTrips = plan.requests.length;
+    return plan;
+}
+
+
+// split a write list into as few exchanges as the negotiated PDU length allows. Unlike a read the data
+// travels in the request, each item starting on a word boundary
+function packWriteRequests(writeRequestArray, maxPDULength) {
+    maxPDULength = maxPDULength || DEFAULT_MAX_PDU_LENGTH;
+
+    var plan = {
+        maxPDULength: maxPDULength,
+        roundTrips: 0,
+        requests: []
+    };
+
+    var current = null;
+    for (var i = 0; i < writeRequestArray.length; i++) {
+        var dataLength = writeRequestArray[i].length;
+        var itemRequestLength = WRITE_REQUEST_ITEM_LENGTH + dataLength;
+
+        // start a new exchange when this item would overflow the current one
+        if ((current === null) ||
+            (current.count >= MAX_ITEMS_IN_MULTIWRITE) ||
+            (current.requestLength + (current.requestLength % 2) + itemRequestLength > maxPDULength) ||
+            (current.responseLength + WRITE_RESPONSE_ITEM_LENGTH > maxPDULength)) {
+            current = {
+                startIndex: i,
+                count: 0,
+                requestLength: WRITE_REQUEST_HEADER_LENGTH,
+                responseLength: WRITE_RESPONSE_HEADER_LENGTH
+            };
+            plan.requests.push(current);
+        } else {
+            // pad the previous item's data to a word boundary
+            current.requestLength += current.requestLength % 2;
+        }
+
+        current.count += 1;
+        current.requestLength += itemRequestLength;
+        current.responseLength += WRITE_RESPONSE_ITEM_LENGTH;
+    }
+
+    plan.roundTrips = plan.requests.length;
+    return plan;
+}
+
+
+// work out the complete read plan: the coalesced items to read, how they are packed into exchanges and,
+// for every exchange, the items readItems reads, which read requests it answers and the descriptors they
+// are decoded with
+function buildReadPlan(readRequestArray, maxPDULength, gapTolerance) {
+    var coalesced = coalesceReadRequests(readRequestArray, gapTolerance, maxPDULength);
+    var plan = packReadRequests(coalesced.readItems, maxPDULength);
+    var itemToRequest = new Array(coalesced.readItems.length);
+    var i, j;
+
+    plan.items = coalesced.readItems;
+    for (i = 0; i < plan.requests.length; i++) {
+        plan.requests[i].readIndexes = [];
+        for (j = 0; j < plan.requests[i].count; j++) {
+            itemToRequest[plan.requests[i].startIndex + j] = i;
+        }
+    }
+
+    // keep the original read list order within each exchange
+    for (i = 0; i < readRequestArray.length; i++) {
+        plan.requests[itemToRequest[coalesced.slices[i].itemIndex]].readIndexes.push(i);
+    }
+
+    plan.requests.forEach(function(request) {
+        // data type, memory area, block index, start address, length of each item the exchange reads
+        request.items = new Int32Array(request.count * 5);
+        for (j = 0; j < request.count; j++) {
+            var readItem = plan.items[request.startIndex + j];
+            request.items.set([readItem.readType, readItem.memoryArea, readItem.blockIndex, readItem.startAddress, readItem.length], j * 5);
+        }
+
+        // result index, byte offset, bit offset, data type, data format, memory area
+        request.descriptors = new Int32Array(request.readIndexes.length * 6);
+        request.readIndexes.forEach(function(readIndex, n) {
+            var readRequest = readRequestArray[readIndex];
+            var slice = coalesced.slices[readIndex];
+            request.descriptors.set([slice.itemIndex - request.startIndex, slice.byteOffset, slice.bitOffset,
+                                     readRequest.readType, readRequest.format, readRequest.memoryArea], n * 6);
+        });
+    });
+
+    plan.flat = flattenReadPlan(plan);
+
+    return plan;
+}
+
+
+// lay the whole plan out flat for subscribe and readExchanges: the items of every exchange, for each exchange its
+// first item, item count and value count, and the descriptors and read request index of each value, the values
+// of each exchange following on from the previous one
+function flattenReadPlan(plan) {
+    var valueCount = 0;
+    plan.requests.forEach(function(request) {
+        valueCount += request.readIndexes.length;
+    });
+
+    var flat = {
+        items: new Int32Array(plan.items.length * 5),
+        exchanges: new Int32Array(plan.requests.length * 3),
+        descriptors: new Int32Array(valueCount * 6),
+        readIndexes: new Int32Array(valueCount)
+    };
+    var valueIndex = 0;
+    plan.requests.forEach(function(request, requestIndex) {
+        flat.items.set(request.items, request.startIndex * 5);
+        flat.exchanges.set([request.startIndex, request.count, request.readIndexes.length], requestIndex * 3);
+        flat.descriptors.set(request.descriptors, valueIndex * 6);
+        flat.readIndexes.set(request.readIndexes, valueIndex);
+        valueIndex += request.readIndexes.length;
+    });
+
+    return flat;
+}
+
+
+module.exports.buildReadPlan = buildReadPlan;
+module.exports.flattenReadPlan = flattenReadPlan;
+module.exports.coalesceReadRequests = coalesceReadRequests;
+module.exports.packReadRequests = packReadRequests;
+module.exports.packWriteRequests = packWriteRequests;
+module.exports.responseDataLength = responseDataLength;
+module.exports.MAX_ITEMS_IN_MULTIREAD = MAX_ITEMS_IN_MULTIREAD;
+module.exports.MAX_ITEMS_IN_MULTIWRITE = MAX_ITEMS_IN_MULTIWRITE;
+module.exports.DEFAULT_MAX_PDU_LENGTH = DEFAULT_MAX_PDU_LENGTH;
+module.exports.DEFAULT_COALESCE_GAP = DEFAULT_COALESCE_GAP;
+module.exports.READ_REQUEST_HEADER_LENGTH = READ_REQUEST_HEADER_LENGTH;
+module.exports.READ_REQUEST_ITEM_LENGTH = READ_REQUEST_ITEM_LENGTH;
+module.exports.READ_RESPONSE_HEADER_LENGTH = READ_RESPONSE_HEADER_LENGTH;
+module.exports.READ_RESPONSE_ITEM_LENGTH = READ_RESPONSE_ITEM_LENGTH;
+module.exports.WRITE_REQUEST_HEADER_LENGTH = WRITE_REQUEST_HEADER_LENGTH;
+module.exports.WRITE_REQUEST_ITEM_LENGTH = WRITE_REQUEST_ITEM_LENGTH;
+module.exports.WRITE_RESPONSE_HEADER_LENGTH = WRITE_RESPONSE_HEADER_LENGTH;
+module.exports.WRITE_RESPONSE_ITEM_LENGTH = WRITE_RESPONSE_ITEM_LENGTH;
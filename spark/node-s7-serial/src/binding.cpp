@@ -3,10 +3,14 @@
 #include <node.h>
 #include <nan.h>
 #include <node_object_wrap.h>
+#include <vector>
+#include <math.h>
+#include <string.h>
 
 extern "C" {
     #include "nodavesimple.h"
     #include "setport.h"
+    #include "openSocket.h"
 }
 
 #include "context_object.h"
@@ -21,8 +25,6 @@ using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
-using Nan::AsyncQueueWorker;
-using Nan::AsyncWorker;
 using Nan::Callback;
 using Nan::New;
 using Nan::Null;
@@ -44,17 +46,44 @@ using Nan::To;
 // memory area
 #define S7_200_AREA_C    0x1E
 #define S7_200_AREA_T    0x1F
+#define S7_300_AREA_C    0x1C
+#define S7_300_AREA_T    0x1D
+
+// return code for an exchange attempted without a connection to the plc
+#define NOT_CONNECTED    -1
+
+// decode descriptor: result index, byte offset, bit offset, data type, data format, memory area
+#define DESCRIPTOR_FIELDS 6
+// read item: data type, memory area, block index, start address, length
+#define ITEM_FIELDS       5
 
 void Method_CreateContext(const FunctionCallbackInfo<Value>& args) {
   ContextObject::NewInstance(args);
 }
 
+/******************************************************************************
+*
+*  Function: 			QueueWorker()
+*  Parameters: contextHandle -- context object
+*              worker        -- worker to run on the context's I/O thread
+*
+*  The worker keeps the context alive until it has completed.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+static void QueueWorker(Local<Value> contextHandle, QueuedWorker* worker) {
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(contextHandle->ToObject());
+  worker->SaveToPersistent("context", contextHandle);
+  context->getCommandQueue()->Queue(worker);
+}
+
 
-class ConnectPPIWorker : public AsyncWorker {
+class ConnectPPIWorker : public QueuedWorker {
 
     public:
-        ConnectPPIWorker(Callback *callback, ContextObject* context, std::string device, std::string baudRate, std::string parity, int localAddress, int plcAddress )
-        : AsyncWorker(callback)
+        ConnectPPIWorker(Callback *callback, ContextObject* context, std::string device, std::string baudRate, std::string parity, int localAddress, int plcAddress, int turnaroundMode, int turnaroundDelay )
+        : QueuedWorker(callback)
         {
             localContext = context;
             localDevice = device;
@@ -62,6 +91,8 @@ class ConnectPPIWorker : public AsyncWorker {
             localParity = parity;
             localLocalAddress = localAddress;
             localPlcAddress = plcAddress;
+            localTurnaroundMode = turnaroundMode;
+            localTurnaroundDelay = turnaroundDelay;
         }
 
         ~ConnectPPIWorker() {}
@@ -72,10 +103,14 @@ class ConnectPPIWorker : public AsyncWorker {
         // should go on `this`.
         void Execute () {
 
+            // keep the subscription thread off the connection while it is being set up
+            localContext->lock(this);
+
             // initialize the flags
             localContext->setSerialStatus(-1);
             localContext->setInitializationStatus(-1);
             localContext->setConnectionStatus(-1);
+            localContext->forgetSession();
 
             //printf("ConnectPPIWorker: Calling setPort for %s : Baud %s Parity %c \n",localDevice.c_str(), localBaudRate.c_str(), localParity.c_str()[0]);
 
@@ -91,6 +126,9 @@ class ConnectPPIWorker : public AsyncWorker {
                 localContext->setInitializationStatus(0); // no need for initialization for ppi
                 //daveSetTimeout(di, 5000000);
 
+                // time the poll for the response from the line speed rather than always waiting 20ms
+                daveSetPPITurnaround(di, localTurnaroundMode, atoi(localBaudRate.c_str()), localTurnaroundDelay);
+
                 //printf("ConnectPPIWorker: Calling daveNewConnection\n");
                 daveConnection *dc = daveNewConnection(di, localPlcAddress, 0, 0);
                 localContext->setDaveConnection(dc);
@@ -105,10 +143,14 @@ class ConnectPPIWorker : public AsyncWorker {
                     daveDisconnectAdapter(di);
                     daveFree(di);
                     closePort(fds->rfd);
+                } else {
+                    localContext->rememberSession(localPlcAddress, 0, 0);
                 }
             } else {
                 //printf("ConnectPPIWorker: FAILED TO CONNECT SERIAL PORT\n");
             }
+
+            localContext->unlock();
         }
 
         // Executed when the async work is complete
@@ -144,6 +186,8 @@ class ConnectPPIWorker : public AsyncWorker {
         std::string localParity;
         int localLocalAddress;
         int localPlcAddress;
+        int localTurnaroundMode;
+        int localTurnaroundDelay;
 };
 
 /******************************************************************************
@@ -156,7 +200,9 @@ class ConnectPPIWorker : public AsyncWorker {
 *			   info[3] -- string  serialParity
 *			   info[4] -- number  localAddress
 *			   info[5] -- number  plcAddress
-*              info[6] -- ASync Callback
+*			   info[6] -- number  turnaroundMode (fixed, frame or adaptive)
+*			   info[7] -- number  turnaroundDelay in microseconds for fixed mode (-1 for the default)
+*              info[8] -- ASync Callback
 *
 *  Returns: Nothing.
 *
@@ -164,13 +210,13 @@ class ConnectPPIWorker : public AsyncWorker {
 NAN_METHOD(Method_ConnectPPI) {
 
   // Check the number of arguments passed.
-  if (info.Length() != 7)
+  if (info.Length() != 9)
   {
       Nan::ThrowTypeError("Wrong number of arguments");
       return;
   }
   // and their types
-  if (!info[0]->IsObject()||!info[1]->IsString()||!info[2]->IsString()||!info[3]->IsString()||!info[4]->IsNumber()||!info[5]->IsNumber()||!info[6]->IsObject()) {
+  if (!info[0]->IsObject()||!info[1]->IsString()||!info[2]->IsString()||!info[3]->IsString()||!info[4]->IsNumber()||!info[5]->IsNumber()||!info[6]->IsNumber()||!info[7]->IsNumber()||!info[8]->IsObject()) {
       Nan::ThrowTypeError("One or more arguments of the wrong type");
       return;
   }
@@ -188,25 +234,28 @@ NAN_METHOD(Method_ConnectPPI) {
 
   int localAddress = (int)info[4]->NumberValue();
   int plcAddress = (int)info[5]->NumberValue();
+  int turnaroundMode = (int)info[6]->NumberValue();
+  int turnaroundDelay = (int)info[7]->NumberValue();
 
-  Callback *callback = new Callback(info[6].As<v8::Function>());
+  Callback *callback = new Callback(info[8].As<v8::Function>());
 
-  AsyncQueueWorker(new ConnectPPIWorker(callback, context, device, baudRate, parity, localAddress, plcAddress));
+  QueueWorker(info[0], new ConnectPPIWorker(callback, context, device, baudRate, parity, localAddress, plcAddress, turnaroundMode, turnaroundDelay));
 }
 
 
 
-class ConnectMPIWorker : public AsyncWorker {
+class ConnectMPIWorker : public QueuedWorker {
 
     public:
         ConnectMPIWorker(Callback *callback, ContextObject* context, std::string device, std::string baudRate, std::string parity, int mpiMode, int mpiSpeed, int localAddress, int plcAddress )
-        : AsyncWorker(callback)
+        : QueuedWorker(callback)
         {
             localContext = context;
             localDevice = device;
             localBaudRate = baudRate;
             localParity = parity;
             localMpiMode = mpiMode;
+            localMpiSpeed = mpiSpeed;
             localLocalAddress = localAddress;
             localPlcAddress = plcAddress;
         }
@@ -219,6 +268,9 @@ class ConnectMPIWorker : public AsyncWorker {
         // should go on `this`.
         void Execute () {
 
+            // keep the subscription thread off the connection while it is being set up
+            localContext->lock(this);
+
             // initialize the flags
             int initializationStatus = -1;
             int connectionStatus = -1;
@@ -226,6 +278,7 @@ class ConnectMPIWorker : public AsyncWorker {
             localContext->setSerialStatus(serialStatus);
             localContext->setInitializationStatus(initializationStatus);
             localContext->setConnectionStatus(connectionStatus);
+            localContext->forgetSession();
 
             daveInterface* di;
             daveConnection *dc;
@@ -263,6 +316,8 @@ class ConnectMPIWorker : public AsyncWorker {
                         daveDisconnectAdapter(di);
                         daveFree(di);
                         closePort(fds->rfd);
+                    } else {
+                        localContext->rememberSession(localPlcAddress, 0, 0);
                     }
                 } else {
                     //printf("ConnectMPIWorker: Initialization attempt failed. Calling daveDisconnectAdapter\n");
@@ -272,6 +327,8 @@ class ConnectMPIWorker : public AsyncWorker {
             } else {
                 //printf("ConnectMPIWorker: FAILED TO CONNECT SERIAL PORT\n");
             }
+
+            localContext->unlock();
         }
 
         // Executed when the async work is complete
@@ -362,19 +419,25 @@ NAN_METHOD(Method_ConnectMPI) {
 
   Callback *callback = new Callback(info[8].As<v8::Function>());
 
-  AsyncQueueWorker(new ConnectMPIWorker(callback, context, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress));
+  QueueWorker(info[0], new ConnectMPIWorker(callback, context, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress));
 }
 
 
-class DisconnectWorker : public AsyncWorker {
+class ConnectTCPWorker : public QueuedWorker {
 
     public:
-        DisconnectWorker(Callback *callback, ContextObject* context)
-        : AsyncWorker(callback) {
+        ConnectTCPWorker(Callback *callback, ContextObject* context, std::string host, int port, int rack, int slot, int parallelJobs)
+        : QueuedWorker(callback)
+        {
             localContext = context;
+            localHost = host;
+            localPort = port;
+            localRack = rack;
+            localSlot = slot;
+            localParallelJobs = parallelJobs;
         }
 
-        ~DisconnectWorker() {}
+        ~ConnectTCPWorker() {}
 
         // Executed inside the worker-thread.
         // It is not safe to access V8, or V8 data structures
@@ -382,176 +445,147 @@ class DisconnectWorker : public AsyncWorker {
         // should go on `this`.
         void Execute () {
 
-            // if connected successfuly, disconnect plc
-            if (localContext->getConnectionStatus() == 0) {
-                //printf("DisconnectWorker: calling daveDisconnectPLC and daveFree\n");
-                daveConnection* dc = localContext->getDaveConnection();
-                daveDisconnectPLC(dc);
-                daveFree(dc);
-                localContext->setConnectionStatus(-1);
-            }
+            // keep the subscription thread off the connection while it is being set up
+            localContext->lock(this);
 
-            // if initialized successfuly, disconnect adapter
-            if(localContext->getInitializationStatus() == 0 ) {
-                //printf("DisconnectWorker: calling daveDisconnectAdapter and daveFree\n");
-                daveInterface* di = localContext->getDaveInterface();
-                daveDisconnectAdapter(di);
-            	daveFree(di);
-                localContext->setInitializationStatus(-1);
-            }
+            // initialize the flags
+            localContext->setSerialStatus(-1);
+            localContext->setInitializationStatus(-1);
+            localContext->setConnectionStatus(-1);
+            localContext->forgetSession();
 
-            // if serial connection active, close it
-            if(localContext->getSerialStatus() == 0 ) {
-                //printf("DisconnectWorker: calling closePort\n");
-                _daveOSserialType* fds = localContext->getDaveOSserialType();
-                closePort(fds->rfd);
-                localContext->setSerialStatus(-1);
+            // the socket takes the place of the serial port, disconnect closes it the same way
+            _daveOSserialType* fds = localContext->getDaveOSserialType();
+            fds->rfd = openSocket(localPort, localHost.c_str());
+            fds->wfd = fds->rfd;
+            localSocketStatus = (fds->rfd > 0) ? 0 : -1;
+            if (localSocketStatus == 0) {
+                localContext->setSerialStatus(0);
+
+                daveInterface* di = daveNewInterface(localContext->getDaveOSserialTypeObj(), (char*)"IF1", 0, daveProtoISOTCP, daveSpeed187k);
+                localContext->setDaveInterface(di);
+                localContext->setInitializationStatus(0); // no adapter to initialize for iso over tcp
+
+                daveConnection *dc = daveNewConnection(di, 2, localRack, localSlot);
+                localContext->setDaveConnection(dc);
+
+                // ask for as many jobs in flight as we would like, the PLC may offer fewer
+                daveSetMaxParallelJobs(dc, localParallelJobs);
+
+                int connectionStatus = daveConnectPLC(dc);  // 0 == success
+                localContext->setConnectionStatus(connectionStatus);
+                if (connectionStatus != 0) {
+                    // nothing left for disconnect to close
+                    daveFree(dc);
+                    daveFree(di);
+                    closePort(fds->rfd);
+                    localContext->setInitializationStatus(-1);
+                    localContext->setSerialStatus(-1);
+                } else {
+                    localContext->rememberSession(2, localRack, localSlot);
+                }
             }
+
+            localContext->unlock();
         }
 
         // Executed when the async work is complete
         // this function will be run inside the main event loop
         // so it is safe to use V8 again
         void HandleOKCallback () {
-            //printf("DisconnectWorker: HandleOKCallback\n");
 
-            Local<Value> argv[] = {
-                Null(),
-                Null()
-            };
-            callback->Call(2, argv);
+            int connectionStatus = localContext->getConnectionStatus();
+
+            if ((localSocketStatus == 0) && (connectionStatus == 0)){
+                Local<Value> argv[] = {
+                    Null(),
+                    Null()
+                };
+                callback->Call(2, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Connecting over ISO TCP. Return codes: Socket = %i Connection = %i\n", localSocketStatus, connectionStatus);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null()
+                };
+                callback->Call(2, argv);
+            }
         }
 
     private:
         ContextObject* localContext;
-
+        std::string localHost;
+        int localPort;
+        int localRack;
+        int localSlot;
+        int localParallelJobs;
+        int localSocketStatus;
 };
 
 /******************************************************************************
 *
-*  Function: 			Method_Disconnect()
+*  Function: 			Method_ConnectTCP()
 *  Sync/Async:			ASync
 *  Parameters: info[0] -- context object
-*              info[1] -- ASync Callback
+*              info[1] -- string  host name or IP address
+*              info[2] -- number  port (102 for ISO over TCP)
+*			   info[3] -- number  rack
+*			   info[4] -- number  slot
+*			   info[5] -- number  parallel jobs to ask for, 1 for stop and wait
+*              info[6] -- ASync Callback
 *
 *  Returns: Nothing.
 *
 ******************************************************************************/
-NAN_METHOD(Method_Disconnect) {
+NAN_METHOD(Method_ConnectTCP) {
 
   // Check the number of arguments passed.
-  if (info.Length() != 2)
+  if (info.Length() != 7)
   {
       Nan::ThrowTypeError("Wrong number of arguments");
       return;
   }
   // and their types
-  if (!info[0]->IsObject() || !info[1]->IsObject()) {
+  if (!info[0]->IsObject()||!info[1]->IsString()||!info[2]->IsNumber()||!info[3]->IsNumber()||!info[4]->IsNumber()||!info[5]->IsNumber()||!info[6]->IsObject()) {
       Nan::ThrowTypeError("One or more arguments of the wrong type");
       return;
   }
 
   ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-  Callback *callback = new Callback(info[1].As<v8::Function>());
-
-  AsyncQueueWorker(new DisconnectWorker(callback, context));
-}
-
-
-
-
-/******************************************************************************
-*
-*  Function: 			Method_PrepareReadRequest()
-*  Sync/Async:			Synchronous
-*  Parameters: info[0] -- context object
-*
-*  Returns: Nothing.
-*
-******************************************************************************/
-NAN_METHOD(Method_PrepareReadRequest) {
-
-    // Check the number of arguments passed.
-    if (info.Length() != 1)
-    {
-        Nan::ThrowTypeError("Wrong number of arguments");
-        return;
-    }
-    // and their types
-    if (!info[0]->IsObject()) {
-        Nan::ThrowTypeError("One or more arguments of the wrong type");
-        return;
-    }
-
-    // get necessary context
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    PDU* p = context->getPDU();
-    daveConnection* dc = context->getDaveConnection();
-
-    //printf("PrepareReadRequest: calling davePrepareReadRequest\n");
-    davePrepareReadRequest(dc, p);
-}
-
-/******************************************************************************
-*
-*  Function: 			Method_AddVarToRequest()
-*  Sync/Async:			Synchronous
-*  Parameters: info[0] -- context object
-*              info[1] -- number  data type to read
-*              info[2] -- number  memory area
-*			   info[3] -- number  block index
-*			   info[4] -- number  start address
-*			   info[5] -- number  length
-*
-*  Returns: Nothing.
-*
-******************************************************************************/
-NAN_METHOD(Method_AddVarToRequest) {
 
-    // Check the number of arguments passed.
-    if (info.Length() != 6)
-    {
-        Nan::ThrowTypeError("Wrong number of arguments");
-        return;
-    }
-    // and their types
-    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber() || !info[5]->IsNumber()) {
-        Nan::ThrowTypeError("One or more arguments of the wrong type");
-        return;
-    }
+  v8::String::Utf8Value arg0(info[1]->ToString());
+  std::string host = std::string(*arg0);
 
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    int dataType = (int)info[1]->NumberValue();
-    int memoryArea = (int)info[2]->NumberValue();
-    int blockIndex = (int)info[3]->NumberValue();
-    int startAddress = (int)info[4]->NumberValue();
-    int length = (int)info[5]->NumberValue();
+  int port = (int)info[2]->NumberValue();
+  int rack = (int)info[3]->NumberValue();
+  int slot = (int)info[4]->NumberValue();
+  int parallelJobs = (int)info[5]->NumberValue();
 
-    // get necessary context
-    PDU* p = context->getPDU();
+  Callback *callback = new Callback(info[6].As<v8::Function>());
 
-    if( dataType == READ_BIT) {
-        //printf("AddVarToRequest: calling daveAddBitVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
-        daveAddBitVarToReadRequest(p, memoryArea, blockIndex, startAddress, length);
-    } else {
-        //printf("AddVarToRequest: calling daveAddVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
-        daveAddVarToReadRequest(p, memoryArea, blockIndex, startAddress, length);
-    }
+  QueueWorker(info[0], new ConnectTCPWorker(callback, context, host, port, rack, slot, parallelJobs));
 }
 
 
-class ExecReadRequestWorker : public AsyncWorker {
+class ConnectNetLinkWorker : public QueuedWorker {
 
     public:
-        ExecReadRequestWorker(Callback *callback, ContextObject* context)
-        : AsyncWorker(callback) {
-            // get necessary context
-            dc = context->getDaveConnection();
-            p = context->getPDU();
-            rs = context->getDaveResultSet();
+        ConnectNetLinkWorker(Callback *callback, ContextObject* context, std::string host, int port, int protocol, int mpiSpeed, int localAddress, int plcAddress, int rack, int slot)
+        : QueuedWorker(callback)
+        {
+            localContext = context;
+            localHost = host;
+            localPort = port;
+            localProtocol = protocol;
+            localMpiSpeed = mpiSpeed;
+            localLocalAddress = localAddress;
+            localPlcAddress = plcAddress;
+            localRack = rack;
+            localSlot = slot;
         }
 
-        ~ExecReadRequestWorker() {}
+        ~ConnectNetLinkWorker() {}
 
         // Executed inside the worker-thread.
         // It is not safe to access V8, or V8 data structures
@@ -559,17 +593,66 @@ class ExecReadRequestWorker : public AsyncWorker {
         // should go on `this`.
         void Execute () {
 
-            //printf("ExecReadRequestWorker: calling daveExecReadRequest\n");
-            result = daveExecReadRequest(dc, p, rs);
+            // keep the subscription thread off the connection while it is being set up
+            localContext->lock(this);
+
+            // initialize the flags
+            int initializationStatus = -1;
+            int connectionStatus = -1;
+            localContext->setSerialStatus(-1);
+            localContext->setInitializationStatus(initializationStatus);
+            localContext->setConnectionStatus(connectionStatus);
+            localContext->forgetSession();
+
+            // the socket to the gateway takes the place of the serial port, disconnect closes it the same way
+            _daveOSserialType* fds = localContext->getDaveOSserialType();
+            fds->rfd = openSocket(localPort, localHost.c_str());
+            fds->wfd = fds->rfd;
+            localSocketStatus = (fds->rfd > 0) ? 0 : -1;
+            if (localSocketStatus == 0) {
+                localContext->setSerialStatus(0);
+
+                daveInterface* di = daveNewInterface(localContext->getDaveOSserialTypeObj(), (char*)"IF1", localLocalAddress, localProtocol, localMpiSpeed);
+                localContext->setDaveInterface(di);
+                daveSetTimeout(di, 5000000);
+
+                initializationStatus = daveInitAdapter(di); // 0 == success
+                localContext->setInitializationStatus(initializationStatus);
+
+                if (initializationStatus == 0) {
+                    daveConnection *dc = daveNewConnection(di, localPlcAddress, localRack, localSlot);
+                    localContext->setDaveConnection(dc);
+
+                    connectionStatus = daveConnectPLC(dc);  // 0 == success
+                    localContext->setConnectionStatus(connectionStatus);
+                    if (connectionStatus != 0) {
+                        daveFree(dc);
+                        daveDisconnectAdapter(di);
+                    } else {
+                        localContext->rememberSession(localPlcAddress, localRack, localSlot);
+                    }
+                }
+
+                if ((initializationStatus != 0) || (connectionStatus != 0)) {
+                    // nothing left for disconnect to close
+                    daveFree(di);
+                    closePort(fds->rfd);
+                    localContext->setInitializationStatus(-1);
+                    localContext->setSerialStatus(-1);
+                }
+            }
+
+            localContext->unlock();
         }
 
         // Executed when the async work is complete
         // this function will be run inside the main event loop
         // so it is safe to use V8 again
         void HandleOKCallback () {
-            //printf("ExecReadRequestWorker: HandleOKCallback Result %d\n" , result);
 
-            if (result == daveResOK) {
+            int connectionStatus = localContext->getConnectionStatus();
+
+            if ((localSocketStatus == 0) && (connectionStatus == 0)){
                 Local<Value> argv[] = {
                     Null(),
                     Null()
@@ -577,7 +660,7 @@ class ExecReadRequestWorker : public AsyncWorker {
                 callback->Call(2, argv);
             } else {
                 char errorMsg[200];
-                sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", result);
+                sprintf(errorMsg,"Error Connecting over NetLink gateway. Return codes: Socket = %i Connection = %i\n", localSocketStatus, connectionStatus);
                 Local<Value> argv[] = {
                     Nan::Error(errorMsg),
                     Null()
@@ -587,166 +670,400 @@ class ExecReadRequestWorker : public AsyncWorker {
         }
 
     private:
-        daveConnection* dc;
-        PDU* p;
-        daveResultSet* rs;
-        int result;
+        ContextObject* localContext;
+        std::string localHost;
+        int localPort;
+        int localProtocol;
+        int localMpiSpeed;
+        int localLocalAddress;
+        int localPlcAddress;
+        int localRack;
+        int localSlot;
+        int localSocketStatus;
 };
 
 /******************************************************************************
 *
-*  Function: 			Method_ExecReadRequest()
+*  Function: 			Method_ConnectNetLink()
 *  Sync/Async:			ASync
 *  Parameters: info[0] -- context object
-*              info[1] -- ASync Callback
+*              info[1] -- string  gateway host name or IP address
+*              info[2] -- number  port (1099 for IBH NetLink, 7777 for NetLink Pro)
+*			   info[3] -- number  protocol (daveProtoMPI_IBH, daveProtoPPI_IBH or daveProtoNLpro)
+*			   info[4] -- number  mpiSpeed
+*			   info[5] -- number  localAddress
+*			   info[6] -- number  plcAddress
+*			   info[7] -- number  rack
+*			   info[8] -- number  slot
+*              info[9] -- ASync Callback
 *
 *  Returns: Nothing.
 *
 ******************************************************************************/
-NAN_METHOD(Method_ExecReadRequest) {
+NAN_METHOD(Method_ConnectNetLink) {
 
   // Check the number of arguments passed.
-  if (info.Length() != 2)
+  if (info.Length() != 10)
   {
       Nan::ThrowTypeError("Wrong number of arguments");
       return;
   }
   // and their types
-  if (!info[0]->IsObject() || !info[1]->IsObject()) {
+  if (!info[0]->IsObject()||!info[1]->IsString()||!info[2]->IsNumber()||!info[3]->IsNumber()||!info[4]->IsNumber()||!info[5]->IsNumber()||!info[6]->IsNumber()||!info[7]->IsNumber()||!info[8]->IsNumber()||!info[9]->IsObject()) {
       Nan::ThrowTypeError("One or more arguments of the wrong type");
       return;
   }
 
+  int protocol = (int)info[3]->NumberValue();
+  if ((protocol != daveProtoMPI_IBH) && (protocol != daveProtoPPI_IBH) && (protocol != daveProtoNLpro)) {
+      Nan::ThrowRangeError("Not a NetLink protocol");
+      return;
+  }
+
   ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-  Callback *callback = new Callback(info[1].As<v8::Function>());
 
-  AsyncQueueWorker(new ExecReadRequestWorker(callback, context));
+  v8::String::Utf8Value arg0(info[1]->ToString());
+  std::string host = std::string(*arg0);
+
+  int port = (int)info[2]->NumberValue();
+  int mpiSpeed = (int)info[4]->NumberValue();
+  int localAddress = (int)info[5]->NumberValue();
+  int plcAddress = (int)info[6]->NumberValue();
+  int rack = (int)info[7]->NumberValue();
+  int slot = (int)info[8]->NumberValue();
+
+  Callback *callback = new Callback(info[9].As<v8::Function>());
+
+  QueueWorker(info[0], new ConnectNetLinkWorker(callback, context, host, port, protocol, mpiSpeed, localAddress, plcAddress, rack, slot));
 }
 
 
+class DisconnectWorker : public QueuedWorker {
 
-/******************************************************************************
-*
-*  Function: 			Method_GetResult()
-*  Sync/Async:			Synchronous
+    public:
+        DisconnectWorker(Callback *callback, ContextObject* context)
+        : QueuedWorker(callback) {
+            localContext = context;
+        }
+
+        ~DisconnectWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            // wait for any exchange in progress, a subscription finds the connection gone afterwards
+            localContext->lock(this);
+
+            // the session ends here, a reconnect has nothing to resume
+            localContext->forgetSession();
+            localContext->clearCarriedLinkStats();
+
+            // if connected successfuly, disconnect plc
+            if (localContext->getConnectionStatus() == 0) {
+                //printf("DisconnectWorker: calling daveDisconnectPLC and daveFree\n");
+                daveConnection* dc = localContext->getDaveConnection();
+                daveDisconnectPLC(dc);
+                daveFree(dc);
+                localContext->setConnectionStatus(-1);
+            }
+
+            // if initialized successfuly, disconnect adapter
+            if(localContext->getInitializationStatus() == 0 ) {
+                //printf("DisconnectWorker: calling daveDisconnectAdapter and daveFree\n");
+                daveInterface* di = localContext->getDaveInterface();
+                daveDisconnectAdapter(di);
+            	daveFree(di);
+                localContext->setInitializationStatus(-1);
+            }
+
+            // if serial connection active, close it
+            if(localContext->getSerialStatus() == 0 ) {
+                //printf("DisconnectWorker: calling closePort\n");
+                _daveOSserialType* fds = localContext->getDaveOSserialType();
+                closePort(fds->rfd);
+                localContext->setSerialStatus(-1);
+            }
+
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+            //printf("DisconnectWorker: HandleOKCallback\n");
+
+            Local<Value> argv[] = {
+                Null(),
+                Null()
+            };
+            callback->Call(2, argv);
+        }
+
+    private:
+        ContextObject* localContext;
+
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_Disconnect()
+*  Sync/Async:			ASync
 *  Parameters: info[0] -- context object
-*              info[1] -- number  index
-*              info[2] -- number  data type to read
-*              info[3] -- number  data format to read
+*              info[1] -- ASync Callback
 *
-*  Returns: Indexed result or null.
+*  Returns: Nothing.
 *
 ******************************************************************************/
-NAN_METHOD(Method_GetResult) {
+NAN_METHOD(Method_Disconnect) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 2)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+  Callback *callback = new Callback(info[1].As<v8::Function>());
+
+  QueueWorker(info[0], new DisconnectWorker(callback, context));
+}
+
+
+// how far a reconnect had to go back
+#define RESUMED_CONNECTION 1   // only the PLC connection was set up again
+#define RESUMED_ADAPTER    2   // the adapter was initialized again too
+
+/*
+    Set the PLC connection up again on the interface that is still open, with
+    the parameters remembered from the last connect. A new S7 connection has to
+    be set up with the PDU length request, but it asks for exactly the PDU length
+    and jobs the PLC agreed to last time, so it settles at once on the values the
+    read plan was built for. Called with the context locked.
+*/
+static int ResumeConnection(ContextObject* context) {
+
+    const SessionParameters* session = context->getSession();
+    daveConnection* dc = daveNewConnection(context->getDaveInterface(), session->plcAddress, session->rack, session->slot);
+    // the PDU length request is built from these
+    dc->maxPDUlength = session->maxPDULength;
+    daveSetMaxParallelJobs(dc, session->parallelJobs);
+
+    int connectionStatus = daveConnectPLC(dc);  // 0 == success
+    if (connectionStatus == 0) {
+        context->setDaveConnection(dc);
+    } else {
+        daveFree(dc);
+    }
+    context->setConnectionStatus(connectionStatus);
+    return connectionStatus;
+}
+
+
+class ReconnectWorker : public QueuedWorker {
+
+    public:
+        ReconnectWorker(Callback *callback, ContextObject* context)
+        : QueuedWorker(callback) {
+            localContext = context;
+        }
+
+        ~ReconnectWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            // a subscription finds the new connection on its next cycle
+            localContext->lock(this);
+
+            result = NOT_CONNECTED;
+            level = 0;
+
+            // without an open port and interface from a successful connect there is nothing to resume
+            if (localContext->getSession()->valid && (localContext->getSerialStatus() == 0) && (localContext->getInitializationStatus() == 0)) {
+
+                // drop the old PLC connection, keeping its link statistics
+                localContext->carryLinkStats();
+                if (localContext->getConnectionStatus() == 0) {
+                    daveConnection* dc = localContext->getDaveConnection();
+                    daveDisconnectPLC(dc);
+                    daveFree(dc);
+                    localContext->setConnectionStatus(-1);
+                }
+
+                level = RESUMED_CONNECTION;
+                result = ResumeConnection(localContext);
+
+                // the adapter may have lost its state as well, e.g. after a power cycle of the PLC.
+                // Its interface stays allocated either way, so disconnect still frees it
+                if (result != 0) {
+                    daveInterface* di = localContext->getDaveInterface();
+                    daveDisconnectAdapter(di);
+                    level = RESUMED_ADAPTER;
+                    result = daveInitAdapter(di);
+                    if (result == 0) {
+                        result = ResumeConnection(localContext);
+                    }
+                }
+            }
+
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+
+            if (result == 0) {
+                Local<Value> argv[] = {
+                    Null(),
+                    Nan::New<v8::Integer>(level)
+                };
+                callback->Call(2, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Reconnecting. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Nan::New<v8::Integer>(level)
+                };
+                callback->Call(2, argv);
+            }
+        }
+
+    private:
+        ContextObject* localContext;
+        int result;
+        int level;
+
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_Reconnect()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- ASync Callback, called with an error or null and how
+*                         far it went back: 1 for the PLC connection alone, 2
+*                         when the adapter was initialized again too
+*
+*  Sets up the PLC connection again on the port and adapter that are still
+*  open. It fails with NOT_CONNECTED when there is nothing to resume, and
+*  otherwise with the error of the last step tried; the caller then has to
+*  disconnect and connect from scratch.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_Reconnect) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 2)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject()||!info[1]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  Callback *callback = new Callback(info[1].As<v8::Function>());
+
+  QueueWorker(info[0], new ReconnectWorker(callback, context));
+}
+
+
+
+
+/******************************************************************************
+*
+*  Function: 			Method_GetMaxPDULength()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: PDU length negotiated with the PLC.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetMaxPDULength) {
 
     // Check the number of arguments passed.
-    if (info.Length() != 5)
+    if (info.Length() != 1)
     {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
     // and their types
-    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber()) {
+    if (!info[0]->IsObject()) {
         Nan::ThrowTypeError("One or more arguments of the wrong type");
         return;
     }
 
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    int index = (int)info[1]->NumberValue();
-    int readType = (int)info[2]->NumberValue();
-    int readFormat = (int)info[3]->NumberValue();
-    int readMemoryArea = (int)info[4]->NumberValue();
-
     // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
     daveConnection* dc = context->getDaveConnection();
-    daveResultSet* rs = context->getDaveResultSet();
 
-    int result = 0;
-    float resultFloat = 0.0;
-    //printf("GetResult: daveUseResult for Index %d With Read Type %d and format %d \n", index, readType, readFormat);
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(daveGetMaxPDULen(dc)));
+}
 
-    // point to the correct result using the passed in index
-    int res = daveUseResult(dc, rs, index);
-    // if result exists
-    if (res == 0) {
-        // get based on type (should handle the conversion from bigendian to little endian where applicable)
-        if(readType == READ_BIT) {
-            // get bit as an unsigned 8 bit and convert to bool
-            result = daveGetU8(dc);
-        } else if (readType == READ_BYTE) {
-            // get it as a Signed or unsigned 8 bit
-            result = (readFormat == FORMAT_SIGNED) ? daveGetS8(dc) : daveGetU8(dc);
-        } else if (readType == READ_WORD) {
-            if (readMemoryArea == S7_200_AREA_C) {
-                // for S7_200_AREA_C, we have discovered that the location of the data in the returned string is not in the
-                // expected position.  Normally we decode the result from the data immediately following the length bytes.  This is
-                // the location pointed to by dc->resultPointer.  For the following example:
-                // PACKET:              FF 09 00 06 00 12 34 00 00 00
-                //    length bytes:          <00 06>
-                //    dc->resultPointer             ^^
-                // however, the actual data value (0x1234) is actually 1 byte past this.  In the absense of confirming documentation,
-                // we have specultated that this due to status information before and after the actual data value.  Watching the
-                // same read request via a kepware client appears to show the availability of status information, but we cannot determine
-                // where it is in the packet.
-                // As such, we instead use daveGetxxAt routines to allow us to index to this location.
-                result = (readFormat == FORMAT_SIGNED) ? daveGetS16At(dc, 1) : daveGetU16At(dc, 1);
-            } else if (readMemoryArea == S7_200_AREA_T) {
-                // similar to S7_200_AREA_C, the S7_200_AREA_T memory area also returns its data in a different portion of the packet.
-                // the example for this value is:
-                // PACKET:              FF 09 00 0A 00 00 00 12 34 00 00 00 00 00
-                //    length bytes:          <00 06>
-                //    dc->resultPointer             ^^
-                // in this case, it appears that we need to add three bytes to get to the data location.  However, we are unable to
-                // load a value into the PLC for these registers larger than 16 bits.  It is possible that we still only need the
-                // 1-byte offset, and that the two zeros preceding the data are actually the high-order bytes of a 32-bit value.
-                // If this is true, however, other changes are required to this library, since it automatically forces any reads of
-                // S7_200_AREA_C and S7_200_AREA_T to be READ_WORD:
-                //      from 'NodeS7Serial.prototype.addItems' in 'spark/node-s7-serial/index.js':
-                //          // no read type included for the timers and counters, they are 16 bit accesses
-                // For now, leave as an index of 3, resulting in our always reading a 16-bit result for counters and timers.
-                result = (readFormat == FORMAT_SIGNED) ? daveGetS16At(dc, 3) : daveGetU16At(dc, 3);
-            } else {
-                result = (readFormat == FORMAT_SIGNED) ? daveGetS16(dc) : daveGetU16(dc);
-            }// get it as a Signed or unsigned 16 bit
-        } else if (readType == READ_DWORD) {
-            // get it as a Signed or unsigned 32 bit, or float
-            if( readFormat == FORMAT_SIGNED) {
-                result = daveGetS32(dc);
-            } else if (readFormat == FORMAT_UNSIGNED) {
-                result = daveGetU32(dc);
-            } else {
-                resultFloat = daveGetFloat(dc);
-            }
-        }
+/******************************************************************************
+*
+*  Function: 			Method_GetParallelJobs()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: Number of requests that may be in flight at once, as negotiated
+*           with the PLC. Only more than 1 on iso over tcp connections.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetParallelJobs) {
 
-        // convert it to applicable v8 type and set it as return value
-        if( readFormat == FORMAT_FLOAT) {
-            v8::Local<v8::Number> resultV8Float = Nan::New<v8::Number>(resultFloat);
-            info.GetReturnValue().Set(resultV8Float);
-        } else if( readFormat == FORMAT_BOOL) {
-            v8::Local<v8::Boolean> resultV8Bool = Nan::New<v8::Boolean>((bool)(result > 0));
-            info.GetReturnValue().Set(resultV8Bool);
-        } else {
-            v8::Local<v8::Integer> resultV8Int = Nan::New<v8::Integer>(result);
-            info.GetReturnValue().Set(resultV8Int);
-        }
-    } else {
-        // if no value, create a v8 null and set it as the return value
-        v8::Local<v8::Primitive> returnNull = Nan::Null();
-        info.GetReturnValue().Set(returnNull);
+    // Check the number of arguments passed.
+    if (info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
     }
+    // and their types
+    if (!info[0]->IsObject()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    daveConnection* dc = context->getDaveConnection();
+
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(daveGetMaxParallelJobs(dc)));
 }
 
 /******************************************************************************
 *
-*  Function: 			Method_FreeResults()
+*  Function: 			Method_GetPPIStats()
 *  Sync/Async:			Synchronous
 *  Parameters: info[0] -- context object
 *
-*  Returns: Nothing.
+*  Returns: Object with the PPI retry counters and the last turnaround delay.
 *
 ******************************************************************************/
-NAN_METHOD(Method_FreeResults) {
+NAN_METHOD(Method_GetPPIStats) {
+
     // Check the number of arguments passed.
     if (info.Length() != 1)
     {
@@ -759,102 +1076,1579 @@ NAN_METHOD(Method_FreeResults) {
         return;
     }
 
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    daveInterface* di = context->getDaveInterface();
+
+    int secondTries, thirdTries, pollRetries;
+    daveGetPPIRetries(di, &secondTries, &thirdTries, &pollRetries);
+
+    v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+    Nan::Set(stats, Nan::New("secondTries").ToLocalChecked(), Nan::New<v8::Integer>(secondTries));
+    Nan::Set(stats, Nan::New("thirdTries").ToLocalChecked(), Nan::New<v8::Integer>(thirdTries));
+    Nan::Set(stats, Nan::New("pollRetries").ToLocalChecked(), Nan::New<v8::Integer>(pollRetries));
+    Nan::Set(stats, Nan::New("turnaroundDelay").ToLocalChecked(), Nan::New<v8::Integer>(daveGetPPITurnaround(di)));
+    info.GetReturnValue().Set(stats);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_GetQueueStats()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: Object with the depth, capacity and wait times of the context's
+*           I/O thread command queue, and a classes array with the depth and
+*           queueing latency of each priority class (control, read, poll).
+*           A class's latency runs from queueing to getting the link.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetQueueStats) {
+
+    // Check the number of arguments passed.
+    if (info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+    CommandQueueStats queueStats;
+    context->getCommandQueue()->GetStats(&queueStats);
+
+    v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+    Nan::Set(stats, Nan::New("depth").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.depth));
+    Nan::Set(stats, Nan::New("maxDepth").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.maxDepth));
+    Nan::Set(stats, Nan::New("capacity").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.capacity));
+    Nan::Set(stats, Nan::New("executed").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.executed));
+    Nan::Set(stats, Nan::New("rejected").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.rejected));
+    Nan::Set(stats, Nan::New("waitTotalUs").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.waitTotalUs));
+    Nan::Set(stats, Nan::New("waitMaxUs").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.waitMaxUs));
+
+    static const char* classNames[PRIORITY_CLASSES] = { "control", "read", "poll" };
+    PriorityClassStats priorityStats[PRIORITY_CLASSES];
+    context->getPriorityStats(priorityStats);
+    v8::Local<v8::Array> classes = Nan::New<v8::Array>(PRIORITY_CLASSES);
+    for (int i = 0; i < PRIORITY_CLASSES; i++) {
+        v8::Local<v8::Object> classStats = Nan::New<v8::Object>();
+        Nan::Set(classStats, Nan::New("name").ToLocalChecked(), Nan::New(classNames[i]).ToLocalChecked());
+        Nan::Set(classStats, Nan::New("priority").ToLocalChecked(), Nan::New<v8::Integer>(i));
+        Nan::Set(classStats, Nan::New("depth").ToLocalChecked(), Nan::New<v8::Number>((double)queueStats.classDepth[i]));
+        Nan::Set(classStats, Nan::New("exchanges").ToLocalChecked(), Nan::New<v8::Number>((double)priorityStats[i].exchanges));
+        Nan::Set(classStats, Nan::New("waitTotalUs").ToLocalChecked(), Nan::New<v8::Number>((double)priorityStats[i].waitTotalUs));
+        Nan::Set(classStats, Nan::New("waitMaxUs").ToLocalChecked(), Nan::New<v8::Number>((double)priorityStats[i].waitMaxUs));
+        Nan::Set(classes, i, classStats);
+    }
+    Nan::Set(stats, Nan::New("classes").ToLocalChecked(), classes);
+    info.GetReturnValue().Set(stats);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_GetStats()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: Object with the link statistics of the connection: exchanges,
+*           errors, timeouts, PPI resends and E5 poll retries, checksum
+*           errors, PDUs and bytes sent and received, and the exchange
+*           latency as total, maximum and a histogram array whose entry i
+*           counts the exchanges shorter than latencyBucketUs[i], the last
+*           entry all longer ones.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetStats) {
+
+    // Check the number of arguments passed.
+    if (info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+    daveConnectionStats linkStats;
+    context->getLinkStats(&linkStats);
+
+    v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+    Nan::Set(stats, Nan::New("exchanges").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.exchanges));
+    Nan::Set(stats, Nan::New("errors").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.errors));
+    Nan::Set(stats, Nan::New("timeouts").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.timeouts));
+    Nan::Set(stats, Nan::New("resends").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.resends));
+    Nan::Set(stats, Nan::New("pollRetries").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.pollRetries));
+    Nan::Set(stats, Nan::New("checksumErrors").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.checksumErrors));
+    Nan::Set(stats, Nan::New("pdusSent").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.pdusSent));
+    Nan::Set(stats, Nan::New("pdusReceived").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.pdusReceived));
+    Nan::Set(stats, Nan::New("bytesSent").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.bytesSent));
+    Nan::Set(stats, Nan::New("bytesReceived").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.bytesReceived));
+    Nan::Set(stats, Nan::New("latencyTotalUs").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.latencyTotal));
+    Nan::Set(stats, Nan::New("latencyMaxUs").ToLocalChecked(), Nan::New<v8::Number>((double)linkStats.latencyMax));
+
+    // the last bucket has no upper bound, so there is one bound less than buckets
+    v8::Local<v8::Array> latency = Nan::New<v8::Array>(daveLatencyBuckets);
+    v8::Local<v8::Array> bucketUs = Nan::New<v8::Array>(daveLatencyBuckets - 1);
+    for (int i = 0; i < daveLatencyBuckets; i++) {
+        Nan::Set(latency, i, Nan::New<v8::Number>((double)linkStats.latency[i]));
+        if (i < daveLatencyBuckets - 1) {
+            Nan::Set(bucketUs, i, Nan::New<v8::Number>((double)(128UL << i)));
+        }
+    }
+    Nan::Set(stats, Nan::New("latency").ToLocalChecked(), latency);
+    Nan::Set(stats, Nan::New("latencyBucketUs").ToLocalChecked(), bucketUs);
+    info.GetReturnValue().Set(stats);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_PrepareReadRequest()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_PrepareReadRequest) {
+
+    // Check the number of arguments passed.
+    if (info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    // get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    PDU* p = context->getPDU();
+    daveConnection* dc = context->getDaveConnection();
+
+    //printf("PrepareReadRequest: calling davePrepareReadRequest\n");
+    davePrepareReadRequest(dc, p);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_AddVarToRequest()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*              info[1] -- number  data type to read
+*              info[2] -- number  memory area
+*			   info[3] -- number  block index
+*			   info[4] -- number  start address
+*			   info[5] -- number  length
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_AddVarToRequest) {
+
+    // Check the number of arguments passed.
+    if (info.Length() != 6)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber() || !info[5]->IsNumber()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    int dataType = (int)info[1]->NumberValue();
+    int memoryArea = (int)info[2]->NumberValue();
+    int blockIndex = (int)info[3]->NumberValue();
+    int startAddress = (int)info[4]->NumberValue();
+    int length = (int)info[5]->NumberValue();
+
+    // get necessary context
+    PDU* p = context->getPDU();
+
+    if( dataType == READ_BIT) {
+        //printf("AddVarToRequest: calling daveAddBitVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
+        daveAddBitVarToReadRequest(p, memoryArea, blockIndex, startAddress, length);
+    } else {
+        //printf("AddVarToRequest: calling daveAddVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
+        daveAddVarToReadRequest(p, memoryArea, blockIndex, startAddress, length);
+    }
+}
+
+
+class ExecReadRequestWorker : public QueuedWorker {
+
+    public:
+        ExecReadRequestWorker(Callback *callback, ContextObject* context)
+        : QueuedWorker(callback, PRIORITY_READ) {
+            // get necessary context
+            localContext = context;
+            dc = context->getDaveConnection();
+            p = context->getPDU();
+            rs = context->getDaveResultSet();
+        }
+
+        ~ExecReadRequestWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            //printf("ExecReadRequestWorker: calling daveExecReadRequestArena\n");
+            // results go in the connection's arena rather than being allocated per item, and are
+            // copied out of the receive buffer as getResult is called later from the event loop
+            localContext->lock(this);
+            result = daveExecReadRequestArena(dc, p, rs);
+            if (result == daveResOK) {
+                daveKeepResults(dc, rs);
+            }
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+            //printf("ExecReadRequestWorker: HandleOKCallback Result %d\n" , result);
+
+            if (result == daveResOK) {
+                Local<Value> argv[] = {
+                    Null(),
+                    Null()
+                };
+                callback->Call(2, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null()
+                };
+                callback->Call(2, argv);
+            }
+        }
+
+    private:
+        ContextObject* localContext;
+        daveConnection* dc;
+        PDU* p;
+        daveResultSet* rs;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ExecReadRequest()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- ASync Callback
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ExecReadRequest) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 2)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+  Callback *callback = new Callback(info[1].As<v8::Function>());
+
+  QueueWorker(info[0], new ExecReadRequestWorker(callback, context));
+}
+
+
+
+/******************************************************************************
+*
+*  Function: 			DecodeResult()
+*  Parameters: dc             -- connection the result set was read on
+*              rs             -- result set filled by daveExecReadRequest
+*              index          -- index of the result in the result set
+*              byteOffset     -- offset of the value within the result data
+*              bitOffset      -- bit within the byte at byteOffset for a bit
+*                                served from a byte read, or -1
+*              readType       -- data type that was read
+*              readFormat     -- data format to decode as
+*              readMemoryArea -- memory area that was read
+*              value          -- decoded value (only valid on success)
+*
+*  Returns: 0 on success, otherwise the error from daveUseResult.
+*
+*  Does not touch V8 so it is safe to call from a worker thread.
+*
+******************************************************************************/
+static int DecodeResult(daveConnection* dc, daveResultSet* rs, int index, int byteOffset, int bitOffset, int readType, int readFormat, int readMemoryArea, double* value) {
+
+    int result = 0;
+    float resultFloat = 0.0;
+    //printf("DecodeResult: daveUseResult for Index %d Offset %d With Read Type %d and format %d \n", index, byteOffset, readType, readFormat);
+
+    // point to the correct result using the passed in index
+    if (index < 0) {
+        return daveEmptyResultSetError;
+    }
+    int res = daveUseResult(dc, rs, index);
+    if (res != 0) {
+        return res;
+    }
+
+    // make sure the value lies within the returned data (matters when slicing coalesced reads)
+    int size = (readType == READ_WORD) ? 2 : ((readType == READ_DWORD) ? 4 : 1);
+    if ((readMemoryArea == S7_200_AREA_C) || (readMemoryArea == S7_200_AREA_T)) {
+        size += (readMemoryArea == S7_200_AREA_C) ? 1 : 3;
+    }
+    if (byteOffset + size > rs->results[index].length) {
+        return daveEmptyResultError;
+    }
+
+    // get based on type (should handle the conversion from bigendian to little endian where applicable)
+    if(readType == READ_BIT) {
+        if (bitOffset >= 0) {
+            // bit served from its containing byte
+            result = (daveGetU8At(dc, byteOffset) >> bitOffset) & 0x01;
+        } else {
+            // get bit as an unsigned 8 bit and convert to bool
+            result = daveGetU8At(dc, byteOffset);
+        }
+    } else if (readType == READ_BYTE) {
+        // get it as a Signed or unsigned 8 bit
+        result = (readFormat == FORMAT_SIGNED) ? daveGetS8At(dc, byteOffset) : daveGetU8At(dc, byteOffset);
+    } else if (readType == READ_WORD) {
+        if (readMemoryArea == S7_200_AREA_C) {
+            // for S7_200_AREA_C, we have discovered that the location of the data in the returned string is not in the
+            // expected position.  Normally we decode the result from the data immediately following the length bytes.  This is
+            // the location pointed to by dc->resultPointer.  For the following example:
+            // PACKET:              FF 09 00 06 00 12 34 00 00 00
+            //    length bytes:          <00 06>
+            //    dc->resultPointer             ^^
+            // however, the actual data value (0x1234) is actually 1 byte past this.  In the absense of confirming documentation,
+            // we have specultated that this due to status information before and after the actual data value.  Watching the
+            // same read request via a kepware client appears to show the availability of status information, but we cannot determine
+            // where it is in the packet.
+            // As such, we instead use daveGetxxAt routines to allow us to index to this location.
+            result = (readFormat == FORMAT_SIGNED) ? daveGetS16At(dc, byteOffset + 1) : daveGetU16At(dc, byteOffset + 1);
+        } else if (readMemoryArea == S7_200_AREA_T) {
+            // similar to S7_200_AREA_C, the S7_200_AREA_T memory area also returns its data in a different portion of the packet.
+            // the example for this value is:
+            // PACKET:              FF 09 00 0A 00 00 00 12 34 00 00 00 00 00
+            //    length bytes:          <00 06>
+            //    dc->resultPointer             ^^
+            // in this case, it appears that we need to add three bytes to get to the data location.  However, we are unable to
+            // load a value into the PLC for these registers larger than 16 bits.  It is possible that we still only need the
+            // 1-byte offset, and that the two zeros preceding the data are actually the high-order bytes of a 32-bit value.
+            // If this is true, however, other changes are required to this library, since it automatically forces any reads of
+            // S7_200_AREA_C and S7_200_AREA_T to be READ_WORD:
+            //      from 'NodeS7Serial.prototype.addItems' in 'spark/node-s7-serial/index.js':
+            //          // no read type included for the timers and counters, they are 16 bit accesses
+            // For now, leave as an index of 3, resulting in our always reading a 16-bit result for counters and timers.
+            result = (readFormat == FORMAT_SIGNED) ? daveGetS16At(dc, byteOffset + 3) : daveGetU16At(dc, byteOffset + 3);
+        } else {
+            result = (readFormat == FORMAT_SIGNED) ? daveGetS16At(dc, byteOffset) : daveGetU16At(dc, byteOffset);
+        }// get it as a Signed or unsigned 16 bit
+    } else if (readType == READ_DWORD) {
+        // get it as a Signed or unsigned 32 bit, or float
+        if( readFormat == FORMAT_SIGNED) {
+            result = daveGetS32At(dc, byteOffset);
+        } else if (readFormat == FORMAT_UNSIGNED) {
+            result = daveGetU32At(dc, byteOffset);
+        } else {
+            resultFloat = daveGetFloatAt(dc, byteOffset);
+        }
+    }
+
+    *value = (readFormat == FORMAT_FLOAT) ? (double)resultFloat : (double)result;
+    return 0;
+}
+
+/******************************************************************************
+*
+*  Function: 			DecodeAll()
+*  Parameters: dc          -- connection the result set was read on
+*              rs          -- result set filled by daveExecReadRequest
+*              descriptors -- DESCRIPTOR_FIELDS entries per value
+*              count       -- number of values
+*              values      -- decoded values
+*              status      -- 0 for a decoded value, otherwise the error
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+static void DecodeAll(daveConnection* dc, daveResultSet* rs, const int32_t* descriptors, size_t count, double* values, uint8_t* status) {
+
+    for (size_t i = 0; i < count; i++) {
+        const int32_t* d = &descriptors[i * DESCRIPTOR_FIELDS];
+        int res = DecodeResult(dc, rs, d[0], d[1], d[2], d[3], d[4], d[5], &values[i]);
+        // keep the status to a byte, making sure an error never aliases to 0 (ok)
+        status[i] = (res == 0) ? 0 : (((res & 0xFF) != 0) ? (uint8_t)(res & 0xFF) : 0xFF);
+    }
+}
+
+/******************************************************************************
+*
+*  Function: 			ReadExchange()
+*  Parameters: context     -- context object, must be locked by the caller
+*              items       -- ITEM_FIELDS entries per item to read
+*              itemCount   -- number of items, must fit in one PDU
+*              descriptors -- DESCRIPTOR_FIELDS entries per value
+*              count       -- number of values
+*              values      -- decoded values
+*              status      -- 0 for a decoded value, otherwise the error
+*
+*  Builds, executes and decodes one read request with a PDU and result set of
+*  its own, so nothing is left behind in the context between exchanges.
+*
+*  Returns: 0 on success, otherwise the error from daveExecReadRequestArena or
+*           NOT_CONNECTED. On an error every status is set to 0xFF.
+*
+******************************************************************************/
+static int ReadExchange(ContextObject* context, const int32_t* items, size_t itemCount, const int32_t* descriptors, size_t count, double* values, uint8_t* status) {
+
+    int result = NOT_CONNECTED;
+
+    if (context->getConnectionStatus() == 0) {
+        daveConnection* dc = context->getDaveConnection();
+        PDU p;
+        daveResultSet rs;
+        rs.numResults = 0;
+        rs.results = NULL;
+        rs.arena = NULL;
+
+        davePrepareReadRequest(dc, &p);
+        for (size_t i = 0; i < itemCount; i++) {
+            const int32_t* item = &items[i * ITEM_FIELDS];
+            if (item[0] == READ_BIT) {
+                daveAddBitVarToReadRequest(&p, item[1], item[2], item[3], item[4]);
+            } else {
+                daveAddVarToReadRequest(&p, item[1], item[2], item[3], item[4]);
+            }
+        }
+
+        result = daveExecReadRequestArena(dc, &p, &rs);
+        if (result == daveResOK) {
+            DecodeAll(dc, &rs, descriptors, count, values, status);
+            daveFreeResults(&rs);
+            return 0;
+        }
+    }
+
+    memset(status, 0xFF, count);
+    return result;
+}
+
+// item start, item count and value count of each exchange of a flattened read plan
+#define EXCHANGE_FIELDS 3
+
+// largest number of requests kept in flight on an iso over tcp connection, as many as libnodave times
+#define MAX_PARALLEL_JOBS daveMaxParallelJobs
+
+/*
+    Run the exchanges of a flattened read plan on an iso over tcp connection,
+    keeping up to the negotiated number of requests in flight rather than waiting
+    for each answer before sending the next request. Answers are matched to their
+    exchange by PDU reference. Like ReadExchange it runs on a worker thread with
+    the context locked, the values of exchange e follow those of exchange e - 1.
+    On error the values not yet read get status 0xFF and the error is returned,
+    the answers still in flight are read off first, or the connection is dropped
+    if that can't be done.
+*/
+static int ReadPipelined(ContextObject* context, const int32_t* items, const int32_t* exchanges, size_t exchangeCount, const int32_t* descriptors, double* values, uint8_t* status) {
+
+    // where the values of each exchange start
+    std::vector<size_t> valueStart(exchangeCount + 1, 0);
+    for (size_t e = 0; e < exchangeCount; e++) {
+        valueStart[e + 1] = valueStart[e] + exchanges[(e * EXCHANGE_FIELDS) + 2];
+    }
+    std::vector<bool> answered(exchangeCount, false);
+
+    int result = NOT_CONNECTED;
+    if (context->getConnectionStatus() == 0) {
+        daveConnection* dc = context->getDaveConnection();
+        int jobs = daveGetMaxParallelJobs(dc);
+        if (jobs > MAX_PARALLEL_JOBS) {
+            jobs = MAX_PARALLEL_JOBS;
+        }
+
+        int refs[MAX_PARALLEL_JOBS];
+        size_t inFlightExchanges[MAX_PARALLEL_JOBS];
+        int inFlight = 0;
+        size_t sent = 0;
+        size_t done = 0;
+        int firstError = 0;
+        result = 0;
+
+        while ((result == 0) && (done < exchangeCount)) {
+            // fill the window, msgOut is free again as soon as a request is sent
+            while ((inFlight < jobs) && (sent < exchangeCount)) {
+                const int32_t* exchange = &exchanges[sent * EXCHANGE_FIELDS];
+                PDU p;
+                davePrepareReadRequest(dc, &p);
+                for (int32_t i = 0; i < exchange[1]; i++) {
+                    const int32_t* item = &items[(exchange[0] + i) * ITEM_FIELDS];
+                    if (item[0] == READ_BIT) {
+                        daveAddBitVarToReadRequest(&p, item[1], item[2], item[3], item[4]);
+                    } else {
+                        daveAddVarToReadRequest(&p, item[1], item[2], item[3], item[4]);
+                    }
+                }
+                result = daveSendRequestTCP(dc, &p, &refs[inFlight]);
+                if (result != 0) {
+                    break;
+                }
+                inFlightExchanges[inFlight++] = sent++;
+            }
+            if (result != 0) {
+                break;
+            }
+
+            // and take whichever answer comes next
+            int ref;
+            result = daveReceiveResponseTCP(dc, &ref);
+            if (result != 0) {
+                break;
+            }
+            int job = 0;
+            while ((job < inFlight) && (refs[job] != ref)) {
+                job++;
+            }
+            if (job == inFlight) {
+                // a late answer to a request given up on before
+                continue;
+            }
+
+            // an exchange the PLC refused doesn't stop the others, their answers are on the way
+            size_t e = inFlightExchanges[job];
+            daveResultSet rs;
+            rs.numResults = 0;
+            rs.results = NULL;
+            rs.arena = NULL;
+            int res = daveGetReadResponseArena(dc, &rs);
+            if (res == daveResOK) {
+                size_t count = valueStart[e + 1] - valueStart[e];
+                DecodeAll(dc, &rs, &descriptors[valueStart[e] * DESCRIPTOR_FIELDS], count, &values[valueStart[e]], &status[valueStart[e]]);
+                daveFreeResults(&rs);
+                answered[e] = true;
+            } else if (firstError == 0) {
+                firstError = res;
+            }
+
+            inFlight--;
+            refs[job] = refs[inFlight];
+            inFlightExchanges[job] = inFlightExchanges[inFlight];
+            done++;
+        }
+        if (result == 0) {
+            result = firstError;
+        } else if (inFlight > 0) {
+            // the answers still on their way would be taken by the next exchange as its own. Read them
+            // off by PDU reference, unless the link timed out, then nothing says when or whether they come
+            bool inSync = (result != daveResTimeout);
+            while (inSync && (inFlight > 0)) {
+                int ref;
+                if (daveReceiveResponseTCP(dc, &ref) != 0) {
+                    inSync = false;
+                    break;
+                }
+                for (int job = 0; job < inFlight; job++) {
+                    if (refs[job] == ref) {
+                        refs[job] = refs[--inFlight];
+                        break;
+                    }
+                }
+            }
+            if (!inSync) {
+                // drop the connection, every command fails with NOT_CONNECTED until the client
+                // reconnects, which opens a new socket. There is no session to resume on this one
+                daveFree(dc);
+                context->setConnectionStatus(-1);
+                context->forgetSession();
+            }
+        }
+    }
+
+    for (size_t e = 0; e < exchangeCount; e++) {
+        if (!answered[e]) {
+            memset(&status[valueStart[e]], 0xFF, valueStart[e + 1] - valueStart[e]);
+        }
+    }
+    return result;
+}
+
+/*
+    Read all the exchanges of a flattened read plan, taking the context lock as
+    the priority class says. On an iso over tcp connection with more than one
+    job negotiated they are pipelined under one lock, otherwise each exchange
+    takes the lock on its own so more urgent commands can go in between. Returns
+    the first error.
+*/
+static int ReadExchanges(ContextObject* context, int priority, uint64_t issuedAt, const int32_t* items, const int32_t* exchanges, size_t exchangeCount, const int32_t* descriptors, double* values, uint8_t* status) {
+
+    context->lock(priority, issuedAt);
+    bool pipelined = (exchangeCount > 1) && (context->getConnectionStatus() == 0) &&
+                     (daveGetMaxParallelJobs(context->getDaveConnection()) > 1);
+    int result = 0;
+    if (pipelined) {
+        result = ReadPipelined(context, items, exchanges, exchangeCount, descriptors, values, status);
+    }
+    context->unlock();
+    if (pipelined) {
+        return result;
+    }
+
+    size_t valueStart = 0;
+    for (size_t e = 0; e < exchangeCount; e++) {
+        const int32_t* exchange = &exchanges[e * EXCHANGE_FIELDS];
+        if (e > 0) {
+            issuedAt = uv_hrtime();
+        }
+        context->lock(priority, issuedAt);
+        int res = ReadExchange(context, &items[exchange[0] * ITEM_FIELDS], exchange[1],
+                               &descriptors[valueStart * DESCRIPTOR_FIELDS], exchange[2],
+                               &values[valueStart], &status[valueStart]);
+        context->unlock();
+        if ((res != 0) && (result == 0)) {
+            result = res;
+        }
+        valueStart += exchange[2];
+    }
+    return result;
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_GetResult()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*              info[1] -- number  index
+*              info[2] -- number  data type to read
+*              info[3] -- number  data format to read
+*              info[4] -- number  memory area
+*
+*  Returns: Indexed result or null.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetResult) {
+
+    // Check the number of arguments passed.
+    if (info.Length() != 5)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    int index = (int)info[1]->NumberValue();
+    int readType = (int)info[2]->NumberValue();
+    int readFormat = (int)info[3]->NumberValue();
+    int readMemoryArea = (int)info[4]->NumberValue();
+
+    // get necessary context
+    daveConnection* dc = context->getDaveConnection();
+    daveResultSet* rs = context->getDaveResultSet();
+
+    double value = 0.0;
+    int res = DecodeResult(dc, rs, index, 0, -1, readType, readFormat, readMemoryArea, &value);
+    // if result exists
+    if (res == 0) {
+        // convert it to applicable v8 type and set it as return value
+        if( readFormat == FORMAT_FLOAT) {
+            v8::Local<v8::Number> resultV8Float = Nan::New<v8::Number>(value);
+            info.GetReturnValue().Set(resultV8Float);
+        } else if( readFormat == FORMAT_BOOL) {
+            v8::Local<v8::Boolean> resultV8Bool = Nan::New<v8::Boolean>((bool)(value > 0));
+            info.GetReturnValue().Set(resultV8Bool);
+        } else {
+            v8::Local<v8::Integer> resultV8Int = Nan::New<v8::Integer>((int)value);
+            info.GetReturnValue().Set(resultV8Int);
+        }
+    } else {
+        // if no value, create a v8 null and set it as the return value
+        v8::Local<v8::Primitive> returnNull = Nan::Null();
+        info.GetReturnValue().Set(returnNull);
+    }
+}
+
+
+class GetAllResultsWorker : public QueuedWorker {
+
+    public:
+        GetAllResultsWorker(Callback *callback, ContextObject* context, const int32_t* descriptors, size_t count)
+        : QueuedWorker(callback, PRIORITY_READ) {
+            // get necessary context
+            localContext = context;
+            dc = context->getDaveConnection();
+            p = context->getPDU();
+            rs = context->getDaveResultSet();
+            // keep our own copy of the decode descriptors
+            itemDescriptors.assign(descriptors, descriptors + (count * DESCRIPTOR_FIELDS));
+        }
+
+        ~GetAllResultsWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            size_t count = itemDescriptors.size() / DESCRIPTOR_FIELDS;
+            values.assign(count, 0.0);
+            status.assign(count, 0);
+
+            // the results are decoded straight out of the receive buffer, nothing is allocated
+            localContext->lock(this);
+            result = daveExecReadRequestArena(dc, p, rs);
+            if (result == daveResOK) {
+                // decode every value out of the result set here, rather than crossing back into the
+                // binding once per item from the main event loop
+                DecodeAll(dc, rs, itemDescriptors.data(), count, values.data(), status.data());
+
+                // release the results (the arena itself belongs to the connection)
+                daveFreeResults(rs);
+            }
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+            //printf("GetAllResultsWorker: HandleOKCallback Result %d\n" , result);
+
+            if (result == daveResOK) {
+                Isolate* isolate = v8::Isolate::GetCurrent();
+                size_t count = values.size();
+
+                Local<v8::ArrayBuffer> valuesBuffer = v8::ArrayBuffer::New(isolate, count * sizeof(double));
+                if (count > 0) {
+                    memcpy(valuesBuffer->GetContents().Data(), &values[0], count * sizeof(double));
+                }
+                Local<v8::ArrayBuffer> statusBuffer = v8::ArrayBuffer::New(isolate, count);
+                if (count > 0) {
+                    memcpy(statusBuffer->GetContents().Data(), &status[0], count);
+                }
+
+                Local<Value> argv[] = {
+                    Null(),
+                    v8::Float64Array::New(valuesBuffer, 0, count),
+                    v8::Uint8Array::New(statusBuffer, 0, count)
+                };
+                callback->Call(3, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null(),
+                    Null()
+                };
+                callback->Call(3, argv);
+            }
+        }
+
+    private:
+        ContextObject* localContext;
+        daveConnection* dc;
+        PDU* p;
+        daveResultSet* rs;
+        std::vector<int32_t> itemDescriptors;
+        std::vector<double> values;
+        std::vector<uint8_t> status;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_GetAllResults()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- Int32Array decode descriptors, 6 entries per value:
+*                         result index, byte offset, bit offset (or -1),
+*                         data type, data format, memory area
+*              info[2] -- ASync Callback
+*
+*  Executes the prepared read request, then decodes and frees the whole result
+*  set in the worker thread. The callback receives (err, values, status) where
+*  values is a Float64Array and status a Uint8Array (0 == ok), both indexed
+*  like the descriptors.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_GetAllResults) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 3)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsInt32Array() || !info[2]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  Nan::TypedArrayContents<int32_t> descriptors(info[1]);
+  if ((descriptors.length() % DESCRIPTOR_FIELDS) != 0) {
+      Nan::ThrowTypeError("Descriptor length must be a multiple of 6");
+      return;
+  }
+
+  Callback *callback = new Callback(info[2].As<v8::Function>());
+
+  QueueWorker(info[0], new GetAllResultsWorker(callback, context, *descriptors, descriptors.length() / DESCRIPTOR_FIELDS));
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_FreeResults()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- context object
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_FreeResults) {
+    // Check the number of arguments passed.
+    if (info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+    //printf("FreeResults: Calling daveFreeResults\n");
+    daveFreeResults(context->getDaveResultSet());
+    //printf("FreeResults: Return from daveFreeResults\n");
+}
+
+/*******************************************************************************
+ *
+ * Function:    Method_PrepareWriteRequest
+ * Sync/Async:  Synchronous
+ * Parameters:
+ *
+ * Returns: Nothing.
+ *
+ /******************************************************************************/
+NAN_METHOD(Method_PrepareWriteRequest){
+
+    //Check the number of arguments passed
+    if(info.Length() != 1)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if(!info[0]->IsObject()){
+        Nan::ThrowTypeError("One or more arguements of the wrong type");
+        return;
+    }
+    //get necessary context
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    PDU* p = context->getPDU();
+    daveConnection* dc = context->getDaveConnection();
+
+    davePrepareWriteRequest(dc, p);
+}
+/*******************************************************************************
+ *
+ * Function:    Method_AddWriteVarToRequest
+ * Sync/Async:  Synchronous
+ *  Parameters: info[0] -- context object
+ *              info[1] -- number  data type to read
+ *              info[2] -- number  memory area
+ *			    info[3] -- number  block index
+ *			    info[4] -- number  start address
+ *			    info[5] -- number  length
+ *
+ * Returns: Nothing.
+ *
+ /******************************************************************************/
+ NAN_METHOD(Method_AddWriteVarToRequest){
+
+    // Check the number of arguments passed.
+    if (info.Length() != 7)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber() || !info[5]->IsNumber()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    int dataType = (int)info[1]->NumberValue();
+    int memoryArea = (int)info[2]->NumberValue();
+    int blockIndex = (int)info[3]->NumberValue();
+    int startAddress = (int)info[4]->NumberValue();
+    int length = (int)info[5]->NumberValue();
+
+    void * da = (void *)node::Buffer::Data(info[6]->ToObject());
+    // get necessary context
+    PDU* p = context->getPDU();
+
+    if( dataType == READ_BIT) {
+        //printf("AddVarToWrite READ_BIT Request: calling daveAddBitVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
+        daveAddBitVarToWriteRequest(p, memoryArea, blockIndex, startAddress, length, da);
+    } else {
+        //printf("AddVarToWrite ELSE Request: calling daveAddVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
+        daveAddVarToWriteRequest(p, memoryArea, blockIndex, startAddress, length, da);
+    }
+}
+
+class ExecWriteRequestWorker : public QueuedWorker {
+
+    public:
+        ExecWriteRequestWorker(Callback *callback, ContextObject* context)
+        : QueuedWorker(callback) {
+            //get necessary context
+            localContext = context;
+            dc = context->getDaveConnection();
+            p = context->getPDU();
+            rs = context->getDaveResultSet();
+        }
+
+        ~ExecWriteRequestWorker() {}
+
+        // Executed inside the worker-thread
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            localContext->lock(this);
+            result = daveExecWriteRequest(dc, p, rs);
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+
+            if(result == daveResOK){
+                Local<Value> argv[] = {
+                    Null(),
+                    Null()
+                };
+                callback->Call(2, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg, "Error Executing Write Request. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null()
+                };
+                callback->Call(2, argv);
+            }
+        }
+    private:
+        ContextObject* localContext;
+        daveConnection* dc;
+        PDU* p;
+        daveResultSet* rs;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ExecWriteRequest()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- ASync Callback
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ExecWriteRequest){
+
+    //Check the number of arguements passed
+    if(info.Length() != 2)
+    {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    // and their types
+    if(!info[0]->IsObject() || !info[1]->IsObject() ){
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
+        return;
+    }
+
+    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+    Callback *callback = new Callback(info[1].As<v8::Function>());
+
+    QueueWorker(info[0], new ExecWriteRequestWorker(callback, context));
+}
+
+static Local<Value> NewInt32Array(const std::vector<int32_t>& values) {
+    size_t count = values.size();
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), count * sizeof(int32_t));
+    if (count > 0) {
+        memcpy(buffer->GetContents().Data(), values.data(), count * sizeof(int32_t));
+    }
+    return v8::Int32Array::New(buffer, 0, count);
+}
+
+static Local<Value> NewFloat64Array(const std::vector<double>& values) {
+    size_t count = values.size();
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), count * sizeof(double));
+    if (count > 0) {
+        memcpy(buffer->GetContents().Data(), values.data(), count * sizeof(double));
+    }
+    return v8::Float64Array::New(buffer, 0, count);
+}
+
+static Local<Value> NewUint8Array(const std::vector<uint8_t>& values) {
+    size_t count = values.size();
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), count);
+    if (count > 0) {
+        memcpy(buffer->GetContents().Data(), values.data(), count);
+    }
+    return v8::Uint8Array::New(buffer, 0, count);
+}
+
+
+class ReadItemsWorker : public QueuedWorker {
+
+    public:
+        ReadItemsWorker(Callback *callback, ContextObject* context, const int32_t* readItems, size_t itemCount, const int32_t* descriptors, size_t count, int priority)
+        : QueuedWorker(callback, priority) {
+            localContext = context;
+            // keep our own copy of the items and decode descriptors
+            items.assign(readItems, readItems + (itemCount * ITEM_FIELDS));
+            itemDescriptors.assign(descriptors, descriptors + (count * DESCRIPTOR_FIELDS));
+        }
+
+        ~ReadItemsWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            size_t count = itemDescriptors.size() / DESCRIPTOR_FIELDS;
+            values.assign(count, 0.0);
+            status.assign(count, 0);
+
+            // the request is built here too, so a subscription can run between two of these
+            localContext->lock(this);
+            result = ReadExchange(localContext, items.data(), items.size() / ITEM_FIELDS, itemDescriptors.data(), count, values.data(), status.data());
+            localContext->unlock();
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+
+            if (result == daveResOK) {
+                Local<Value> argv[] = {
+                    Null(),
+                    NewFloat64Array(values),
+                    NewUint8Array(status)
+                };
+                callback->Call(3, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null(),
+                    Null()
+                };
+                callback->Call(3, argv);
+            }
+        }
+
+    private:
+        ContextObject* localContext;
+        std::vector<int32_t> items;
+        std::vector<int32_t> itemDescriptors;
+        std::vector<double> values;
+        std::vector<uint8_t> status;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ReadItems()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- Int32Array items, 5 entries per item:
+*                         data type, memory area, block index, start address,
+*                         length
+*              info[2] -- Int32Array decode descriptors, 6 entries per value
+*                         (see Method_GetAllResults)
+*              info[3] -- priority class, PRIORITY_READ for on-demand reads or
+*                         PRIORITY_POLL for cyclic polling
+*              info[4] -- ASync Callback
+*
+*  Prepares, executes and decodes a whole read request in the worker thread.
+*  Unlike prepareReadRequest/addVarToRequest/getAllResults it is safe to use
+*  while a subscription is running. Queued writes and reads of a more urgent
+*  class go ahead of it. The callback receives (err, values, status) as for
+*  Method_GetAllResults.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ReadItems) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 5)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsInt32Array() || !info[2]->IsInt32Array() || !info[3]->IsNumber() || !info[4]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  Nan::TypedArrayContents<int32_t> items(info[1]);
+  Nan::TypedArrayContents<int32_t> descriptors(info[2]);
+  if (((items.length() % ITEM_FIELDS) != 0) || ((descriptors.length() % DESCRIPTOR_FIELDS) != 0)) {
+      Nan::ThrowTypeError("Item length must be a multiple of 5 and descriptor length a multiple of 6");
+      return;
+  }
+
+  int priority = (int)info[3]->NumberValue();
+  if ((priority != PRIORITY_READ) && (priority != PRIORITY_POLL)) {
+      Nan::ThrowRangeError("Reads must be PRIORITY_READ or PRIORITY_POLL");
+      return;
+  }
+
+  Callback *callback = new Callback(info[4].As<v8::Function>());
+
+  QueueWorker(info[0], new ReadItemsWorker(callback, context, *items, items.length() / ITEM_FIELDS, *descriptors, descriptors.length() / DESCRIPTOR_FIELDS, priority));
+}
+
+
+class ReadExchangesWorker : public QueuedWorker {
+
+    public:
+        ReadExchangesWorker(Callback *callback, ContextObject* context, const int32_t* readItems, size_t itemCount, const int32_t* readExchanges, size_t exchangeCount, const int32_t* descriptors, size_t count, int priority)
+        : QueuedWorker(callback, priority) {
+            localContext = context;
+            // keep our own copy of the plan
+            items.assign(readItems, readItems + (itemCount * ITEM_FIELDS));
+            exchanges.assign(readExchanges, readExchanges + (exchangeCount * EXCHANGE_FIELDS));
+            itemDescriptors.assign(descriptors, descriptors + (count * DESCRIPTOR_FIELDS));
+        }
+
+        ~ReadExchangesWorker() {}
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            size_t count = itemDescriptors.size() / DESCRIPTOR_FIELDS;
+            values.assign(count, 0.0);
+            status.assign(count, 0);
+
+            result = ReadExchanges(localContext, getPriority(), getQueuedAt(), items.data(), exchanges.data(),
+                                   exchanges.size() / EXCHANGE_FIELDS, itemDescriptors.data(), values.data(), status.data());
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+
+            Local<Value> err = Null();
+            if (result != daveResOK) {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", result);
+                err = Nan::Error(errorMsg);
+            }
+            // values that could be read are passed on even if others failed
+            Local<Value> argv[] = {
+                err,
+                NewFloat64Array(values),
+                NewUint8Array(status)
+            };
+            callback->Call(3, argv);
+        }
+
+    private:
+        ContextObject* localContext;
+        std::vector<int32_t> items;
+        std::vector<int32_t> exchanges;
+        std::vector<int32_t> itemDescriptors;
+        std::vector<double> values;
+        std::vector<uint8_t> status;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ReadExchanges()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- Int32Array items of the whole read plan, 5 entries
+*                         per item (see Method_ReadItems)
+*              info[2] -- Int32Array exchanges, 3 entries per exchange:
+*                         first item, item count and value count
+*              info[3] -- Int32Array decode descriptors, 6 entries per value,
+*                         the values of each exchange following the previous
+*              info[4] -- priority class, PRIORITY_READ or PRIORITY_POLL
+*              info[5] -- ASync Callback
+*
+*  Reads every exchange of a read plan in one command. On an iso over tcp
+*  connection that negotiated more than one parallel job the requests are
+*  pipelined, up to that many in flight. The callback receives
+*  (err, values, status) for all the values, err being the first error.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ReadExchanges) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 6)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsInt32Array() || !info[2]->IsInt32Array() || !info[3]->IsInt32Array() || !info[4]->IsNumber() || !info[5]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  Nan::TypedArrayContents<int32_t> items(info[1]);
+  Nan::TypedArrayContents<int32_t> exchanges(info[2]);
+  Nan::TypedArrayContents<int32_t> descriptors(info[3]);
+  if (((items.length() % ITEM_FIELDS) != 0) || ((exchanges.length() % EXCHANGE_FIELDS) != 0) || ((descriptors.length() % DESCRIPTOR_FIELDS) != 0)) {
+      Nan::ThrowTypeError("Item, exchange or descriptor length is not a multiple of its fields");
+      return;
+  }
+
+  // every exchange has to lie inside the items and descriptors passed
+  size_t itemCount = items.length() / ITEM_FIELDS;
+  size_t valueCount = 0;
+  for (size_t e = 0; e < exchanges.length() / EXCHANGE_FIELDS; e++) {
+      const int32_t* exchange = &(*exchanges)[e * EXCHANGE_FIELDS];
+      if ((exchange[0] < 0) || (exchange[1] < 0) || (exchange[2] < 0) || ((size_t)(exchange[0] + exchange[1]) > itemCount)) {
+          Nan::ThrowRangeError("Exchange items out of range");
+          return;
+      }
+      valueCount += exchange[2];
+  }
+  if (valueCount != descriptors.length() / DESCRIPTOR_FIELDS) {
+      Nan::ThrowRangeError("Exchange value counts don't match the descriptors");
+      return;
+  }
+
+  int priority = (int)info[4]->NumberValue();
+  if ((priority != PRIORITY_READ) && (priority != PRIORITY_POLL)) {
+      Nan::ThrowRangeError("Reads must be PRIORITY_READ or PRIORITY_POLL");
+      return;
+  }
+
+  Callback *callback = new Callback(info[5].As<v8::Function>());
+
+  QueueWorker(info[0], new ReadExchangesWorker(callback, context, *items, itemCount, *exchanges, exchanges.length() / EXCHANGE_FIELDS, *descriptors, valueCount, priority));
+}
+
+
+// largest block readBlock takes, the byte addresses of a data block are 16 bit
+#define MAX_BLOCK_LENGTH 65536
+
+class ReadBlockWorker : public QueuedWorker {
+
+    public:
+        ReadBlockWorker(Callback *callback, ContextObject* context, int area, int blockIndex, int start, int length, int priority)
+        : QueuedWorker(callback, priority) {
+            localContext = context;
+            localArea = area;
+            localBlockIndex = blockIndex;
+            localStart = start;
+            localLength = length;
+            data = NULL;
+            pos = 0;
+            result = 0;
+        }
+
+        ~ReadBlockWorker() {
+            // only left if the block never made it into a Buffer
+            free(data);
+        }
+
+        // Executed inside the worker-thread.
+        // It is not safe to access V8, or V8 data structures
+        // here, so everything we need for input and output
+        // should go on `this`.
+        void Execute () {
+
+            // read straight into the memory the Buffer will own
+            if (data == NULL) {
+                data = (char*)malloc(localLength);
+                if (data == NULL) {
+                    result = daveResNoBuffer;
+                    return;
+                }
+                pos = 0;
+            }
+
+            // daveReadManyBytes splits the block into PDU sized reads, but it would keep the link for all
+            // of them. Read one PDU's worth per run and yield, the queue then runs writes and more urgent
+            // reads before the next chunk
+            localContext->lock(getPriority(), getQueuedAt());
+            if (localContext->getConnectionStatus() == 0) {
+                daveConnection* dc = localContext->getDaveConnection();
+                int chunk = daveGetMaxPDULen(dc) - 18;
+                if (chunk > localLength - pos) {
+                    chunk = localLength - pos;
+                }
+                result = daveReadManyBytes(dc, localArea, localBlockIndex, localStart + pos, chunk, data + pos);
+                pos += chunk;
+            } else {
+                result = NOT_CONNECTED;
+            }
+            localContext->unlock();
+
+            if ((result == 0) && (pos < localLength)) {
+                Yield();
+            }
+        }
+
+        // Executed when the async work is complete
+        // this function will be run inside the main event loop
+        // so it is safe to use V8 again
+        void HandleOKCallback () {
+
+            if (result == daveResOK) {
+                // the Buffer takes the memory over, nothing is copied
+                Local<v8::Object> block = Nan::NewBuffer(data, localLength).ToLocalChecked();
+                data = NULL;
+                Local<Value> argv[] = {
+                    Null(),
+                    block
+                };
+                callback->Call(2, argv);
+            } else {
+                char errorMsg[200];
+                sprintf(errorMsg,"Error Reading Block. Return code = %i\n", result);
+                Local<Value> argv[] = {
+                    Nan::Error(errorMsg),
+                    Null()
+                };
+                callback->Call(2, argv);
+            }
+        }
+
+    private:
+        ContextObject* localContext;
+        int localArea;
+        int localBlockIndex;
+        int localStart;
+        int localLength;
+        char* data;
+        // bytes read so far, the worker runs once per chunk
+        int pos;
+        int result;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_ReadBlock()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- number  memory area
+*              info[2] -- number  block index (data block number, 1 for V memory)
+*              info[3] -- number  start address in bytes
+*              info[4] -- number  length in bytes
+*              info[5] -- priority class, PRIORITY_READ or PRIORITY_POLL
+*              info[6] -- ASync Callback
+*
+*  Reads a range of consecutive bytes with daveReadManyBytes, one PDU sized
+*  exchange per run of the worker, into a single Buffer. The worker yields
+*  between chunks so queued writes and more urgent reads are not held up. The callback receives
+*  (err, buffer) with the bytes as the PLC holds them, big-endian.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_ReadBlock) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 7)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber() || !info[5]->IsNumber() || !info[6]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  int area = (int)info[1]->NumberValue();
+  int blockIndex = (int)info[2]->NumberValue();
+  int start = (int)info[3]->NumberValue();
+  int length = (int)info[4]->NumberValue();
+  if ((area == S7_200_AREA_C) || (area == S7_200_AREA_T) || (area == S7_300_AREA_C) || (area == S7_300_AREA_T)) {
+      Nan::ThrowRangeError("Timers and counters can't be read as a block");
+      return;
+  }
+  if ((start < 0) || (length <= 0) || (start + length > MAX_BLOCK_LENGTH)) {
+      Nan::ThrowRangeError("Block start or length out of range");
+      return;
+  }
+
+  int priority = (int)info[5]->NumberValue();
+  if ((priority != PRIORITY_READ) && (priority != PRIORITY_POLL)) {
+      Nan::ThrowRangeError("Reads must be PRIORITY_READ or PRIORITY_POLL");
+      return;
+  }
 
-    //printf("FreeResults: Calling daveFreeResults\n");
-    daveFreeResults(context->getDaveResultSet());
-    //printf("FreeResults: Return from daveFreeResults\n");
+  Callback *callback = new Callback(info[6].As<v8::Function>());
+
+  QueueWorker(info[0], new ReadBlockWorker(callback, context, area, blockIndex, start, length, priority));
 }
 
-/*******************************************************************************
- *
- * Function:    Method_PrepareWriteRequest
- * Sync/Async:  Synchronous
- * Parameters:
- *
- * Returns: Nothing.
- *
- /******************************************************************************/
-NAN_METHOD(Method_PrepareWriteRequest){
+/******************************************************************************
+*
+*  Function: 			Method_DecodeArray()
+*  Sync/Async:			Synchronous
+*  Parameters: info[0] -- Buffer  block, as passed to the readBlock callback
+*              info[1] -- number  byte offset of the first value
+*              info[2] -- number  count of values
+*              info[3] -- number  data type, READ_WORD or READ_DWORD
+*              info[4] -- number  data format
+*
+*  Converts count consecutive big-endian words or double words in one pass.
+*
+*  Returns: Int16Array or Uint16Array for words, Int32Array, Uint32Array or
+*           Float32Array for double words, in the machine's byte order.
+*
+******************************************************************************/
+NAN_METHOD(Method_DecodeArray) {
 
-    //Check the number of arguments passed
-    if(info.Length() != 1)
+    // Check the number of arguments passed.
+    if (info.Length() != 5)
     {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
     // and their types
-    if(!info[0]->IsObject()){
-        Nan::ThrowTypeError("One or more arguements of the wrong type");
+    if (!node::Buffer::HasInstance(info[0]) || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber()) {
+        Nan::ThrowTypeError("One or more arguments of the wrong type");
         return;
     }
-    //get necessary context
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    PDU* p = context->getPDU();
-    daveConnection* dc = context->getDaveConnection();
 
-    davePrepareWriteRequest(dc, p);
-}
-/*******************************************************************************
- *
- * Function:    Method_AddWriteVarToRequest
- * Sync/Async:  Synchronous
- *  Parameters: info[0] -- context object
- *              info[1] -- number  data type to read
- *              info[2] -- number  memory area
- *			    info[3] -- number  block index
- *			    info[4] -- number  start address
- *			    info[5] -- number  length
- *
- * Returns: Nothing.
- *
- /******************************************************************************/
- NAN_METHOD(Method_AddWriteVarToRequest){
+    uc* block = (uc*)node::Buffer::Data(info[0]);
+    size_t blockLength = node::Buffer::Length(info[0]);
+    int offset = (int)info[1]->NumberValue();
+    int count = (int)info[2]->NumberValue();
+    int readType = (int)info[3]->NumberValue();
+    int readFormat = (int)info[4]->NumberValue();
 
-    // Check the number of arguments passed.
-    if (info.Length() != 7)
-    {
-        Nan::ThrowTypeError("Wrong number of arguments");
+    if ((readType != READ_WORD) && (readType != READ_DWORD)) {
+        Nan::ThrowRangeError("Only words and double words are decoded as arrays");
         return;
     }
-    // and their types
-    if (!info[0]->IsObject() || !info[1]->IsNumber() || !info[2]->IsNumber() || !info[3]->IsNumber() || !info[4]->IsNumber() || !info[5]->IsNumber()) {
-        Nan::ThrowTypeError("One or more arguments of the wrong type");
+    size_t size = (readType == READ_WORD) ? 2 : 4;
+    if ((offset < 0) || (count < 0) || ((size_t)offset + (size * count) > blockLength)) {
+        Nan::ThrowRangeError("Values out of the block");
         return;
     }
 
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    int dataType = (int)info[1]->NumberValue();
-    int memoryArea = (int)info[2]->NumberValue();
-    int blockIndex = (int)info[3]->NumberValue();
-    int startAddress = (int)info[4]->NumberValue();
-    int length = (int)info[5]->NumberValue();
-
-    void * da = (void *)node::Buffer::Data(info[6]->ToObject());
-    // get necessary context
-    PDU* p = context->getPDU();
-
-    if( dataType == READ_BIT) {
-        //printf("AddVarToWrite READ_BIT Request: calling daveAddBitVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
-        daveAddBitVarToWriteRequest(p, memoryArea, blockIndex, startAddress, length, da);
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), size * count);
+    uc* from = block + offset;
+    if (readType == READ_WORD) {
+        uint16_t* to = (uint16_t*)buffer->GetContents().Data();
+        for (int i = 0; i < count; i++) {
+            to[i] = (uint16_t)daveGetU16from(from + (2 * i));
+        }
+        if (readFormat == FORMAT_SIGNED) {
+            info.GetReturnValue().Set(v8::Int16Array::New(buffer, 0, count));
+        } else {
+            info.GetReturnValue().Set(v8::Uint16Array::New(buffer, 0, count));
+        }
     } else {
-        //printf("AddVarToWrite ELSE Request: calling daveAddVarToReadRequest : Memory Area %d : Block Index %d: Start Address %d : Length %d \n", memoryArea, blockIndex, startAddress, length);
-        daveAddVarToWriteRequest(p, memoryArea, blockIndex, startAddress, length, da);
+        // floats are swapped as their bit pattern
+        uint32_t* to = (uint32_t*)buffer->GetContents().Data();
+        for (int i = 0; i < count; i++) {
+            to[i] = daveGetU32from(from + (4 * i));
+        }
+        if (readFormat == FORMAT_SIGNED) {
+            info.GetReturnValue().Set(v8::Int32Array::New(buffer, 0, count));
+        } else if (readFormat == FORMAT_FLOAT) {
+            info.GetReturnValue().Set(v8::Float32Array::New(buffer, 0, count));
+        } else {
+            info.GetReturnValue().Set(v8::Uint32Array::New(buffer, 0, count));
+        }
     }
 }
 
-class ExecWriteRequestWorker : public AsyncWorker {
+class WriteItemsWorker : public QueuedWorker {
 
     public:
-        ExecWriteRequestWorker(Callback *callback, ContextObject* context)
-        : AsyncWorker(callback) {
-            //get necessary context
-            dc = context->getDaveConnection();
-            p = context->getPDU();
-            rs = context->getDaveResultSet();
+        WriteItemsWorker(Callback *callback, ContextObject* context, const int32_t* writeItems, size_t itemCount, const char* data, size_t dataLength)
+        : QueuedWorker(callback) {
+            localContext = context;
+            // keep our own copy of the items and data, the buffer may be reused by the caller before we run
+            items.assign(writeItems, writeItems + (itemCount * ITEM_FIELDS));
+            localData.assign(data, data + dataLength);
         }
 
-        ~ExecWriteRequestWorker() {}
+        ~WriteItemsWorker() {}
 
         // Executed inside the worker-thread
         // It is not safe to access V8, or V8 data structures
@@ -862,7 +2656,42 @@ class ExecWriteRequestWorker : public AsyncWorker {
         // should go on `this`.
         void Execute () {
 
-            result = daveExecWriteRequest(dc, p, rs);
+            size_t count = items.size() / ITEM_FIELDS;
+            result = NOT_CONNECTED;
+            answered = false;
+            status.assign(count, NOT_CONNECTED);
+
+            // the request is built here too, so a subscription can run between two of these
+            localContext->lock(this);
+            if (localContext->getConnectionStatus() == 0) {
+                daveConnection* dc = localContext->getDaveConnection();
+                PDU p;
+                daveResultSet rs;
+                rs.numResults = 0;
+                rs.results = NULL;
+                rs.arena = NULL;
+
+                davePrepareWriteRequest(dc, &p);
+                size_t offset = 0;
+                for (size_t i = 0; i < count; i++) {
+                    const int32_t* item = &items[i * ITEM_FIELDS];
+                    if (item[0] == READ_BIT) {
+                        daveAddBitVarToWriteRequest(&p, item[1], item[2], item[3], item[4], &localData[offset]);
+                    } else {
+                        daveAddVarToWriteRequest(&p, item[1], item[2], item[3], item[4], &localData[offset]);
+                    }
+                    offset += item[4];
+                }
+                result = daveExecWriteRequest(dc, &p, &rs);
+
+                // the PLC answers every item, an item it didn't answer failed with the request
+                for (size_t i = 0; i < count; i++) {
+                    status[i] = ((int)i < rs.numResults) ? rs.results[i].error : ((result != 0) ? result : daveEmptyResultSetError);
+                }
+                answered = (rs.numResults > 0);
+                daveFreeResults(&rs);
+            }
+            localContext->unlock();
         }
 
         // Executed when the async work is complete
@@ -870,10 +2699,16 @@ class ExecWriteRequestWorker : public AsyncWorker {
         // so it is safe to use V8 again
         void HandleOKCallback () {
 
-            if(result == daveResOK){
+            if ((result == daveResOK) || answered) {
+                Isolate* isolate = v8::Isolate::GetCurrent();
+                size_t count = status.size();
+                Local<v8::ArrayBuffer> statusBuffer = v8::ArrayBuffer::New(isolate, count * sizeof(int32_t));
+                if (count > 0) {
+                    memcpy(statusBuffer->GetContents().Data(), status.data(), count * sizeof(int32_t));
+                }
                 Local<Value> argv[] = {
                     Null(),
-                    Null()
+                    v8::Int32Array::New(statusBuffer, 0, count)
                 };
                 callback->Call(2, argv);
             } else {
@@ -886,41 +2721,430 @@ class ExecWriteRequestWorker : public AsyncWorker {
                 callback->Call(2, argv);
             }
         }
+
     private:
-        daveConnection* dc;
-        PDU* p;
-        daveResultSet* rs;
+        ContextObject* localContext;
+        std::vector<int32_t> items;
+        std::vector<char> localData;
+        std::vector<int32_t> status;
+        bool answered;
         int result;
 };
 
 /******************************************************************************
 *
-*  Function: 			Method_ExecWriteRequest()
+*  Function: 			Method_WriteItems()
 *  Sync/Async:			ASync
 *  Parameters: info[0] -- context object
-*              info[1] -- ASync Callback
+*              info[1] -- Int32Array items, 5 entries per item:
+*                         data type, memory area, block index, start address,
+*                         length
+*              info[2] -- Buffer  data of every item, one after the other
+*              info[3] -- ASync Callback
+*
+*  Prepares and executes a write request of all the items in the worker thread,
+*  so it is safe to use while a subscription is running. The items must fit in
+*  one PDU. The callback receives (err, status) where status is an Int32Array
+*  of the libnodave result of each item (0 == ok); err is only set when the
+*  PLC didn't answer at all.
 *
 *  Returns: Nothing.
 *
 ******************************************************************************/
-NAN_METHOD(Method_ExecWriteRequest){
+NAN_METHOD(Method_WriteItems) {
 
-    //Check the number of arguements passed
-    if(info.Length() != 2)
-    {
-        Nan::ThrowTypeError("Wrong number of arguments");
-        return;
-    }
-    // and their types
-    if(!info[0]->IsObject() || !info[1]->IsObject() ){
-        Nan::ThrowTypeError("One or more arguments of the wrong type");
-        return;
-    }
+  // Check the number of arguments passed.
+  if (info.Length() != 4)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsInt32Array() || !node::Buffer::HasInstance(info[2]) || !info[3]->IsObject()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
 
-    ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
-    Callback *callback = new Callback(info[1].As<v8::Function>());
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+
+  Nan::TypedArrayContents<int32_t> items(info[1]);
+  if ((items.length() % ITEM_FIELDS) != 0) {
+      Nan::ThrowTypeError("Item length must be a multiple of 5");
+      return;
+  }
+
+  // the data of every item must be in the buffer
+  const char* data = node::Buffer::Data(info[2]);
+  size_t dataLength = node::Buffer::Length(info[2]);
+  size_t needed = 0;
+  for (size_t i = 0; i < items.length(); i += ITEM_FIELDS) {
+      int32_t length = (*items)[i + 4];
+      if (length < 0) {
+          Nan::ThrowRangeError("Negative item length");
+          return;
+      }
+      needed += length;
+  }
+  if (needed > dataLength) {
+      Nan::ThrowRangeError("Item lengths are larger than the buffer");
+      return;
+  }
+
+  Callback *callback = new Callback(info[3].As<v8::Function>());
+
+  QueueWorker(info[0], new WriteItemsWorker(callback, context, *items, items.length() / ITEM_FIELDS, data, dataLength));
+}
+
+
+// values of one cycle that changed, handed from the subscription thread to the main event loop
+struct SubscriptionBatch {
+    int result;
+    std::vector<int32_t> indexes;
+    std::vector<double> values;
+    std::vector<uint8_t> status;
+};
+
+/******************************************************************************
+*
+*  Class: 			Subscription
+*
+*  Reads a fixed set of exchanges on its own thread at a fixed period. Every
+*  value is compared with the one last delivered and only the values whose
+*  status changed, or whose value moved by at least its deadband (any change
+*  for a deadband of 0), are handed to the main event loop through a uv_async
+*  handle, one batch per cycle. The first cycle delivers every value.
+*
+*  Each exchange holds the context lock, so workers queued from the event loop
+*  get the connection between exchanges.
+*
+******************************************************************************/
+class Subscription {
+
+    public:
+        Subscription(ContextObject* context, Local<v8::Object> contextHandle, Local<v8::Function> callback,
+                     const int32_t* readItems, size_t itemCount, const int32_t* readExchanges, size_t exchangeCount,
+                     const int32_t* descriptors, const double* deadbands, size_t count, uint64_t periodMs)
+        : resource("nodeS7Serial:Subscription") {
+            localContext = context;
+            // keep the context alive for as long as the thread may use it
+            localContextHandle.Reset(contextHandle);
+            dataCallback.Reset(callback);
+            items.assign(readItems, readItems + (itemCount * ITEM_FIELDS));
+            exchanges.assign(readExchanges, readExchanges + (exchangeCount * EXCHANGE_FIELDS));
+            itemDescriptors.assign(descriptors, descriptors + (count * DESCRIPTOR_FIELDS));
+            valueDeadbands.assign(deadbands, deadbands + count);
+            values.assign(count, 0.0);
+            status.assign(count, 0);
+            lastValues.assign(count, 0.0);
+            lastStatus.assign(count, 0);
+            periodNs = periodMs * 1000000;
+            firstCycle = true;
+            stopping = false;
+            finished = false;
+            stopRequested = false;
+        }
+
+        ~Subscription() {
+            uv_cond_destroy(&cond);
+            uv_mutex_destroy(&mutex);
+            localContextHandle.Reset();
+        }
+
+        // start the polling thread, called from the main event loop
+        int Start() {
+            uv_mutex_init(&mutex);
+            uv_cond_init(&cond);
+            uv_async_init(uv_default_loop(), &async, Deliver);
+            async.data = this;
+            int res = uv_thread_create(&thread, Run, this);
+            if (res != 0) {
+                uv_close((uv_handle_t*)&async, Closed);
+            }
+            return res;
+        }
+
+        // ask the thread to stop, the callback runs once it has been joined
+        bool Stop(Local<v8::Function> callback) {
+            if (stopRequested) {
+                return false;
+            }
+            stopRequested = true;
+            stopCallback.Reset(callback);
+            uv_mutex_lock(&mutex);
+            stopping = true;
+            uv_cond_signal(&cond);
+            uv_mutex_unlock(&mutex);
+            return true;
+        }
+
+    private:
+        static void Run(void* arg) {
+            Subscription* self = (Subscription*)arg;
+
+            uint64_t next = uv_hrtime();
+            uv_mutex_lock(&self->mutex);
+            while (!self->stopping) {
+                uv_mutex_unlock(&self->mutex);
+                self->Poll();
+                uv_mutex_lock(&self->mutex);
+
+                // keep to the period, but never try to catch up on cycles that overran
+                uint64_t now = uv_hrtime();
+                next += self->periodNs;
+                if (next < now) {
+                    next = now;
+                }
+                while (!self->stopping && (now < next)) {
+                    uv_cond_timedwait(&self->cond, &self->mutex, next - now);
+                    now = uv_hrtime();
+                }
+            }
+            self->finished = true;
+            uv_mutex_unlock(&self->mutex);
+
+            uv_async_send(&self->async);
+        }
+
+        // one cycle, runs on the subscription thread
+        void Poll() {
+            SubscriptionBatch* batch = new SubscriptionBatch();
+            batch->result = 0;
+
+            batch->result = ReadExchanges(localContext, PRIORITY_POLL, uv_hrtime(), items.data(), exchanges.data(),
+                                          exchanges.size() / EXCHANGE_FIELDS, itemDescriptors.data(), values.data(), status.data());
+
+            for (size_t i = 0; i < values.size(); i++) {
+                bool changed;
+                if (firstCycle || (status[i] != lastStatus[i])) {
+                    changed = true;
+                } else if (status[i] != 0) {
+                    changed = false;
+                } else if (valueDeadbands[i] > 0.0) {
+                    changed = (fabs(values[i] - lastValues[i]) >= valueDeadbands[i]);
+                } else {
+                    changed = (values[i] != lastValues[i]);
+                }
+                if (changed) {
+                    lastValues[i] = values[i];
+                    lastStatus[i] = status[i];
+                    batch->indexes.push_back((int32_t)i);
+                    batch->values.push_back(values[i]);
+                    batch->status.push_back(status[i]);
+                }
+            }
+            firstCycle = false;
+
+            // nothing changed and nothing failed, so don't wake the event loop
+            if (batch->indexes.empty() && (batch->result == 0)) {
+                delete batch;
+                return;
+            }
+
+            uv_mutex_lock(&mutex);
+            pending.push_back(batch);
+            uv_mutex_unlock(&mutex);
+            uv_async_send(&async);
+        }
+
+        // runs inside the main event loop, so it is safe to use V8
+        static void Deliver(uv_async_t* handle) {
+            Nan::HandleScope scope;
+            Subscription* self = (Subscription*)handle->data;
+
+            std::vector<SubscriptionBatch*> batches;
+            uv_mutex_lock(&self->mutex);
+            batches.swap(self->pending);
+            bool finished = self->finished;
+            uv_mutex_unlock(&self->mutex);
+
+            for (size_t b = 0; b < batches.size(); b++) {
+                SubscriptionBatch* batch = batches[b];
+                // nothing more is delivered once unsubscribe has been called
+                if (!self->stopRequested) {
+                    Local<Value> err = Null();
+                    if (batch->result != 0) {
+                        char errorMsg[200];
+                        sprintf(errorMsg,"Error Executing Read Request. Return code = %i\n", batch->result);
+                        err = Nan::Error(errorMsg);
+                    }
+                    Local<Value> argv[] = {
+                        err,
+                        NewInt32Array(batch->indexes),
+                        NewFloat64Array(batch->values),
+                        NewUint8Array(batch->status)
+                    };
+                    self->dataCallback.Call(4, argv, &self->resource);
+                }
+                delete batch;
+            }
+
+            if (finished) {
+                uv_thread_join(&self->thread);
+                self->localContext->setSubscription(NULL);
+                if (!self->stopCallback.IsEmpty()) {
+                    Local<Value> argv[] = {
+                        Null()
+                    };
+                    self->stopCallback.Call(1, argv, &self->resource);
+                }
+                uv_close((uv_handle_t*)&self->async, Closed);
+            }
+        }
+
+        static void Closed(uv_handle_t* handle) {
+            delete (Subscription*)handle->data;
+        }
+
+        ContextObject* localContext;
+        Nan::Persistent<v8::Object> localContextHandle;
+        Callback dataCallback;
+        Callback stopCallback;
+        Nan::AsyncResource resource;
+
+        // only used by the subscription thread once started
+        std::vector<int32_t> items;
+        std::vector<int32_t> exchanges;
+        std::vector<int32_t> itemDescriptors;
+        std::vector<double> valueDeadbands;
+        std::vector<double> values;
+        std::vector<uint8_t> status;
+        std::vector<double> lastValues;
+        std::vector<uint8_t> lastStatus;
+        uint64_t periodNs;
+        bool firstCycle;
+
+        // only used by the main event loop
+        bool stopRequested;
+
+        // shared, guarded by mutex
+        uv_mutex_t mutex;
+        uv_cond_t cond;
+        bool stopping;
+        bool finished;
+        std::vector<SubscriptionBatch*> pending;
+
+        uv_thread_t thread;
+        uv_async_t async;
+};
+
+/******************************************************************************
+*
+*  Function: 			Method_Subscribe()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- Int32Array items, 5 entries per item (see Method_ReadItems)
+*              info[2] -- Int32Array exchanges, 3 entries per exchange:
+*                         index of its first item, item count, value count
+*              info[3] -- Int32Array decode descriptors, 6 entries per value,
+*                         the values of each exchange following on from the
+*                         previous one (see Method_GetAllResults)
+*              info[4] -- Float64Array deadband of each value, 0 for any change
+*              info[5] -- number  period in milliseconds
+*              info[6] -- Callback, called from the event loop once per cycle
+*                         that changed something with (err, indexes, values,
+*                         status): Int32Array value indexes, Float64Array
+*                         values and Uint8Array status (0 == ok)
+*
+*  Starts a thread polling the exchanges until Method_Unsubscribe is called.
+*  Only one subscription can run on a context.
+*
+*  Returns: Nothing.
+*
+******************************************************************************/
+NAN_METHOD(Method_Subscribe) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 7)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsInt32Array() || !info[2]->IsInt32Array() || !info[3]->IsInt32Array() || !info[4]->IsFloat64Array() || !info[5]->IsNumber() || !info[6]->IsFunction()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+  if (context->getSubscription() != NULL) {
+      Nan::ThrowError("Already subscribed");
+      return;
+  }
+
+  Nan::TypedArrayContents<int32_t> items(info[1]);
+  Nan::TypedArrayContents<int32_t> exchanges(info[2]);
+  Nan::TypedArrayContents<int32_t> descriptors(info[3]);
+  Nan::TypedArrayContents<double> deadbands(info[4]);
+  size_t count = descriptors.length() / DESCRIPTOR_FIELDS;
+  if (((items.length() % ITEM_FIELDS) != 0) || ((exchanges.length() % 3) != 0) || ((descriptors.length() % DESCRIPTOR_FIELDS) != 0) || (deadbands.length() != count)) {
+      Nan::ThrowTypeError("Array lengths do not match");
+      return;
+  }
+
+  // every exchange must stay within the items and values given
+  size_t itemCount = items.length() / ITEM_FIELDS;
+  size_t valueCount = 0;
+  for (size_t e = 0; e < exchanges.length(); e += 3) {
+      int32_t itemStart = (*exchanges)[e];
+      int32_t exchangeItems = (*exchanges)[e + 1];
+      int32_t exchangeValues = (*exchanges)[e + 2];
+      if ((itemStart < 0) || (exchangeItems < 0) || (exchangeValues < 0) || ((size_t)(itemStart + exchangeItems) > itemCount)) {
+          Nan::ThrowRangeError("Exchange out of range");
+          return;
+      }
+      valueCount += exchangeValues;
+  }
+  if (valueCount != count) {
+      Nan::ThrowRangeError("Exchange out of range");
+      return;
+  }
+
+  double period = info[5]->NumberValue();
+  if (!(period >= 1)) {
+      Nan::ThrowRangeError("Period must be at least 1ms");
+      return;
+  }
+
+  Subscription* subscription = new Subscription(context, info[0]->ToObject(), info[6].As<v8::Function>(),
+                                                *items, itemCount, *exchanges, exchanges.length() / 3,
+                                                *descriptors, *deadbands, count, (uint64_t)period);
+  if (subscription->Start() != 0) {
+      Nan::ThrowError("Could not start the subscription thread");
+      return;
+  }
+  context->setSubscription(subscription);
+}
+
+/******************************************************************************
+*
+*  Function: 			Method_Unsubscribe()
+*  Sync/Async:			ASync
+*  Parameters: info[0] -- context object
+*              info[1] -- ASync Callback, called once the thread has stopped
+*
+*  Returns: true when a subscription is being stopped, false (and the callback
+*           will not be called) when there is none.
+*
+******************************************************************************/
+NAN_METHOD(Method_Unsubscribe) {
+
+  // Check the number of arguments passed.
+  if (info.Length() != 2)
+  {
+      Nan::ThrowTypeError("Wrong number of arguments");
+      return;
+  }
+  // and their types
+  if (!info[0]->IsObject() || !info[1]->IsFunction()) {
+      Nan::ThrowTypeError("One or more arguments of the wrong type");
+      return;
+  }
+
+  ContextObject* context = node::ObjectWrap::Unwrap<ContextObject>(info[0]->ToObject());
+  Subscription* subscription = context->getSubscription();
 
-    AsyncQueueWorker(new ExecWriteRequestWorker(callback, context));
+  bool stopping = (subscription != NULL) && subscription->Stop(info[1].As<v8::Function>());
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(stopping));
 }
 
 void init(v8::Local<v8::Object> target) {
@@ -930,15 +3154,31 @@ void init(v8::Local<v8::Object> target) {
     NODE_SET_METHOD(target, "createContext", Method_CreateContext);
     target->Set(Nan::New("connectPPI").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ConnectPPI)->GetFunction());                  // ASYNC Function
     target->Set(Nan::New("connectMPI").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ConnectMPI)->GetFunction());                  // ASYNC Function
+    target->Set(Nan::New("connectTCP").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ConnectTCP)->GetFunction());                  // ASYNC Function
+    target->Set(Nan::New("connectNetLink").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ConnectNetLink)->GetFunction());          // ASYNC Function
     target->Set(Nan::New("disconnect").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Disconnect)->GetFunction());                  // ASYNC Function
+    target->Set(Nan::New("reconnect").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Reconnect)->GetFunction());                    // ASYNC Function
+    target->Set(Nan::New("getPPIStats").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetPPIStats)->GetFunction());
+    target->Set(Nan::New("getQueueStats").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetQueueStats)->GetFunction());
+    target->Set(Nan::New("getStats").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetStats)->GetFunction());
+    target->Set(Nan::New("getMaxPDULength").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetMaxPDULength)->GetFunction());
+    target->Set(Nan::New("getParallelJobs").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetParallelJobs)->GetFunction());
     target->Set(Nan::New("prepareReadRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_PrepareReadRequest)->GetFunction());
     target->Set(Nan::New("addVarToRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_AddVarToRequest)->GetFunction());
     target->Set(Nan::New("execReadRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ExecReadRequest)->GetFunction());        // ASYNC Function
     target->Set(Nan::New("getResult").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetResult)->GetFunction());
+    target->Set(Nan::New("getAllResults").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_GetAllResults)->GetFunction());     // ASYNC Function
     target->Set(Nan::New("freeResults").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_FreeResults)->GetFunction());
     target->Set(Nan::New("prepareWriteRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_PrepareWriteRequest)->GetFunction());
     target->Set(Nan::New("addWriteVarToRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_AddWriteVarToRequest)->GetFunction());
     target->Set(Nan::New("execWriteRequest").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ExecWriteRequest)->GetFunction());
+    target->Set(Nan::New("readItems").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ReadItems)->GetFunction());             // ASYNC Function
+    target->Set(Nan::New("readExchanges").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ReadExchanges)->GetFunction());     // ASYNC Function
+    target->Set(Nan::New("readBlock").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_ReadBlock)->GetFunction());             // ASYNC Function
+    target->Set(Nan::New("decodeArray").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_DecodeArray)->GetFunction());
+    target->Set(Nan::New("writeItems").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_WriteItems)->GetFunction());           // ASYNC Function
+    target->Set(Nan::New("subscribe").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Subscribe)->GetFunction());
+    target->Set(Nan::New("unsubscribe").ToLocalChecked(),Nan::New<v8::FunctionTemplate>(Method_Unsubscribe)->GetFunction());       // ASYNC Function
 }
 
 NODE_MODULE(binding, init);
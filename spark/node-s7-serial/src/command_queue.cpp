@@ -0,0 +1,157 @@
+#include "command_queue.h"
+
+namespace nodeS7Serial {
+
+CommandQueue::CommandQueue(size_t queueCapacity) {
+    capacity = queueCapacity;
+    stopping = false;
+    depth = 0;
+    maxDepth = 0;
+    executed = 0;
+    rejected = 0;
+    waitTotalNs = 0;
+    waitMaxNs = 0;
+    outstanding = 0;
+    started = false;
+    uv_mutex_init(&mutex);
+    uv_cond_init(&cond);
+}
+
+CommandQueue::~CommandQueue() {
+    uv_cond_destroy(&cond);
+    uv_mutex_destroy(&mutex);
+}
+
+int CommandQueue::Start() {
+    uv_async_init(uv_default_loop(), &async, Complete);
+    async.data = this;
+    // only wake the event loop for completions, an idle queue must not keep the process alive
+    uv_unref((uv_handle_t*)&async);
+    int res = uv_thread_create(&thread, Run, this);
+    started = (res == 0);
+    return res;
+}
+
+void CommandQueue::Queue(QueuedWorker* worker) {
+    // keep the loop alive while there is work outstanding, as uv_queue_work does
+    if (outstanding++ == 0) {
+        uv_ref((uv_handle_t*)&async);
+    }
+
+    uv_mutex_lock(&mutex);
+    if (depth >= capacity) {
+        rejected++;
+        worker->Reject("Command queue full");
+        done.push_back(worker);
+        uv_mutex_unlock(&mutex);
+        uv_async_send(&async);
+        return;
+    }
+    int priority = worker->getPriority();
+    if ((priority < 0) || (priority >= PRIORITY_CLASSES)) {
+        priority = PRIORITY_CLASSES - 1;
+    }
+    worker->setQueuedAt(uv_hrtime());
+    pending[priority].push_back(worker);
+    if (++depth > maxDepth) {
+        maxDepth = depth;
+    }
+    uv_cond_signal(&cond);
+    uv_mutex_unlock(&mutex);
+}
+
+void CommandQueue::Shutdown() {
+    uv_mutex_lock(&mutex);
+    stopping = true;
+    uv_cond_signal(&cond);
+    uv_mutex_unlock(&mutex);
+    if (started) {
+        uv_thread_join(&thread);
+    }
+    uv_close((uv_handle_t*)&async, Closed);
+}
+
+void CommandQueue::GetStats(CommandQueueStats* stats) {
+    uv_mutex_lock(&mutex);
+    stats->depth = depth;
+    for (int i = 0; i < PRIORITY_CLASSES; i++) {
+        stats->classDepth[i] = pending[i].size();
+    }
+    stats->maxDepth = maxDepth;
+    stats->capacity = capacity;
+    stats->executed = executed;
+    stats->rejected = rejected;
+    stats->waitTotalUs = waitTotalNs / 1000;
+    stats->waitMaxUs = waitMaxNs / 1000;
+    uv_mutex_unlock(&mutex);
+}
+
+void CommandQueue::Run(void* arg) {
+    CommandQueue* self = (CommandQueue*)arg;
+
+    uv_mutex_lock(&self->mutex);
+    for (;;) {
+        while (!self->stopping && (self->depth == 0)) {
+            uv_cond_wait(&self->cond, &self->mutex);
+        }
+        if (self->depth == 0) {
+            break;
+        }
+        // a worker is one exchange, or yields after each, so a control write waits for at most the one running
+        int priority = 0;
+        while (self->pending[priority].empty()) {
+            priority++;
+        }
+        QueuedWorker* worker = self->pending[priority].front();
+        self->pending[priority].pop_front();
+        self->depth--;
+
+        uint64_t wait = uv_hrtime() - worker->getQueuedAt();
+        self->waitTotalNs += wait;
+        if (wait > self->waitMaxNs) {
+            self->waitMaxNs = wait;
+        }
+        uv_mutex_unlock(&self->mutex);
+
+        worker->Execute();
+
+        uv_mutex_lock(&self->mutex);
+        if (worker->TakeYield()) {
+            // already counted against the capacity when first queued, so never rejected here
+            worker->setQueuedAt(uv_hrtime());
+            self->pending[priority].push_back(worker);
+            self->depth++;
+            continue;
+        }
+        self->executed++;
+        self->done.push_back(worker);
+        uv_async_send(&self->async);
+    }
+    uv_mutex_unlock(&self->mutex);
+}
+
+// runs inside the main event loop, so it is safe to use V8
+void CommandQueue::Complete(uv_async_t* handle) {
+    CommandQueue* self = (CommandQueue*)handle->data;
+
+    std::vector<QueuedWorker*> workers;
+    uv_mutex_lock(&self->mutex);
+    workers.swap(self->done);
+    uv_mutex_unlock(&self->mutex);
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->WorkComplete();
+        workers[i]->Destroy();
+    }
+
+    self->outstanding -= workers.size();
+    if (self->outstanding == 0) {
+        uv_unref((uv_handle_t*)&self->async);
+    }
+}
+
+void CommandQueue::Closed(uv_handle_t* handle) {
+    delete (CommandQueue*)handle->data;
+}
+
+}  // namespace nodeS7Serial
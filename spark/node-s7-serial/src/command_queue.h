@@ -0,0 +1,100 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <nan.h>
+#include <uv.h>
+#include <deque>
+#include <vector>
+
+// priority classes, most urgent first: control writes, on-demand reads, cyclic polling
+#define PRIORITY_CONTROL 0
+#define PRIORITY_READ 1
+#define PRIORITY_POLL 2
+#define PRIORITY_CLASSES 3
+
+namespace nodeS7Serial {
+
+// a worker run on a context's own I/O thread rather than the libuv threadpool
+class QueuedWorker : public Nan::AsyncWorker {
+ public:
+  explicit QueuedWorker(Nan::Callback *callback, int workerPriority = PRIORITY_CONTROL)
+      : Nan::AsyncWorker(callback), priority(workerPriority), queuedAt(0), yielded(false) {}
+
+  // complete with an error without running Execute
+  inline void Reject(const char* msg) { SetErrorMessage(msg); }
+
+  // called from Execute to be queued again behind the rest of its class instead of
+  // completing, a long command does one exchange per run so others can go in between
+  inline void Yield() { yielded = true; }
+  inline bool TakeYield() { bool y = yielded; yielded = false; return y; }
+
+  inline int getPriority() { return priority; }
+  // when the worker was queued, its queueing latency is measured from here
+  inline uint64_t getQueuedAt() { return queuedAt; }
+  inline void setQueuedAt(uint64_t at) { queuedAt = at; }
+
+ private:
+  int priority;
+  uint64_t queuedAt;
+  bool yielded;
+};
+
+struct CommandQueueStats {
+  size_t depth;
+  size_t maxDepth;
+  size_t capacity;
+  uint64_t executed;
+  uint64_t rejected;
+  uint64_t waitTotalUs;
+  uint64_t waitMaxUs;
+  size_t classDepth[PRIORITY_CLASSES];
+};
+
+// runs the workers of one context one at a time on a thread of its own so a slow
+// serial exchange never holds up the threadpool or another context, the most
+// urgent class goes first and each class keeps its own order
+class CommandQueue {
+ public:
+  explicit CommandQueue(size_t capacity);
+
+  // start the thread, called from the main event loop
+  int Start();
+  // queue a worker, it is rejected with an error once the queue is full
+  void Queue(QueuedWorker* worker);
+  // stop and join the thread, the queue deletes itself once its handle is closed
+  void Shutdown();
+
+  void GetStats(CommandQueueStats* stats);
+
+ private:
+  ~CommandQueue();
+
+  static void Run(void* arg);
+  static void Complete(uv_async_t* handle);
+  static void Closed(uv_handle_t* handle);
+
+  // guarded by mutex
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  std::deque<QueuedWorker*> pending[PRIORITY_CLASSES];
+  size_t depth;
+  std::vector<QueuedWorker*> done;
+  bool stopping;
+  size_t capacity;
+  size_t maxDepth;
+  uint64_t executed;
+  uint64_t rejected;
+  uint64_t waitTotalNs;
+  uint64_t waitMaxNs;
+
+  // queued, running or waiting to complete, only used by the main event loop
+  size_t outstanding;
+
+  bool started;
+  uv_thread_t thread;
+  uv_async_t async;
+};
+
+}  // namespace nodeS7Serial
+
+#endif
@@ -1,4 +1,5 @@
 #include <node.h>
+#include <string.h>
 
 #include "context_object.h"
 
@@ -17,13 +18,141 @@ using v8::Value;
 
 Persistent<Function> ContextObject::constructor;
 
-ContextObject::ContextObject(void) {
+// commands that may wait for the I/O thread before new ones are rejected
+#define DEFAULT_QUEUE_CAPACITY 64
+
+// sum = carried + current, the counters of two connections one after the other
+static void AddLinkStats(const daveConnectionStats* carried, const daveConnectionStats* current, daveConnectionStats* sum) {
+    sum->exchanges = carried->exchanges + current->exchanges;
+    sum->errors = carried->errors + current->errors;
+    sum->timeouts = carried->timeouts + current->timeouts;
+    sum->resends = carried->resends + current->resends;
+    sum->pollRetries = carried->pollRetries + current->pollRetries;
+    sum->checksumErrors = carried->checksumErrors + current->checksumErrors;
+    sum->pdusSent = carried->pdusSent + current->pdusSent;
+    sum->pdusReceived = carried->pdusReceived + current->pdusReceived;
+    sum->bytesSent = carried->bytesSent + current->bytesSent;
+    sum->bytesReceived = carried->bytesReceived + current->bytesReceived;
+    sum->latencyTotal = carried->latencyTotal + current->latencyTotal;
+    sum->latencyMax = (carried->latencyMax > current->latencyMax) ? carried->latencyMax : current->latencyMax;
+    for (int i = 0; i < daveLatencyBuckets; i++) {
+        sum->latency[i] = carried->latency[i] + current->latency[i];
+    }
+}
+
+ContextObject::ContextObject(size_t queueCapacity) {
     serialStatus = -1;
     initializationStatus = -1;
     connectionStatus = -1;
+    rs.numResults = 0;
+    rs.results = NULL;
+    rs.arena = NULL;
+    subscription = NULL;
+    busy = false;
+    for (int i = 0; i < PRIORITY_CLASSES; i++) {
+        waiting[i] = 0;
+        exchanges[i] = 0;
+        waitTotalNs[i] = 0;
+        waitMaxNs[i] = 0;
+    }
+    memset(&linkStats, 0, sizeof(linkStats));
+    memset(&carriedLinkStats, 0, sizeof(carriedLinkStats));
+    memset(&session, 0, sizeof(session));
+    uv_mutex_init(&mutex);
+    uv_cond_init(&turn);
+    queue = new CommandQueue(queueCapacity);
 }
 
 ContextObject::~ContextObject() {
+    // nothing can be queued any more, every worker keeps its context alive
+    queue->Shutdown();
+    uv_cond_destroy(&turn);
+    uv_mutex_destroy(&mutex);
+}
+
+void ContextObject::lock(int priority, uint64_t issuedAt) {
+    if ((priority < 0) || (priority >= PRIORITY_CLASSES)) {
+        priority = PRIORITY_CLASSES - 1;
+    }
+
+    uv_mutex_lock(&mutex);
+    waiting[priority]++;
+    for (;;) {
+        bool urgentWaiting = false;
+        for (int i = 0; i < priority; i++) {
+            if (waiting[i] != 0) {
+                urgentWaiting = true;
+                break;
+            }
+        }
+        if (!busy && !urgentWaiting) {
+            break;
+        }
+        uv_cond_wait(&turn, &mutex);
+    }
+    waiting[priority]--;
+    busy = true;
+
+    uint64_t now = uv_hrtime();
+    uint64_t wait = (now > issuedAt) ? (now - issuedAt) : 0;
+    exchanges[priority]++;
+    waitTotalNs[priority] += wait;
+    if (wait > waitMaxNs[priority]) {
+        waitMaxNs[priority] = wait;
+    }
+    uv_mutex_unlock(&mutex);
+}
+
+void ContextObject::unlock() {
+    uv_mutex_lock(&mutex);
+    // the holder of the link is done with the connection, it cannot change or go away under us
+    if (connectionStatus == 0) {
+        daveConnectionStats current;
+        daveGetConnectionStats(dc, &current);
+        AddLinkStats(&carriedLinkStats, &current, &linkStats);
+    }
+    busy = false;
+    // wake everyone, the most urgent waiter takes the link and the rest wait again
+    uv_cond_broadcast(&turn);
+    uv_mutex_unlock(&mutex);
+}
+
+void ContextObject::rememberSession(int plcAddress, int rack, int slot) {
+    session.plcAddress = plcAddress;
+    session.rack = rack;
+    session.slot = slot;
+    // what the PLC agreed to, not what was asked for
+    session.parallelJobs = daveGetMaxParallelJobs(dc);
+    session.maxPDULength = dc->maxPDUlength;
+    session.valid = true;
+}
+
+void ContextObject::carryLinkStats() {
+    uv_mutex_lock(&mutex);
+    carriedLinkStats = linkStats;
+    uv_mutex_unlock(&mutex);
+}
+
+void ContextObject::clearCarriedLinkStats() {
+    uv_mutex_lock(&mutex);
+    memset(&carriedLinkStats, 0, sizeof(carriedLinkStats));
+    uv_mutex_unlock(&mutex);
+}
+
+void ContextObject::getPriorityStats(PriorityClassStats stats[PRIORITY_CLASSES]) {
+    uv_mutex_lock(&mutex);
+    for (int i = 0; i < PRIORITY_CLASSES; i++) {
+        stats[i].exchanges = exchanges[i];
+        stats[i].waitTotalUs = waitTotalNs[i] / 1000;
+        stats[i].waitMaxUs = waitMaxNs[i] / 1000;
+    }
+    uv_mutex_unlock(&mutex);
+}
+
+void ContextObject::getLinkStats(daveConnectionStats* stats) {
+    uv_mutex_lock(&mutex);
+    *stats = linkStats;
+    uv_mutex_unlock(&mutex);
 }
 
 void ContextObject::Init(Isolate* isolate) {
@@ -39,8 +168,18 @@ void ContextObject::New(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
 
   if (args.IsConstructCall()) {
-    // Invoked as constructor: `new ContextObject(...)`
-    ContextObject* obj = new ContextObject();
+    // Invoked as constructor: `new ContextObject(queueCapacity)`
+    size_t queueCapacity = DEFAULT_QUEUE_CAPACITY;
+    if (args[0]->IsNumber() && (args[0]->NumberValue() >= 1)) {
+      queueCapacity = (size_t)args[0]->NumberValue();
+    }
+    ContextObject* obj = new ContextObject(queueCapacity);
+    if (obj->queue->Start() != 0) {
+      delete obj;
+      isolate->ThrowException(v8::Exception::Error(
+          String::NewFromUtf8(isolate, "Could not start the I/O thread")));
+      return;
+    }
     obj->Wrap(args.This());
     args.GetReturnValue().Set(args.This());
   } else {
@@ -3,6 +3,9 @@
 
 #include <node.h>
 #include <node_object_wrap.h>
+#include <uv.h>
+
+#include "command_queue.h"
 
 extern "C" {
     #include "nodavesimple.h"
@@ -10,6 +13,24 @@ extern "C" {
 
 namespace nodeS7Serial {
 
+class Subscription;
+
+struct PriorityClassStats {
+  uint64_t exchanges;
+  uint64_t waitTotalUs;
+  uint64_t waitMaxUs;
+};
+
+// what the PLC connection was last set up with, so a reconnect can redo just that part
+struct SessionParameters {
+  bool valid;
+  int plcAddress;
+  int rack;
+  int slot;
+  int parallelJobs;     // negotiated
+  int maxPDULength;     // negotiated
+};
+
 class ContextObject : public node::ObjectWrap {
  public:
   static void Init(v8::Isolate* isolate);
@@ -31,8 +52,37 @@ class ContextObject : public node::ObjectWrap {
   inline int getConnectionStatus() { return connectionStatus; }
   inline void setConnectionStatus(int connStatus) { connectionStatus = connStatus; }
 
+  // libnodave builds every request in the connection's own buffer, so an exchange
+  // (prepare, add, exec and decode) must not be interleaved with another one.
+  // Between exchanges the link goes to the most urgent class waiting for it, the
+  // wait counts towards that class's latency from issuedAt (uv_hrtime)
+  void lock(int priority, uint64_t issuedAt);
+  inline void lock(QueuedWorker* worker) { lock(worker->getPriority(), worker->getQueuedAt()); }
+  void unlock();
+
+  void getPriorityStats(PriorityClassStats stats[PRIORITY_CLASSES]);
+
+  // libnodave's link statistics of the connection as of the last unlock, so reading
+  // them never waits for an exchange and outlives a disconnect
+  void getLinkStats(daveConnectionStats* stats);
+
+  // connect workers remember the PLC connection they set up, and forget it before trying
+  void rememberSession(int plcAddress, int rack, int slot);
+  inline void forgetSession() { session.valid = false; }
+  inline const SessionParameters* getSession() { return &session; }
+
+  // a reconnect replaces the connection, its link statistics are kept and the new
+  // connection's are added to them. Cleared when the session ends with a disconnect
+  void carryLinkStats();
+  void clearCarriedLinkStats();
+
+  inline Subscription* getSubscription() { return subscription; }
+  inline void setSubscription(Subscription* sub) { subscription = sub; }
+
+  inline CommandQueue* getCommandQueue() { return queue; }
+
  private:
-  explicit ContextObject();
+  explicit ContextObject(size_t queueCapacity);
   ~ContextObject();
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -50,6 +100,21 @@ class ContextObject : public node::ObjectWrap {
   int serialStatus;
   int initializationStatus;
   int connectionStatus;
+  // serialises exchanges between the I/O thread and the subscription thread
+  uv_mutex_t mutex;
+  uv_cond_t turn;
+  bool busy;
+  size_t waiting[PRIORITY_CLASSES];
+  uint64_t exchanges[PRIORITY_CLASSES];
+  uint64_t waitTotalNs[PRIORITY_CLASSES];
+  uint64_t waitMaxNs[PRIORITY_CLASSES];
+  daveConnectionStats linkStats;
+  daveConnectionStats carriedLinkStats;
+  SessionParameters session;
+  // cyclic read running on its own thread, or NULL
+  Subscription* subscription;
+  // I/O thread running the workers of this context
+  CommandQueue* queue;
 
 };
 
@@ -25,6 +25,7 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
   let variablesWriteObj = {};
   let disconnectedTimer = null;
   let connectionReported = false;
+  let readInProgress = false;
 
   const typeToSize = {
     float: {
@@ -144,28 +145,35 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
     });
   }
 
-  function readTimer() {
+  function decodeValue(variable, buff) {
+    const { size } = typeToSize[variable.format];
+    let method = `read${typeToSize[variable.format].method}`;
+    if (size > 1) {
+      // TODO: what is the endianness of the S5 ?
+      method += 'BE';
+    }
+    if (size === 8) {
+      // no 64 bit read in nodejs buffer
+      if (variable.endian === 'BE') {
+        return (buff.readUInt32BE(0) * 0x100000000) + buff.readUInt32BE(4);
+      }
+      return (buff.readUInt32LE(4) * 0x100000000) + buff.readUInt32LE(0);
+    }
+    return buff[method](0);
+  }
+
+  function processReadResults(values, errors) {
     let varErrorCount = 0;
     let errorVariable = null;
     let errorFlag = false;
 
     for (const i in variableReadArray) {
       const variable = variableReadArray[i];
-      const { size } = typeToSize[variable.format];
-
-      let err = null;
-      let buff;
-      try {
-        buff = client.readSync(
-          parseInt(variable.address, 16),
-          size,
-        );
-      } catch (e) {
-        varErrorCount += 1;
-        err = e;
-      }
 
+      const err = errors[i];
+      const buff = values[i];
       if (err) {
+        varErrorCount += 1;
         if (varErrorCount === variableReadArray.length) {
           errorFlag = false;
           alert.clear('var-read-error');
@@ -184,24 +192,7 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
         connectionDetected();
       }
 
-      let method = `read${typeToSize[variable.format].method}`;
-      if (size > 1) {
-        // TODO: what is the endianness of the S5 ?
-        method += 'BE';
-      }
-      let value;
-      if (size === 8) {
-        // no 64 bit read in nodejs buffer
-        if (variable.endian === 'BE') {
-          value = (buff.readUInt32BE(0) * 0x100000000) + buff.readUInt32BE(4);
-        } else {
-          value = (buff.readUInt32LE(4) * 0x100000000) + buff.readUInt32LE(0);
-        }
-      } else {
-        value = buff[method](0);
-      }
-
-      that.dataCb(that.machine, variable, value, (error, res) => {
+      that.dataCb(that.machine, variable, decodeValue(variable, buff), (error, res) => {
         if (error) log.error(error);
         if (res) log.debug(res);
       });
@@ -215,6 +206,54 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
     }
   }
 
+  function readTimer() {
+    // the reads run on a worker thread, don't queue another cycle behind a slow one
+    if (readInProgress) return;
+    readInProgress = true;
+
+    const readClient = client;
+    const items = variableReadArray.map(variable => ({
+      address: parseInt(variable.address, 16),
+      size: typeToSize[variable.format].size,
+    }));
+
+    client.readMany(items, (err, values, errors) => {
+      readInProgress = false;
+
+      // ignore results that arrive after the client was closed
+      if (readClient !== client) return;
+
+      if (err) {
+        alert.raise({ key: 'connection-error', errorMsg: err.message });
+        disconnectDetected();
+        return;
+      }
+
+      processReadResults(values, errors);
+    });
+  }
+
+  function subscriptionUpdate(err, changes) {
+    // called by the client with only the variables whose bytes changed since they were last reported
+    if (err) {
+      alert.raise({ key: 'connection-error', errorMsg: err.message });
+      disconnectDetected();
+      return;
+    }
+
+    if (connectionReported === false) {
+      connectionDetected();
+    }
+
+    Object.keys(changes).forEach((index) => {
+      const variable = variableReadArray[index];
+      that.dataCb(that.machine, variable, decodeValue(variable, changes[index]), (error, res) => {
+        if (error) log.error(error);
+        if (res) log.debug(res);
+      });
+    });
+  }
+
   function open(done) {
     if (client) {
       alert.raise({ key: 'opened-client' });
@@ -321,17 +360,17 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
     }
 
     // write the buffer value to the controller
-    try {
-      client.writeSync(parseInt(variable.address, 16), size, buff);
-    } catch (e) {
-      log.warn(e);
-      done(e);
-      return;
-    }
+    client.write(parseInt(variable.address, 16), size, buff, (err) => {
+      if (err) {
+        log.warn(err);
+        done(err);
+        return;
+      }
 
-    // clear variable write alert
-    alert.clear(`var-write-error-${variable.name}`);
-    done(null);
+      // clear variable write alert
+      alert.clear(`var-write-error-${variable.name}`);
+      done(null);
+    });
   };
 
   this.start = function start(dataCb, configUpdateCb, done) {
@@ -360,9 +399,18 @@ const hplSiemensS5 = function hplSiemensS5(log, machine, model, conf, db, alert)
         return done(err);
       }
 
-      // start the read timer
-      timer = setInterval(readTimer,
-        that.machine.settings.model.updateRate * 1000);
+      if (that.machine.settings.model.changeOnly === true) {
+        // let the PLC report the variables with STATUS VAR and only pass on those that changed
+        const items = variableReadArray.map(variable => ({
+          address: parseInt(variable.address, 16),
+          size: typeToSize[variable.format].size,
+        }));
+        client.subscribe(items, that.machine.settings.model.updateRate * 1000, subscriptionUpdate);
+      } else {
+        // start the read timer
+        timer = setInterval(readTimer,
+          that.machine.settings.model.updateRate * 1000);
+      }
 
       log.info('Started');
       return done(null);
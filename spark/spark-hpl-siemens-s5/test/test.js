@@ -356,6 +356,65 @@ describe('SPARK HPL SIEMENS S5', () => {
     });
   });
 
+  it('update model should succeed enabling change only mode', (done) => {
+    sparkHplSiemensS5.updateModel({
+      enable: true,
+      updateRate: 1,
+      changeOnly: true,
+    }, (err) => {
+      if (err) return done(err);
+      return done();
+    });
+  });
+
+  it('spark hpl siemens-s5 should produce data in change only mode', (done) => {
+    const variableReadArray = [];
+    const gotDataForVar = [];
+    testMachine.variables.forEach((variable) => {
+      if (!_.get(variable, 'machineConnected', false) && (_.isEqual(_.get(variable, 'access', 'read'), 'read'))) {
+        variableReadArray.push(variable);
+      }
+    });
+
+    db.on('data', (data) => {
+      variableReadArray.forEach((variable) => {
+        if (variable.name === data.variable) {
+          if (gotDataForVar.indexOf(data.variable) === -1) {
+            data[variable.name].should.eql(variable.value);
+            gotDataForVar.push(data.variable);
+            if (gotDataForVar.length === variableReadArray.length) {
+              db.removeAllListeners('data');
+              return done();
+            }
+          }
+        }
+        return undefined;
+      });
+    });
+  }).timeout(3000);
+
+  it('spark hpl siemens-s5 should not report unchanged values in change only mode', (done) => {
+    db.on('data', (data) => {
+      db.removeAllListeners('data');
+      return done(new Error(`unchanged variable ${data.variable} reported`));
+    });
+    setTimeout(() => {
+      db.removeAllListeners('data');
+      return done();
+    }, 1500);
+  }).timeout(3000);
+
+  it('spark hpl siemens-s5 should raise a connection error when the status var dialogue fails', (done) => {
+    sparkAlert.on('raise', (alert) => {
+      alert.key.should.equal('connection-error');
+      alert.description.should.equal('Not able to open connection. Please verify the configuration. Error: status var Error');
+      sparkAlert.removeAllListeners('raise');
+      sparkHplSiemensS5.tester.prototype.setVariableError(null);
+      return done();
+    });
+    sparkHplSiemensS5.tester.prototype.setVariableError('status var Error');
+  }).timeout(3000);
+
   it('start should result in error', (done) => {
     sparkAlert.on('raise', (alert) => {
       alert.should.have.all.keys('key', 'msg', 'description');
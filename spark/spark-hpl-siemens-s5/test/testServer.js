@@ -61,6 +61,7 @@ let connError = null;
 
 const TestServerSiemensS5 = function TestServerSiemensS5(device) {
   this.device = device;
+  this.subscriptionTimer = null;
 
   this.openSync = function openSync() {
     if (connError) {
@@ -70,6 +71,7 @@ const TestServerSiemensS5 = function TestServerSiemensS5(device) {
   };
 
   this.closeSync = function closeSync() {
+    this.unsubscribe(() => {});
     return true;
   };
 
@@ -191,6 +193,70 @@ const TestServerSiemensS5 = function TestServerSiemensS5(device) {
     });
     return undefined;
   };
+
+  // the asynchronous calls answer on a later tick, like the worker thread of node-as511 would
+  this.readMany = function readMany(items, callback) {
+    const values = [];
+    const errors = [];
+    items.forEach((item) => {
+      try {
+        values.push(this.readSync(item.address, item.size));
+        errors.push(null);
+      } catch (e) {
+        values.push(null);
+        errors.push(e);
+      }
+    });
+    setImmediate(callback, null, values, errors);
+  };
+
+  // like STATUS VAR in node-as511: every item on the first cycle and after an error, then only the changed ones
+  this.subscribe = function subscribe(items, periodMs, callback) {
+    const lastValues = {};
+    let firstCycle = true;
+    this.subscriptionTimer = setInterval(() => {
+      if (varError) {
+        firstCycle = true;
+        callback(new Error(varError), {});
+        return;
+      }
+      const changes = {};
+      items.forEach((item, index) => {
+        let buff = null;
+        try {
+          buff = this.readSync(item.address, item.size);
+        } catch (e) {
+          return;
+        }
+        if (firstCycle || !buff.equals(lastValues[index])) {
+          changes[index] = buff;
+          lastValues[index] = buff;
+        }
+      });
+      firstCycle = false;
+      if (!_.isEmpty(changes)) {
+        callback(null, changes);
+      }
+    }, periodMs);
+  };
+
+  this.unsubscribe = function unsubscribe(callback) {
+    if (this.subscriptionTimer) {
+      clearInterval(this.subscriptionTimer);
+      this.subscriptionTimer = null;
+    }
+    setImmediate(callback, null);
+  };
+
+  this.write = function write(addr, size, buff, callback) {
+    let err = null;
+    try {
+      this.writeSync(addr, size, buff);
+    } catch (e) {
+      err = e;
+    }
+    setImmediate(callback, err);
+  };
 };
 
 TestServerSiemensS5.prototype.setVariables = function setVariables(variable) {
@@ -21,8 +21,15 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
   let disconnectedTimer = null;
   let connectionReported = false;
   let variableReadArray = [];
+  let subscribedValues = {};
+  let linkHealthTimer = null;
+  let lastLinkStats = null;
+  let reconnecting = false;
   const S7_SERIAL_DEFAULT_LOCAL_ADDRESS = 0;
   const S7_SERIAL_DEFAULT_PLC_ADDRESS = 2;
+  // share of a check period's exchanges that may fail, or need a resend, before the serial link counts as degraded
+  const LINK_DEGRADED_ERROR_RATE = 0.05;
+  const LINK_DEGRADED_RESEND_RATE = 0.1;
 
   // Alert Objects
   alert.preLoad({
@@ -42,6 +49,10 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
       msg: `${machine.info.name}: Configuration Error`,
       description: 'Failed to list some variables. Please make sure all the variables are configured with proper format.',
     },
+    'link-degraded': {
+      msg: `${machine.info.name}: Serial Link Degraded`,
+      description: x => `Of ${x.exchanges} exchanges with the PLC ${x.errors} failed, ${x.resends} needed a resend and ${x.checksumErrors} answers had a bad checksum. Please check the serial cable, its connectors and the baud rate`,
+    },
   });
 
   // public variables
@@ -138,6 +149,88 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
     });
   }
 
+  // latency the given share of the exchanges stayed below, from the growth of the histogram since last
+  function windowPercentile(stats, last, share) {
+    const counts = stats.latency.map((count, i) => count - last.latency[i]);
+    const rank = Math.ceil(share * _.sum(counts));
+    let seen = 0;
+    for (let i = 0; i < counts.length; i += 1) {
+      seen += counts[i];
+      if ((seen >= rank) && (seen > 0)) {
+        return (i < stats.latencyBucketUs.length) ? stats.latencyBucketUs[i] : stats.latencyMaxUs;
+      }
+    }
+    return 0;
+  }
+
+  function checkLinkHealth() {
+    // the serial client keeps the statistics as of the last exchange, compare them with the last check
+    const stats = client.getStats();
+    const last = lastLinkStats;
+    lastLinkStats = stats;
+    const health = {
+      exchanges: stats.exchanges - last.exchanges,
+      errors: stats.errors - last.errors,
+      timeouts: stats.timeouts - last.timeouts,
+      resends: stats.resends - last.resends,
+      pollRetries: stats.pollRetries - last.pollRetries,
+      checksumErrors: stats.checksumErrors - last.checksumErrors,
+      bytesSent: stats.bytesSent - last.bytesSent,
+      bytesReceived: stats.bytesReceived - last.bytesReceived,
+    };
+    if (health.exchanges <= 0) return;
+    health.latencyP50Us = windowPercentile(stats, last, 0.5);
+    health.latencyP99Us = windowPercentile(stats, last, 0.99);
+    const reconnectStats = client.getReconnectStats();
+    health.reconnects = reconnectStats.reconnects;
+    health.reconnectMaxUs = reconnectStats.maxUs;
+    log.info({ linkHealth: health }, 'Serial link health');
+
+    if ((health.errors > LINK_DEGRADED_ERROR_RATE * health.exchanges)
+      || (health.resends > LINK_DEGRADED_RESEND_RATE * health.exchanges)
+      || (health.checksumErrors > 0)) {
+      alert.raise({
+        key: 'link-degraded',
+        exchanges: health.exchanges,
+        errors: health.errors,
+        resends: health.resends,
+        checksumErrors: health.checksumErrors,
+      });
+    } else {
+      alert.clear('link-degraded');
+    }
+  }
+
+  function reconnectSerial() {
+    // after a failed poll the serial client sets up only the PLC connection again if it can,
+    // rather than closing the port and waiting for the reconnect timer
+    if (reconnecting || (interfaceType === 'ethernet') || (client === null)) return;
+    reconnecting = true;
+    client.reconnect((err, level) => {
+      reconnecting = false;
+      const stats = client.getReconnectStats();
+      if (err) {
+        log.error({ err, reconnectUs: stats.lastUs }, 'Reconnect failed');
+        return;
+      }
+      log.info({ level, reconnectUs: stats.lastUs, reconnectMaxUs: stats.maxUs }, 'Reconnected');
+    });
+  }
+
+  function startLinkHealth() {
+    // a new connection starts counting from zero
+    lastLinkStats = client.getStats();
+    const period = _.get(that.machine.settings.model, 'linkHealthPeriod', 60);
+    linkHealthTimer = setInterval(checkLinkHealth, period * 1000);
+  }
+
+  function stopLinkHealth() {
+    if (linkHealthTimer) {
+      clearInterval(linkHealthTimer);
+      linkHealthTimer = null;
+    }
+  }
+
   function readTimer() {
     // check we are not still processing last request
     if (sendingActive === false) {
@@ -177,7 +270,7 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
               log.error(err);
               sendingActive = false;
               disconnectDetected();
-              //              disconnectReconnect();
+              reconnectSerial();
               return;
             }
           }
@@ -216,8 +309,52 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
           // done, so set active flag back to false
           sendingActive = false;
         });
-      });
+        // the serial client lets writes and on-demand reads go ahead of a timed poll, nodes7 ignores this
+      }, nodeS7Serial.constants.PRIORITY_POLL);
+    }
+  }
+
+  function subscriptionUpdate(err, changes) {
+    // called by the serial client with only the variables that changed since they were last reported
+    const changedVariables = _.filter(variableReadArray, variable => _.has(changes, variable.address));
+    _.assign(subscribedValues, changes);
+
+    if (err) {
+      // nothing left to read, treat it like a failed poll
+      if (_.every(variableReadArray, variable => subscribedValues[variable.address] === null)) {
+        alert.clear('data-null-error');
+        alert.raise({ key: 'dataset-empty-error' });
+        log.error(err);
+        disconnectDetected();
+        reconnectSerial();
+        return;
+      }
     }
+
+    alert.clear('dataset-empty-error');
+    connectionDetected();
+
+    // write each changed variable to the database in turn
+    async.forEachSeries(changedVariables, (variable, callback) => {
+      const varResult = changes[variable.address];
+      if (varResult !== null) {
+        that.dataCb(that.machine, variable, varResult, (error, res) => {
+          if (error) {
+            log.error(error);
+          }
+          if (res) log.debug(res);
+          callback();
+        });
+      } else {
+        alert.raise({ key: 'data-null-error', variableName: variable.name });
+        callback();
+      }
+    }, () => {
+      // clear the null data alert once every variable has a value again
+      if (!_.some(variableReadArray, variable => subscribedValues[variable.address] === null)) {
+        alert.clear('data-null-error');
+      }
+    });
   }
 
   function calculateFormat(sparkformat) {
@@ -343,8 +480,15 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
         ({ plcAddress } = that.machine.settings.model);
       }
 
-      // eslint-disable-next-line max-len
-      client = new nodeS7Serial.constructor(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress);
+      if (interfaceType === 'netlink') {
+        // the gateway takes the place of the serial port, the PLC keeps its bus address behind it
+        const { host, netLinkMode, netLinkPort } = that.machine.settings.model;
+        // eslint-disable-next-line max-len
+        client = new nodeS7Serial.constructor(netLinkMode, host, '', '', '', mpiSpeed, localAddress, plcAddress, { port: netLinkPort });
+      } else {
+        // eslint-disable-next-line max-len
+        client = new nodeS7Serial.constructor(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress);
+      }
       client.initiateConnection((err) => {
         if (err) {
           alert.raise({ key: 'connection-error' });
@@ -382,9 +526,23 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
           }
         }
 
-        // also start a timer task that will trigger the read requests
-        timer = setInterval(readTimer, requestFrequencyMs);
-        log.info('Connected - timer started');
+        if (that.machine.settings.model.changeOnly === true) {
+          // let the client poll on its own thread and only report the values that changed
+          const deadbands = {};
+          variableReadArray.forEach((variable) => {
+            if (_.has(variable, 'deadband')) {
+              deadbands[variable.address] = variable.deadband;
+            }
+          });
+          subscribedValues = {};
+          client.subscribe(requestFrequencyMs, { deadbands }, subscriptionUpdate);
+          log.info('Connected - subscription started');
+        } else {
+          // also start a timer task that will trigger the read requests
+          timer = setInterval(readTimer, requestFrequencyMs);
+          log.info('Connected - timer started');
+        }
+        startLinkHealth();
         // eslint-disable-next-line consistent-return
         callback(null);
       });
@@ -398,6 +556,7 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
     }
 
     updateConnectionStatus(false);
+    stopLinkHealth();
 
     // if we are currently in a request/response cycle
     if (sendingActive === true) {
@@ -516,6 +675,7 @@ const hplSiemensS7 = function hplSiemensS7(log, machine, model, conf, db, alert)
       clearInterval(timer);
       timer = null;
     }
+    stopLinkHealth();
 
     if (reconnectTimer) {
       clearTimeout(reconnectTimer);
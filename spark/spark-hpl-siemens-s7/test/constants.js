@@ -55,6 +55,16 @@ module.exports.FORMAT_SIGNED = 1;
 module.exports.FORMAT_FLOAT = 2;
 module.exports.FORMAT_BOOL = 3;
 
+// command priority classes
+module.exports.PRIORITY_CONTROL = 0; // connect, disconnect and writes
+module.exports.PRIORITY_READ = 1; // on-demand reads
+module.exports.PRIORITY_POLL = 2; // cyclic polling
+
+// how far reconnect had to go back
+module.exports.RECONNECT_CONNECTION = 1; // only the PLC connection was set up again
+module.exports.RECONNECT_ADAPTER = 2; // the adapter was initialized again too
+module.exports.RECONNECT_FULL = 3; // port, adapter and connection from scratch
+
 
 // MPI versions (should match as defined in nodavesimple.h)
 module.exports.mpiModeTranslate = {
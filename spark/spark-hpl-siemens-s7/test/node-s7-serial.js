@@ -5,6 +5,39 @@ let variables = [];
 let variableError = null;
 let connError = null;
 let writeError = null;
+// the client created last, to check what the hpl passed to it
+let lastClient = null;
+// how many of the reconnect levels fail before one works, 1 fails the connection resume,
+// 2 the adapter reset as well so only a full reconnect is left
+let reconnectFailures = 0;
+let lastReconnect = null;
+// counted as the serial client counts them
+const reconnectStats = {
+  reconnects: 0,
+  failed: 0,
+  levels: [0, 0, 0],
+  lastUs: 0,
+  maxUs: 0,
+  totalUs: 0,
+};
+// the link statistics as the serial client counts them, from connecting on
+const LATENCY_BUCKETS = 16;
+let linkStats = {
+  exchanges: 0,
+  errors: 0,
+  timeouts: 0,
+  resends: 0,
+  pollRetries: 0,
+  checksumErrors: 0,
+  pdusSent: 0,
+  pdusReceived: 0,
+  bytesSent: 0,
+  bytesReceived: 0,
+  latencyTotalUs: 0,
+  latencyMaxUs: 0,
+  latency: _.fill(Array(LATENCY_BUCKETS), 0),
+  latencyBucketUs: _.times(LATENCY_BUCKETS - 1, i => 128 * (2 ** i)),
+};
 
 const NodeS7Serial = function NodeS7Serial() {
   this.isoConnectionState = 0;
@@ -16,13 +49,15 @@ const NodeS7Serial = function NodeS7Serial() {
   this.mpiSpeed = 0;
   this.localAddress = 0;
   this.plcAddress = 0;
+  this.options = {};
   this.serialPort = null;
   this.readArray = [];
   this.resultObject = {};
+  this.subscriptionTimer = null;
 };
 
 // eslint-disable-next-line max-len
-function constructor(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress) {
+function constructor(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed, localAddress, plcAddress, options) {
   const object = new NodeS7Serial();
   object.protocolMode = protocolMode;
   object.device = device;
@@ -32,6 +67,8 @@ function constructor(protocolMode, device, baudRate, parity, mpiMode, mpiSpeed,
   object.mpiSpeed = mpiSpeed;
   object.localAddress = localAddress;
   object.plcAddress = plcAddress;
+  object.options = options || {};
+  lastClient = object;
   return object;
 }
 
@@ -57,6 +94,7 @@ NodeS7Serial.prototype.addItems = function addItems(address) {
 };
 
 NodeS7Serial.prototype.dropConnection = function dropConnection(callback) {
+  this.unsubscribe(() => {});
   this.isoConnectionState = 0;
   return callback(null);
 };
@@ -82,6 +120,43 @@ NodeS7Serial.prototype.readAllItems = function readAllItems(callback) {
   return callback(null, this.resultObject);
 };
 
+NodeS7Serial.prototype.subscribe = function subscribe(periodMs, options, callback) {
+  const lastValues = {};
+  let firstCycle = true;
+  this.subscriptionTimer = setInterval(() => {
+    const changes = {};
+    this.readArray.forEach((address) => {
+      const variable = _.find(variables, { address });
+      if (variable !== undefined) {
+        // the serial client reports values it could not read as null
+        const value = variableError ? null : variable.value;
+        if (firstCycle || !_.isEqual(lastValues[address], value)) {
+          changes[address] = value;
+          lastValues[address] = value;
+        }
+      }
+    });
+    firstCycle = false;
+    if (variableError) {
+      callback(variableError, changes);
+    } else if (!_.isEmpty(changes)) {
+      callback(null, changes);
+    }
+  }, periodMs);
+};
+
+NodeS7Serial.prototype.unsubscribe = function unsubscribe(callback) {
+  if (this.subscriptionTimer) {
+    clearInterval(this.subscriptionTimer);
+    this.subscriptionTimer = null;
+  }
+  return callback(null);
+};
+
+NodeS7Serial.prototype.getStats = function getStats() {
+  return _.cloneDeep(linkStats);
+};
+
 NodeS7Serial.prototype.writeItems = function writeItems(data, value, cb) {
   variables.forEach((variable) => {
     let writeValue = null;
@@ -107,6 +182,56 @@ NodeS7Serial.prototype.setWriteError = function setWriteError(writeErr, cb) {
   return cb(null);
 };
 
+NodeS7Serial.prototype.setReconnectFailures = function setReconnectFailures(failures) {
+  reconnectFailures = failures;
+};
+
+NodeS7Serial.prototype.reconnect = function reconnect(callback) {
+  // each level that fails hands on to the next, a full reconnect fails as connecting does
+  const level = Math.min(constants.RECONNECT_CONNECTION + reconnectFailures,
+    constants.RECONNECT_FULL);
+  const err = (level === constants.RECONNECT_FULL) ? connError : null;
+  const us = 1000 * level;
+  reconnectStats.reconnects += 1;
+  reconnectStats.lastUs = us;
+  reconnectStats.maxUs = Math.max(reconnectStats.maxUs, us);
+  reconnectStats.totalUs += us;
+  if (err) {
+    reconnectStats.failed += 1;
+  } else {
+    reconnectStats.levels[level - 1] += 1;
+  }
+  lastReconnect = { err, level };
+  return callback(err, level);
+};
+
+NodeS7Serial.prototype.getReconnectStats = function getReconnectStats() {
+  return {
+    reconnects: reconnectStats.reconnects,
+    failed: reconnectStats.failed,
+    connectionOnly: reconnectStats.levels[constants.RECONNECT_CONNECTION - 1],
+    adapter: reconnectStats.levels[constants.RECONNECT_ADAPTER - 1],
+    full: reconnectStats.levels[constants.RECONNECT_FULL - 1],
+    lastUs: reconnectStats.lastUs,
+    maxUs: reconnectStats.maxUs,
+    totalUs: reconnectStats.totalUs,
+    averageUs: (reconnectStats.reconnects > 0)
+      ? (reconnectStats.totalUs / reconnectStats.reconnects) : 0,
+  };
+};
+
+NodeS7Serial.prototype.getLastReconnect = function getLastReconnect() {
+  return lastReconnect;
+};
+
+NodeS7Serial.prototype.getLastClient = function getLastClient() {
+  return lastClient;
+};
+
+NodeS7Serial.prototype.setLinkStats = function setLinkStats(stats) {
+  linkStats = _.merge({}, linkStats, stats);
+};
+
 module.exports = NodeS7Serial;
 module.exports.constructor = constructor;
 module.exports.constants = constants;
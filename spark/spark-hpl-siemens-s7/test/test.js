@@ -5,6 +5,7 @@ const bunyan = require('bunyan');
 const _ = require('lodash');
 const pkg = require('../package.json');
 const SparkHplS7 = require('../index.js');
+const constants = require('./constants.js');
 
 const log = bunyan.createLogger({
   name: pkg.name,
@@ -248,6 +249,7 @@ sparkAlert.getAlerter = function getAlerter() {
     },
     clear(key) {
       log.debug({ key }, 'Cleared alert');
+      sparkAlert.emit('clear', key);
     },
   };
 };
@@ -261,6 +263,20 @@ sparkConfig.set = function set(key, value, done) {
 describe('SPARK HPL SIEMENS S7', () => {
   let sparkHplS7;
 
+  // fail the serial polls until the hpl has had the client reconnect, then let them succeed again
+  function failPollUntilReconnected(before, callback) {
+    const client = sparkHplS7.tester.prototype;
+    client.setVariableError(Error('variable Error'));
+    const timer = setInterval(() => {
+      const stats = client.getReconnectStats();
+      if (stats.reconnects > before.reconnects) {
+        clearInterval(timer);
+        client.setVariableError(null);
+        callback(stats, client.getLastReconnect());
+      }
+    }, 100);
+  }
+
   it('successfully create a new net S7', (done) => {
     /* eslint new-cap: ["error", { "newIsCap": false }] */
     sparkHplS7 = new SparkHplS7.hpl(log.child({
@@ -570,6 +586,200 @@ describe('SPARK HPL SIEMENS S7', () => {
     return done();
   });
 
+  it('the serial client should have reconnected after the failed poll', (done) => {
+    const stats = sparkHplS7.tester.prototype.getReconnectStats();
+    stats.reconnects.should.be.above(0);
+    stats.connectionOnly.should.equal(stats.reconnects);
+    stats.failed.should.equal(0);
+    const lastReconnect = sparkHplS7.tester.prototype.getLastReconnect();
+    lastReconnect.level.should.equal(constants.RECONNECT_CONNECTION);
+    return done();
+  });
+
+  it('the serial client should reset the adapter when the connection cannot be resumed', (done) => {
+    const before = sparkHplS7.tester.prototype.getReconnectStats();
+    sparkHplS7.tester.prototype.setReconnectFailures(1);
+    failPollUntilReconnected(before, (stats, lastReconnect) => {
+      (lastReconnect.err === null).should.equal(true);
+      lastReconnect.level.should.equal(constants.RECONNECT_ADAPTER);
+      stats.adapter.should.be.above(before.adapter);
+      stats.connectionOnly.should.equal(before.connectionOnly);
+      stats.full.should.equal(before.full);
+      stats.failed.should.equal(before.failed);
+      return done();
+    });
+  }).timeout(6000);
+
+  it('the serial client should reconnect fully when the adapter cannot be reset', (done) => {
+    const before = sparkHplS7.tester.prototype.getReconnectStats();
+    sparkHplS7.tester.prototype.setReconnectFailures(2);
+    failPollUntilReconnected(before, (stats, lastReconnect) => {
+      (lastReconnect.err === null).should.equal(true);
+      lastReconnect.level.should.equal(constants.RECONNECT_FULL);
+      stats.full.should.be.above(before.full);
+      stats.adapter.should.equal(before.adapter);
+      stats.connectionOnly.should.equal(before.connectionOnly);
+      stats.failed.should.equal(before.failed);
+      stats.maxUs.should.be.above(before.maxUs);
+      return done();
+    });
+  }).timeout(6000);
+
+  it('a reconnect should count as failed when the full reconnect fails', (done) => {
+    const before = sparkHplS7.tester.prototype.getReconnectStats();
+    sparkHplS7.tester.prototype.setReconnectFailures(2);
+    sparkHplS7.tester.prototype.setConnectionError(Error('no answer from the adapter'));
+    failPollUntilReconnected(before, (stats, lastReconnect) => {
+      sparkHplS7.tester.prototype.setConnectionError(null);
+      lastReconnect.err.message.should.equal('no answer from the adapter');
+      lastReconnect.level.should.equal(constants.RECONNECT_FULL);
+      stats.failed.should.be.above(before.failed);
+      stats.full.should.equal(before.full);
+      stats.adapter.should.equal(before.adapter);
+      stats.connectionOnly.should.equal(before.connectionOnly);
+      return done();
+    });
+  }).timeout(6000);
+
+  it('reconnect failures should be cleared', (done) => {
+    sparkHplS7.tester.prototype.setReconnectFailures(0);
+    return done();
+  });
+
+  it('update model should succeed enabling change only mode in serial mode', (done) => {
+    sparkHplS7.updateModel(_.merge({}, testMachineSerial.settings.model, {
+      requestFrequency: '.50',
+      changeOnly: true,
+    }), (err) => {
+      if (err) return done(err);
+      return done();
+    });
+  });
+
+  it('spark hpl siemens-s7 should produce data in change only mode', (done) => {
+    const variableReadArray = [];
+    const gotDataForVar = [];
+    testMachineSerial.variables.forEach((variable) => {
+      if (!_.get(variable, 'machineConnected', false) && _.isEqual(_.get(variable, 'access'), 'read')) {
+        variableReadArray.push(variable);
+      }
+    });
+    db.on('data', (data) => {
+      variableReadArray.forEach((variable) => {
+        if (variable.name === data.variable) {
+          if (gotDataForVar.indexOf(data.variable) === -1) {
+            data[variable.name].should.eql(variable.value);
+            gotDataForVar.push(data.variable);
+            if (gotDataForVar.length === variableReadArray.length) {
+              db.removeAllListeners('data');
+              return done();
+            }
+          }
+        }
+        return undefined;
+      });
+    });
+  }).timeout(6000);
+
+  it('spark hpl siemens-s7 should not report unchanged values in change only mode', (done) => {
+    db.on('data', (data) => {
+      db.removeAllListeners('data');
+      return done(new Error(`unchanged variable ${data.variable} reported`));
+    });
+    setTimeout(() => {
+      db.removeAllListeners('data');
+      return done();
+    }, 1500);
+  }).timeout(6000);
+
+  it('update model should succeed with a short link health period in serial mode', (done) => {
+    sparkHplS7.updateModel(_.merge({}, testMachineSerial.settings.model, {
+      requestFrequency: '.50',
+      changeOnly: true,
+      linkHealthPeriod: 1,
+    }), (err) => {
+      if (err) return done(err);
+      return done();
+    });
+  });
+
+  it('alert is raised when the serial link degrades', (done) => {
+    sparkAlert.on('raise', (alert) => {
+      alert.should.be.instanceof(Object);
+      alert.should.have.all.keys('key', 'msg', 'description', 'exchanges', 'errors', 'resends', 'checksumErrors');
+      alert.key.should.equal('link-degraded');
+      alert.msg.should.equal(`${testMachineSerial.info.name}: Serial Link Degraded`);
+      alert.description.should.equal('Of 100 exchanges with the PLC 2 failed, 20 needed a resend and 1 answers had a bad checksum. Please check the serial cable, its connectors and the baud rate');
+      sparkAlert.removeAllListeners('raise');
+      return done();
+    });
+    sparkHplS7.tester.prototype.setLinkStats({
+      exchanges: 100,
+      errors: 2,
+      resends: 20,
+      checksumErrors: 1,
+    });
+  }).timeout(6000);
+
+  it('serial link degraded alert should be cleared after clean exchanges', (done) => {
+    sparkAlert.on('clear', (key) => {
+      // other alerts are cleared on every poll as well
+      if (key === 'link-degraded') {
+        sparkAlert.removeAllListeners('clear');
+        return done();
+      }
+      return undefined;
+    });
+    sparkHplS7.tester.prototype.setLinkStats({
+      exchanges: 200,
+    });
+  }).timeout(6000);
+
+  it('update model should succeed with the NetLink interface', (done) => {
+    sparkHplS7.updateModel(_.merge({}, testMachineSerial.settings.model, {
+      requestFrequency: '.50',
+      interface: 'netlink',
+      host: '192.168.0.10',
+      netLinkMode: 'IBH MPI',
+      netLinkPort: 1099,
+      changeOnly: false,
+    }), (err) => {
+      if (err) return done(err);
+      const client = sparkHplS7.tester.prototype.getLastClient();
+      client.protocolMode.should.equal('IBH MPI');
+      client.device.should.equal('192.168.0.10');
+      client.mpiSpeed.should.equal('187K');
+      client.plcAddress.should.equal(2);
+      client.options.should.eql({ port: 1099 });
+      return done();
+    });
+  });
+
+  it('spark hpl siemens-s7 should produce data over a NetLink gateway', (done) => {
+    const variableReadArray = [];
+    const gotDataForVar = [];
+    testMachineSerial.variables.forEach((variable) => {
+      if (!_.get(variable, 'machineConnected', false) && _.isEqual(_.get(variable, 'access'), 'read')) {
+        variableReadArray.push(variable);
+      }
+    });
+    db.on('data', (data) => {
+      variableReadArray.forEach((variable) => {
+        if (variable.name === data.variable) {
+          if (gotDataForVar.indexOf(data.variable) === -1) {
+            data[variable.name].should.eql(variable.value);
+            gotDataForVar.push(data.variable);
+            if (gotDataForVar.length === variableReadArray.length) {
+              db.removeAllListeners('data');
+              return done();
+            }
+          }
+        }
+        return undefined;
+      });
+    });
+  }).timeout(6000);
+
   it('set the connection error in serial mode', (done) => {
     sparkAlert.on('raise', (alert) => {
       alert.should.be.instanceof(Object);